@@ -12,6 +12,7 @@
 #define __DB_COMMON_H__
 
 #include <drift/ds_value.h>
+#include <drift/SyncedInt.h>
 
 class DSL_API_CLASS SC_Row {
 public:
@@ -70,7 +70,7 @@ private:
 	MYSQL * sql = NULL;
 	string host, user, pass, dbname, charset;
 	uint16 port = 0;
-	uint32 query_count = 0;
+	DSL_ShardedCounter query_count;
 };
 
 /**@}*/
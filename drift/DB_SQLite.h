@@ -89,7 +89,7 @@ public:
 
 private:
 	sqlite3 * handle = NULL;
-	uint32_t query_count = 0;
+	DSL_ShardedCounter query_count;
 	bool _insert(const string& table, const SC_Row& row, const string& action);
 };
 
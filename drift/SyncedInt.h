@@ -14,76 +14,105 @@
 #include <drift/mutex.h>
 
 /**
- * \defgroup atomic Atomic Integer Class
- * These days you should just #include <atomic>, this was made before that existed.
+ * \defgroup atomic Atomic Integer Classes
  */
 
 /** \addtogroup atomic
  * @{
  */
 
-
+/**
+ * std::atomic wrapper that lives on its own cache line (so it doesn't false-share with neighbouring members) and adds the operations std::atomic is missing like FetchMin/FetchMax.
+ */
 template <class T>
-class SyncedInt {
-#if defined(WIN32)
+class alignas(64) DSL_Atomic {
 private:
-	T * value;
+	atomic<T> value;
 public:
-	SyncedInt() {
-		value = (T *)_aligned_malloc(sizeof(T), 64);
-		*value = 0;
-	}
-	~SyncedInt() {
-		_aligned_free(value);
+	DSL_Atomic(T val = 0) : value(val) {}
+	DSL_Atomic(const DSL_Atomic&) = delete;
+	DSL_Atomic& operator=(const DSL_Atomic&) = delete;
+
+	T Get(memory_order order = memory_order_seq_cst) const { return value.load(order); }
+	void Set(T val, memory_order order = memory_order_seq_cst) { value.store(val, order); }
+	T Exchange(T val) { return value.exchange(val); }
+	/**
+	 * If the current value is expected it is replaced with desired and true is returned, otherwise expected is set to the current value and false is returned.
+	 */
+	bool CompareExchange(T& expected, T desired) { return value.compare_exchange_strong(expected, desired); }
+
+	T FetchAdd(T val, memory_order order = memory_order_seq_cst) { return value.fetch_add(val, order); } ///< Returns the previous value
+	T FetchSub(T val, memory_order order = memory_order_seq_cst) { return value.fetch_sub(val, order); } ///< Returns the previous value
+	T Increment() { return value.fetch_add(1) + 1; } ///< Returns the new value
+	T Decrement() { return value.fetch_sub(1) - 1; } ///< Returns the new value
+	/**
+	 * Sets the value to the smaller of the current value and val, returns the previous value. Handy for tracking minimum latencies, etc.
+	 */
+	T FetchMin(T val) {
+		T cur = value.load(memory_order_relaxed);
+		while (val < cur && !value.compare_exchange_weak(cur, val)) {}
+		return cur;
 	}
-	T Increment() {
-		if (sizeof(T) == 4) {
-			return InterlockedIncrement((LONG *)value);
-#if (_WIN32_WINNT >= 0x0600)
-		} else if (sizeof(T) == 8) {
-			return InterlockedIncrement64((LONGLONG *)value);
-#endif
-#if (_WIN32_WINNT >= 0x0602)
-		} else if (sizeof(T) == 2) {
-			return InterlockedIncrement16((LONGLONG *)value);
-#endif
-		} else {
-			printf("SyncedInt: Unsupported int size: %u\n", sizeof(T));
-		}
-		return -1;
+	/**
+	 * Sets the value to the larger of the current value and val, returns the previous value.
+	 */
+	T FetchMax(T val) {
+		T cur = value.load(memory_order_relaxed);
+		while (val > cur && !value.compare_exchange_weak(cur, val)) {}
+		return cur;
 	}
-	T Decrement() {
-		if (sizeof(T) == 4) {
-			return InterlockedDecrement((LONG *)value);
-#if (_WIN32_WINNT >= 0x0600)
-		} else if (sizeof(T) == 8) {
-			return InterlockedDecrement64((LONGLONG *)value);
-#endif
-#if (_WIN32_WINNT >= 0x0602)
-		} else if (sizeof(T) == 2) {
-			return InterlockedDecrement16((LONGLONG *)value);
+
+	operator T() const { return value.load(); }
+	T operator=(T val) { value.store(val); return val; }
+	T operator+=(T val) { return value.fetch_add(val) + val; }
+	T operator-=(T val) { return value.fetch_sub(val) - val; }
+	T operator++() { return Increment(); }
+	T operator--() { return Decrement(); }
+	T operator++(int) { return value.fetch_add(1); }
+	T operator--(int) { return value.fetch_sub(1); }
+};
+
+/**
+ * Kept for older code, use DSL_Atomic in new code.
+ */
+template <class T>
+class SyncedInt : public DSL_Atomic<T> {
+};
+
+#ifndef DOXYGEN_SKIP
+struct alignas(64) DSL_ShardedCounter_Slot {
+	atomic<int64> value;
+};
 #endif
-		} else {
-			printf("SyncedInt: Unsupported int size: %u\n", sizeof(T));
-		}
-		return -1;
-	}
-	T Get() { return *value; }
-#else
+
+/**
+ * Counter for statistics that are updated from lots of threads. Each thread adds to its own cache-line-padded slot so updates don't bounce a shared cache line between cores, reads add up all the slots.<br>
+ * Get() is not a snapshot: adds that happen while it is summing may or may not be counted, which is fine for statistics but don't use it for things like reference counts.
+ */
+class DSL_API_CLASS DSL_ShardedCounter {
 private:
-	T __attribute__((aligned(64))) value;
+	DSL_ShardedCounter_Slot * slots;
+	uint32 mask;
+	DSL_ShardedCounter_Slot& slot();
 public:
-	SyncedInt() {
-		value = 0;
-	}
-	T Increment() {
-		return __sync_add_and_fetch(&value, 1);
-	}
-	T Decrement() {
-		return __sync_sub_and_fetch(&value, 1);
-	}
-	T Get() { return value; }
-#endif
+	DSL_ShardedCounter();
+	~DSL_ShardedCounter();
+	DSL_ShardedCounter(const DSL_ShardedCounter&) = delete;
+	DSL_ShardedCounter& operator=(const DSL_ShardedCounter&) = delete;
+
+	void Add(int64 val) { slot().value.fetch_add(val, memory_order_relaxed); }
+	void Increment() { Add(1); }
+	void Decrement() { Add(-1); }
+	int64 Get() const; ///< Sum of all the slots
+	void Reset(); ///< Sets the counter back to 0
+
+	operator int64() const { return Get(); }
+	DSL_ShardedCounter& operator+=(int64 val) { Add(val); return *this; }
+	DSL_ShardedCounter& operator-=(int64 val) { Add(-val); return *this; }
+	DSL_ShardedCounter& operator++() { Add(1); return *this; }
+	DSL_ShardedCounter& operator--() { Add(-1); return *this; }
+	void operator++(int) { Add(1); }
+	void operator--(int) { Add(-1); }
 };
 
 /**@}*/
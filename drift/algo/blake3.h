@@ -0,0 +1,74 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+#ifndef __DSL_BLAKE3_H__
+#define __DSL_BLAKE3_H__
+
+/** \addtogroup hash
+ * @{
+ */
+
+#define BLAKE3_KEY_LEN 32
+#define BLAKE3_OUT_LEN 32 ///< The default output size, any length can be read with blake3_hasher_finalize()
+#define BLAKE3_BLOCK_LEN 64
+#define BLAKE3_CHUNK_LEN 1024
+#define BLAKE3_MAX_DEPTH 54
+
+/**
+ * blake3_hasher_update() splits inputs at least this big between the default thread pool's threads (if it has more than one.)
+ */
+#define BLAKE3_PARALLEL_MIN (128 * 1024)
+
+#ifndef DOXYGEN_SKIP
+struct blake3_chunk_state {
+	uint32 cv[8];
+	uint64 chunk_counter;
+	uint8 buf[BLAKE3_BLOCK_LEN];
+	uint8 buf_len;
+	uint8 blocks_compressed;
+	uint8 flags;
+};
+#endif
+
+/**
+ * BLAKE3 state, it is plain data so it can be copied to fork a hash mid-stream.<br>
+ * hash_init("blake3") gives you the default (unkeyed, 32 byte) mode through the normal hash API, use these functions directly for the keyed and key derivation modes or for more (or less) output.
+ */
+struct blake3_hasher {
+#ifndef DOXYGEN_SKIP
+	uint32 key[8];
+	blake3_chunk_state chunk;
+	uint8 cv_stack_len;
+	uint8 cv_stack[(BLAKE3_MAX_DEPTH + 1) * BLAKE3_OUT_LEN];
+#endif
+};
+
+DSL_API void DSL_CC blake3_hasher_init(blake3_hasher * self); ///< Plain hashing
+DSL_API void DSL_CC blake3_hasher_init_keyed(blake3_hasher * self, const uint8 key[BLAKE3_KEY_LEN]); ///< Keyed hashing (a MAC/PRF), use this instead of HMAC
+/**
+ * Key derivation mode.
+ * @param context A hardcoded, globally unique string describing what the key is for, like "example.com 2025-01-01 session tokens". The key material is what you feed to blake3_hasher_update().
+ */
+DSL_API void DSL_CC blake3_hasher_init_derive_key(blake3_hasher * self, const char * context);
+DSL_API void DSL_CC blake3_hasher_init_derive_key_raw(blake3_hasher * self, const void * context, size_t context_len); ///< Same as blake3_hasher_init_derive_key() with a context that isn't a C string
+/**
+ * Adds input. Full chunks are hashed several at a time with SSE4.1/AVX2/AVX-512 when the CPU has them, and inputs of BLAKE3_PARALLEL_MIN or more are also split between the threads of the default thread pool.
+ */
+DSL_API void DSL_CC blake3_hasher_update(blake3_hasher * self, const void * input, size_t input_len);
+/**
+ * Writes out_len bytes of output. This doesn't change self, so you can keep adding input and finalize again. Any out_len works (it's an extendable output function), shorter outputs are prefixes of longer ones.
+ */
+DSL_API void DSL_CC blake3_hasher_finalize(const blake3_hasher * self, uint8 * out, size_t out_len);
+DSL_API void DSL_CC blake3_hasher_finalize_seek(const blake3_hasher * self, uint64 seek, uint8 * out, size_t out_len); ///< Like blake3_hasher_finalize() but starts at byte seek of the output stream
+DSL_API void DSL_CC blake3_hasher_reset(blake3_hasher * self); ///< Starts over in the same mode with the same key
+
+/**@}*/
+
+#endif // __DSL_BLAKE3_H__
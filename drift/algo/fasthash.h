@@ -0,0 +1,79 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+#ifndef __DSL_FASTHASH_H__
+#define __DSL_FASTHASH_H__
+
+/** \addtogroup hash
+ * @{
+ */
+
+/*
+ * Non-cryptographic hashes and checksums, for hash tables, dedup keys and catching corruption.
+ * None of these are any good against someone deliberately making collisions, use sha256/blake3 (or blake3_hasher_init_keyed()) for that.
+ *
+ * They can also be used through hash_init()/hashdata() as "xxh3-64", "xxh3-128", "wyhash", "crc32" and "crc32c". The digest bytes there are
+ * big endian (XXH3's canonical form), so the hex matches what xxhsum, crc32, etc. print.
+ */
+
+/**
+ * XXH3 64-bit, compatible with XXH3_64bits_withSeed() from xxHash 0.8. The long input loop uses AVX2 when the CPU has it.
+ */
+DSL_API uint64 DSL_CC xxh3_64(const void * data, size_t len, uint64 seed = 0);
+
+struct xxh3_128_hash {
+	uint64 low;
+	uint64 high;
+};
+/**
+ * XXH3 128-bit (XXH128), compatible with XXH3_128bits_withSeed() from xxHash 0.8.
+ */
+DSL_API xxh3_128_hash DSL_CC xxh3_128(const void * data, size_t len, uint64 seed = 0);
+
+/**
+ * Streaming XXH3 state, plain data so it can be copied mid-stream. The same state gives either the 64 or the 128-bit digest.
+ */
+struct xxh3_state {
+#ifndef DOXYGEN_SKIP
+	uint64 acc[8];
+	uint8 secret[192];
+	uint8 buffer[256];
+	uint32 buffered;
+	size_t stripes_so_far;
+	uint64 total_len;
+	uint64 seed;
+#endif
+};
+
+DSL_API void DSL_CC xxh3_init(xxh3_state * state, uint64 seed = 0);
+DSL_API void DSL_CC xxh3_update(xxh3_state * state, const void * data, size_t len);
+DSL_API uint64 DSL_CC xxh3_digest64(const xxh3_state * state); ///< The state isn't changed, you can keep adding data
+DSL_API xxh3_128_hash DSL_CC xxh3_digest128(const xxh3_state * state); ///< The state isn't changed, you can keep adding data
+
+/**
+ * wyhash (final 4.2 with the default secret), the quickest option for hash table keys.<br>
+ * It can't be computed incrementally, so hash_init("wyhash") keeps a copy of everything you feed it until hash_finish().
+ */
+DSL_API uint64 DSL_CC wyhash(const void * data, size_t len, uint64 seed = 0);
+
+/**
+ * CRC-32 (the zlib/gzip/PNG/Ethernet one). Pass 0 as crc to start, or a previous result to continue it, same as zlib's crc32().<br>
+ * Uses PCLMULQDQ folding when the CPU has it.
+ */
+DSL_API uint32 DSL_CC dsl_crc32(uint32 crc, const void * data, size_t len);
+/**
+ * CRC-32C (Castagnoli, used by iSCSI, ext4, SCTP, etc.) Works like dsl_crc32().<br>
+ * Uses the SSE4.2 crc32 instruction, plus PCLMULQDQ folding for larger buffers.
+ */
+DSL_API uint32 DSL_CC dsl_crc32c(uint32 crc, const void * data, size_t len);
+
+/**@}*/
+
+#endif // __DSL_FASTHASH_H__
@@ -0,0 +1,106 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+#ifndef __DSL_HASH_ACCEL_H__
+#define __DSL_HASH_ACCEL_H__
+
+#include <drift/hash.h>
+
+/*
+ * Internal to the native hash provider: CPU feature detection and the hardware accelerated block functions.
+ * The scalar code in sha1.cpp/sha2.cpp picks one of these once at runtime and falls back to itself when the CPU (or compiler) can't do better.
+ */
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	#if defined(_MSC_VER) || defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)
+		#define DSL_HASH_X86
+	#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	// older GCCs can't use the crypto intrinsics in a function-level target
+	#if defined(_MSC_VER) || defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 10)
+		#define DSL_HASH_ARM64
+	#endif
+#endif
+
+// multi-buffer kernels for hash_batch(), they use GCC/Clang vector extensions
+#if defined(DSL_HASH_X86) && (defined(__GNUC__) || defined(__clang__))
+	#define DSL_HASH_MB
+#endif
+
+// Lets a single function use instructions the rest of the build doesn't assume. MSVC allows intrinsics anywhere so it's a no-op there.
+#if defined(__GNUC__) || defined(__clang__)
+	#define DSL_HASH_TARGET(x) __attribute__((target(x)))
+#else
+	#define DSL_HASH_TARGET(x)
+#endif
+
+#if defined(__clang__)
+	#define DSL_HASH_TARGET_ARM_CRYPTO DSL_HASH_TARGET("crypto")
+#else
+	#define DSL_HASH_TARGET_ARM_CRYPTO DSL_HASH_TARGET("+crypto")
+#endif
+
+struct DSL_HASH_CPU {
+	// x86
+	bool ssse3;
+	bool sse41;
+	bool sse42;
+	bool pclmul;
+	bool avx2; ///< AVX2 + BMI2 and enabled by the OS
+	bool avx512; ///< AVX-512 F + VL + BW and enabled by the OS
+	bool sha; ///< Intel SHA extensions (SHA-1 and SHA-256)
+
+	// ARMv8
+	bool arm_sha1;
+	bool arm_sha2;
+	bool arm_sha512;
+	bool arm_sha3;
+	bool arm_crc32;
+	bool arm_pmull;
+};
+
+/**
+ * The features the hash code can use on this CPU, detected on first use. Setting the environment variable DSL_NO_HASH_ACCEL before then turns them all off, handy for benchmarking or ruling out the accelerated code.
+ */
+const DSL_HASH_CPU * dsl_hash_cpu();
+
+typedef void (*sha1_blocks_func)(uint32 h[5], const uint8 * data, size_t nblocks);
+typedef void (*sha256_blocks_func)(uint32 h[8], const uint8 * data, size_t nblocks);
+typedef void (*sha512_blocks_func)(uint64 h[8], const uint8 * data, size_t nblocks);
+
+/* The block functions sha1.cpp/sha2.cpp picked for this CPU */
+sha1_blocks_func sha1_get_blocks();
+sha256_blocks_func sha256_get_blocks();
+
+/* The Keccak-f[1600] permutation and its round constants from sha3.cpp */
+void keccakf1600(uint64 s[25]);
+extern const uint64 keccakf_rndc[24];
+
+/* hash_batch() back ends: out gets count digests back to back */
+void md5_batch(const HASH_BATCH_ITEM * items, size_t count, uint8 * out);
+void sha1_batch(const HASH_BATCH_ITEM * items, size_t count, uint8 * out);
+void sha256_batch(const HASH_BATCH_ITEM * items, size_t count, uint8 * out);
+void sha3_256_batch(const HASH_BATCH_ITEM * items, size_t count, uint8 * out);
+void sha3_512_batch(const HASH_BATCH_ITEM * items, size_t count, uint8 * out);
+void keccak256_batch(const HASH_BATCH_ITEM * items, size_t count, uint8 * out);
+void keccak512_batch(const HASH_BATCH_ITEM * items, size_t count, uint8 * out);
+
+#if defined(DSL_HASH_X86)
+void sha1_blocks_shani(uint32 h[5], const uint8 * data, size_t nblocks);
+void sha256_blocks_shani(uint32 h[8], const uint8 * data, size_t nblocks);
+void sha512_blocks_avx2(uint64 h[8], const uint8 * data, size_t nblocks);
+void sha512_blocks_avx512(uint64 h[8], const uint8 * data, size_t nblocks);
+#endif
+#if defined(DSL_HASH_ARM64)
+void sha1_blocks_armv8(uint32 h[5], const uint8 * data, size_t nblocks);
+void sha256_blocks_armv8(uint32 h[8], const uint8 * data, size_t nblocks);
+#endif
+
+#endif // __DSL_HASH_ACCEL_H__
@@ -35,7 +35,9 @@
 #define SHA2_H
 
 #define SHA256_DIGEST_SIZE ( 256 / 8)
+#define SHA384_DIGEST_SIZE ( 384 / 8)
 #define SHA512_DIGEST_SIZE ( 512 / 8)
+#define SHA512_256_DIGEST_SIZE ( 256 / 8)
 
 #define SHA256_BLOCK_SIZE  ( 512 / 8)
 #define SHA512_BLOCK_SIZE  (1024 / 8)
@@ -45,14 +47,14 @@ extern "C" {
 #endif
 
 typedef struct {
-    unsigned int tot_len;
+    uint64 tot_len;
     unsigned int len;
     unsigned char block[2 * SHA256_BLOCK_SIZE];
     uint32 h[8];
 } sha256_ctx;
 
 typedef struct {
-    unsigned int tot_len;
+    uint64 tot_len;
     unsigned int len;
     unsigned char block[2 * SHA512_BLOCK_SIZE];
     uint64 h[8];
@@ -75,6 +77,17 @@ void sha512_final(sha512_ctx *ctx, unsigned char *digest);
 void sha512(const unsigned char *message, unsigned int len,
             unsigned char *digest);
 
+void sha384_init(sha384_ctx *ctx);
+void sha384_update(sha384_ctx *ctx, const unsigned char *message,
+                   unsigned int len);
+void sha384_final(sha384_ctx *ctx, unsigned char *digest);
+void sha384(const unsigned char *message, unsigned int len,
+            unsigned char *digest);
+
+/* SHA-512/256, use sha512_update() in between */
+void sha512_256_init(sha512_ctx *ctx);
+void sha512_256_final(sha512_ctx *ctx, unsigned char *digest);
+
 #ifdef __cplusplus
 }
 #endif
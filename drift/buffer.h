@@ -22,7 +22,8 @@
  */
 
 /** \struct DSL_BUFFER
- * Data Buffer structure. data/udata are just a convenience union to point to the same data as a signed or unsigned ptr.
+ * Data Buffer structure. data/udata are just a convenience union to point to the same data as a signed or unsigned ptr.<br>
+ * data always points to the first valid byte, removing data from the front just advances it instead of moving the remaining data. The consumed space is reclaimed lazily when an append/prepend needs room.
  */
 struct DSL_BUFFER {
 	DSL_Mutex * hMutex; ///< Handle to the mutex protecting this buffer, if enabled.
@@ -31,20 +32,47 @@ struct DSL_BUFFER {
 		uint8 * udata;
 	};
 	int64 len;
-	int64 capacity;
+	int64 capacity; ///< Size of the underlying allocation, including any consumed space at the front (see head)
+	int64 head; ///< Number of bytes consumed from the front of the allocation, data - head is the start of the allocation
+	uint32 flags; ///< See the DSL_BUFFER_FLAG_* defines
+	int64 spill_threshold; ///< If > 0 the data is moved to a temporary file once the buffer needs more than this many bytes, see buffer_init_spill()
+	struct DSL_BUFFER_SPILL * spill; ///< Temporary file state once the buffer has spilled to disk
 };
 
+#define DSL_BUFFER_FLAG_INLINE	0x00000001 ///< The buffer is using caller-provided storage, see buffer_init_inline()
+#define DSL_BUFFER_FLAG_SPILLED	0x00000002 ///< The data is in a memory-mapped temporary file, see buffer_init_spill()
+
 DSL_API void DSL_CC buffer_init(DSL_BUFFER * buf, bool useMutex = false); ///< Initialize the buffer, optionally with a mutex protecting it. If you don't use the mutex you need to either synchronize access yourself or only use it from a single thread.
+/**
+ * Initialize a buffer that stays in RAM until it needs more than threshold bytes, then transparently moves to a memory-mapped temporary file. data/len work exactly the same (including through RW_ConvertBuffer) but the pages are backed by the file so the OS can write them out instead of the process running out of memory.<br>
+ * The temp file is deleted as soon as it is created (on Windows when it is closed) so nothing is left behind.
+ * @param threshold The size at which to spill to disk, 0 to never spill.
+ * @sa buffer_set_spill_defaults
+ */
+DSL_API void DSL_CC buffer_init_spill(DSL_BUFFER * buf, int64 threshold, bool useMutex = false);
+/**
+ * Sets the spill threshold used by buffer_init() (so existing code that uses DSL_BUFFER like downloads and serialization gets it automatically) and the directory to create spill files in. Call this at startup before creating any buffers.
+ * @param threshold The default threshold for new buffers, 0 (the default) to never spill.
+ * @param tmpdir The directory to create temp files in, NULL to use TMPDIR or /tmp (or GetTempPath() on Windows.)
+ */
+DSL_API void DSL_CC buffer_set_spill_defaults(int64 threshold, const char * tmpdir = NULL);
+/**
+ * Initialize the buffer to use your own storage (for example a stack array) so small payloads don't need any allocations. If it ever needs more than size bytes the data is moved to the heap transparently. The storage must stay valid until buffer_free().
+ * @sa DSL_INLINE_BUFFER
+ */
+DSL_API void DSL_CC buffer_init_inline(DSL_BUFFER * buf, void * storage, int64 size);
 DSL_API void DSL_CC buffer_free(DSL_BUFFER * buf); ///< Free the buffer when you are done with it.
 DSL_API_CLASS string buffer_as_string(DSL_BUFFER * buf); ///< Gets the buffer as a string
 
 DSL_API void DSL_CC buffer_clear(DSL_BUFFER * buf, bool force_free = false); ///< Sets the buffer length to 0 and clears the data. It is still ready to be used unlike buffer_free. By default the underlying memory isn't actually freed so it's ready to reuse without new allocations (same as STL vectors), set force_free = true to actually free it.
 DSL_API void DSL_CC buffer_set(DSL_BUFFER * buf, const char * ptr, int64 len); ///< Sets the buffer to the specified data, discarding anything existing.
-DSL_API void DSL_CC buffer_resize(DSL_BUFFER * buf, int64 len); ///< Resize the buffer, if the length is longer then the existing data the added byte values are undefined.
+DSL_API bool DSL_CC buffer_resize(DSL_BUFFER * buf, int64 len); ///< Resize the buffer, if the length is longer then the existing data the added byte values are undefined. Returns false (and leaves the buffer as it was) if it couldn't grow.
+
+DSL_API void DSL_CC buffer_compact(DSL_BUFFER * buf); ///< Moves the data back to the start of the allocation, reclaiming space consumed by buffer_remove_front. You normally don't need to call this since appends will do it when needed.
 
-DSL_API void DSL_CC buffer_remove_front(DSL_BUFFER * buf, int64 len); ///< Remove data from the beginning of the buffer.
+DSL_API void DSL_CC buffer_remove_front(DSL_BUFFER * buf, int64 len); ///< Remove data from the beginning of the buffer. This is O(1), it only advances the read position.
 DSL_API void DSL_CC buffer_remove_end(DSL_BUFFER * buf, int64 len); ///< Remove data from the end of the buffer.
-DSL_API bool DSL_CC buffer_prepend(DSL_BUFFER * buf, const char * ptr, int64 len); ///< Add data to the beginning of the buffer.
+DSL_API bool DSL_CC buffer_prepend(DSL_BUFFER * buf, const char * ptr, int64 len); ///< Add data to the beginning of the buffer. If there is enough consumed space at the front it is reused without moving the existing data.
 DSL_API bool DSL_CC buffer_append(DSL_BUFFER * buf, const char * ptr, int64 len); ///< Add data to the end of the buffer.
 
 /**
@@ -53,6 +81,26 @@ DSL_API bool DSL_CC buffer_append(DSL_BUFFER * buf, const char * ptr, int64 len)
  */
 template <typename T> bool buffer_append_int(DSL_BUFFER * buf, T y) { return buffer_append(buf, (char *)&y, sizeof(y)); }
 
+/**
+ * Gets an initialized buffer (without a mutex) from the calling thread's pool, allocating one only if the pool for that size class is empty. Return it with buffer_release() instead of buffer_free().
+ * @param capacity Hint for how much data you expect to put in it, the buffer will have at least this much space reserved.
+ */
+DSL_API DSL_BUFFER * DSL_CC buffer_acquire(int64 capacity = 0);
+DSL_API void DSL_CC buffer_release(DSL_BUFFER * buf); ///< Returns a buffer to the calling thread's pool. It doesn't have to be the same thread that acquired it. Buffers that are too big or when the pool is full are freed.
+DSL_API void DSL_CC buffer_pool_trim(); ///< Frees all buffers cached in the calling thread's pool. This happens automatically when the thread exits.
+
+/**
+ * DSL_BUFFER with N bytes of inline storage, handy as a local variable for small payloads. It is initialized and freed for you.
+ */
+template <size_t N> struct DSL_INLINE_BUFFER : public DSL_BUFFER {
+	char storage[N];
+
+	DSL_INLINE_BUFFER() { buffer_init_inline(this, storage, N); }
+	~DSL_INLINE_BUFFER() { buffer_free(this); }
+	DSL_INLINE_BUFFER(const DSL_INLINE_BUFFER&) = delete;
+	DSL_INLINE_BUFFER& operator=(const DSL_INLINE_BUFFER&) = delete;
+};
+
 /**@}*/
 
 #endif // __DSL_BUFFER_H__
@@ -0,0 +1,96 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+#ifndef __DSL_BYTE_QUEUE_H__
+#define __DSL_BYTE_QUEUE_H__
+
+#include <drift/mutex.h>
+
+/** \addtogroup buffer
+ * @{
+ */
+
+/**
+ * A reserved region of a DSL_ByteQueue to be filled in by the producer. Because the queue is a ring the region may be split into 2 parts.
+ */
+struct DSL_ByteQueue_Reservation {
+	uint8 * ptr[2];
+	size_t len[2];
+#ifndef DOXYGEN_SKIP
+	uint64 start;
+	size_t size;
+	size_t written;
+#endif
+
+	/**
+	 * Copies data into the next unwritten part of the reservation.
+	 * @return The number of bytes copied, less than len if the reservation is full.
+	 */
+	DSL_API_CLASS size_t Write(const void * data, size_t len);
+};
+
+/**
+ * Lock-free ring byte queue for handing data from producer thread(s) to a single consumer thread, for example a socket reader and a parser. It has the same append/peek/consume semantics as DSL_BUFFER but no operation takes a lock.<br>
+ * In single producer mode the producer and consumer only touch their own index. In multi producer mode producers claim space with a CAS and commit in order.<br>
+ * Waits use DSL_EventCount (a futex on Linux) so they don't cost anything unless the thread actually needs to sleep.<br>
+ * Timeouts follow DSL_Mutex: 0 = don't wait, <0 = wait forever, >0 = milliseconds.
+ */
+class DSL_API_CLASS DSL_ByteQueue {
+private:
+	uint8 * data;
+	size_t capacity;
+	uint64 mask;
+	bool multi_producer;
+
+	alignas(64) atomic<uint64> reserved; // MPSC only, next byte a producer can claim
+	alignas(64) atomic<uint64> committed; // bytes visible to the consumer
+	alignas(64) atomic<uint64> head; // consumer position
+	DSL_EventCount data_event, space_event;
+
+	template <typename T> bool wait_for(DSL_EventCount& ev, int timeout, T cond);
+public:
+	/**
+	 * @param capacity The size of the ring, rounded up to a power of 2.
+	 * @param multi_producer Set to true if more than one thread will be adding data.
+	 */
+	DSL_ByteQueue(size_t capacity, bool multi_producer = false);
+	~DSL_ByteQueue();
+
+	/* Producer side */
+
+	/**
+	 * Reserves space in the queue to fill in yourself, for example so a socket can recv() straight into it or to commit several chunks at once. Call Commit() when you are done with it.<br>
+	 * In multi producer mode other producers' data will not become visible until yours is committed, so don't hold on to it for long.
+	 * @return false if there isn't enough space before the timeout or len > capacity.
+	 */
+	bool Reserve(size_t len, DSL_ByteQueue_Reservation * res, int timeout = 0);
+	void Commit(DSL_ByteQueue_Reservation * res); ///< Makes the reserved data visible to the consumer. Unwritten bytes of the reservation are zeroed.
+	bool Append(const void * ptr, size_t len, int timeout = 0); ///< Adds data to the queue. It is all or nothing, returns false if there isn't enough space before the timeout or len > capacity.
+	bool WaitForSpace(size_t len, int timeout = -1); ///< Waits until there is at least len bytes of free space (only a hint in multi producer mode)
+
+	/* Consumer side, only one thread at a time */
+
+	size_t Peek(void * buf, size_t len, size_t offset = 0); ///< Copies data without consuming it, returns the number of bytes copied.
+	size_t Read(void * buf, size_t len); ///< Copies data and consumes it, returns the number of bytes copied.
+	/**
+	 * Gets a pointer to the readable data at the front of the queue without copying it. Because the queue is a ring this may be less than Length(), call Consume() and GetReadPtr() again to get the rest.
+	 * @return The number of contiguous bytes at ptr.
+	 */
+	size_t GetReadPtr(const uint8 ** ptr);
+	void Consume(size_t len); ///< Removes data from the front of the queue.
+	bool WaitForData(size_t len = 1, int timeout = -1); ///< Waits until there is at least len bytes in the queue.
+
+	size_t Length(); ///< The number of committed bytes in the queue.
+	size_t Capacity() { return capacity; }
+};
+
+/**@}*/
+
+#endif // __DSL_BYTE_QUEUE_H__
@@ -0,0 +1,133 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+#ifndef __DSL_CHAIN_BUFFER_H__
+#define __DSL_CHAIN_BUFFER_H__
+
+#include <drift/buffer.h>
+#include <drift/rwops.h>
+#if !defined(WIN32)
+#include <sys/uio.h>
+#endif
+
+/** \addtogroup buffer
+ * @{
+ */
+
+#if defined(WIN32)
+typedef WSABUF DSL_IOVEC; ///< An iovec on POSIX (for writev/sendmsg) or a WSABUF on Windows (for WSASend)
+#else
+typedef struct iovec DSL_IOVEC; ///< An iovec on POSIX (for writev/sendmsg) or a WSABUF on Windows (for WSASend)
+#endif
+
+#define DSL_CHAIN_BUFFER_DEFAULT_SEGMENT_SIZE 16384
+
+/**
+ * Called when a segment referencing external memory is no longer needed by the chain.
+ * @param ptr The pointer that was passed to chain_buffer_append_ref/chain_buffer_prepend_ref
+ * @param len The length that was passed to chain_buffer_append_ref/chain_buffer_prepend_ref
+ */
+typedef void (*chain_buffer_release_func)(void * ptr, int64 len, void * user_ptr);
+
+/** \struct DSL_CHAIN_SEGMENT
+ * One segment in a DSL_CHAIN_BUFFER, either a fixed-size block owned by the chain or a reference to external memory.
+ */
+struct DSL_CHAIN_SEGMENT {
+	DSL_CHAIN_SEGMENT * prev;
+	DSL_CHAIN_SEGMENT * next;
+	uint8 * data; ///< Pointer to the first valid byte in this segment
+	int64 len; ///< Number of valid bytes at data
+
+#ifndef DOXYGEN_SKIP
+	uint8 * base; ///< Start of the segment's memory
+	int64 capacity; ///< Size of the memory at base, only data owned by the chain can be written to
+	chain_buffer_release_func release;
+	void * release_ptr; ///< Original pointer to pass to release
+	int64 release_len; ///< Original length to pass to release
+	void * user_ptr;
+	bool owned;
+#endif
+};
+
+/** \struct DSL_CHAIN_BUFFER
+ * Segmented data buffer. Unlike DSL_BUFFER the data is not contiguous, it is a list of segments so appending never has to reallocate/copy existing data and you can add external memory (mmap'ed files, caller-owned blocks, etc.) without copying it.<br>
+ * Walk the segments with first/next or export them with chain_buffer_get_iovec() for writev()/sendmsg().
+ */
+struct DSL_CHAIN_BUFFER {
+	DSL_Mutex * hMutex; ///< Handle to the mutex protecting this buffer, if enabled.
+	DSL_CHAIN_SEGMENT * first;
+	DSL_CHAIN_SEGMENT * last;
+	int64 len; ///< Total number of bytes in all segments
+	int64 segment_size; ///< Size of segments allocated for copied data
+	uint32 num_segments;
+};
+
+DSL_API void DSL_CC chain_buffer_init(DSL_CHAIN_BUFFER * buf, int64 segment_size = DSL_CHAIN_BUFFER_DEFAULT_SEGMENT_SIZE, bool useMutex = false); ///< Initialize the buffer, optionally with a mutex protecting it. If you don't use the mutex you need to either synchronize access yourself or only use it from a single thread.
+DSL_API void DSL_CC chain_buffer_free(DSL_CHAIN_BUFFER * buf); ///< Free the buffer when you are done with it. Release callbacks are called for any remaining external segments.
+DSL_API void DSL_CC chain_buffer_clear(DSL_CHAIN_BUFFER * buf); ///< Removes all data, the buffer is still ready to be used unlike chain_buffer_free.
+DSL_API_CLASS string chain_buffer_as_string(DSL_CHAIN_BUFFER * buf); ///< Gets the buffer as a string
+
+DSL_API bool DSL_CC chain_buffer_append(DSL_CHAIN_BUFFER * buf, const char * ptr, int64 len); ///< Copy data to the end of the buffer. Only allocates when the last segment is full.
+DSL_API bool DSL_CC chain_buffer_prepend(DSL_CHAIN_BUFFER * buf, const char * ptr, int64 len); ///< Copy data to the beginning of the buffer. Existing data is never moved.
+/**
+ * Add a reference to external memory to the end of the buffer without copying it. The memory must stay valid and unchanged until release is called.
+ * @param release Optional callback called once the chain no longer references the memory (consumed, cleared or freed.)
+ */
+DSL_API bool DSL_CC chain_buffer_append_ref(DSL_CHAIN_BUFFER * buf, const void * ptr, int64 len, chain_buffer_release_func release = NULL, void * user_ptr = NULL);
+/**
+ * Add a reference to external memory to the beginning of the buffer without copying it. The memory must stay valid and unchanged until release is called.
+ * @param release Optional callback called once the chain no longer references the memory (consumed, cleared or freed.)
+ */
+DSL_API bool DSL_CC chain_buffer_prepend_ref(DSL_CHAIN_BUFFER * buf, const void * ptr, int64 len, chain_buffer_release_func release = NULL, void * user_ptr = NULL);
+/**
+ * Takes ownership of the memory in a DSL_BUFFER and appends it as a segment without copying. src is left empty but still initialized.
+ */
+DSL_API bool DSL_CC chain_buffer_append_buffer(DSL_CHAIN_BUFFER * buf, DSL_BUFFER * src);
+/**
+ * Moves all segments from src to the end of buf without copying any data. src is left empty.
+ */
+DSL_API void DSL_CC chain_buffer_append_chain(DSL_CHAIN_BUFFER * buf, DSL_CHAIN_BUFFER * src);
+
+/**
+ * Copies data from the buffer without removing it.
+ * @param offset The position in the buffer to start copying from.
+ * @return The number of bytes copied.
+ */
+DSL_API int64 DSL_CC chain_buffer_peek(DSL_CHAIN_BUFFER * buf, void * dst, int64 len, int64 offset = 0);
+/**
+ * Copies data from the beginning of the buffer and removes it.
+ * @return The number of bytes copied.
+ */
+DSL_API int64 DSL_CC chain_buffer_read(DSL_CHAIN_BUFFER * buf, void * dst, int64 len);
+DSL_API void DSL_CC chain_buffer_remove_front(DSL_CHAIN_BUFFER * buf, int64 len); ///< Remove data from the beginning of the buffer. Fully consumed segments are freed/released.
+/**
+ * Copies the whole chain (or the first len bytes if len >= 0) to the end of a DSL_BUFFER.
+ */
+DSL_API bool DSL_CC chain_buffer_to_buffer(DSL_CHAIN_BUFFER * buf, DSL_BUFFER * dst, int64 len = -1);
+
+/**
+ * Fills an array of iovecs with the segments at the start of the buffer, ready for writev()/sendmsg()/WSASend(). After sending use chain_buffer_remove_front() with the number of bytes that were actually sent.<br>
+ * If the buffer has a mutex it is your responsibility to make sure the buffer isn't changed while you use the iovecs.
+ * @param max_iov The number of entries in iov.
+ * @param max_bytes Stop after this many bytes, <0 for no limit.
+ * @return The number of iov entries filled in.
+ */
+DSL_API int DSL_CC chain_buffer_get_iovec(DSL_CHAIN_BUFFER * buf, DSL_IOVEC * iov, int max_iov, int64 max_bytes = -1);
+
+/**
+ * Creates a stream handle for a DSL_CHAIN_BUFFER. Writes are appended to the end of the chain and reads consume data from the beginning, so the position only moves forward (seek only supports skipping forward with SEEK_CUR.)
+ * @param autofree If true the chain buffer is freed with chain_buffer_free (but not dsl_free'd) when the handle is closed.
+ * @return A handle on success, NULL on failure.
+ */
+DSL_API DSL_FILE * DSL_CC RW_ConvertChainBuffer(DSL_CHAIN_BUFFER * buf, bool autofree = false);
+
+/**@}*/
+
+#endif // __DSL_CHAIN_BUFFER_H__
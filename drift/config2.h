@@ -12,6 +12,7 @@
 #define __UNIVERSAL_CONFIG2_H__
 
 #include <drift/ds_value.h>
+#include <drift/mutex.h>
 
 /**
  * \defgroup config2 Configuration Reader/Writer V2
@@ -85,6 +86,7 @@ protected:
 	string _name;
 	valueList _values;
 	sectionList _sections; // sub-sections
+	mutable DSL_RWLock hLock; // protects _values and _sections, not the ConfigValues themselves
 
 	DSL_CONFIG_FORMAT getSerializerModeFromFN(const string& filename) const;
 
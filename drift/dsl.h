@@ -28,9 +28,15 @@
 #include <drift/config2.h>
 #include <drift/mutex.h>
 #include <drift/buffer.h>
+#include <drift/chain_buffer.h>
+#include <drift/byte_queue.h>
 #include <drift/sockets3.h>
 #include <drift/download.h>
 #include <drift/threading.h>
+#include <drift/thread_pool.h>
+#include <drift/parallel.h>
+#include <drift/queue.h>
+#include <drift/scheduler.h>
 #include <drift/SyncedInt.h>
 #include <drift/directory.h>
 #include <drift/serialize.h>
@@ -31,19 +31,70 @@ struct HASH_CTX {
 	const HASH_PROVIDER * provider;
 	void *pptr1;
 	const HASH_NATIVE * impl;
+	bool inplace; ///< lives in caller storage, the provider must not free the ctx itself
 #endif
 };
 
 /**
  * Initialize a hashing CTX with hashing algorithm 'name'<br>
- * Without optional modules we support: sha3-256, sha3-512, sha256, sha512, sha1, md5, keccak256 (the pre-SHA3 version as used by Ethereum), keccak512<br>
+ * Without optional modules we support: sha3-256, sha3-512, sha256, sha512, sha1, md5, keccak256 (the pre-SHA3 version as used by Ethereum), keccak512, blake3 (see drift/algo/blake3.h for its other modes)<br>
+ * Non-cryptographic (checksums and hash table keys only): xxh3-64, xxh3-128, wyhash, crc32, crc32c. See drift/algo/fasthash.h to call them directly without a HASH_CTX.<br>
  * With ENABLE_OPENSSL: Adds the full range of OpenSSL supported hash algorithms<br>
  * With ENABLE_GNUTLS: Adds RIPEMD-160, MD2, SHA224, SHA384<br>
  * With ENABLE_SODIUM: Adds blake2b<br>
+ * The name is resolved through the hash_algo_lookup() cache, if you hash a lot of small messages keep the handle and call hash_init_algo() directly.<br>
  * See hashdata(), hashfile(), hashfile_fp(), and hashfile_rw() for one-shot convenience functions. The hashfile* ones automatically hash the file in 32K chunks so it won't try to load the entire file into memory or anything.
  * @param name The name of the hashing algorithm.
  */
 DSL_API HASH_CTX * DSL_CC hash_init(const char * name);
+
+/**
+ * A pre-resolved hashing algorithm from hash_algo_lookup().
+ */
+struct HASH_ALGO {
+	size_t hashSize;
+	size_t blockSize;
+
+#ifndef DOXYGEN_SKIP
+	const HASH_PROVIDER * provider;
+	const void * impl; ///< what provider->hash_lookup() returned, NULL if the provider doesn't have one
+	string name;
+#endif
+};
+
+/**
+ * Resolves a hashing algorithm name (see hash_init() for the list) to a handle for hash_init_algo(). Lookups are cached so repeated calls with the same name return the same handle.<br>
+ * The handle stays valid until dsl_cleanup(), or until the optional module providing it (OpenSSL, GnuTLS, etc.) is shut down.
+ * @return NULL if no provider supports the algorithm.
+ */
+DSL_API const HASH_ALGO * DSL_CC hash_algo_lookup(const char * name);
+/**
+ * Like hash_init() but with a handle from hash_algo_lookup(). There is no name matching and no global lock, so it's the one to use when lots of threads are hashing small messages.
+ */
+DSL_API HASH_CTX * DSL_CC hash_init_algo(const HASH_ALGO * algo);
+
+#define DSL_HASH_CTX_ALIGN 16 ///< the alignment hash_ctx_init_inplace()/hash_clone() need for caller storage
+
+/**
+ * The number of bytes of storage hash_ctx_init_inplace() needs for algo.
+ * @return 0 if algo's provider can't work in caller storage.
+ */
+DSL_API size_t DSL_CC hash_ctx_size(const HASH_ALGO * algo);
+/**
+ * Like hash_init_algo() but the HASH_CTX is built in storage you provide (on the stack, in a pool, etc.) With the native provider the whole hash state is in there so there are no heap allocations at all, OpenSSL and GnuTLS still allocate their own state once per ctx.<br>
+ * hash_finish() releases any provider resources but not storage. Use hash_finish_reset() to hash more messages with the same ctx.
+ * @param storage At least hash_ctx_size(algo) bytes, aligned to DSL_HASH_CTX_ALIGN.
+ * @return NULL if storage is too small or the provider doesn't support it.
+ */
+DSL_API HASH_CTX * DSL_CC hash_ctx_init_inplace(const HASH_ALGO * algo, void * storage, size_t size);
+DSL_API bool DSL_CC hash_reset(HASH_CTX * ctx); ///< Throws away anything hashed so far so ctx can start on a new message. Returns false if the provider can't do it, ctx is still valid in that case.
+DSL_API bool DSL_CC hash_finish_reset(HASH_CTX * ctx, uint8 * out, size_t outlen); ///< Like hash_finish() but ctx is ready for a new message afterwards instead of being destroyed. Returns false if the provider can't do it, ctx is still valid in that case.
+/**
+ * Copies ctx mid-message, for example to hash several messages sharing a prefix while only hashing the prefix once.
+ * @param storage NULL for a heap allocated copy, otherwise the copy is built there like hash_ctx_init_inplace() does.
+ * @return NULL if the provider doesn't support it or storage is too small.
+ */
+DSL_API HASH_CTX * DSL_CC hash_clone(const HASH_CTX * ctx, void * storage = NULL, size_t size = 0);
 DSL_API void DSL_CC hash_update(HASH_CTX *ctx, const uint8 *input, size_t length); ///< Call with the data you want to hash, can be called multiple times to hash a large file in chunks for example.
 DSL_API bool DSL_CC hash_finish(HASH_CTX *ctx, uint8 * out, size_t outlen); ///< Finalize hash and store in out. outlen should be >= hashSize in the HASH_CTX struct. After this no further calls to hash_update() can be made and ctx is destroyed.
 
@@ -52,6 +103,53 @@ DSL_API bool DSL_CC hashfile(const char * name, const char * fn, char * out, siz
 DSL_API bool DSL_CC hashfile_fp(const char * name, FILE * fp, char * out, size_t outlen, bool raw_output = false); ///< Wrapper around hash_init()/hash_update()/hash_finish(). If raw_output == true out will contain binary data, otherwise will contain a hex string.
 DSL_API bool DSL_CC hashfile_rw(const char * name, DSL_FILE * fp, char * out, size_t outlen, bool raw_output = false); ///< Wrapper around hash_init()/hash_update()/hash_finish(). If raw_output == true out will contain binary data, otherwise will contain a hex string.
 
+#define DSL_HASHFILE_MMAP		0x01 ///< Map the file and hash it straight from the page cache (with sequential read-ahead advice), falls back to reading it if the file can't be mapped
+#define DSL_HASHFILE_READAHEAD	0x02 ///< When reading, read the next chunk on a second thread while the current one is hashed so disk I/O overlaps hashing
+#define DSL_HASHFILE_FAST		(DSL_HASHFILE_MMAP | DSL_HASHFILE_READAHEAD)
+
+/**
+ * hashfile() for big files, gives exactly the same result.<br>
+ * Note: with DSL_HASHFILE_MMAP, if another process truncates the file while it is being hashed you get a SIGBUS (or an EXCEPTION_IN_PAGE_ERROR on Windows, which is caught and makes this return false.) Leave it out if that can happen to your files.
+ * @param flags DSL_HASHFILE_* flags, 0 is the same as hashfile().
+ */
+DSL_API bool DSL_CC hashfile_ex(const char * name, const char * fn, char * out, size_t outlen, bool raw_output = false, uint32 flags = DSL_HASHFILE_FAST);
+
+#define DSL_HASH_TREE_CHUNK (1024*1024) ///< Default leaf size for hashdata_tree()/hashfile_tree()
+
+/**
+ * Merkle tree hash of data with hashing algorithm 'name': data is split into chunk_size leaves which are hashed in parallel on the default thread pool, then combined into one root digest.<br>
+ * The tree has the same shape as RFC 6962 (Certificate Transparency): leaf = H(0x00 || chunk), node = H(0x01 || left || right), where the left subtree covers the largest power of 2 number of leaves that is less than the total. Empty data is H() of nothing.<br>
+ * The result is NOT the same as hashdata() and it depends on chunk_size, both sides have to agree on it.
+ */
+DSL_API bool DSL_CC hashdata_tree(const char * name, const uint8 *data, size_t datalen, char * out, size_t outlen, bool raw_output = false, size_t chunk_size = DSL_HASH_TREE_CHUNK);
+/**
+ * hashdata_tree() of a file. With DSL_HASHFILE_MMAP it is mapped into memory if possible, otherwise it is read in groups of chunks (with DSL_HASHFILE_READAHEAD the next group is read while the current one is hashed.)<br>
+ * Note: the same SIGBUS caveat as hashfile_ex() applies with DSL_HASHFILE_MMAP.
+ * @param flags DSL_HASHFILE_* flags.
+ */
+DSL_API bool DSL_CC hashfile_tree(const char * name, const char * fn, char * out, size_t outlen, bool raw_output = false, size_t chunk_size = DSL_HASH_TREE_CHUNK, uint32 flags = DSL_HASHFILE_FAST);
+struct HASH_BATCH_ITEM {
+	const uint8 * data;
+	size_t length;
+};
+
+/**
+ * Hashes count independent messages in one call, which is much faster than a hash_init()/hash_update()/hash_finish() cycle for each of them when there are lots of small ones.<br>
+ * With the native provider md5, sha1 and sha256 hash 8 or 16 messages at once in SIMD lanes (AVX2/AVX-512), other algorithms and providers are hashed one after another.
+ * @param items The messages to hash.
+ * @param out Gets the raw digests back to back, digest i starts at out + (i * hashSize).
+ * @param outlen The size of out, must be at least count * hashSize.
+ * @return false if the algorithm isn't supported or out is too small.
+ */
+DSL_API bool DSL_CC hash_batch(const char * name, const HASH_BATCH_ITEM * items, size_t count, uint8 * out, size_t outlen);
+
+/**
+ * Hashes a list of files in parallel on the default thread pool with hashfile().
+ * @param out Gets one entry per file in the same order as files, an empty string for files that couldn't be hashed.
+ * @return true if every file was hashed successfully.
+ */
+DSL_API bool DSL_CC hashfiles(const char * name, const vector<string>& files, vector<string>& out, bool raw_output = false);
+
 /**@}*/
 
 #ifndef DOXYGEN_SKIP
@@ -62,6 +160,13 @@ struct HASH_PROVIDER {
 	HASH_CTX * (*hash_init)(const char * name);
 	void(*hash_update)(HASH_CTX *ctx, const uint8 *input, size_t length);
 	bool(*hash_finish)(HASH_CTX *ctx, uint8 * out, size_t outlen);
+	bool(*hash_batch)(const char * name, const HASH_BATCH_ITEM * items, size_t count, uint8 * out, size_t outlen); ///< optional, NULL if the provider can't do better than hashing one at a time
+	const void * (*hash_lookup)(const char * name); ///< optional, resolves name to something hash_init_algo() can use without any string work. NULL if the algorithm isn't supported.
+	HASH_CTX * (*hash_init_algo)(const void * impl); ///< optional, must be set if hash_lookup is
+	size_t(*hash_ctx_size)(const void * impl); ///< optional, the storage hash_init_inplace() needs. Needs hash_lookup.
+	HASH_CTX * (*hash_init_inplace)(const void * impl, void * storage); ///< optional, must be set if hash_ctx_size is
+	bool(*hash_reset)(HASH_CTX *ctx, uint8 * out, size_t outlen); ///< optional, finishes into out if it isn't NULL and then starts over
+	HASH_CTX * (*hash_clone)(const HASH_CTX *ctx, void * storage, size_t size); ///< optional, storage is NULL for a heap copy. Returns NULL if size is too small.
 };
 
 struct HASH_NATIVE {
@@ -71,6 +176,8 @@ struct HASH_NATIVE {
 	bool(*init)(HASH_CTX * ctx);
 	void(*update)(HASH_CTX * ctx, const uint8 *input, size_t length);
 	bool(*finish)(HASH_CTX * ctx, uint8 * out);
+	void(*batch)(const HASH_BATCH_ITEM * items, size_t count, uint8 * out); ///< optional
+	size_t stateSize; ///< If set the provider puts this much (zeroed) state at pptr1 before calling init() and finish() doesn't free anything. If 0 init() allocates the state itself and finish() frees it, these can't be cloned or used in place.
 };
 
 DSL_API void DSL_CC dsl_add_hash_provider(const HASH_PROVIDER * p);
@@ -30,6 +30,7 @@ struct HASH_HMAC_CTX {
 	const HMAC_PROVIDER * provider;
 	void *pptr1;
 	const HMAC_NATIVE * impl;
+	bool inplace; ///< lives in caller storage, the provider must not free the ctx itself
 #endif
 };
 
@@ -44,9 +45,63 @@ struct HASH_HMAC_CTX {
  * @param length The length of the secret key.
  */
 DSL_API HASH_HMAC_CTX * DSL_CC hmac_init(const char * name, const uint8 *key, size_t length);
+
+#define DSL_HMAC_CTX_ALIGN 16 ///< the alignment hmac_init_inplace()/hmac_clone() need for caller storage
+
+/**
+ * The number of bytes of storage hmac_init_inplace() needs for algorithm 'name'.
+ * @return 0 if the algorithm isn't supported or its provider can't work in caller storage.
+ */
+DSL_API size_t DSL_CC hmac_ctx_size(const char * name);
+/**
+ * Like hmac_init() but the HASH_HMAC_CTX is built in storage you provide. With the native provider the whole HMAC state is in there so there are no heap allocations at all, OpenSSL and GnuTLS still allocate their own state once per ctx.<br>
+ * hmac_finish() releases any provider resources but not storage. Use hmac_finish_reset() to MAC more messages with the same key and ctx.
+ * @param storage At least hmac_ctx_size(name) bytes, aligned to DSL_HMAC_CTX_ALIGN.
+ * @return NULL if storage is too small or the provider doesn't support it.
+ */
+DSL_API HASH_HMAC_CTX * DSL_CC hmac_init_inplace(const char * name, const uint8 *key, size_t length, void * storage, size_t size);
+DSL_API bool DSL_CC hmac_reset(HASH_HMAC_CTX * ctx); ///< Throws away anything hashed so far so ctx can start on a new message with the same key. Returns false if the provider can't do it, ctx is still valid in that case.
+DSL_API bool DSL_CC hmac_finish_reset(HASH_HMAC_CTX * ctx, uint8 * out, size_t outlen); ///< Like hmac_finish() but ctx is ready for a new message with the same key afterwards instead of being destroyed.
+/**
+ * Copies ctx mid-message.
+ * @param storage NULL for a heap allocated copy, otherwise the copy is built there like hmac_init_inplace() does.
+ * @return NULL if the provider doesn't support it or storage is too small.
+ */
+DSL_API HASH_HMAC_CTX * DSL_CC hmac_clone(const HASH_HMAC_CTX * ctx, void * storage = NULL, size_t size = 0);
 DSL_API void DSL_CC hmac_update(HASH_HMAC_CTX *ctx, const uint8 *input, size_t length); ///< Call with the data you want to hash, can be called multiple times to hash a large file in chunks for example.
 DSL_API bool DSL_CC hmac_finish(HASH_HMAC_CTX *ctx, uint8 * out, size_t outlen); ///< Finalize HMAC and store in out. outlen should be >= hashSize in the HASH_CTX struct. After this no further calls to hmac_update() can be made and ctx is destroyed.
 
+/**
+ * A prepared HMAC key: the provider has already run the key schedule (the inner/outer ipad/opad states) so starting a MAC with it is just a copy. Use it when you MAC lots of messages with the same few keys.<br>
+ * It is never modified after hmac_key_create() so one key can be shared by any number of threads.
+ */
+struct HMAC_KEY {
+	size_t hashSize;
+
+#ifndef DOXYGEN_SKIP
+	HASH_HMAC_CTX * proto; ///< keyed ctx that hasn't seen any data, per-message contexts are cloned from it
+	size_t ctxSize; ///< the storage a clone of proto needs, 0 if its provider can't work in caller storage
+	char * name; ///< with key/keylen, only kept if the provider can't clone and we have to fall back to hmac_init()
+	uint8 * key;
+	size_t keylen;
+#endif
+};
+
+/**
+ * Prepares key for hashing algorithm 'name', the same ones hmac_init() supports.
+ * @return NULL if the algorithm isn't supported. Free it with hmac_key_free().
+ */
+DSL_API HMAC_KEY * DSL_CC hmac_key_create(const char * name, const uint8 *key, size_t length);
+DSL_API void DSL_CC hmac_key_free(HMAC_KEY * key); ///< Frees a key from hmac_key_create(), contexts started from it are unaffected.
+DSL_API HASH_HMAC_CTX * DSL_CC hmac_init_key(const HMAC_KEY * key); ///< Like hmac_init() but starts from a prepared key, use hmac_update()/hmac_finish() as usual.
+DSL_API size_t DSL_CC hmac_key_ctx_size(const HMAC_KEY * key); ///< The storage hmac_init_key_inplace() needs, 0 if the key's provider can't work in caller storage.
+DSL_API HASH_HMAC_CTX * DSL_CC hmac_init_key_inplace(const HMAC_KEY * key, void * storage, size_t size); ///< Like hmac_init_inplace() but starts from a prepared key. storage must be aligned to DSL_HMAC_CTX_ALIGN.
+/**
+ * One-shot MAC of data with a prepared key. With the native provider this doesn't touch the heap at all.
+ * @param out Gets the raw (binary) MAC, outlen must be >= key->hashSize.
+ */
+DSL_API bool DSL_CC hmac_key_mac(const HMAC_KEY * key, const uint8 *data, size_t datalen, uint8 * out, size_t outlen);
+
 DSL_API bool DSL_CC hmacdata(const char * name, const uint8 *key, size_t keylen, const uint8 *data, size_t datalen, char * out, size_t outlen); ///< Wrapper around hmac_init()/hmac_update()/hmac_finish(). If raw_output == true out will contain binary data, otherwise will contain a hex string.
 DSL_API bool DSL_CC hmacfile(const char * name, const uint8 *key, size_t keylen, const char * fn, char * out, size_t outlen); ///< Wrapper around hmac_init()/hmac_update()/hmac_finish(). If raw_output == true out will contain binary data, otherwise will contain a hex string.
 DSL_API bool DSL_CC hmacfile_fp(const char * name, const uint8 *key, size_t keylen, FILE * fp, char * out, size_t outlen); ///< Wrapper around hmac_init()/hmac_update()/hmac_finish(). If raw_output == true out will contain binary data, otherwise will contain a hex string.
@@ -61,6 +116,10 @@ struct HMAC_PROVIDER {
 	HASH_HMAC_CTX * (*hmac_init)(const char * name, const uint8 *key, size_t length);
 	void(*hmac_update)(HASH_HMAC_CTX *ctx, const uint8 *input, size_t length);
 	bool(*hmac_finish)(HASH_HMAC_CTX *ctx, uint8 * out, size_t outlen);
+	size_t(*hmac_ctx_size)(const char * name); ///< optional, the storage hmac_init_inplace() needs, 0 if the algorithm isn't supported
+	HASH_HMAC_CTX * (*hmac_init_inplace)(const char * name, const uint8 *key, size_t length, void * storage); ///< optional, must be set if hmac_ctx_size is
+	bool(*hmac_reset)(HASH_HMAC_CTX *ctx, uint8 * out, size_t outlen); ///< optional, finishes into out if it isn't NULL and then starts over with the same key
+	HASH_HMAC_CTX * (*hmac_clone)(const HASH_HMAC_CTX *ctx, void * storage, size_t size); ///< optional, storage is NULL for a heap copy. Returns NULL if size is too small.
 };
 
 struct HMAC_NATIVE {
@@ -69,6 +128,8 @@ struct HMAC_NATIVE {
 	bool(*init)(HASH_HMAC_CTX * ctx, const uint8 *key, size_t length);
 	void(*update)(HASH_HMAC_CTX * ctx, const uint8 *input, size_t length);
 	bool(*finish)(HASH_HMAC_CTX * ctx, uint8 * out);
+	bool(*reset)(HASH_HMAC_CTX * ctx); ///< optional, starts over with the same key
+	size_t stateSize; ///< If set the provider puts this much (zeroed) state at pptr1 before calling init() and finish() doesn't free anything. If 0 init() allocates the state itself and finish() frees it, these can't be cloned, reset or used in place.
 };
 
 DSL_API void DSL_CC dsl_add_hmac_provider(const HMAC_PROVIDER * p);
@@ -54,16 +54,21 @@ struct DSL_SOCKET_LIBEVENT {
 	dsl_sockets_event_callback connect_cb;
 };
 
-class DSL_LIBEVENT_API_CLASS DSL_Sockets_Events {
+class DSL_LIBEVENT_API_CLASS DSL_Sockets_Events : public DSL_Executor {
 	protected:
 	private:
 		DSL_Sockets3_Base * socks = NULL;
 		event_base * evbase = NULL;
 		set<DSL_SOCKET_LIBEVENT *> sockets;
+		event * evpost = NULL;
+		DSL_FastMutex post_mutex;
+		vector<function<void()>> posted;
+		static void post_cb(evutil_socket_t fd, short events, void * ptr);
 	public:
 		DSL_Sockets_Events(DSL_Sockets3_Base * pSocks);
 		~DSL_Sockets_Events();
 		event_base * GetEventBase() { return evbase; }
+		DSL_Sockets3_Base * GetSockets() { return socks; }
 
 		int LoopWithFlags(int flags=0); // can be 0, EVLOOP_ONCE and/or EVLOOP_NONBLOCK
 		int LoopWithTimeout(int timeout);
@@ -80,8 +85,13 @@ class DSL_LIBEVENT_API_CLASS DSL_Sockets_Events {
 		DSL_SOCKET_LIBEVENT * AddTimer(dsl_sockets_event_callback cb, bool persist = true, void * user_ptr = NULL);
 		// use EnableRecv/DisableRecv to enable/disable timer
 		void FreeTimer(DSL_SOCKET_LIBEVENT * timer);
+
+		void Execute(function<void()> func); // Runs func on the thread running the event loop, can be called from any thread. Also lets you use the loop as a DSL_Executor for DSL_AsyncTask callbacks.
 };
 
 /**@}*/
 
+// co_await support for C++20 and newer
+#include <drift/libevent_coro.h>
+
 #endif // __DRIFT_LIBEVENT_H__
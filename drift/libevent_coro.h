@@ -0,0 +1,437 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+#ifndef __DRIFT_LIBEVENT_CORO_H__
+#define __DRIFT_LIBEVENT_CORO_H__
+
+#include <drift/libevent.h>
+
+#if defined(DSL_IS_CPP20_OR_NEWER)
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+/** \addtogroup libevent
+ * @{
+ */
+
+/*
+ * C++20 coroutine layer on top of DSL_Sockets_Events. It is header-only so the library itself doesn't have to be built as C++20.
+ * Everything here must be used from the thread running the event loop, use DSL_Sockets_Events::Execute() to get there from other threads.
+ */
+
+#define DSL_EVENT_TIMEOUT	-10 ///< Returned by the coroutine socket operations when the timeout expires
+#define DSL_EVENT_CANCELLED	-11 ///< Returned by the coroutine socket operations when DSL_Event_Cancel::Cancel() was called
+
+/**
+ * Cancellation source for coroutine socket operations and DSL_Event_Sleep. Calling Cancel() wakes up whatever operation is currently waiting on it and makes future ones return DSL_EVENT_CANCELLED right away.
+ */
+class DSL_Event_Cancel {
+private:
+	bool cancelled = false;
+	function<void()> on_cancel;
+public:
+	bool IsCancelled() const { return cancelled; }
+	void Cancel() {
+		cancelled = true;
+		if (on_cancel) {
+			function<void()> f = std::move(on_cancel);
+			on_cancel = nullptr;
+			f();
+		}
+	}
+	void Reset() { cancelled = false; } ///< Lets the source be used again after Cancel()
+
+#ifndef DOXYGEN_SKIP
+	void SetHandler(function<void()> f) { on_cancel = std::move(f); }
+#endif
+};
+
+template <typename T = void> class DSL_Event_Task;
+
+#ifndef DOXYGEN_SKIP
+struct DSL_Event_PromiseBase {
+	std::coroutine_handle<> continuation;
+	exception_ptr error;
+	bool detached = false;
+
+	struct final_awaiter {
+		bool await_ready() noexcept { return false; }
+		template <typename P> std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+			auto& p = h.promise();
+			if (p.continuation) {
+				return p.continuation;
+			}
+			if (p.detached) {
+				// nobody is going to look at the result
+				h.destroy();
+			}
+			return std::noop_coroutine();
+		}
+		void await_resume() noexcept {}
+	};
+
+	std::suspend_always initial_suspend() noexcept { return {}; }
+	final_awaiter final_suspend() noexcept { return {}; }
+	void unhandled_exception() { error = current_exception(); }
+};
+
+template <typename T> struct DSL_Event_Promise : public DSL_Event_PromiseBase {
+	std::optional<T> value;
+	DSL_Event_Task<T> get_return_object();
+	void return_value(T val) { value = std::move(val); }
+};
+template <> struct DSL_Event_Promise<void> : public DSL_Event_PromiseBase {
+	DSL_Event_Task<void> get_return_object();
+	void return_void() {}
+};
+#endif
+
+/**
+ * Coroutine task type for event loop handlers. Tasks are lazy: they don't run until they are co_await'ed from another coroutine or started with Start(). Exceptions thrown inside a task are rethrown in whoever co_awaits it.
+ */
+template <typename T> class DSL_Event_Task {
+public:
+	typedef DSL_Event_Promise<T> promise_type;
+private:
+	std::coroutine_handle<promise_type> handle;
+public:
+	explicit DSL_Event_Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+	DSL_Event_Task(DSL_Event_Task&& o) noexcept : handle(std::exchange(o.handle, nullptr)) {}
+	DSL_Event_Task(const DSL_Event_Task&) = delete;
+	DSL_Event_Task& operator=(const DSL_Event_Task&) = delete;
+	~DSL_Event_Task() {
+		if (handle) {
+			handle.destroy();
+		}
+	}
+
+	/**
+	 * Starts the task as a fire-and-forget handler, the coroutine frame frees itself when it finishes and any exception it throws is discarded. This object is empty afterwards.
+	 * @param exec If not NULL the task is started with exec->Execute() (ie. pass your DSL_Sockets_Events to start it on the loop thread), otherwise it starts running right away on the calling thread.
+	 */
+	void Start(DSL_Executor * exec = NULL) {
+		std::coroutine_handle<promise_type> h = std::exchange(handle, nullptr);
+		if (!h) { return; }
+		h.promise().detached = true;
+		if (exec != NULL) {
+			exec->Execute([h]() { h.resume(); });
+		} else {
+			h.resume();
+		}
+	}
+
+#ifndef DOXYGEN_SKIP
+	bool await_ready() { return !handle || handle.done(); }
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) {
+		handle.promise().continuation = awaiting;
+		return handle;
+	}
+	T await_resume() {
+		promise_type& p = handle.promise();
+		if (p.error) {
+			rethrow_exception(p.error);
+		}
+		if constexpr (!std::is_void_v<T>) {
+			return std::move(*p.value);
+		}
+	}
+#endif
+};
+
+#ifndef DOXYGEN_SKIP
+template <typename T> DSL_Event_Task<T> DSL_Event_Promise<T>::get_return_object() {
+	return DSL_Event_Task<T>(std::coroutine_handle<DSL_Event_Promise<T>>::from_promise(*this));
+}
+inline DSL_Event_Task<void> DSL_Event_Promise<void>::get_return_object() {
+	return DSL_Event_Task<void>(std::coroutine_handle<DSL_Event_Promise<void>>::from_promise(*this));
+}
+#endif
+
+/**
+ * co_await DSL_Event_Sleep(ev, ms) suspends the coroutine for ms milliseconds without blocking the event loop.<br>
+ * The result is true if the full time passed, false if it was cancelled.
+ */
+class DSL_Event_Sleep {
+private:
+	DSL_Sockets_Events * ev;
+	int ms;
+	DSL_Event_Cancel * cancel;
+	DSL_SOCKET_LIBEVENT * timer = NULL;
+	std::coroutine_handle<> waiter;
+	bool cancelled = false;
+
+	static void timer_cb(DSL_SOCKET_LIBEVENT * s, short flags) {
+		DSL_Event_Sleep * self = (DSL_Event_Sleep *)s->user_ptr;
+		self->finish();
+	}
+	void finish() {
+		ev->FreeTimer(timer);
+		timer = NULL;
+		if (cancel != NULL) {
+			cancel->SetHandler(nullptr);
+		}
+		waiter.resume();
+	}
+public:
+	DSL_Event_Sleep(DSL_Sockets_Events * pev, int pms, DSL_Event_Cancel * pcancel = NULL) : ev(pev), ms(pms), cancel(pcancel) {}
+
+#ifndef DOXYGEN_SKIP
+	bool await_ready() {
+		if (cancel != NULL && cancel->IsCancelled()) {
+			cancelled = true;
+			return true;
+		}
+		return (ms <= 0);
+	}
+	void await_suspend(std::coroutine_handle<> h) {
+		waiter = h;
+		timer = ev->AddTimer(timer_cb, false, this);
+		if (cancel != NULL) {
+			cancel->SetHandler([this]() {
+				cancelled = true;
+				finish();
+			});
+		}
+		ev->EnableRecv(timer, ms);
+	}
+	bool await_resume() { return !cancelled; }
+#endif
+};
+
+/**
+ * Wraps a DSL_SOCKET for use from coroutines. The socket is switched to non-blocking mode and added to the event loop, each operation tries the socket first and only suspends the coroutine (with EnableRecv()/EnableWrite()) when it would block, so thousands of connections can be handled by one loop thread.<br>
+ * Only one coroutine should be receiving and one sending on a socket at a time.<br>
+ * All the operations take an optional timeout in milliseconds (0 for none) and an optional DSL_Event_Cancel.
+ */
+class DSL_Event_Socket {
+private:
+	DSL_Sockets_Events * ev;
+	DSL_Sockets3_Base * socks;
+	DSL_SOCKET * sock;
+	DSL_SOCKET_LIBEVENT * evs;
+	string inbuf; // data received past the end of a line by RecvLine
+
+	std::coroutine_handle<> read_waiter, write_waiter;
+	short read_flags = 0, write_flags = 0;
+
+	static void read_cb(DSL_SOCKET_LIBEVENT * s, short flags) {
+		DSL_Event_Socket * self = (DSL_Event_Socket *)s->user_ptr;
+		self->read_flags = flags;
+		std::coroutine_handle<> h = std::exchange(self->read_waiter, nullptr);
+		if (h) { h.resume(); }
+	}
+	static void write_cb(DSL_SOCKET_LIBEVENT * s, short flags) {
+		DSL_Event_Socket * self = (DSL_Event_Socket *)s->user_ptr;
+		self->write_flags = flags;
+		std::coroutine_handle<> h = std::exchange(self->write_waiter, nullptr);
+		if (h) { h.resume(); }
+	}
+
+	bool would_block() {
+		int err = socks->GetLastError(sock);
+		return (err == EWOULDBLOCK || err == EAGAIN || err == EINPROGRESS);
+	}
+
+	/* Waits for the socket to become readable/writable. The result is the libevent flags (EV_READ, EV_WRITE, EV_TIMEOUT) or 0 if cancelled */
+	struct wait_awaiter {
+		DSL_Event_Socket * s;
+		bool write;
+		int timeout;
+		DSL_Event_Cancel * cancel;
+		bool cancelled = false;
+
+		bool await_ready() {
+			cancelled = (cancel != NULL && cancel->IsCancelled());
+			return cancelled;
+		}
+		void await_suspend(std::coroutine_handle<> h) {
+			if (cancel != NULL) {
+				cancel->SetHandler([this]() {
+					cancelled = true;
+					std::coroutine_handle<> w;
+					if (write) {
+						s->ev->DisableWrite(s->evs);
+						w = std::exchange(s->write_waiter, nullptr);
+					} else {
+						s->ev->DisableRecv(s->evs);
+						w = std::exchange(s->read_waiter, nullptr);
+					}
+					if (w) { w.resume(); }
+				});
+			}
+			if (write) {
+				s->write_waiter = h;
+				s->ev->EnableWrite(s->evs, timeout);
+			} else {
+				s->read_waiter = h;
+				s->ev->EnableRecv(s->evs, timeout);
+			}
+		}
+		short await_resume() {
+			if (cancel != NULL) {
+				cancel->SetHandler(nullptr);
+			}
+			if (cancelled) {
+				return 0;
+			}
+			return write ? s->write_flags : s->read_flags;
+		}
+	};
+	wait_awaiter wait(bool write, int timeout, DSL_Event_Cancel * cancel) { return wait_awaiter{ this, write, timeout, cancel }; }
+	static int wait_error(short flags) { return (flags == 0) ? DSL_EVENT_CANCELLED : DSL_EVENT_TIMEOUT; }
+
+public:
+	/**
+	 * @param pev The event loop to use.
+	 * @param psock The socket, it must come from the DSL_Sockets3_Base pev was created with.
+	 */
+	DSL_Event_Socket(DSL_Sockets_Events * pev, DSL_SOCKET * psock) : ev(pev), socks(pev->GetSockets()), sock(psock) {
+		socks->SetNonBlocking(sock, true);
+		evs = ev->Add(sock, read_cb, write_cb, NULL, this, false, false);
+	}
+	/**
+	 * Removes the socket from the event loop. Don't destroy it while a coroutine is waiting on it.
+	 */
+	~DSL_Event_Socket() {
+		if (evs != NULL) {
+			ev->Remove(evs, false);
+		}
+	}
+	DSL_Event_Socket(const DSL_Event_Socket&) = delete;
+	DSL_Event_Socket& operator=(const DSL_Event_Socket&) = delete;
+
+	DSL_SOCKET * GetSocket() { return sock; }
+	/**
+	 * Removes the socket from the event loop and closes it.
+	 */
+	void Close() {
+		if (evs != NULL) {
+			ev->Remove(evs, true);
+			evs = NULL;
+		}
+	}
+
+	/**
+	 * Connects the socket. Note: the host name lookup itself is still blocking, pass an IP address if that matters.
+	 * @return true if the connection was established.
+	 */
+	DSL_Event_Task<bool> Connect(string host, int port, int timeout = 0, DSL_Event_Cancel * cancel = NULL) {
+		if (socks->Connect(sock, host.c_str(), port)) {
+			co_return true;
+		}
+		if (!would_block()) {
+			co_return false;
+		}
+		short flags = co_await wait(true, timeout, cancel);
+		if (!(flags & EV_WRITE)) {
+			co_return false;
+		}
+		int err = 0;
+		socklen_t len = sizeof(err);
+		if (getsockopt(sock->sock, SOL_SOCKET, SO_ERROR, (char *)&err, &len) != 0 || err != 0) {
+			co_return false;
+		}
+		co_return true;
+	}
+
+	/**
+	 * Receives up to bufsize bytes, waiting until at least 1 byte is available.
+	 * @return Same as DSL_Sockets3_Base::Recv() (0 = connection closed, -1 = error) or DSL_EVENT_TIMEOUT/DSL_EVENT_CANCELLED.
+	 */
+	DSL_Event_Task<int> Recv(char * buf, uint32 bufsize, int timeout = 0, DSL_Event_Cancel * cancel = NULL) {
+		if (inbuf.length()) {
+			uint32 n = (inbuf.length() < bufsize) ? (uint32)inbuf.length() : bufsize;
+			memcpy(buf, inbuf.c_str(), n);
+			inbuf.erase(0, n);
+			co_return (int)n;
+		}
+		while (1) {
+			int n = socks->Recv(sock, buf, bufsize);
+			if (n >= 0 || !would_block()) {
+				co_return n;
+			}
+			short flags = co_await wait(false, timeout, cancel);
+			if (!(flags & EV_READ)) {
+				co_return wait_error(flags);
+			}
+		}
+	}
+
+	/**
+	 * Receives a line of text, the trailing \r\n/\n is removed.
+	 * @param maxlen The longest line accepted.
+	 * @return The length of the line or RL3_CLOSED, RL3_ERROR, RL3_LINETOOLONG, DSL_EVENT_TIMEOUT, DSL_EVENT_CANCELLED.
+	 */
+	DSL_Event_Task<int> RecvLine(string& line, size_t maxlen = 4096, int timeout = 0, DSL_Event_Cancel * cancel = NULL) {
+		char buf[4096];
+		while (1) {
+			size_t ind = inbuf.find('\n');
+			if (ind != string::npos) {
+				line = inbuf.substr(0, ind);
+				inbuf.erase(0, ind + 1);
+				while (line.length() && line[line.length() - 1] == '\r') {
+					line.pop_back();
+				}
+				co_return (int)line.length();
+			}
+			if (inbuf.length() >= maxlen) {
+				co_return RL3_LINETOOLONG;
+			}
+
+			int n = socks->Recv(sock, buf, sizeof(buf));
+			if (n > 0) {
+				inbuf.append(buf, n);
+				continue;
+			} else if (n == 0) {
+				co_return RL3_CLOSED;
+			} else if (!would_block()) {
+				co_return RL3_ERROR;
+			}
+			short flags = co_await wait(false, timeout, cancel);
+			if (!(flags & EV_READ)) {
+				co_return wait_error(flags);
+			}
+		}
+	}
+
+	/**
+	 * Sends all of data, waiting for the socket to become writable as needed.
+	 * @return datalen on success, -1 on error or DSL_EVENT_TIMEOUT/DSL_EVENT_CANCELLED. If it fails part of the data may have been sent.
+	 */
+	DSL_Event_Task<int> Send(const char * data, int datalen = -1, int timeout = 0, DSL_Event_Cancel * cancel = NULL) {
+		if (datalen == -1) { datalen = (int)strlen(data); }
+		int sent = 0;
+		while (sent < datalen) {
+			int n = socks->Send(sock, data + sent, datalen - sent, false);
+			if (n > 0) {
+				sent += n;
+				continue;
+			} else if (n == 0 || !would_block()) {
+				co_return -1;
+			}
+			short flags = co_await wait(true, timeout, cancel);
+			if (!(flags & EV_WRITE)) {
+				co_return wait_error(flags);
+			}
+		}
+		co_return sent;
+	}
+	DSL_Event_Task<int> Send(string data, int timeout = 0, DSL_Event_Cancel * cancel = NULL) {
+		co_return co_await Send(data.c_str(), (int)data.length(), timeout, cancel);
+	}
+};
+
+/**@}*/
+
+#endif // DSL_IS_CPP20_OR_NEWER
+
+#endif // __DRIFT_LIBEVENT_CORO_H__
@@ -14,6 +14,10 @@
 #include <drift/threading.h>
 #include <chrono>
 #include <mutex>
+#include <atomic>
+#if !defined(LINUX)
+#include <condition_variable>
+#endif
 
 /**
  * \defgroup mutex Mutexes
@@ -27,6 +31,29 @@
 #define DSL_DEFAULT_MUTEX_TIMEOUT -1
 #endif
 
+#define DSL_MUTEX_PROFILE_BUCKETS 24 ///< Histogram buckets are powers of 2 in microseconds: <1us, <2us, <4us, ... and the last bucket is everything over ~4s
+
+/**
+ * Lock contention statistics for one AutoMutex/LockMutex call site. These are only collected if you compile with DSL_MUTEX_PROFILER defined (ENABLE_MUTEX_PROFILER in CMake) and turn the profiler on with dsl_mutex_profiler_enable().<br>
+ * All times are in nanoseconds. Hold time is from the outermost lock to the final release of a recursive lock and is credited to the site that took the outermost lock.
+ */
+struct DSL_API_CLASS DSL_MUTEX_PROFILE_SITE {
+	const char * file;
+	int line;
+	atomic<uint64> count; ///< Number of acquisitions
+	atomic<uint64> contended; ///< Number of acquisitions that had to wait for another thread
+	atomic<uint64> wait_total;
+	atomic<uint64> wait_max;
+	atomic<uint64> hold_total;
+	atomic<uint64> hold_max;
+	atomic<uint64> wait_hist[DSL_MUTEX_PROFILE_BUCKETS]; ///< Only contended acquisitions are counted
+	atomic<uint64> hold_hist[DSL_MUTEX_PROFILE_BUCKETS];
+	DSL_MUTEX_PROFILE_SITE * next; ///< Next registered site
+
+	DSL_MUTEX_PROFILE_SITE(const char * file, int line); ///< Registers the site in the global list, these should be static.
+	void Reset();
+};
+
 /**
  * Cross-platform Mutex (now just a wrapper for C++11's recursive_timed_mutex)
  */
@@ -34,6 +61,11 @@ class DSL_API_CLASS DSL_Mutex {
 private:
 	recursive_timed_mutex hMutex;
 	int lock_timeout = 0;
+	// profiler state, only touched by the thread holding the lock
+	DSL_MUTEX_PROFILE_SITE * prof_site = NULL;
+	uint32 prof_depth = 0;
+	uint64 prof_start = 0;
+	bool lock_raw(int timeout);
 public:
 	/**
 	* timeout is the default timeout for Lock(), anything less than 0 for infinite blocking until locked
@@ -42,6 +74,7 @@ public:
 
 	bool Lock(int timeout);
 	bool Lock();
+	bool Lock(DSL_MUTEX_PROFILE_SITE * site); ///< Lock() that records contention stats for site if the profiler is enabled
 	void Release();
 
 	void SetLockTimeout(int timeout) { // anything less than 0 for infinite blocking until locked. This should only be called before the mutex is being used or after the lock is already held, otherwise the behaviour is undefined.
@@ -66,6 +99,15 @@ public:
 }
 #define RelMutex(x) { printf("DSL_Mutex::Release(%s, %d)\n", __FILE__, __LINE__); x.Release(); }
 #define RelMutexPtr(x) { OutputDebugString("DSL_Mutex::Release()\n"); printf("DSL_Mutex::Release(%s, %d)\n", __FILE__, __LINE__); x->Release(); printf("DSL_Mutex::Released(%s, %d)\n", __FILE__, __LINE__); OutputDebugString("DSL_Mutex::Released()\n");  }
+#elif defined(DSL_MUTEX_PROFILER)
+/* Each expansion gets its own static site, registered the first time that line runs */
+#define DSL_MUTEX_SITE() ([]() -> DSL_MUTEX_PROFILE_SITE * { static DSL_MUTEX_PROFILE_SITE site(__FILE__, __LINE__); return &site; }())
+#define LockMutex(x) x.Lock(DSL_MUTEX_SITE())
+#define LockMutexPtr(x) x->Lock(DSL_MUTEX_SITE())
+#define TryLockMutex(x, y) x.Lock(y)
+#define TryLockMutexPtr(x, y) x->Lock(y)
+#define RelMutex(x) x.Release()
+#define RelMutexPtr(x) x->Release()
 #else
 #define LockMutex(x) x.Lock()
 #define LockMutexPtr(x) x->Lock()
@@ -113,6 +155,10 @@ public:
 		hMutex = mutex;
 		_locked = LockMutexPtr(mutex);
 	}
+	DSL_MutexLocker(DSL_Mutex * mutex, DSL_MUTEX_PROFILE_SITE * site) {
+		hMutex = mutex;
+		_locked = hMutex->Lock(site);
+	}
 	~DSL_MutexLocker() {
 		if (locked) {
 			RelMutexPtr(hMutex);
@@ -124,11 +170,186 @@ public:
 #ifdef DEBUG_MUTEX
 #define AutoMutex(x) DSL_MutexLocker MAKE_UNIQUE_NAME (&x, __FILE__, __LINE__)
 #define AutoMutexPtr(x) DSL_MutexLocker MAKE_UNIQUE_NAME (x, __FILE__, __LINE__)
+#elif defined(DSL_MUTEX_PROFILER)
+#define AutoMutex(x) DSL_MutexLocker MAKE_UNIQUE_NAME (&x, DSL_MUTEX_SITE())
+#define AutoMutexPtr(x) DSL_MutexLocker MAKE_UNIQUE_NAME (x, DSL_MUTEX_SITE())
 #else
 #define AutoMutex(x) DSL_MutexLocker MAKE_UNIQUE_NAME (&x)
 #define AutoMutexPtr(x) DSL_MutexLocker MAKE_UNIQUE_NAME (x)
 #endif
 
+/**
+ * Turns collection of lock contention stats on or off at runtime. It only has an effect on code compiled with DSL_MUTEX_PROFILER defined, otherwise the call sites aren't recorded at all.
+ */
+DSL_API void DSL_CC dsl_mutex_profiler_enable(bool enable);
+DSL_API bool DSL_CC dsl_mutex_profiler_enabled();
+DSL_API void DSL_CC dsl_mutex_profiler_reset(); ///< Zeroes the stats of all call sites
+DSL_API DSL_MUTEX_PROFILE_SITE * DSL_CC dsl_mutex_profiler_first_site(); ///< Gets the first registered call site if you want to walk them yourself, follow the next pointers for the rest
+/**
+ * Writes a report of every call site that has been hit, sorted by total wait time.
+ * @param show_histograms Also print the wait/hold time histograms of contended sites.
+ */
+DSL_API void DSL_CC dsl_mutex_profiler_report(FILE * fp, bool show_histograms = true);
+/**
+ * Starts a background thread that writes the report when the process receives signal sig (SIGUSR2 for example.) Only supported on POSIX systems.<br>
+ * Calling it again changes the file and/or signal. dsl_cleanup() stops the thread and puts back the signal's previous handler.
+ * @param filename File to append the report to, or NULL for stderr.
+ */
+DSL_API bool DSL_CC dsl_mutex_profiler_dump_on_signal(int sig, const char * filename = NULL);
+
+/**
+ * Lightweight event count for building blocking waits on top of lock-free state. Waiting only costs a syscall (a futex on Linux) when the thread actually has to sleep, and Notify() is just a fence and a load when nobody is waiting.<br>
+ * Usage: uint32 key = ec.PrepareWait(); if (condition is still false) { ec.Wait(key, timeout); } else { ec.CancelWait(); }<br>
+ * Changes to the condition must be published before calling Notify().
+ */
+class DSL_API_CLASS DSL_EventCount {
+private:
+	atomic<uint32> seq;
+	atomic<uint32> waiters;
+#if !defined(LINUX)
+	mutex hMutex;
+	condition_variable hCond;
+#endif
+public:
+	DSL_EventCount();
+
+	uint32 PrepareWait(); ///< Registers the thread as a waiter, re-check your condition after calling this
+	void CancelWait(); ///< Call instead of Wait() if the condition became true after PrepareWait()
+	/**
+	 * Sleeps until Notify() is called after PrepareWait() returned key, or the timeout expires. The waiter is always unregistered when this returns.
+	 * @param timeout Timeout in milliseconds, anything less than 0 to wait forever.
+	 * @return false if the timeout expired, true otherwise (which may include spurious wakeups, so re-check your condition.)
+	 */
+	bool Wait(uint32 key, int timeout = -1);
+	void Notify(bool all = true); ///< Wakes up waiting threads, if there are any
+};
+
+/**
+ * Tells the CPU we are in a spin-wait loop (pause/yield instruction.)
+ */
+inline void dsl_cpu_relax() {
+#if defined(_MSC_VER)
+	YieldProcessor();
+#elif defined(__i386__) || defined(__x86_64__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+/**
+ * Fast non-recursive mutex. The uncontended lock/release is a single atomic operation with no syscall, under contention it spins for a while (adapting the spin count to how long the lock is usually held) before sleeping on a futex (via DSL_EventCount.)<br>
+ * Use it instead of DSL_Mutex for short critical sections that never lock the same mutex again while it is held, locking it twice from the same thread will deadlock.
+ */
+class DSL_API_CLASS DSL_FastMutex {
+private:
+	atomic<uint32> state; // 0 = unlocked, 1 = locked, 2 = locked with (possible) sleepers
+	atomic<int32> spin_avg;
+	DSL_EventCount hEvent;
+	bool lock_slow(int timeout);
+public:
+	DSL_FastMutex();
+	DSL_FastMutex(const DSL_FastMutex&) = delete;
+	DSL_FastMutex& operator=(const DSL_FastMutex&) = delete;
+
+	bool TryLock() {
+		uint32 exp = 0;
+		return state.compare_exchange_strong(exp, 1, memory_order_acquire, memory_order_relaxed);
+	}
+	bool Lock() {
+		return TryLock() || lock_slow(-1);
+	}
+	bool Lock(int timeout) { ///< Same timeout semantics as DSL_Mutex, 0 = try only, <0 = infinite
+		return TryLock() || (timeout != 0 && lock_slow(timeout));
+	}
+	void Release() {
+		if (state.exchange(0, memory_order_release) == 2) {
+			hEvent.Notify(false);
+		}
+	}
+};
+
+/**
+ * Reader/writer lock: any number of readers or a single writer. Waiting writers block new readers so they can't be starved.<br>
+ * Neither side is recursive, a thread already holding a read lock must not take another one if a writer could be waiting.
+ */
+class DSL_API_CLASS DSL_RWLock {
+private:
+	atomic<uint32> state; // reader count + DSL_RWLOCK_* flags
+	DSL_EventCount read_event, write_event;
+public:
+	DSL_RWLock();
+	DSL_RWLock(const DSL_RWLock&) = delete;
+	DSL_RWLock& operator=(const DSL_RWLock&) = delete;
+
+	bool TryLockRead();
+	void LockRead();
+	void ReleaseRead();
+
+	bool TryLockWrite();
+	void LockWrite();
+	void ReleaseWrite();
+};
+
+/**
+ * Simple test-and-test-and-set spin lock for tiny critical sections (a few instructions) that are rarely contended. It never sleeps in the kernel, it yields the CPU if it has to spin for too long. Not recursive.
+ */
+class DSL_API_CLASS DSL_SpinLock {
+private:
+	atomic<bool> locked;
+public:
+	DSL_SpinLock() { locked = false; }
+	DSL_SpinLock(const DSL_SpinLock&) = delete;
+	DSL_SpinLock& operator=(const DSL_SpinLock&) = delete;
+
+	bool TryLock() {
+		return !locked.load(memory_order_relaxed) && !locked.exchange(true, memory_order_acquire);
+	}
+	void Lock();
+	void Release() {
+		locked.store(false, memory_order_release);
+	}
+};
+
+/**
+ * Scoped locker for DSL_FastMutex, DSL_SpinLock, or anything else with Lock()/Release().
+ */
+template <class T> class DSL_LockGuard {
+private:
+	T * hLock;
+public:
+	DSL_LockGuard(T * lock) : hLock(lock) { hLock->Lock(); }
+	~DSL_LockGuard() { hLock->Release(); }
+	DSL_LockGuard(const DSL_LockGuard&) = delete;
+	DSL_LockGuard& operator=(const DSL_LockGuard&) = delete;
+};
+
+/**
+ * Scoped read or write locker for DSL_RWLock.
+ */
+template <bool WRITE> class DSL_RWLocker {
+private:
+	DSL_RWLock * hLock;
+public:
+	DSL_RWLocker(DSL_RWLock * lock) : hLock(lock) {
+		if (WRITE) { hLock->LockWrite(); } else { hLock->LockRead(); }
+	}
+	~DSL_RWLocker() {
+		if (WRITE) { hLock->ReleaseWrite(); } else { hLock->ReleaseRead(); }
+	}
+	DSL_RWLocker(const DSL_RWLocker&) = delete;
+	DSL_RWLocker& operator=(const DSL_RWLocker&) = delete;
+};
+
+#define AutoFastMutex(x) DSL_LockGuard<DSL_FastMutex> MAKE_UNIQUE_NAME (&x)
+#define AutoFastMutexPtr(x) DSL_LockGuard<DSL_FastMutex> MAKE_UNIQUE_NAME (x)
+#define AutoSpinLock(x) DSL_LockGuard<DSL_SpinLock> MAKE_UNIQUE_NAME (&x)
+#define AutoSpinLockPtr(x) DSL_LockGuard<DSL_SpinLock> MAKE_UNIQUE_NAME (x)
+#define AutoReadLock(x) DSL_RWLocker<false> MAKE_UNIQUE_NAME (&x)
+#define AutoReadLockPtr(x) DSL_RWLocker<false> MAKE_UNIQUE_NAME (x)
+#define AutoWriteLock(x) DSL_RWLocker<true> MAKE_UNIQUE_NAME (&x)
+#define AutoWriteLockPtr(x) DSL_RWLocker<true> MAKE_UNIQUE_NAME (x)
+
 /**@}*/
 
 #ifndef DOXYGEN_SKIP
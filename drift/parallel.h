@@ -0,0 +1,127 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+#ifndef __DSL_PARALLEL_H__
+#define __DSL_PARALLEL_H__
+
+#include <drift/threading.h>
+#include <drift/thread_pool.h>
+#include <algorithm>
+
+/** \addtogroup threads
+ * @{
+ */
+
+#define DSL_PARALLEL_SORT_CUTOFF 8192 ///< DSL_ParallelSort() just uses std::sort() for fewer items than this
+
+/**
+ * Picks the number of items per chunk for a parallel loop over count items.
+ * @param grain If non-zero it is returned as-is, otherwise enough chunks are made to give every pool thread several of them so uneven items still balance out.
+ */
+DSL_API size_t DSL_CC DSL_ParallelGrainSize(size_t count, size_t grain = 0, DSL_ThreadPool * pool = NULL);
+/**
+ * The building block for the other parallel algorithms. Splits [begin, end) into chunks of grain items (the last one can be smaller) and calls body(first, last) once for each chunk.<br>
+ * Chunks are handed out dynamically to the calling thread and the pool's workers, so a slow chunk doesn't hold up the rest. The calling thread always takes part and, if it is a worker of the same pool, runs other queued tasks while it waits so nested parallel loops can't deadlock.<br>
+ * If body throws, the remaining chunks are skipped and the first exception is rethrown in the calling thread.
+ * @param grain Items per chunk, 0 to pick one with DSL_ParallelGrainSize().
+ * @param pool The pool to use, NULL for DSL_GetDefaultThreadPool().
+ */
+DSL_API void DSL_CC DSL_ParallelForRange(size_t begin, size_t end, size_t grain, const function<void(size_t, size_t)>& body, DSL_ThreadPool * pool = NULL);
+
+/**
+ * Calls func(i) for every i in [begin, end) in parallel.
+ */
+template <typename F> void DSL_ParallelFor(size_t begin, size_t end, F func, size_t grain = 0, DSL_ThreadPool * pool = NULL) {
+	DSL_ParallelForRange(begin, end, grain, [&func](size_t first, size_t last) {
+		for (size_t i = first; i < last; i++) {
+			func(i);
+		}
+	}, pool);
+}
+
+/**
+ * Calls func(item) for every item in [first, last) in parallel. Needs random access iterators.
+ */
+template <typename It, typename F> void DSL_ParallelForEach(It first, It last, F func, size_t grain = 0, DSL_ThreadPool * pool = NULL) {
+	DSL_ParallelFor(0, (size_t)(last - first), [&first, &func](size_t i) { func(first[i]); }, grain, pool);
+}
+
+/**
+ * Parallel std::transform(): out[i] = func(first[i]) for every item in [first, last). Needs random access iterators, out must already have room for the results.
+ */
+template <typename It, typename OutIt, typename F> void DSL_ParallelTransform(It first, It last, OutIt out, F func, size_t grain = 0, DSL_ThreadPool * pool = NULL) {
+	DSL_ParallelFor(0, (size_t)(last - first), [&first, &out, &func](size_t i) { out[i] = func(first[i]); }, grain, pool);
+}
+
+/**
+ * Maps every i in [begin, end) with map(i) and combines the results with reduce(a, b). Each chunk is reduced on its own then the chunk results are combined in order on the calling thread, so reduce only needs to be associative (not commutative) and the result doesn't depend on thread timing.
+ * @param identity The starting value for each chunk, for example 0 for a sum.
+ */
+template <typename T, typename MapFunc, typename ReduceFunc> T DSL_ParallelReduce(size_t begin, size_t end, T identity, MapFunc map, ReduceFunc reduce, size_t grain = 0, DSL_ThreadPool * pool = NULL) {
+	if (end <= begin) {
+		return identity;
+	}
+	grain = DSL_ParallelGrainSize(end - begin, grain, pool);
+	vector<T> partials((end - begin + grain - 1) / grain, identity);
+	DSL_ParallelForRange(begin, end, grain, [&](size_t first, size_t last) {
+		T acc = identity;
+		for (size_t i = first; i < last; i++) {
+			acc = reduce(acc, map(i));
+		}
+		partials[(first - begin) / grain] = acc;
+	}, pool);
+	T ret = identity;
+	for (auto& x : partials) {
+		ret = reduce(ret, x);
+	}
+	return ret;
+}
+
+/**
+ * Parallel std::sort(): sorts one block per pool thread at the same time then merges neighbouring blocks in rounds. Needs random access iterators. Like std::sort() it isn't stable.
+ */
+template <typename It, typename Compare> void DSL_ParallelSort(It first, It last, Compare comp, DSL_ThreadPool * pool = NULL) {
+	if (pool == NULL) {
+		pool = DSL_GetDefaultThreadPool();
+	}
+	size_t n = (size_t)(last - first);
+	if (n < DSL_PARALLEL_SORT_CUTOFF || pool->NumThreads() < 2) {
+		std::sort(first, last, comp);
+		return;
+	}
+
+	// a power of 2 so every merge round pairs up evenly
+	size_t parts = 1;
+	while (parts < pool->NumThreads()) {
+		parts <<= 1;
+	}
+	size_t width = (n + parts - 1) / parts;
+	DSL_ParallelFor(0, parts, [&](size_t i) {
+		std::sort(first + std::min(i * width, n), first + std::min((i + 1) * width, n), comp);
+	}, 1, pool);
+	for (; width < n; width *= 2) {
+		size_t merges = (n + (2 * width) - 1) / (2 * width);
+		DSL_ParallelFor(0, merges, [&](size_t i) {
+			size_t lo = i * 2 * width;
+			size_t mid = std::min(lo + width, n);
+			size_t hi = std::min(lo + (2 * width), n);
+			if (mid < hi) {
+				std::inplace_merge(first + lo, first + mid, first + hi, comp);
+			}
+		}, 1, pool);
+	}
+}
+template <typename It> void DSL_ParallelSort(It first, It last, DSL_ThreadPool * pool = NULL) {
+	DSL_ParallelSort(first, last, std::less<typename std::iterator_traits<It>::value_type>(), pool);
+}
+
+/**@}*/
+
+#endif // __DSL_PARALLEL_H__
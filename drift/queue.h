@@ -0,0 +1,247 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+#ifndef __DSL_QUEUE_H__
+#define __DSL_QUEUE_H__
+
+#include <drift/mutex.h>
+#include <chrono>
+#include <new>
+
+/** \addtogroup threads
+ * @{
+ */
+
+/**
+ * Bounded lock-free multi-producer/multi-consumer queue (Dmitry Vyukov's ring design.) Each slot has a sequence number so producers and consumers only contend on their own index with a single CAS, there are no locks anywhere.<br>
+ * The Try* functions never block. Push()/Pop() wait on a DSL_EventCount (a futex on Linux) when the queue is full/empty, which costs nothing when nobody is waiting.<br>
+ * Timeouts follow DSL_Mutex: 0 = don't wait, <0 = wait forever, >0 = milliseconds.
+ */
+template <typename T> class DSL_Queue {
+private:
+	struct cell {
+		atomic<size_t> seq;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+	cell * cells;
+	size_t mask;
+	alignas(64) atomic<size_t> enqueue_pos;
+	alignas(64) atomic<size_t> dequeue_pos;
+	alignas(64) atomic<bool> closed;
+	DSL_EventCount not_empty, not_full;
+
+	template <typename U> bool push_one(U&& val) {
+		cell * c;
+		size_t pos = enqueue_pos.load(memory_order_relaxed);
+		while (1) {
+			c = &cells[pos & mask];
+			intptr_t dif = (intptr_t)c->seq.load(memory_order_acquire) - (intptr_t)pos;
+			if (dif == 0) {
+				if (enqueue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+					break;
+				}
+			} else if (dif < 0) {
+				// full
+				return false;
+			} else {
+				pos = enqueue_pos.load(memory_order_relaxed);
+			}
+		}
+		new (c->storage) T(std::forward<U>(val));
+		c->seq.store(pos + 1, memory_order_release);
+		return true;
+	}
+	bool pop_one(T& val) {
+		cell * c;
+		size_t pos = dequeue_pos.load(memory_order_relaxed);
+		while (1) {
+			c = &cells[pos & mask];
+			intptr_t dif = (intptr_t)c->seq.load(memory_order_acquire) - (intptr_t)(pos + 1);
+			if (dif == 0) {
+				if (dequeue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+					break;
+				}
+			} else if (dif < 0) {
+				// empty
+				return false;
+			} else {
+				pos = dequeue_pos.load(memory_order_relaxed);
+			}
+		}
+		T * p = (T *)c->storage;
+		val = std::move(*p);
+		p->~T();
+		c->seq.store(pos + mask + 1, memory_order_release);
+		return true;
+	}
+
+	template <typename F> bool wait_for(DSL_EventCount& ev, int timeout, F cond) {
+		if (cond()) { return true; }
+		if (timeout == 0) { return false; }
+		auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+		while (1) {
+			uint32 key = ev.PrepareWait();
+			if (cond()) {
+				ev.CancelWait();
+				return true;
+			}
+			if (closed.load()) {
+				ev.CancelWait();
+				return false;
+			}
+			int left = -1;
+			if (timeout > 0) {
+				auto now = std::chrono::steady_clock::now();
+				if (now >= end) {
+					ev.CancelWait();
+					return false;
+				}
+				left = (int)std::chrono::duration_cast<std::chrono::milliseconds>(end - now).count() + 1;
+			}
+			ev.Wait(key, left);
+		}
+	}
+
+public:
+	/**
+	 * @param capacity The max number of items in the queue, rounded up to a power of 2.
+	 */
+	DSL_Queue(size_t capacity) {
+		size_t size = 2;
+		while (size < capacity) {
+			size <<= 1;
+		}
+		mask = size - 1;
+		cells = new cell[size];
+		for (size_t i = 0; i < size; i++) {
+			cells[i].seq.store(i, memory_order_relaxed);
+		}
+		enqueue_pos = 0;
+		dequeue_pos = 0;
+		closed = false;
+	}
+	~DSL_Queue() {
+		T tmp;
+		while (pop_one(tmp)) {}
+		delete [] cells;
+	}
+	DSL_Queue(const DSL_Queue&) = delete;
+	DSL_Queue& operator=(const DSL_Queue&) = delete;
+
+	bool TryPush(const T& val) {
+		if (!closed.load(memory_order_relaxed) && push_one(val)) {
+			not_empty.Notify(false);
+			return true;
+		}
+		return false;
+	}
+	bool TryPush(T&& val) {
+		if (!closed.load(memory_order_relaxed) && push_one(std::move(val))) {
+			not_empty.Notify(false);
+			return true;
+		}
+		return false;
+	}
+	bool TryPop(T& val) {
+		if (pop_one(val)) {
+			not_full.Notify(false);
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	 * Adds an item, waiting for space if the queue is full.
+	 * @return false if the timeout expired or the queue was closed.
+	 */
+	bool Push(T val, int timeout = -1) {
+		if (closed.load()) { return false; }
+		if (wait_for(not_full, timeout, [&] { return push_one(std::move(val)); })) {
+			not_empty.Notify(false);
+			return true;
+		}
+		return false;
+	}
+	/**
+	 * Removes an item, waiting for one if the queue is empty.
+	 * @return false if the timeout expired or the queue is closed and empty.
+	 */
+	bool Pop(T& val, int timeout = -1) {
+		if (wait_for(not_empty, timeout, [&] { return pop_one(val); })) {
+			not_full.Notify(false);
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	 * Adds up to num items without blocking, waking up consumers once at the end.
+	 * @return The number of items added (from the start of items), less than num if the queue filled up.
+	 */
+	size_t TryPushBatch(T * items, size_t num) {
+		size_t ret = 0;
+		if (closed.load(memory_order_relaxed)) { return 0; }
+		while (ret < num && push_one(std::move(items[ret]))) {
+			ret++;
+		}
+		if (ret > 0) {
+			not_empty.Notify(true);
+		}
+		return ret;
+	}
+	/**
+	 * Removes up to max items without blocking, waking up producers once at the end.
+	 * @return The number of items stored in items.
+	 */
+	size_t TryPopBatch(T * items, size_t max) {
+		size_t ret = 0;
+		while (ret < max && pop_one(items[ret])) {
+			ret++;
+		}
+		if (ret > 0) {
+			not_full.Notify(true);
+		}
+		return ret;
+	}
+	/**
+	 * Waits for at least 1 item then removes as many as are available up to max.
+	 * @return The number of items stored in items, 0 if the timeout expired or the queue is closed and empty.
+	 */
+	size_t PopBatch(T * items, size_t max, int timeout = -1) {
+		if (max == 0 || !Pop(items[0], timeout)) {
+			return 0;
+		}
+		return 1 + TryPopBatch(items + 1, max - 1);
+	}
+
+	/**
+	 * Closes the queue: pushes fail from now on and blocked consumers wake up, consumers can still pop what is left. Handy to shut down worker threads blocked in Pop().
+	 */
+	void Close() {
+		closed = true;
+		not_empty.Notify(true);
+		not_full.Notify(true);
+	}
+	bool IsClosed() { return closed.load(); }
+
+	/**
+	 * The approximate number of items in the queue, it can be out of date by the time it returns if other threads are using the queue.
+	 */
+	size_t Size() {
+		size_t deq = dequeue_pos.load(memory_order_relaxed);
+		size_t enq = enqueue_pos.load(memory_order_relaxed);
+		return (enq > deq) ? enq - deq : 0;
+	}
+	size_t Capacity() { return mask + 1; }
+};
+
+/**@}*/
+
+#endif // __DSL_QUEUE_H__
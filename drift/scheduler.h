@@ -0,0 +1,76 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+#ifndef __DSL_SCHEDULER_H__
+#define __DSL_SCHEDULER_H__
+
+#include <drift/thread_pool.h>
+
+/** \addtogroup threads
+ * @{
+ */
+
+typedef uint64 DSL_SCHEDULER_ID; ///< Identifies a scheduled task for DSL_Scheduler::Cancel(), 0 is never a valid ID
+
+#ifndef DOXYGEN_SKIP
+struct DSL_Scheduler_Impl;
+#endif
+
+/**
+ * Runs delayed and periodic tasks from a single timer thread, so programs don't need a thread per timer or loops that sleep and check the clock.<br>
+ * The timer thread sleeps until the next task is due (on a DSL_EventCount, it isn't woken up otherwise) then hands the task to an executor: a DSL_ThreadPool, a DSL_Sockets_Events loop, or anything else implementing DSL_Executor. Tasks are never run on the timer thread itself, so a slow task can't delay the others.<br>
+ * Times are in milliseconds based on GetTickCount64() so wall clock changes don't affect them.<br>
+ * The timer thread is started with DSL_StartThreadEx() so it counts in DSL_NumThreads() until Shutdown().
+ */
+class DSL_API_CLASS DSL_Scheduler {
+private:
+	DSL_Scheduler_Impl * impl;
+public:
+	DSL_Scheduler(const char * name = "Scheduler");
+	~DSL_Scheduler(); ///< Calls Shutdown()
+	DSL_Scheduler(const DSL_Scheduler&) = delete;
+	DSL_Scheduler& operator=(const DSL_Scheduler&) = delete;
+
+	/**
+	 * Runs func once after delay milliseconds.
+	 * @param exec Where to run func, NULL for DSL_GetDefaultThreadPool().
+	 */
+	DSL_SCHEDULER_ID ScheduleIn(uint64 delay, function<void()> func, DSL_Executor * exec = NULL);
+	/**
+	 * Runs func once at a wall clock time. If when is in the past it runs right away.
+	 * @param exec Where to run func, NULL for DSL_GetDefaultThreadPool().
+	 */
+	DSL_SCHEDULER_ID ScheduleAt(time_t when, function<void()> func, DSL_Executor * exec = NULL);
+	/**
+	 * Runs func every interval milliseconds until it is cancelled. If a run is still going when the next one is due that run is skipped instead of piling up, and if the timer falls behind it doesn't try to catch up with missed runs.
+	 * @param first_delay Delay before the first run, -1 to use interval.
+	 * @param exec Where to run func, NULL for DSL_GetDefaultThreadPool().
+	 */
+	DSL_SCHEDULER_ID ScheduleEvery(uint64 interval, function<void()> func, DSL_Executor * exec = NULL, int64 first_delay = -1);
+	/**
+	 * Cancels a scheduled task. A run that was already handed to its executor still finishes.
+	 * @return true if the task was found.
+	 */
+	bool Cancel(DSL_SCHEDULER_ID id);
+	size_t NumScheduled(); ///< The number of pending tasks (including periodic ones)
+	/**
+	 * Cancels everything and stops the timer thread.
+	 */
+	void Shutdown();
+};
+
+/**
+ * Gets the library's shared scheduler, it is created the first time you call this and shut down by dsl_cleanup().
+ */
+DSL_API DSL_Scheduler * DSL_CC DSL_GetDefaultScheduler();
+
+/**@}*/
+
+#endif // __DSL_SCHEDULER_H__
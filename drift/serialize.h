@@ -12,6 +12,8 @@
 #define __DSL_SERIALIZE_H__
 
 #include <drift/buffer.h>
+#include <drift/chain_buffer.h>
+#include <drift/parallel.h>
 
 /**
  * \defgroup serialize Data Serializer
@@ -88,6 +90,42 @@ protected:
 	}
 	#define serv2(x,y) if (!serialize_vector2<y>(buf, x, deserialize)) { return false; }
 
+	/*
+	 * Same format as serialize_vector2, but the objects' GetSerialized()/FromSerialized() run in parallel on the default thread pool (vectors of 16 or less stay on the calling thread.)
+	 * Only use it when T's (de)serialization is safe to run on several threads at once. The data is still read/written from buf in order.
+	 */
+	template <typename T> bool serialize_vector2_parallel(DSL_BUFFER * buf, vector<T>& vec, bool deserialize) {
+		if (deserialize) {
+			uint32 num;
+			ser(&num);
+			// every entry takes at least 1 byte, so don't trust num any further than that
+			if (num > buf->len) { return false; }
+			vector<string> tmp;
+			tmp.reserve(num);
+			for (uint32 i = 0; i < num; i++) {
+				tmp.emplace_back();
+				ser(&tmp.back());
+			}
+			vector<T> objs(num);
+			atomic<bool> ok(true);
+			DSL_ParallelFor(0, num, [&](size_t i) {
+				if (!objs[i].FromSerialized(tmp[i])) { ok = false; }
+			}, 16);
+			if (!ok) { return false; }
+			vec = std::move(objs);
+		} else {
+			uint32 num = vec.size();
+			ser(&num);
+			vector<string> tmp(num);
+			DSL_ParallelTransform(vec.begin(), vec.end(), tmp.begin(), [](T& obj) { return obj.GetSerialized(); }, 16);
+			for (uint32 i = 0; i < num; i++) {
+				ser(&tmp[i]);
+			}
+		}
+		return true;
+	}
+	#define serv2p(x,y) if (!serialize_vector2_parallel<y>(buf, x, deserialize)) { return false; }
+
 	/* Serialize a vector of std::string's */
 	#define servstr(x,y) if (!dsl_serialize_vector_string(buf, x, deserialize)) { return false; }
 	#define sersstr(x,y) if (!dsl_serialize_set_string(buf, x, deserialize)) { return false; }
@@ -98,6 +136,8 @@ public:
 	bool FromSerialized(const string& str);
 	bool GetSerialized(DSL_BUFFER * buf);
 	bool FromSerialized(DSL_BUFFER * buf);
+	bool GetSerialized(DSL_CHAIN_BUFFER * buf); ///< Appends the serialized data to the chain without copying it again
+	bool FromSerialized(DSL_CHAIN_BUFFER * buf); ///< Deserializes from the start of the chain, removing the data that was used
 
 #ifdef ENABLE_ZLIB
 	string GetCompressed(int compression_level = 5);
@@ -0,0 +1,98 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+#ifndef __DSL_THREAD_POOL_H__
+#define __DSL_THREAD_POOL_H__
+
+#include <drift/mutex.h>
+#include <functional>
+#include <thread>
+
+/** \addtogroup threads
+ * @{
+ */
+
+typedef function<void()> DSL_ThreadPool_Task;
+
+#ifndef DOXYGEN_SKIP
+struct DSL_ThreadPool_Worker;
+#endif
+
+/**
+ * Fixed-size pool of worker threads for running lots of short tasks without creating a thread for each one.<br>
+ * Every worker has its own task deque: tasks submitted from a worker go on that worker's deque (newest first for cache locality), tasks submitted from other threads are spread round-robin, and idle workers steal the oldest tasks from the others. Idle workers sleep on a DSL_EventCount so an idle pool doesn't use any CPU.<br>
+ * Tasks should not block for long periods (network I/O, etc.), use DSL_StartThread() or DSL_StartAsyncTask() for that.
+ */
+class DSL_API_CLASS DSL_ThreadPool : public DSL_Executor {
+private:
+	vector<DSL_ThreadPool_Worker *> workers;
+	vector<thread> threads;
+	string name;
+	atomic<uint32> next_worker;
+	atomic<int64> queued; // tasks waiting in the deques
+	atomic<int64> outstanding; // queued + running
+	atomic<bool> shutting_down;
+	atomic<int32> submitting; // Submit()/SubmitBatch() calls in progress, Shutdown() waits for them before stopping the workers
+	DSL_EventCount work_event, idle_event;
+
+	void worker_main(DSL_ThreadPool_Worker * w);
+	bool get_task(DSL_ThreadPool_Worker * w, DSL_ThreadPool_Task& task);
+	bool begin_submit();
+	void run_task(DSL_ThreadPool_Task& task);
+	DSL_ThreadPool_Worker * current_worker();
+public:
+	/**
+	 * @param num_threads The number of worker threads, 0 to use the number of CPU cores.
+	 * @param name Thread name for the workers.
+	 */
+	DSL_ThreadPool(uint32 num_threads = 0, const char * name = "Thread Pool");
+	~DSL_ThreadPool(); ///< Calls Shutdown(), so don't delete a pool from one of its own tasks
+	DSL_ThreadPool(const DSL_ThreadPool&) = delete;
+	DSL_ThreadPool& operator=(const DSL_ThreadPool&) = delete;
+
+	void Submit(DSL_ThreadPool_Task task); ///< Queues a task to be run by a worker thread. Once Shutdown() has started the task is run on the calling thread instead, so a submitted task always runs.
+	void SubmitBatch(vector<DSL_ThreadPool_Task>& tasks); ///< Queues a group of tasks at once, spreading them over the workers with a single wakeup. tasks is left empty. Like Submit(), they are run on the calling thread once Shutdown() has started.
+	void Execute(function<void()> func) { Submit(std::move(func)); } ///< DSL_Executor interface, same as Submit()
+
+	/**
+	 * Runs one queued task on the calling thread if there is one. Use this while waiting on other tasks from inside a worker so nested waits can't run out of workers.
+	 * @return true if a task was run.
+	 */
+	bool RunPendingTask();
+	/**
+	 * Waits until there are no queued or running tasks. Don't call this from one of the pool's own tasks.
+	 * @param timeout Timeout in milliseconds, anything less than 0 to wait forever.
+	 * @return false if the timeout expired.
+	 */
+	bool WaitIdle(int timeout = -1);
+	/**
+	 * Runs any remaining queued tasks then stops and joins the worker threads. Tasks submitted after this has started (including by the remaining tasks) run on the submitting thread.
+	 * @return false without doing anything if called from one of the pool's own workers, since a worker can't join itself.
+	 */
+	bool Shutdown();
+
+	uint32 NumThreads() { return (uint32)workers.size(); }
+	int64 NumQueued() { return queued.load(memory_order_relaxed); } ///< The number of tasks waiting to be run
+	bool IsWorkerThread(); ///< Returns true if the calling thread is one of this pool's workers
+};
+
+/**
+ * Gets the library's shared thread pool, it is created with one thread per CPU core the first time you call this and shut down by dsl_cleanup().
+ */
+DSL_API DSL_ThreadPool * DSL_CC DSL_GetDefaultThreadPool();
+/**
+ * Runs a DSL_AsyncTask on a thread pool instead of a new thread, done is set to true when it finishes. Use DSL_StartAsyncTask() instead if the task can block for a long time.
+ * @param pool The pool to use, NULL for DSL_GetDefaultThreadPool().
+ */
+DSL_API void DSL_CC DSL_StartAsyncTaskOnPool(DSL_AsyncTask * task, DSL_ThreadPool * pool = NULL);
+
+/**@}*/
+
+#endif // __DSL_THREAD_POOL_H__
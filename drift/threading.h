@@ -15,6 +15,8 @@
 #define DSL_THREADING_USE_C11
 #endif
 
+#include <functional>
+
 /**
  * \defgroup threads Threads
  */
@@ -29,6 +31,8 @@
 #define THREADIDTYPE pthread_t
 #endif
 
+#define DSL_THREAD_MAX_KEYS 32 ///< Max number of keys that can be created with DSL_ThreadKeyCreate()
+
 struct DSL_THREAD_INFO {
 #ifdef _WIN32
 	HANDLE hThread;
@@ -41,15 +45,63 @@ struct DSL_THREAD_INFO {
 
 	char desc[256];
 
+	void * values[DSL_THREAD_MAX_KEYS]; ///< Per-thread values, see DSL_ThreadKeyCreate()
+
 #ifndef DOXYGEN_SKIP
 	void (*RemoveMe)(DSL_THREAD_INFO * tt);
+	ThreadProto func;
+	int priority;
 #endif
 };
 
+enum DSL_THREAD_PRIORITY {
+	DSL_THREAD_PRIORITY_IDLE, ///< Only runs when nothing else wants the CPU (SCHED_IDLE on Linux)
+	DSL_THREAD_PRIORITY_LOWEST,
+	DSL_THREAD_PRIORITY_BELOW_NORMAL,
+	DSL_THREAD_PRIORITY_NORMAL,
+	DSL_THREAD_PRIORITY_ABOVE_NORMAL, ///< On POSIX raising the priority usually needs root/CAP_SYS_NICE, if it is not allowed the thread runs at normal priority
+	DSL_THREAD_PRIORITY_HIGHEST,
+	DSL_THREAD_PRIORITY_REALTIME ///< SCHED_FIFO on Linux, THREAD_PRIORITY_TIME_CRITICAL on Windows
+};
+
+/**
+ * Extra options for DSL_StartThreadEx()
+ */
+struct DSL_THREAD_OPTIONS {
+	const char * desc = NULL; ///< Thread name/description
+	int32 id = -1; ///< User-specified ID
+	size_t stack_size = 0; ///< Stack size in bytes, 0 for the system default
+	DSL_THREAD_PRIORITY priority = DSL_THREAD_PRIORITY_NORMAL;
+	/**
+	 * CPUs the thread is allowed to run on, empty to let the OS decide. Currently supported on Linux and Windows (first 64 CPUs/processor group 0.)
+	 */
+	vector<int> cpus;
+	/**
+	 * Restricts the thread to the CPUs of a NUMA node, -1 for no preference. The thread is pinned before it starts so its stack and anything else it touches first is allocated on that node's memory.
+	 */
+	int numa_node = -1;
+};
+
 /**
  * Starts a thread. Declare and define your thread with DSL_DEFINE_THREAD(Name)
  */
 DSL_API DSL_THREAD_INFO * DSL_CC DSL_StartThread(ThreadProto Thread, void * Parm, const char * Desc = NULL, int32 id = -1);
+/**
+ * Starts a thread with CPU affinity, NUMA placement, priority and/or stack size options.
+ * @return The thread info on success, NULL if the thread couldn't be created (for example if none of the requested CPUs exist.)
+ */
+DSL_API DSL_THREAD_INFO * DSL_CC DSL_StartThreadEx(ThreadProto Thread, void * Parm, const DSL_THREAD_OPTIONS& opts);
+DSL_API DSL_THREAD_INFO * DSL_CC DSL_GetCurrentThreadInfo(); ///< Returns the DSL_THREAD_INFO of the calling thread, or NULL if it wasn't started with DSL_StartThread/DSL_StartThreadEx
+DSL_API int DSL_CC DSL_GetNumaNodeCount(); ///< The number of NUMA nodes in the system (1 on non-NUMA systems)
+
+/**
+ * Reserves a key for per-thread values stored in DSL_THREAD_INFO::values, so subsystems can keep thread-local caches for threads started by DSL.
+ * @param destructor Optional function called with the value (if not NULL) when a thread exits.
+ * @return The key, or -1 if all DSL_THREAD_MAX_KEYS keys are in use.
+ */
+DSL_API int DSL_CC DSL_ThreadKeyCreate(void (*destructor)(void * value) = NULL);
+DSL_API void * DSL_CC DSL_GetThreadValue(int key); ///< Gets the calling thread's value for key, NULL if it isn't set or the thread wasn't started by DSL
+DSL_API bool DSL_CC DSL_SetThreadValue(int key, void * value); ///< Sets the calling thread's value for key, returns false if the thread wasn't started by DSL
 /**
  * Starts a thread with no tracking structure.
  */
@@ -61,15 +113,93 @@ DSL_API void DSL_CC DSL_PrintRunningThreads();
 DSL_API void DSL_CC DSL_PrintRunningThreadsWithID(int id);
 DSL_API bool DSL_CC DSL_KillThread(DSL_THREAD_INFO * tt);
 
+/**
+ * Something that can run functions for you later: DSL_ThreadPool, DSL_Sockets_Events (on its event loop thread), etc.
+ */
+class DSL_API_CLASS DSL_Executor {
+public:
+	virtual ~DSL_Executor() {}
+	virtual void Execute(function<void()> func) = 0;
+};
+
+#ifndef DOXYGEN_SKIP
+struct DSL_AsyncTask_State;
+#endif
+
+class DSL_AsyncTask;
+typedef function<void(DSL_AsyncTask * task)> DSL_AsyncTask_Callback;
+
+/**
+ * Base class for a unit of work run by DSL_StartAsyncTask(), DSL_StartAsyncTaskOnPool() or a continuation of another task with Then().<br>
+ * Instead of polling done you can block with Wait(), get a callback with OnComplete(), or chain dependent tasks with Then().
+ */
 class DSL_API_CLASS DSL_AsyncTask {
+private:
+	DSL_AsyncTask_State * state;
 public:
-	bool done = false;
+	bool done = false; ///< Set to true after Run() has finished, just before the completion callbacks are called
+
+	DSL_AsyncTask();
+	virtual ~DSL_AsyncTask(); ///< Don't delete a task until it is done. If you use OnComplete() the callback gets the task pointer, so either wait for the callback or delete the task in it.
+	DSL_AsyncTask(const DSL_AsyncTask&) = delete;
+	DSL_AsyncTask& operator=(const DSL_AsyncTask&) = delete;
 
 	virtual void Run() = 0;
+
+	/**
+	 * Waits for the task to finish.
+	 * @param timeout Timeout in milliseconds, anything less than 0 to wait forever.
+	 * @return true if the task is done, false if the timeout expired.
+	 */
+	bool Wait(int timeout = -1);
+	/**
+	 * Calls cb when the task finishes, or right away on the calling thread if it already has.
+	 * @param executor NULL to call it on the thread that ran the task, otherwise the callback is posted to executor (an event loop, thread pool, etc.)
+	 */
+	void OnComplete(DSL_AsyncTask_Callback cb, DSL_Executor * executor = NULL);
+	/**
+	 * Runs next after this task finishes.
+	 * @param executor Where to run next, NULL to run it on the thread that ran this task.
+	 * @return next, so you can chain Then() calls: a->Then(b)->Then(c)
+	 */
+	DSL_AsyncTask * Then(DSL_AsyncTask * next, DSL_Executor * executor = NULL);
+
+	/**
+	 * Calls Run() and then Complete(). This is what DSL_StartAsyncTask() and the thread pool do, use it if you run a task yourself.
+	 */
+	void Execute();
+	/**
+	 * Marks the task as done, wakes up threads in Wait() and then calls the completion callbacks. Execute() calls it for you, you only need it for tasks that finish some other way (like the ones returned by DSL_WhenAll/DSL_WhenAny.)
+	 */
+	void Complete();
 };
 
 /**
- * Starts a task in a new thread, you can check on the status by checking if done == true. At that point you can do whatever with the result and delete the task handle.
+ * A DSL_AsyncTask that runs a function/lambda.
+ */
+class DSL_API_CLASS DSL_FunctionTask : public DSL_AsyncTask {
+private:
+	function<void()> func;
+public:
+	DSL_FunctionTask(function<void()> pfunc) : func(pfunc) {}
+	void Run() { func(); }
+};
+
+/**
+ * Task returned by DSL_WhenAll/DSL_WhenAny. It is never run, it completes when its group of tasks does. You own it and need to delete it once it is done.
+ */
+class DSL_API_CLASS DSL_WhenTask : public DSL_AsyncTask {
+public:
+	DSL_AsyncTask * first_done = NULL; ///< DSL_WhenAny only: the task that finished first
+	void Run() {}
+};
+
+DSL_API_CLASS DSL_WhenTask * DSL_WhenAll(const vector<DSL_AsyncTask *>& tasks); ///< Returns a task that completes when all of tasks have completed
+DSL_API_CLASS DSL_WhenTask * DSL_WhenAny(const vector<DSL_AsyncTask *>& tasks); ///< Returns a task that completes when any of tasks has completed, check first_done to see which one
+
+/**
+ * Starts a task in a new thread, you can check on the status by checking if done == true or with the DSL_AsyncTask completion functions. Once it is done you can do whatever with the result and delete the task handle.<br>
+ * For short tasks DSL_StartAsyncTaskOnPool() is much cheaper since it doesn't create a thread for each task.
  */
 DSL_API void DSL_CC DSL_StartAsyncTask(DSL_AsyncTask * task, const char * thread_name = NULL);
 
@@ -97,6 +227,7 @@ DSL_API void DSL_CC DSL_SetThreadName(DWORD dwThreadID, LPCSTR szThreadName);
 #endif
 
 #define GetCurrentThreadId pthread_self
+DSL_API void DSL_CC DSL_SetThreadName(pthread_t thread_id, const char * szThreadName);
 #endif
 
 #if !defined(NO_CPLUSPLUS) || defined(DOXYGEN_SKIP)
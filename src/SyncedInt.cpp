@@ -0,0 +1,58 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+#include <drift/dslcore.h>
+#include <drift/SyncedInt.h>
+#include <thread>
+
+#define DSL_SHARDED_COUNTER_MAX_SLOTS 64
+
+static atomic<uint32> dsl_next_counter_slot(0);
+static thread_local uint32 dsl_counter_slot = 0xFFFFFFFF;
+
+DSL_ShardedCounter::DSL_ShardedCounter() {
+	// round up to a power of 2 so picking a slot is just a mask
+	uint32 cores = thread::hardware_concurrency();
+	uint32 num = 1;
+	while (num < cores && num < DSL_SHARDED_COUNTER_MAX_SLOTS) {
+		num <<= 1;
+	}
+	mask = num - 1;
+	slots = new DSL_ShardedCounter_Slot[num];
+	for (uint32 i = 0; i < num; i++) {
+		slots[i].value = 0;
+	}
+}
+
+DSL_ShardedCounter::~DSL_ShardedCounter() {
+	delete [] slots;
+}
+
+DSL_ShardedCounter_Slot& DSL_ShardedCounter::slot() {
+	// each thread gets the next slot number the first time it uses any counter, so threads spread evenly over the slots
+	if (dsl_counter_slot == 0xFFFFFFFF) {
+		dsl_counter_slot = dsl_next_counter_slot.fetch_add(1, memory_order_relaxed) & 0x7FFFFFFF;
+	}
+	return slots[dsl_counter_slot & mask];
+}
+
+int64 DSL_ShardedCounter::Get() const {
+	int64 ret = 0;
+	for (uint32 i = 0; i <= mask; i++) {
+		ret += slots[i].value.load(memory_order_relaxed);
+	}
+	return ret;
+}
+
+void DSL_ShardedCounter::Reset() {
+	for (uint32 i = 0; i <= mask; i++) {
+		slots[i].value.store(0, memory_order_relaxed);
+	}
+}
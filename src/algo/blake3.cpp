@@ -0,0 +1,680 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+/*
+ * BLAKE3, following the structure of the reference implementation (https://github.com/BLAKE3-team/BLAKE3, CC0/Apache 2.0.)
+ * The input is split into 1K chunks that are the leaves of a binary tree, so whole chunks (and the parent nodes above them) can be hashed
+ * several at a time: one per 32-bit SIMD lane with the same vector extension approach as hash_mb.cpp (4 with SSE4.1, 8 with AVX2, 16 with
+ * AVX-512), and big inputs are split into subtrees that are hashed on the thread pool.
+ */
+
+#include <drift/dslcore.h>
+#include <drift/hash.h>
+#include <drift/parallel.h>
+#include <drift/algo/hash_accel.h>
+#include <drift/algo/blake3.h>
+
+#define B3_MAX_SIMD_DEGREE 16
+
+enum {
+	B3_CHUNK_START = 1 << 0,
+	B3_CHUNK_END = 1 << 1,
+	B3_PARENT = 1 << 2,
+	B3_ROOT = 1 << 3,
+	B3_KEYED_HASH = 1 << 4,
+	B3_DERIVE_KEY_CONTEXT = 1 << 5,
+	B3_DERIVE_KEY_MATERIAL = 1 << 6,
+};
+
+static const uint32 blake3_iv[8] = { 0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19 };
+
+static const uint8 blake3_msg_schedule[7][16] = {
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+	{ 2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8 },
+	{ 3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1 },
+	{ 10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6 },
+	{ 12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4 },
+	{ 9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7 },
+	{ 11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13 },
+};
+
+static inline uint32 b3_load32(const uint8 * p) {
+	return ((uint32)p[0]) | ((uint32)p[1] << 8) | ((uint32)p[2] << 16) | ((uint32)p[3] << 24);
+}
+
+static inline void b3_store32(uint8 * p, uint32 x) {
+	p[0] = (uint8)x;
+	p[1] = (uint8)(x >> 8);
+	p[2] = (uint8)(x >> 16);
+	p[3] = (uint8)(x >> 24);
+}
+
+static inline void b3_load_key(uint32 key_words[8], const uint8 key[BLAKE3_KEY_LEN]) {
+	for (int i = 0; i < 8; i++) {
+		key_words[i] = b3_load32(key + (i * 4));
+	}
+}
+
+static inline void b3_store_cv(uint8 out[BLAKE3_OUT_LEN], const uint32 cv[8]) {
+	for (int i = 0; i < 8; i++) {
+		b3_store32(out + (i * 4), cv[i]);
+	}
+}
+
+#define B3_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define B3_G(s, a, b, c, d, x, y) { \
+	s[a] = s[a] + s[b] + (x); s[d] = B3_ROTR(s[d] ^ s[a], 16); \
+	s[c] = s[c] + s[d]; s[b] = B3_ROTR(s[b] ^ s[c], 12); \
+	s[a] = s[a] + s[b] + (y); s[d] = B3_ROTR(s[d] ^ s[a], 8); \
+	s[c] = s[c] + s[d]; s[b] = B3_ROTR(s[b] ^ s[c], 7); \
+}
+#define B3_ROUND(s, m, r) { \
+	const uint8 * sched = blake3_msg_schedule[r]; \
+	B3_G(s, 0, 4, 8, 12, m[sched[0]], m[sched[1]]); \
+	B3_G(s, 1, 5, 9, 13, m[sched[2]], m[sched[3]]); \
+	B3_G(s, 2, 6, 10, 14, m[sched[4]], m[sched[5]]); \
+	B3_G(s, 3, 7, 11, 15, m[sched[6]], m[sched[7]]); \
+	B3_G(s, 0, 5, 10, 15, m[sched[8]], m[sched[9]]); \
+	B3_G(s, 1, 6, 11, 12, m[sched[10]], m[sched[11]]); \
+	B3_G(s, 2, 7, 8, 13, m[sched[12]], m[sched[13]]); \
+	B3_G(s, 3, 4, 9, 14, m[sched[14]], m[sched[15]]); \
+}
+
+static void b3_compress_pre(uint32 s[16], const uint32 cv[8], const uint8 block[BLAKE3_BLOCK_LEN], uint8 block_len, uint64 counter, uint8 flags) {
+	uint32 m[16];
+	for (int i = 0; i < 16; i++) {
+		m[i] = b3_load32(block + (i * 4));
+	}
+	for (int i = 0; i < 8; i++) {
+		s[i] = cv[i];
+	}
+	s[8] = blake3_iv[0];
+	s[9] = blake3_iv[1];
+	s[10] = blake3_iv[2];
+	s[11] = blake3_iv[3];
+	s[12] = (uint32)counter;
+	s[13] = (uint32)(counter >> 32);
+	s[14] = block_len;
+	s[15] = flags;
+	for (int r = 0; r < 7; r++) {
+		B3_ROUND(s, m, r);
+	}
+}
+
+static void b3_compress_in_place(uint32 cv[8], const uint8 block[BLAKE3_BLOCK_LEN], uint8 block_len, uint64 counter, uint8 flags) {
+	uint32 s[16];
+	b3_compress_pre(s, cv, block, block_len, counter, flags);
+	for (int i = 0; i < 8; i++) {
+		cv[i] = s[i] ^ s[i + 8];
+	}
+}
+
+static void b3_compress_xof(const uint32 cv[8], const uint8 block[BLAKE3_BLOCK_LEN], uint8 block_len, uint64 counter, uint8 flags, uint8 out[64]) {
+	uint32 s[16];
+	b3_compress_pre(s, cv, block, block_len, counter, flags);
+	for (int i = 0; i < 8; i++) {
+		b3_store32(out + (i * 4), s[i] ^ s[i + 8]);
+		b3_store32(out + 32 + (i * 4), s[i + 8] ^ cv[i]);
+	}
+}
+
+/*
+ * hash_many: hashes num_inputs inputs of blocks whole blocks each (full chunks, or the 64 byte pairs of child CVs for parent nodes) and
+ * writes their chaining values back to back into out. The chunk counter goes up by one per input when increment_counter is set.
+ */
+typedef void (*b3_hash_many_func)(const uint8 * const * inputs, size_t num_inputs, size_t blocks, const uint32 key[8], uint64 counter, bool increment_counter, uint8 flags, uint8 flags_start, uint8 flags_end, uint8 * out);
+
+static void b3_hash_one(const uint8 * input, size_t blocks, const uint32 key[8], uint64 counter, uint8 flags, uint8 flags_start, uint8 flags_end, uint8 out[BLAKE3_OUT_LEN]) {
+	uint32 cv[8];
+	memcpy(cv, key, sizeof(cv));
+	uint8 block_flags = flags | flags_start;
+	while (blocks > 0) {
+		if (blocks == 1) {
+			block_flags |= flags_end;
+		}
+		b3_compress_in_place(cv, input, BLAKE3_BLOCK_LEN, counter, block_flags);
+		input += BLAKE3_BLOCK_LEN;
+		blocks--;
+		block_flags = flags;
+	}
+	b3_store_cv(out, cv);
+}
+
+static void b3_hash_many_portable(const uint8 * const * inputs, size_t num_inputs, size_t blocks, const uint32 key[8], uint64 counter, bool increment_counter, uint8 flags, uint8 flags_start, uint8 flags_end, uint8 * out) {
+	for (size_t i = 0; i < num_inputs; i++) {
+		b3_hash_one(inputs[i], blocks, key, counter, flags, flags_start, flags_end, out + (i * BLAKE3_OUT_LEN));
+		if (increment_counter) {
+			counter++;
+		}
+	}
+}
+
+#if defined(DSL_HASH_MB)
+
+typedef uint32 b3_u32x4 __attribute__((vector_size(16)));
+typedef uint32 b3_u32x8 __attribute__((vector_size(32)));
+typedef uint32 b3_u32x16 __attribute__((vector_size(64)));
+
+// no target of its own, it takes on the one of the per-ISA wrapper it is inlined into
+#define B3_INLINE inline __attribute__((always_inline))
+
+/* The same as b3_hash_one() for N inputs at once, lane l hashes inputs[l] */
+template <typename V, size_t N> B3_INLINE void b3_hash_xN(const uint8 * const * inputs, size_t blocks, const uint32 key[8], uint64 counter, bool increment_counter, uint8 flags, uint8 flags_start, uint8 flags_end, uint8 * out) {
+	V cv[8];
+	for (int i = 0; i < 8; i++) {
+		cv[i] = V{} + key[i];
+	}
+	alignas(64) uint32 tmp[16][N];
+	for (size_t l = 0; l < N; l++) {
+		uint64 c = counter + (increment_counter ? l : 0);
+		tmp[0][l] = (uint32)c;
+		tmp[1][l] = (uint32)(c >> 32);
+	}
+	V ctr_lo, ctr_hi;
+	memcpy(&ctr_lo, tmp[0], sizeof(V));
+	memcpy(&ctr_hi, tmp[1], sizeof(V));
+
+	uint8 block_flags = flags | flags_start;
+	for (size_t b = 0; b < blocks; b++) {
+		if (b + 1 == blocks) {
+			block_flags |= flags_end;
+		}
+
+		// transpose word t of every lane's block into one vector per word
+		V m[16];
+		for (size_t l = 0; l < N; l++) {
+			const uint8 * p = inputs[l] + (b * BLAKE3_BLOCK_LEN);
+			for (int t = 0; t < 16; t++) {
+				tmp[t][l] = b3_load32(p + (t * 4));
+			}
+		}
+		memcpy(m, tmp, sizeof(m));
+
+		V s[16] = {};
+		for (int i = 0; i < 8; i++) {
+			s[i] = cv[i];
+		}
+		s[8] = V{} + blake3_iv[0];
+		s[9] = V{} + blake3_iv[1];
+		s[10] = V{} + blake3_iv[2];
+		s[11] = V{} + blake3_iv[3];
+		s[12] = ctr_lo;
+		s[13] = ctr_hi;
+		s[14] = V{} + (uint32)BLAKE3_BLOCK_LEN;
+		s[15] = V{} + (uint32)block_flags;
+		for (int r = 0; r < 7; r++) {
+			B3_ROUND(s, m, r);
+		}
+		for (int i = 0; i < 8; i++) {
+			cv[i] = s[i] ^ s[i + 8];
+		}
+		block_flags = flags;
+	}
+
+	memcpy(tmp, cv, sizeof(cv));
+	for (size_t l = 0; l < N; l++) {
+		for (int i = 0; i < 8; i++) {
+			b3_store32(out + (l * BLAKE3_OUT_LEN) + (i * 4), tmp[i][l]);
+		}
+	}
+}
+
+DSL_HASH_TARGET("sse4.1") static void b3_hash_x4_sse41(const uint8 * const * inputs, size_t blocks, const uint32 key[8], uint64 counter, bool increment_counter, uint8 flags, uint8 flags_start, uint8 flags_end, uint8 * out) {
+	b3_hash_xN<b3_u32x4, 4>(inputs, blocks, key, counter, increment_counter, flags, flags_start, flags_end, out);
+}
+DSL_HASH_TARGET("avx2") static void b3_hash_x8_avx2(const uint8 * const * inputs, size_t blocks, const uint32 key[8], uint64 counter, bool increment_counter, uint8 flags, uint8 flags_start, uint8 flags_end, uint8 * out) {
+	b3_hash_xN<b3_u32x8, 8>(inputs, blocks, key, counter, increment_counter, flags, flags_start, flags_end, out);
+}
+DSL_HASH_TARGET("avx512f,avx512vl,avx2") static void b3_hash_x16_avx512(const uint8 * const * inputs, size_t blocks, const uint32 key[8], uint64 counter, bool increment_counter, uint8 flags, uint8 flags_start, uint8 flags_end, uint8 * out) {
+	b3_hash_xN<b3_u32x16, 16>(inputs, blocks, key, counter, increment_counter, flags, flags_start, flags_end, out);
+}
+
+/* Feeds N inputs at a time to kernel, whatever is left over goes through the portable code */
+#define B3_HASH_MANY_SIMD(name, kernel, N) \
+static void name(const uint8 * const * inputs, size_t num_inputs, size_t blocks, const uint32 key[8], uint64 counter, bool increment_counter, uint8 flags, uint8 flags_start, uint8 flags_end, uint8 * out) { \
+	while (num_inputs >= N) { \
+		kernel(inputs, blocks, key, counter, increment_counter, flags, flags_start, flags_end, out); \
+		if (increment_counter) { \
+			counter += N; \
+		} \
+		inputs += N; \
+		num_inputs -= N; \
+		out += N * BLAKE3_OUT_LEN; \
+	} \
+	b3_hash_many_portable(inputs, num_inputs, blocks, key, counter, increment_counter, flags, flags_start, flags_end, out); \
+}
+B3_HASH_MANY_SIMD(b3_hash_many_sse41, b3_hash_x4_sse41, 4)
+B3_HASH_MANY_SIMD(b3_hash_many_avx2, b3_hash_x8_avx2, 8)
+B3_HASH_MANY_SIMD(b3_hash_many_avx512, b3_hash_x16_avx512, 16)
+
+#endif // DSL_HASH_MB
+
+struct B3_IMPL {
+	b3_hash_many_func hash_many;
+	size_t simd_degree; ///< how many inputs hash_many does at once
+};
+
+static B3_IMPL b3_pick_impl() {
+#if defined(DSL_HASH_MB)
+	const DSL_HASH_CPU * cpu = dsl_hash_cpu();
+	if (cpu->avx512) {
+		return { b3_hash_many_avx512, 16 };
+	}
+	if (cpu->avx2) {
+		return { b3_hash_many_avx2, 8 };
+	}
+	if (cpu->sse41) {
+		return { b3_hash_many_sse41, 4 };
+	}
+#endif
+	return { b3_hash_many_portable, 1 };
+}
+
+static const B3_IMPL& b3_impl() {
+	static const B3_IMPL impl = b3_pick_impl();
+	return impl;
+}
+
+/* Chunk state */
+
+static void b3_chunk_state_init(blake3_chunk_state * self, const uint32 key[8], uint8 flags) {
+	memcpy(self->cv, key, sizeof(self->cv));
+	self->chunk_counter = 0;
+	memset(self->buf, 0, sizeof(self->buf));
+	self->buf_len = 0;
+	self->blocks_compressed = 0;
+	self->flags = flags;
+}
+
+static void b3_chunk_state_reset(blake3_chunk_state * self, const uint32 key[8], uint64 chunk_counter) {
+	memcpy(self->cv, key, sizeof(self->cv));
+	self->chunk_counter = chunk_counter;
+	self->blocks_compressed = 0;
+	memset(self->buf, 0, sizeof(self->buf));
+	self->buf_len = 0;
+}
+
+static inline size_t b3_chunk_state_len(const blake3_chunk_state * self) {
+	return (BLAKE3_BLOCK_LEN * (size_t)self->blocks_compressed) + (size_t)self->buf_len;
+}
+
+static inline uint8 b3_chunk_state_start_flag(const blake3_chunk_state * self) {
+	return (self->blocks_compressed == 0) ? B3_CHUNK_START : 0;
+}
+
+static size_t b3_chunk_state_fill_buf(blake3_chunk_state * self, const uint8 * input, size_t input_len) {
+	size_t take = BLAKE3_BLOCK_LEN - (size_t)self->buf_len;
+	if (take > input_len) {
+		take = input_len;
+	}
+	memcpy(self->buf + self->buf_len, input, take);
+	self->buf_len += (uint8)take;
+	return take;
+}
+
+static void b3_chunk_state_update(blake3_chunk_state * self, const uint8 * input, size_t input_len) {
+	if (self->buf_len > 0) {
+		size_t take = b3_chunk_state_fill_buf(self, input, input_len);
+		input += take;
+		input_len -= take;
+		if (input_len > 0) {
+			b3_compress_in_place(self->cv, self->buf, BLAKE3_BLOCK_LEN, self->chunk_counter, self->flags | b3_chunk_state_start_flag(self));
+			self->blocks_compressed++;
+			self->buf_len = 0;
+			memset(self->buf, 0, sizeof(self->buf));
+		}
+	}
+
+	// the last block is always kept back, it might be the one that needs CHUNK_END
+	while (input_len > BLAKE3_BLOCK_LEN) {
+		b3_compress_in_place(self->cv, input, BLAKE3_BLOCK_LEN, self->chunk_counter, self->flags | b3_chunk_state_start_flag(self));
+		self->blocks_compressed++;
+		input += BLAKE3_BLOCK_LEN;
+		input_len -= BLAKE3_BLOCK_LEN;
+	}
+
+	b3_chunk_state_fill_buf(self, input, input_len);
+}
+
+/* A compression that hasn't been done yet, it becomes a chaining value or (for the root) the output stream */
+struct B3_OUTPUT {
+	uint32 input_cv[8];
+	uint64 counter;
+	uint8 block[BLAKE3_BLOCK_LEN];
+	uint8 block_len;
+	uint8 flags;
+};
+
+static B3_OUTPUT b3_make_output(const uint32 input_cv[8], const uint8 block[BLAKE3_BLOCK_LEN], uint8 block_len, uint64 counter, uint8 flags) {
+	B3_OUTPUT ret;
+	memcpy(ret.input_cv, input_cv, sizeof(ret.input_cv));
+	memcpy(ret.block, block, BLAKE3_BLOCK_LEN);
+	ret.block_len = block_len;
+	ret.counter = counter;
+	ret.flags = flags;
+	return ret;
+}
+
+static void b3_output_chaining_value(const B3_OUTPUT * self, uint8 cv[BLAKE3_OUT_LEN]) {
+	uint32 cv_words[8];
+	memcpy(cv_words, self->input_cv, sizeof(cv_words));
+	b3_compress_in_place(cv_words, self->block, self->block_len, self->counter, self->flags);
+	b3_store_cv(cv, cv_words);
+}
+
+static void b3_output_root_bytes(const B3_OUTPUT * self, uint64 seek, uint8 * out, size_t out_len) {
+	uint64 output_block_counter = seek / 64;
+	size_t offset_within_block = (size_t)(seek % 64);
+	uint8 wide_buf[64];
+	while (out_len > 0) {
+		b3_compress_xof(self->input_cv, self->block, self->block_len, output_block_counter, self->flags | B3_ROOT, wide_buf);
+		size_t available = 64 - offset_within_block;
+		size_t n = (out_len > available) ? available : out_len;
+		memcpy(out, wide_buf + offset_within_block, n);
+		out += n;
+		out_len -= n;
+		output_block_counter++;
+		offset_within_block = 0;
+	}
+}
+
+static B3_OUTPUT b3_chunk_state_output(const blake3_chunk_state * self) {
+	uint8 block_flags = self->flags | b3_chunk_state_start_flag(self) | B3_CHUNK_END;
+	return b3_make_output(self->cv, self->buf, self->buf_len, self->chunk_counter, block_flags);
+}
+
+static B3_OUTPUT b3_parent_output(const uint8 block[BLAKE3_BLOCK_LEN], const uint32 key[8], uint8 flags) {
+	return b3_make_output(key, block, BLAKE3_BLOCK_LEN, 0, flags | B3_PARENT);
+}
+
+/* Subtrees */
+
+static inline uint64 b3_round_down_to_power_of_2(uint64 x) {
+	uint64 ret = 1;
+	while ((ret << 1) <= x) {
+		ret <<= 1;
+	}
+	return ret;
+}
+
+static inline unsigned int b3_popcnt(uint64 x) {
+	unsigned int ret = 0;
+	while (x != 0) {
+		ret++;
+		x &= x - 1;
+	}
+	return ret;
+}
+
+// the left side of a subtree gets the largest power of 2 number of chunks that still leaves at least 1 byte for the right side
+static inline size_t b3_left_len(size_t content_len) {
+	size_t full_chunks = (content_len - 1) / BLAKE3_CHUNK_LEN;
+	return (size_t)b3_round_down_to_power_of_2(full_chunks) * BLAKE3_CHUNK_LEN;
+}
+
+static size_t b3_compress_chunks_parallel(const uint8 * input, size_t input_len, const uint32 key[8], uint64 chunk_counter, uint8 flags, uint8 * out) {
+	const uint8 * chunks_array[B3_MAX_SIMD_DEGREE];
+	size_t input_position = 0;
+	size_t chunks_array_len = 0;
+	while (input_len - input_position >= BLAKE3_CHUNK_LEN) {
+		chunks_array[chunks_array_len++] = input + input_position;
+		input_position += BLAKE3_CHUNK_LEN;
+	}
+
+	b3_impl().hash_many(chunks_array, chunks_array_len, BLAKE3_CHUNK_LEN / BLAKE3_BLOCK_LEN, key, chunk_counter, true, flags, B3_CHUNK_START, B3_CHUNK_END, out);
+
+	// a partial chunk at the end can only happen if the whole input was one chunk or less
+	if (input_len > input_position) {
+		blake3_chunk_state chunk;
+		b3_chunk_state_init(&chunk, key, flags);
+		chunk.chunk_counter = chunk_counter + (uint64)chunks_array_len;
+		b3_chunk_state_update(&chunk, input + input_position, input_len - input_position);
+		B3_OUTPUT output = b3_chunk_state_output(&chunk);
+		b3_output_chaining_value(&output, out + (chunks_array_len * BLAKE3_OUT_LEN));
+		return chunks_array_len + 1;
+	}
+	return chunks_array_len;
+}
+
+static size_t b3_compress_parents_parallel(const uint8 * child_chaining_values, size_t num_chaining_values, const uint32 key[8], uint8 flags, uint8 * out) {
+	const uint8 * parents_array[B3_MAX_SIMD_DEGREE];
+	size_t parents_array_len = 0;
+	while (num_chaining_values - (2 * parents_array_len) >= 2) {
+		parents_array[parents_array_len] = child_chaining_values + (2 * parents_array_len * BLAKE3_OUT_LEN);
+		parents_array_len++;
+	}
+
+	b3_impl().hash_many(parents_array, parents_array_len, 1, key, 0, false, flags | B3_PARENT, 0, 0, out);
+
+	// an odd one out is passed up as-is
+	if (num_chaining_values > 2 * parents_array_len) {
+		memcpy(out + (parents_array_len * BLAKE3_OUT_LEN), child_chaining_values + (2 * parents_array_len * BLAKE3_OUT_LEN), BLAKE3_OUT_LEN);
+		return parents_array_len + 1;
+	}
+	return parents_array_len;
+}
+
+static bool b3_use_threads() {
+	static const bool ret = (DSL_GetDefaultThreadPool()->NumThreads() > 1);
+	return ret;
+}
+
+/*
+ * Hashes a whole subtree down to at most simd_degree (or 2) chaining values so the level above can use SIMD too.
+ * The two halves of big subtrees are hashed on the thread pool at the same time.
+ */
+static size_t b3_compress_subtree_wide(const uint8 * input, size_t input_len, const uint32 key[8], uint64 chunk_counter, uint8 flags, uint8 * out) {
+	size_t simd_degree = b3_impl().simd_degree;
+	if (input_len <= simd_degree * BLAKE3_CHUNK_LEN) {
+		return b3_compress_chunks_parallel(input, input_len, key, chunk_counter, flags, out);
+	}
+
+	size_t left_input_len = b3_left_len(input_len);
+	size_t right_input_len = input_len - left_input_len;
+	const uint8 * right_input = input + left_input_len;
+	uint64 right_chunk_counter = chunk_counter + (uint64)(left_input_len / BLAKE3_CHUNK_LEN);
+
+	// with no SIMD at least 2 CVs are needed so there is always a parent node to make
+	uint8 cv_array[2 * B3_MAX_SIMD_DEGREE * BLAKE3_OUT_LEN];
+	size_t degree = simd_degree;
+	if (left_input_len > BLAKE3_CHUNK_LEN && degree == 1) {
+		degree = 2;
+	}
+	uint8 * right_cvs = cv_array + (degree * BLAKE3_OUT_LEN);
+
+	size_t left_n, right_n;
+	if (input_len >= BLAKE3_PARALLEL_MIN && b3_use_threads()) {
+		DSL_ParallelFor(0, 2, [&](size_t i) {
+			if (i == 0) {
+				left_n = b3_compress_subtree_wide(input, left_input_len, key, chunk_counter, flags, cv_array);
+			} else {
+				right_n = b3_compress_subtree_wide(right_input, right_input_len, key, right_chunk_counter, flags, right_cvs);
+			}
+		}, 1);
+	} else {
+		left_n = b3_compress_subtree_wide(input, left_input_len, key, chunk_counter, flags, cv_array);
+		right_n = b3_compress_subtree_wide(right_input, right_input_len, key, right_chunk_counter, flags, right_cvs);
+	}
+
+	// only happens without SIMD, the caller wants at least 2 CVs
+	if (left_n == 1) {
+		memcpy(out, cv_array, 2 * BLAKE3_OUT_LEN);
+		return 2;
+	}
+
+	return b3_compress_parents_parallel(cv_array, left_n + right_n, key, flags, out);
+}
+
+/* The root of a subtree is never compressed here since it could be the root of the whole tree, out gets its two children */
+static void b3_compress_subtree_to_parent_node(const uint8 * input, size_t input_len, const uint32 key[8], uint64 chunk_counter, uint8 flags, uint8 out[2 * BLAKE3_OUT_LEN]) {
+	uint8 cv_array[2 * B3_MAX_SIMD_DEGREE * BLAKE3_OUT_LEN];
+	size_t num_cvs = b3_compress_subtree_wide(input, input_len, key, chunk_counter, flags, cv_array);
+
+	uint8 out_array[B3_MAX_SIMD_DEGREE * BLAKE3_OUT_LEN];
+	while (num_cvs > 2) {
+		num_cvs = b3_compress_parents_parallel(cv_array, num_cvs, key, flags, out_array);
+		memcpy(cv_array, out_array, num_cvs * BLAKE3_OUT_LEN);
+	}
+	memcpy(out, cv_array, 2 * BLAKE3_OUT_LEN);
+}
+
+/* Hasher */
+
+static void b3_hasher_init_base(blake3_hasher * self, const uint32 key[8], uint8 flags) {
+	memcpy(self->key, key, sizeof(self->key));
+	b3_chunk_state_init(&self->chunk, key, flags);
+	self->cv_stack_len = 0;
+}
+
+void DSL_CC blake3_hasher_init(blake3_hasher * self) {
+	b3_hasher_init_base(self, blake3_iv, 0);
+}
+
+void DSL_CC blake3_hasher_init_keyed(blake3_hasher * self, const uint8 key[BLAKE3_KEY_LEN]) {
+	uint32 key_words[8];
+	b3_load_key(key_words, key);
+	b3_hasher_init_base(self, key_words, B3_KEYED_HASH);
+}
+
+void DSL_CC blake3_hasher_init_derive_key_raw(blake3_hasher * self, const void * context, size_t context_len) {
+	blake3_hasher context_hasher;
+	b3_hasher_init_base(&context_hasher, blake3_iv, B3_DERIVE_KEY_CONTEXT);
+	blake3_hasher_update(&context_hasher, context, context_len);
+	uint8 context_key[BLAKE3_KEY_LEN];
+	blake3_hasher_finalize(&context_hasher, context_key, BLAKE3_KEY_LEN);
+	uint32 context_key_words[8];
+	b3_load_key(context_key_words, context_key);
+	b3_hasher_init_base(self, context_key_words, B3_DERIVE_KEY_MATERIAL);
+}
+
+void DSL_CC blake3_hasher_init_derive_key(blake3_hasher * self, const char * context) {
+	blake3_hasher_init_derive_key_raw(self, context, strlen(context));
+}
+
+/*
+ * Merges finished subtrees on the CV stack. The number of completed subtrees is the number of 1 bits in total_len (in chunks), anything
+ * above that gets merged into parent nodes. The last merge is held back until there is more input since it might be the root.
+ */
+static void b3_hasher_merge_cv_stack(blake3_hasher * self, uint64 total_len) {
+	size_t post_merge_stack_len = (size_t)b3_popcnt(total_len);
+	while (self->cv_stack_len > post_merge_stack_len) {
+		uint8 * parent_node = self->cv_stack + ((self->cv_stack_len - 2) * BLAKE3_OUT_LEN);
+		B3_OUTPUT output = b3_parent_output(parent_node, self->key, self->chunk.flags);
+		b3_output_chaining_value(&output, parent_node);
+		self->cv_stack_len--;
+	}
+}
+
+static void b3_hasher_push_cv(blake3_hasher * self, const uint8 new_cv[BLAKE3_OUT_LEN], uint64 chunk_counter) {
+	b3_hasher_merge_cv_stack(self, chunk_counter);
+	memcpy(self->cv_stack + (self->cv_stack_len * BLAKE3_OUT_LEN), new_cv, BLAKE3_OUT_LEN);
+	self->cv_stack_len++;
+}
+
+void DSL_CC blake3_hasher_update(blake3_hasher * self, const void * input, size_t input_len) {
+	if (input_len == 0) {
+		return;
+	}
+	const uint8 * input_bytes = (const uint8 *)input;
+
+	// finish off a partial chunk first
+	if (b3_chunk_state_len(&self->chunk) > 0) {
+		size_t take = BLAKE3_CHUNK_LEN - b3_chunk_state_len(&self->chunk);
+		if (take > input_len) {
+			take = input_len;
+		}
+		b3_chunk_state_update(&self->chunk, input_bytes, take);
+		input_bytes += take;
+		input_len -= take;
+		if (input_len == 0) {
+			return;
+		}
+		B3_OUTPUT output = b3_chunk_state_output(&self->chunk);
+		uint8 chunk_cv[BLAKE3_OUT_LEN];
+		b3_output_chaining_value(&output, chunk_cv);
+		b3_hasher_push_cv(self, chunk_cv, self->chunk.chunk_counter);
+		b3_chunk_state_reset(&self->chunk, self->key, self->chunk.chunk_counter + 1);
+	}
+
+	// then the biggest whole subtrees we can, as long as they line up with what has been hashed so far
+	while (input_len > BLAKE3_CHUNK_LEN) {
+		uint64 subtree_len = b3_round_down_to_power_of_2(input_len);
+		uint64 count_so_far = self->chunk.chunk_counter * BLAKE3_CHUNK_LEN;
+		while (((subtree_len - 1) & count_so_far) != 0) {
+			subtree_len /= 2;
+		}
+		uint64 subtree_chunks = subtree_len / BLAKE3_CHUNK_LEN;
+		if (subtree_len <= BLAKE3_CHUNK_LEN) {
+			blake3_chunk_state chunk_state;
+			b3_chunk_state_init(&chunk_state, self->key, self->chunk.flags);
+			chunk_state.chunk_counter = self->chunk.chunk_counter;
+			b3_chunk_state_update(&chunk_state, input_bytes, (size_t)subtree_len);
+			B3_OUTPUT output = b3_chunk_state_output(&chunk_state);
+			uint8 cv[BLAKE3_OUT_LEN];
+			b3_output_chaining_value(&output, cv);
+			b3_hasher_push_cv(self, cv, chunk_state.chunk_counter);
+		} else {
+			uint8 cv_pair[2 * BLAKE3_OUT_LEN];
+			b3_compress_subtree_to_parent_node(input_bytes, (size_t)subtree_len, self->key, self->chunk.chunk_counter, self->chunk.flags, cv_pair);
+			b3_hasher_push_cv(self, cv_pair, self->chunk.chunk_counter);
+			b3_hasher_push_cv(self, cv_pair + BLAKE3_OUT_LEN, self->chunk.chunk_counter + (subtree_chunks / 2));
+		}
+		self->chunk.chunk_counter += subtree_chunks;
+		input_bytes += subtree_len;
+		input_len -= (size_t)subtree_len;
+	}
+
+	// whatever is left (at most 1 chunk) waits in the chunk state, it could be the root
+	if (input_len > 0) {
+		b3_chunk_state_update(&self->chunk, input_bytes, input_len);
+		b3_hasher_merge_cv_stack(self, self->chunk.chunk_counter);
+	}
+}
+
+void DSL_CC blake3_hasher_finalize_seek(const blake3_hasher * self, uint64 seek, uint8 * out, size_t out_len) {
+	if (out_len == 0) {
+		return;
+	}
+
+	// just one chunk, it is the root
+	if (self->cv_stack_len == 0) {
+		B3_OUTPUT output = b3_chunk_state_output(&self->chunk);
+		b3_output_root_bytes(&output, seek, out, out_len);
+		return;
+	}
+
+	B3_OUTPUT output;
+	size_t cvs_remaining;
+	if (b3_chunk_state_len(&self->chunk) > 0) {
+		cvs_remaining = self->cv_stack_len;
+		output = b3_chunk_state_output(&self->chunk);
+	} else {
+		// the stack has at least 2 CVs here, the top two make the last parent
+		cvs_remaining = self->cv_stack_len - 2;
+		output = b3_parent_output(self->cv_stack + (cvs_remaining * BLAKE3_OUT_LEN), self->key, self->chunk.flags);
+	}
+	while (cvs_remaining > 0) {
+		cvs_remaining--;
+		uint8 parent_block[BLAKE3_BLOCK_LEN];
+		memcpy(parent_block, self->cv_stack + (cvs_remaining * BLAKE3_OUT_LEN), BLAKE3_OUT_LEN);
+		b3_output_chaining_value(&output, parent_block + BLAKE3_OUT_LEN);
+		output = b3_parent_output(parent_block, self->key, self->chunk.flags);
+	}
+	b3_output_root_bytes(&output, seek, out, out_len);
+}
+
+void DSL_CC blake3_hasher_finalize(const blake3_hasher * self, uint8 * out, size_t out_len) {
+	blake3_hasher_finalize_seek(self, 0, out, out_len);
+}
+
+void DSL_CC blake3_hasher_reset(blake3_hasher * self) {
+	b3_chunk_state_reset(&self->chunk, self->key, 0);
+	self->cv_stack_len = 0;
+}
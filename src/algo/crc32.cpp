@@ -0,0 +1,245 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+/*
+ * CRC-32 and CRC-32C. The portable code is slicing-by-8, on x86 CRC-32C uses the SSE4.2 crc32 instruction and both fold 64 bytes at a time
+ * with PCLMULQDQ ("Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction", Intel 2009.)
+ */
+
+// the intrinsic headers have to come before dslcore.h poisons malloc & co.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+#include <drift/dslcore.h>
+#include <drift/algo/hash_accel.h>
+#include <drift/algo/fasthash.h>
+
+// bit reversed polynomials
+#define CRC32_POLY 0xEDB88320
+#define CRC32C_POLY 0x82F63B78
+
+struct CRC_TABLES {
+	uint32 t[8][256];
+};
+
+static void crc_make_tables(CRC_TABLES& tables, uint32 poly) {
+	for (uint32 i = 0; i < 256; i++) {
+		uint32 c = i;
+		for (int k = 0; k < 8; k++) {
+			c = (c & 1) ? (c >> 1) ^ poly : (c >> 1);
+		}
+		tables.t[0][i] = c;
+	}
+	for (uint32 i = 0; i < 256; i++) {
+		for (int k = 1; k < 8; k++) {
+			tables.t[k][i] = (tables.t[k - 1][i] >> 8) ^ tables.t[0][tables.t[k - 1][i] & 0xFF];
+		}
+	}
+}
+
+static const CRC_TABLES& crc32_tables() {
+	static const CRC_TABLES tables = []() {
+		CRC_TABLES ret;
+		crc_make_tables(ret, CRC32_POLY);
+		return ret;
+	}();
+	return tables;
+}
+
+static const CRC_TABLES& crc32c_tables() {
+	static const CRC_TABLES tables = []() {
+		CRC_TABLES ret;
+		crc_make_tables(ret, CRC32C_POLY);
+		return ret;
+	}();
+	return tables;
+}
+
+/* crc here (and in the other internal functions) is the running value, without the pre and post inversion */
+static uint32 crc_slice8(const CRC_TABLES& tables, uint32 crc, const uint8 * p, size_t len) {
+	const uint32 (*t)[256] = tables.t;
+	while (len >= 8) {
+		uint32 lo = crc ^ (((uint32)p[0]) | ((uint32)p[1] << 8) | ((uint32)p[2] << 16) | ((uint32)p[3] << 24));
+		uint32 hi = ((uint32)p[4]) | ((uint32)p[5] << 8) | ((uint32)p[6] << 16) | ((uint32)p[7] << 24);
+		crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^ t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+		p += 8;
+		len -= 8;
+	}
+	while (len--) {
+		crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+	}
+	return crc;
+}
+
+#if defined(DSL_HASH_X86)
+
+/*
+ * Folding constants for a bit reflected CRC, each is (x^n mod P) bit reversed and shifted left 1:
+ * k1/k2 fold 512 bits forward (n = 4*128+32, 4*128-32), k3/k4 128 bits (n = 128+32, 128-32), k5 64 bits (n = 64),
+ * and poly/mu (P itself and floor(x^64 / P), bit reversed) are for the final Barrett reduction.
+ */
+struct CRC_FOLD_CONSTANTS {
+	uint64 k1, k2;
+	uint64 k3, k4;
+	uint64 k5;
+	uint64 poly, mu;
+};
+
+static const CRC_FOLD_CONSTANTS crc32_fold = { 0x154442BD4ULL, 0x1C6E41596ULL, 0x1751997D0ULL, 0x0CCAA009EULL, 0x163CD6124ULL, 0x1DB710641ULL, 0x1F7011641ULL };
+static const CRC_FOLD_CONSTANTS crc32c_fold = { 0x0740EEF02ULL, 0x09E4ADDF8ULL, 0x0F20C0DFEULL, 0x14CD00BD6ULL, 0x0DD45AAB8ULL, 0x105EC76F1ULL, 0x0DEA713F1ULL };
+
+#define CRC_FOLD_MIN 64
+
+/* Folds len bytes (a multiple of 16, at least CRC_FOLD_MIN) down to a CRC */
+DSL_HASH_TARGET("pclmul,sse4.1") static uint32 crc_fold_pclmul(uint32 crc, const uint8 * p, size_t len, const CRC_FOLD_CONSTANTS& c) {
+	__m128i x1 = _mm_loadu_si128((const __m128i *)p);
+	__m128i x2 = _mm_loadu_si128((const __m128i *)(p + 16));
+	__m128i x3 = _mm_loadu_si128((const __m128i *)(p + 32));
+	__m128i x4 = _mm_loadu_si128((const __m128i *)(p + 48));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+	p += 64;
+	len -= 64;
+
+	// 4 x 128 bits at a time
+	__m128i k = _mm_set_epi64x((long long)c.k2, (long long)c.k1);
+	while (len >= 64) {
+		__m128i y1 = _mm_clmulepi64_si128(x1, k, 0x00);
+		__m128i y2 = _mm_clmulepi64_si128(x2, k, 0x00);
+		__m128i y3 = _mm_clmulepi64_si128(x3, k, 0x00);
+		__m128i y4 = _mm_clmulepi64_si128(x4, k, 0x00);
+		x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, k, 0x11), y1);
+		x2 = _mm_xor_si128(_mm_clmulepi64_si128(x2, k, 0x11), y2);
+		x3 = _mm_xor_si128(_mm_clmulepi64_si128(x3, k, 0x11), y3);
+		x4 = _mm_xor_si128(_mm_clmulepi64_si128(x4, k, 0x11), y4);
+		x1 = _mm_xor_si128(x1, _mm_loadu_si128((const __m128i *)p));
+		x2 = _mm_xor_si128(x2, _mm_loadu_si128((const __m128i *)(p + 16)));
+		x3 = _mm_xor_si128(x3, _mm_loadu_si128((const __m128i *)(p + 32)));
+		x4 = _mm_xor_si128(x4, _mm_loadu_si128((const __m128i *)(p + 48)));
+		p += 64;
+		len -= 64;
+	}
+
+	// down to one 128-bit value, then whatever 16 byte blocks are left
+	k = _mm_set_epi64x((long long)c.k4, (long long)c.k3);
+	x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k, 0x11), _mm_clmulepi64_si128(x1, k, 0x00)), x2);
+	x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k, 0x11), _mm_clmulepi64_si128(x1, k, 0x00)), x3);
+	x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k, 0x11), _mm_clmulepi64_si128(x1, k, 0x00)), x4);
+	while (len >= 16) {
+		x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k, 0x11), _mm_clmulepi64_si128(x1, k, 0x00)), _mm_loadu_si128((const __m128i *)p));
+		p += 16;
+		len -= 16;
+	}
+
+	// 128 -> 64 bits
+	const __m128i mask32 = _mm_setr_epi32(-1, 0, -1, 0);
+	x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, mask32);
+	x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, _mm_set_epi64x(0, (long long)c.k5), 0x00), x2);
+
+	// Barrett reduction to 32 bits
+	k = _mm_set_epi64x((long long)c.mu, (long long)c.poly);
+	x2 = _mm_and_si128(x1, mask32);
+	x2 = _mm_clmulepi64_si128(x2, k, 0x10);
+	x2 = _mm_and_si128(x2, mask32);
+	x2 = _mm_clmulepi64_si128(x2, k, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+	return (uint32)_mm_extract_epi32(x1, 1);
+}
+
+DSL_HASH_TARGET("sse4.2") static uint32 crc32c_sse42(uint32 crc, const uint8 * p, size_t len) {
+#if defined(__x86_64__) || defined(_M_X64)
+	uint64 crc64 = crc;
+	while (len >= 8) {
+		uint64 v;
+		memcpy(&v, p, 8);
+		crc64 = _mm_crc32_u64(crc64, v);
+		p += 8;
+		len -= 8;
+	}
+	crc = (uint32)crc64;
+#endif
+	while (len >= 4) {
+		uint32 v;
+		memcpy(&v, p, 4);
+		crc = _mm_crc32_u32(crc, v);
+		p += 4;
+		len -= 4;
+	}
+	while (len--) {
+		crc = _mm_crc32_u8(crc, *p++);
+	}
+	return crc;
+}
+
+#endif // DSL_HASH_X86
+
+typedef uint32 (*crc_func)(uint32 crc, const uint8 * p, size_t len);
+
+static uint32 crc32_portable(uint32 crc, const uint8 * p, size_t len) {
+	return crc_slice8(crc32_tables(), crc, p, len);
+}
+
+static uint32 crc32c_portable(uint32 crc, const uint8 * p, size_t len) {
+	return crc_slice8(crc32c_tables(), crc, p, len);
+}
+
+#if defined(DSL_HASH_X86)
+static uint32 crc32_pclmul(uint32 crc, const uint8 * p, size_t len) {
+	if (len >= CRC_FOLD_MIN) {
+		size_t n = len & ~(size_t)15;
+		crc = crc_fold_pclmul(crc, p, n, crc32_fold);
+		p += n;
+		len -= n;
+	}
+	return crc_slice8(crc32_tables(), crc, p, len);
+}
+
+static uint32 crc32c_pclmul(uint32 crc, const uint8 * p, size_t len) {
+	// one chain of crc32 instructions is limited by their latency (8 bytes per 3 cycles), folding wins once there is enough data to get it going
+	if (len >= 256) {
+		size_t n = len & ~(size_t)15;
+		crc = crc_fold_pclmul(crc, p, n, crc32c_fold);
+		p += n;
+		len -= n;
+	}
+	return crc32c_sse42(crc, p, len);
+}
+#endif
+
+static crc_func crc32_pick() {
+#if defined(DSL_HASH_X86)
+	if (dsl_hash_cpu()->pclmul && dsl_hash_cpu()->sse41) {
+		return crc32_pclmul;
+	}
+#endif
+	return crc32_portable;
+}
+
+static crc_func crc32c_pick() {
+#if defined(DSL_HASH_X86)
+	if (dsl_hash_cpu()->sse42) {
+		return dsl_hash_cpu()->pclmul ? crc32c_pclmul : crc32c_sse42;
+	}
+#endif
+	return crc32c_portable;
+}
+
+uint32 DSL_CC dsl_crc32(uint32 crc, const void * data, size_t len) {
+	static const crc_func func = crc32_pick();
+	return ~func(~crc, (const uint8 *)data, len);
+}
+
+uint32 DSL_CC dsl_crc32c(uint32 crc, const void * data, size_t len) {
+	static const crc_func func = crc32c_pick();
+	return ~func(~crc, (const uint8 *)data, len);
+}
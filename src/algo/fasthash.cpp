@@ -0,0 +1,627 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+/*
+ * XXH3 (https://github.com/Cyan4973/xxHash, BSD 2-clause) and wyhash final 4.2 (https://github.com/wangyi-fudan/wyhash, public domain.)
+ * Written from the reference code and checked against it, the output is the same as the originals.
+ */
+
+// the intrinsic headers have to come before dslcore.h poisons malloc & co.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <drift/dslcore.h>
+#include <drift/algo/hash_accel.h>
+#include <drift/algo/fasthash.h>
+
+static inline uint32 fh_read32(const uint8 * p) {
+	return ((uint32)p[0]) | ((uint32)p[1] << 8) | ((uint32)p[2] << 16) | ((uint32)p[3] << 24);
+}
+
+static inline uint64 fh_read64(const uint8 * p) {
+	return ((uint64)fh_read32(p)) | ((uint64)fh_read32(p + 4) << 32);
+}
+
+static inline void fh_write64(uint8 * p, uint64 x) {
+	for (int i = 0; i < 8; i++) {
+		p[i] = (uint8)(x >> (i * 8));
+	}
+}
+
+static inline uint32 fh_swap32(uint32 x) {
+	return ((x << 24) & 0xFF000000) | ((x << 8) & 0x00FF0000) | ((x >> 8) & 0x0000FF00) | ((x >> 24) & 0x000000FF);
+}
+
+static inline uint64 fh_swap64(uint64 x) {
+	return ((uint64)fh_swap32((uint32)x) << 32) | fh_swap32((uint32)(x >> 32));
+}
+
+static inline uint64 fh_rotl64(uint64 x, int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint32 fh_rotl32(uint32 x, int r) {
+	return (x << r) | (x >> (32 - r));
+}
+
+/* 64x64 -> 128-bit multiply */
+static inline void fh_mul128(uint64 a, uint64 b, uint64 * lo, uint64 * hi) {
+#if defined(__SIZEOF_INT128__)
+	unsigned __int128 r = (unsigned __int128)a * b;
+	*lo = (uint64)r;
+	*hi = (uint64)(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	*lo = _umul128(a, b, hi);
+#else
+	uint64 lo_lo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+	uint64 hi_lo = (a >> 32) * (b & 0xFFFFFFFF);
+	uint64 lo_hi = (a & 0xFFFFFFFF) * (b >> 32);
+	uint64 hi_hi = (a >> 32) * (b >> 32);
+	uint64 cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+	*hi = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+	*lo = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+#endif
+}
+
+static inline uint64 fh_mul128_fold64(uint64 a, uint64 b) {
+	uint64 lo, hi;
+	fh_mul128(a, b, &lo, &hi);
+	return lo ^ hi;
+}
+
+/* XXH3 */
+
+#define XXH_PRIME32_1 0x9E3779B1U
+#define XXH_PRIME32_2 0x85EBCA77U
+#define XXH_PRIME32_3 0xC2B2AE3DU
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+#define XXH_PRIME_MX1 0x165667919E3779F9ULL
+#define XXH_PRIME_MX2 0x9FB21C651E98DF25ULL
+
+#define XXH_SECRET_SIZE 192
+#define XXH_STRIPE_LEN 64
+#define XXH_SECRET_CONSUME_RATE 8
+#define XXH_STRIPES_PER_BLOCK ((XXH_SECRET_SIZE - XXH_STRIPE_LEN) / XXH_SECRET_CONSUME_RATE)
+#define XXH_BLOCK_LEN (XXH_STRIPE_LEN * XXH_STRIPES_PER_BLOCK)
+#define XXH_MIDSIZE_MAX 240
+#define XXH_MIDSIZE_STARTOFFSET 3
+#define XXH_MIDSIZE_LASTOFFSET 17
+#define XXH_SECRET_SIZE_MIN 136
+#define XXH_SECRET_LASTACC_START 7
+#define XXH_SECRET_MERGEACCS_START 11
+#define XXH_BUFFER_SIZE 256
+
+static const uint8 xxh3_ksecret[XXH_SECRET_SIZE] = {
+	0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+	0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+	0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+	0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+	0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+	0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+	0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+	0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+	0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+	0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+	0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+	0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+static const uint64 xxh3_init_acc[8] = { XXH_PRIME32_3, XXH_PRIME64_1, XXH_PRIME64_2, XXH_PRIME64_3, XXH_PRIME64_4, XXH_PRIME32_2, XXH_PRIME64_5, XXH_PRIME32_1 };
+
+static inline uint64 xxh64_avalanche(uint64 h) {
+	h ^= h >> 33;
+	h *= XXH_PRIME64_2;
+	h ^= h >> 29;
+	h *= XXH_PRIME64_3;
+	h ^= h >> 32;
+	return h;
+}
+
+static inline uint64 xxh3_avalanche(uint64 h) {
+	h ^= h >> 37;
+	h *= XXH_PRIME_MX1;
+	h ^= h >> 32;
+	return h;
+}
+
+static inline uint64 xxh3_rrmxmx(uint64 h, uint64 len) {
+	h ^= fh_rotl64(h, 49) ^ fh_rotl64(h, 24);
+	h *= XXH_PRIME_MX2;
+	h ^= (h >> 35) + len;
+	h *= XXH_PRIME_MX2;
+	return h ^ (h >> 28);
+}
+
+static inline uint64 xxh3_mix16(const uint8 * input, const uint8 * secret, uint64 seed) {
+	return fh_mul128_fold64(fh_read64(input) ^ (fh_read64(secret) + seed), fh_read64(input + 8) ^ (fh_read64(secret + 8) - seed));
+}
+
+static void xxh3_init_secret(uint8 secret[XXH_SECRET_SIZE], uint64 seed) {
+	for (int i = 0; i < XXH_SECRET_SIZE / 16; i++) {
+		fh_write64(secret + (16 * i), fh_read64(xxh3_ksecret + (16 * i)) + seed);
+		fh_write64(secret + (16 * i) + 8, fh_read64(xxh3_ksecret + (16 * i) + 8) - seed);
+	}
+}
+
+/* Short inputs, these always use the default secret */
+
+static uint64 xxh3_64_0to16(const uint8 * input, size_t len, const uint8 * secret, uint64 seed) {
+	if (len > 8) {
+		uint64 bitflip1 = (fh_read64(secret + 24) ^ fh_read64(secret + 32)) + seed;
+		uint64 bitflip2 = (fh_read64(secret + 40) ^ fh_read64(secret + 48)) - seed;
+		uint64 input_lo = fh_read64(input) ^ bitflip1;
+		uint64 input_hi = fh_read64(input + len - 8) ^ bitflip2;
+		uint64 acc = len + fh_swap64(input_lo) + input_hi + fh_mul128_fold64(input_lo, input_hi);
+		return xxh3_avalanche(acc);
+	}
+	if (len >= 4) {
+		seed ^= (uint64)fh_swap32((uint32)seed) << 32;
+		uint64 input1 = fh_read32(input);
+		uint64 input2 = fh_read32(input + len - 4);
+		uint64 bitflip = (fh_read64(secret + 8) ^ fh_read64(secret + 16)) - seed;
+		uint64 input64 = input2 + (input1 << 32);
+		return xxh3_rrmxmx(input64 ^ bitflip, len);
+	}
+	if (len > 0) {
+		uint32 combined = ((uint32)input[0] << 16) | ((uint32)input[len >> 1] << 24) | ((uint32)input[len - 1]) | ((uint32)len << 8);
+		uint64 bitflip = (fh_read32(secret) ^ fh_read32(secret + 4)) + seed;
+		return xxh64_avalanche((uint64)combined ^ bitflip);
+	}
+	return xxh64_avalanche(seed ^ (fh_read64(secret + 56) ^ fh_read64(secret + 64)));
+}
+
+static uint64 xxh3_64_17to128(const uint8 * input, size_t len, const uint8 * secret, uint64 seed) {
+	uint64 acc = len * XXH_PRIME64_1;
+	if (len > 32) {
+		if (len > 64) {
+			if (len > 96) {
+				acc += xxh3_mix16(input + 48, secret + 96, seed);
+				acc += xxh3_mix16(input + len - 64, secret + 112, seed);
+			}
+			acc += xxh3_mix16(input + 32, secret + 64, seed);
+			acc += xxh3_mix16(input + len - 48, secret + 80, seed);
+		}
+		acc += xxh3_mix16(input + 16, secret + 32, seed);
+		acc += xxh3_mix16(input + len - 32, secret + 48, seed);
+	}
+	acc += xxh3_mix16(input, secret, seed);
+	acc += xxh3_mix16(input + len - 16, secret + 16, seed);
+	return xxh3_avalanche(acc);
+}
+
+static uint64 xxh3_64_129to240(const uint8 * input, size_t len, const uint8 * secret, uint64 seed) {
+	uint64 acc = len * XXH_PRIME64_1;
+	unsigned int rounds = (unsigned int)len / 16;
+	for (unsigned int i = 0; i < 8; i++) {
+		acc += xxh3_mix16(input + (16 * i), secret + (16 * i), seed);
+	}
+	uint64 acc_end = xxh3_mix16(input + len - 16, secret + XXH_SECRET_SIZE_MIN - XXH_MIDSIZE_LASTOFFSET, seed);
+	acc = xxh3_avalanche(acc);
+	for (unsigned int i = 8; i < rounds; i++) {
+		acc_end += xxh3_mix16(input + (16 * i), secret + (16 * (i - 8)) + XXH_MIDSIZE_STARTOFFSET, seed);
+	}
+	return xxh3_avalanche(acc + acc_end);
+}
+
+static xxh3_128_hash xxh3_128_0to16(const uint8 * input, size_t len, const uint8 * secret, uint64 seed) {
+	xxh3_128_hash ret;
+	if (len > 8) {
+		uint64 bitflipl = (fh_read64(secret + 32) ^ fh_read64(secret + 40)) - seed;
+		uint64 bitfliph = (fh_read64(secret + 48) ^ fh_read64(secret + 56)) + seed;
+		uint64 input_lo = fh_read64(input);
+		uint64 input_hi = fh_read64(input + len - 8);
+		uint64 m_lo, m_hi;
+		fh_mul128(input_lo ^ input_hi ^ bitflipl, XXH_PRIME64_1, &m_lo, &m_hi);
+		m_lo += (uint64)(len - 1) << 54;
+		input_hi ^= bitfliph;
+		m_hi += input_hi + ((uint64)(uint32)input_hi * (uint64)(XXH_PRIME32_2 - 1));
+		m_lo ^= fh_swap64(m_hi);
+		fh_mul128(m_lo, XXH_PRIME64_2, &ret.low, &ret.high);
+		ret.high += m_hi * XXH_PRIME64_2;
+		ret.low = xxh3_avalanche(ret.low);
+		ret.high = xxh3_avalanche(ret.high);
+		return ret;
+	}
+	if (len >= 4) {
+		seed ^= (uint64)fh_swap32((uint32)seed) << 32;
+		uint64 input_64 = fh_read32(input) + ((uint64)fh_read32(input + len - 4) << 32);
+		uint64 bitflip = (fh_read64(secret + 16) ^ fh_read64(secret + 24)) + seed;
+		fh_mul128(input_64 ^ bitflip, XXH_PRIME64_1 + (len << 2), &ret.low, &ret.high);
+		ret.high += (ret.low << 1);
+		ret.low ^= (ret.high >> 3);
+		ret.low ^= ret.low >> 35;
+		ret.low *= XXH_PRIME_MX2;
+		ret.low ^= ret.low >> 28;
+		ret.high = xxh3_avalanche(ret.high);
+		return ret;
+	}
+	if (len > 0) {
+		uint32 combinedl = ((uint32)input[0] << 16) | ((uint32)input[len >> 1] << 24) | ((uint32)input[len - 1]) | ((uint32)len << 8);
+		uint32 combinedh = fh_rotl32(fh_swap32(combinedl), 13);
+		uint64 bitflipl = (fh_read32(secret) ^ fh_read32(secret + 4)) + seed;
+		uint64 bitfliph = (fh_read32(secret + 8) ^ fh_read32(secret + 12)) - seed;
+		ret.low = xxh64_avalanche((uint64)combinedl ^ bitflipl);
+		ret.high = xxh64_avalanche((uint64)combinedh ^ bitfliph);
+		return ret;
+	}
+	ret.low = xxh64_avalanche(seed ^ fh_read64(secret + 64) ^ fh_read64(secret + 72));
+	ret.high = xxh64_avalanche(seed ^ fh_read64(secret + 80) ^ fh_read64(secret + 88));
+	return ret;
+}
+
+static inline void xxh3_mix32(xxh3_128_hash& acc, const uint8 * input_1, const uint8 * input_2, const uint8 * secret, uint64 seed) {
+	acc.low += xxh3_mix16(input_1, secret, seed);
+	acc.low ^= fh_read64(input_2) + fh_read64(input_2 + 8);
+	acc.high += xxh3_mix16(input_2, secret + 16, seed);
+	acc.high ^= fh_read64(input_1) + fh_read64(input_1 + 8);
+}
+
+static xxh3_128_hash xxh3_128_finish_mid(const xxh3_128_hash& acc, size_t len, uint64 seed) {
+	xxh3_128_hash ret;
+	ret.low = xxh3_avalanche(acc.low + acc.high);
+	ret.high = (uint64)0 - xxh3_avalanche((acc.low * XXH_PRIME64_1) + (acc.high * XXH_PRIME64_4) + ((len - seed) * XXH_PRIME64_2));
+	return ret;
+}
+
+static xxh3_128_hash xxh3_128_17to128(const uint8 * input, size_t len, const uint8 * secret, uint64 seed) {
+	xxh3_128_hash acc = { len * XXH_PRIME64_1, 0 };
+	if (len > 32) {
+		if (len > 64) {
+			if (len > 96) {
+				xxh3_mix32(acc, input + 48, input + len - 64, secret + 96, seed);
+			}
+			xxh3_mix32(acc, input + 32, input + len - 48, secret + 64, seed);
+		}
+		xxh3_mix32(acc, input + 16, input + len - 32, secret + 32, seed);
+	}
+	xxh3_mix32(acc, input, input + len - 16, secret, seed);
+	return xxh3_128_finish_mid(acc, len, seed);
+}
+
+static xxh3_128_hash xxh3_128_129to240(const uint8 * input, size_t len, const uint8 * secret, uint64 seed) {
+	xxh3_128_hash acc = { len * XXH_PRIME64_1, 0 };
+	for (size_t i = 32; i < 160; i += 32) {
+		xxh3_mix32(acc, input + i - 32, input + i - 16, secret + i - 32, seed);
+	}
+	acc.low = xxh3_avalanche(acc.low);
+	acc.high = xxh3_avalanche(acc.high);
+	for (size_t i = 160; i <= len; i += 32) {
+		xxh3_mix32(acc, input + i - 32, input + i - 16, secret + XXH_MIDSIZE_STARTOFFSET + i - 160, seed);
+	}
+	xxh3_mix32(acc, input + len - 16, input + len - 32, secret + XXH_SECRET_SIZE_MIN - XXH_MIDSIZE_LASTOFFSET - 16, (uint64)0 - seed);
+	return xxh3_128_finish_mid(acc, len, seed);
+}
+
+/*
+ * Long inputs: 8 64-bit accumulators take a 64 byte stripe at a time, and get scrambled every XXH_BLOCK_LEN bytes.
+ * accumulate() does nstripes stripes with the secret moving 8 bytes per stripe.
+ */
+typedef void (*xxh3_accumulate_func)(uint64 acc[8], const uint8 * input, const uint8 * secret, size_t nstripes);
+typedef void (*xxh3_scramble_func)(uint64 acc[8], const uint8 * secret);
+
+static void xxh3_accumulate_scalar(uint64 acc[8], const uint8 * input, const uint8 * secret, size_t nstripes) {
+	for (size_t n = 0; n < nstripes; n++) {
+		const uint8 * in = input + (n * XXH_STRIPE_LEN);
+		const uint8 * sec = secret + (n * XXH_SECRET_CONSUME_RATE);
+		for (int i = 0; i < 8; i++) {
+			uint64 data_val = fh_read64(in + (i * 8));
+			uint64 data_key = data_val ^ fh_read64(sec + (i * 8));
+			acc[i ^ 1] += data_val;
+			acc[i] += (uint64)(uint32)data_key * (data_key >> 32);
+		}
+	}
+}
+
+static void xxh3_scramble_scalar(uint64 acc[8], const uint8 * secret) {
+	for (int i = 0; i < 8; i++) {
+		uint64 a = acc[i];
+		a ^= a >> 47;
+		a ^= fh_read64(secret + (i * 8));
+		a *= XXH_PRIME32_1;
+		acc[i] = a;
+	}
+}
+
+#if defined(DSL_HASH_X86)
+
+/*
+ * 4 accumulators per register. There is no AVX-512 version, the long input loop is already limited by loads with AVX2 and
+ * 512-bit versions of these intrinsics trip -Wuninitialized false positives in GCC 12's headers.
+ */
+DSL_HASH_TARGET("avx2") static void xxh3_accumulate_avx2(uint64 acc[8], const uint8 * input, const uint8 * secret, size_t nstripes) {
+	__m256i a0 = _mm256_loadu_si256((const __m256i *)acc);
+	__m256i a1 = _mm256_loadu_si256((const __m256i *)(acc + 4));
+	for (size_t n = 0; n < nstripes; n++) {
+		const uint8 * in = input + (n * XXH_STRIPE_LEN);
+		const uint8 * sec = secret + (n * XXH_SECRET_CONSUME_RATE);
+		__m256i d0 = _mm256_loadu_si256((const __m256i *)in);
+		__m256i d1 = _mm256_loadu_si256((const __m256i *)(in + 32));
+		__m256i k0 = _mm256_xor_si256(d0, _mm256_loadu_si256((const __m256i *)sec));
+		__m256i k1 = _mm256_xor_si256(d1, _mm256_loadu_si256((const __m256i *)(sec + 32)));
+		// low 32 bits * high 32 bits of each data^key lane, plus the data of the neighbouring lane
+		a0 = _mm256_add_epi64(a0, _mm256_mul_epu32(k0, _mm256_srli_epi64(k0, 32)));
+		a1 = _mm256_add_epi64(a1, _mm256_mul_epu32(k1, _mm256_srli_epi64(k1, 32)));
+		a0 = _mm256_add_epi64(a0, _mm256_shuffle_epi32(d0, _MM_SHUFFLE(1, 0, 3, 2)));
+		a1 = _mm256_add_epi64(a1, _mm256_shuffle_epi32(d1, _MM_SHUFFLE(1, 0, 3, 2)));
+	}
+	_mm256_storeu_si256((__m256i *)acc, a0);
+	_mm256_storeu_si256((__m256i *)(acc + 4), a1);
+}
+
+DSL_HASH_TARGET("avx2") static void xxh3_scramble_avx2(uint64 acc[8], const uint8 * secret) {
+	const __m256i prime = _mm256_set1_epi32((int)XXH_PRIME32_1);
+	for (int i = 0; i < 2; i++) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)(acc + (i * 4)));
+		a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+		a = _mm256_xor_si256(a, _mm256_loadu_si256((const __m256i *)(secret + (i * 32))));
+		// 64-bit * 32-bit multiply done as two 32x32 halves
+		__m256i lo = _mm256_mul_epu32(a, prime);
+		__m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+		_mm256_storeu_si256((__m256i *)(acc + (i * 4)), _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32)));
+	}
+}
+
+#endif // DSL_HASH_X86
+
+struct XXH3_IMPL {
+	xxh3_accumulate_func accumulate;
+	xxh3_scramble_func scramble;
+};
+
+static XXH3_IMPL xxh3_pick_impl() {
+#if defined(DSL_HASH_X86)
+	if (dsl_hash_cpu()->avx2) {
+		return { xxh3_accumulate_avx2, xxh3_scramble_avx2 };
+	}
+#endif
+	return { xxh3_accumulate_scalar, xxh3_scramble_scalar };
+}
+
+static const XXH3_IMPL& xxh3_impl() {
+	static const XXH3_IMPL impl = xxh3_pick_impl();
+	return impl;
+}
+
+static void xxh3_hash_long(uint64 acc[8], const uint8 * input, size_t len, const uint8 * secret) {
+	const XXH3_IMPL& impl = xxh3_impl();
+	memcpy(acc, xxh3_init_acc, sizeof(xxh3_init_acc));
+	size_t nblocks = (len - 1) / XXH_BLOCK_LEN;
+	for (size_t n = 0; n < nblocks; n++) {
+		impl.accumulate(acc, input + (n * XXH_BLOCK_LEN), secret, XXH_STRIPES_PER_BLOCK);
+		impl.scramble(acc, secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN);
+	}
+	size_t nstripes = ((len - 1) - (XXH_BLOCK_LEN * nblocks)) / XXH_STRIPE_LEN;
+	impl.accumulate(acc, input + (nblocks * XXH_BLOCK_LEN), secret, nstripes);
+	// the last stripe always ends on the last byte, even if it overlaps the one before
+	impl.accumulate(acc, input + len - XXH_STRIPE_LEN, secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN - XXH_SECRET_LASTACC_START, 1);
+}
+
+static uint64 xxh3_merge_accs(const uint64 acc[8], const uint8 * secret, uint64 start) {
+	uint64 result = start;
+	for (int i = 0; i < 4; i++) {
+		result += fh_mul128_fold64(acc[2 * i] ^ fh_read64(secret + (16 * i)), acc[(2 * i) + 1] ^ fh_read64(secret + (16 * i) + 8));
+	}
+	return xxh3_avalanche(result);
+}
+
+static inline uint64 xxh3_merge64(const uint64 acc[8], const uint8 * secret, uint64 len) {
+	return xxh3_merge_accs(acc, secret + XXH_SECRET_MERGEACCS_START, len * XXH_PRIME64_1);
+}
+
+static inline xxh3_128_hash xxh3_merge128(const uint64 acc[8], const uint8 * secret, uint64 len) {
+	xxh3_128_hash ret;
+	ret.low = xxh3_merge_accs(acc, secret + XXH_SECRET_MERGEACCS_START, len * XXH_PRIME64_1);
+	ret.high = xxh3_merge_accs(acc, secret + XXH_SECRET_SIZE - 64 - XXH_SECRET_MERGEACCS_START, ~(len * XXH_PRIME64_2));
+	return ret;
+}
+
+/* Long inputs with a seed use a secret derived from it instead */
+static const uint8 * xxh3_long_secret(uint64 seed, uint8 custom[XXH_SECRET_SIZE]) {
+	if (seed == 0) {
+		return xxh3_ksecret;
+	}
+	xxh3_init_secret(custom, seed);
+	return custom;
+}
+
+uint64 DSL_CC xxh3_64(const void * data, size_t len, uint64 seed) {
+	const uint8 * input = (const uint8 *)data;
+	if (len <= 16) {
+		return xxh3_64_0to16(input, len, xxh3_ksecret, seed);
+	}
+	if (len <= 128) {
+		return xxh3_64_17to128(input, len, xxh3_ksecret, seed);
+	}
+	if (len <= XXH_MIDSIZE_MAX) {
+		return xxh3_64_129to240(input, len, xxh3_ksecret, seed);
+	}
+	uint8 custom[XXH_SECRET_SIZE];
+	const uint8 * secret = xxh3_long_secret(seed, custom);
+	uint64 acc[8];
+	xxh3_hash_long(acc, input, len, secret);
+	return xxh3_merge64(acc, secret, len);
+}
+
+xxh3_128_hash DSL_CC xxh3_128(const void * data, size_t len, uint64 seed) {
+	const uint8 * input = (const uint8 *)data;
+	if (len <= 16) {
+		return xxh3_128_0to16(input, len, xxh3_ksecret, seed);
+	}
+	if (len <= 128) {
+		return xxh3_128_17to128(input, len, xxh3_ksecret, seed);
+	}
+	if (len <= XXH_MIDSIZE_MAX) {
+		return xxh3_128_129to240(input, len, xxh3_ksecret, seed);
+	}
+	uint8 custom[XXH_SECRET_SIZE];
+	const uint8 * secret = xxh3_long_secret(seed, custom);
+	uint64 acc[8];
+	xxh3_hash_long(acc, input, len, secret);
+	return xxh3_merge128(acc, secret, len);
+}
+
+/* Streaming */
+
+void DSL_CC xxh3_init(xxh3_state * state, uint64 seed) {
+	memcpy(state->acc, xxh3_init_acc, sizeof(state->acc));
+	xxh3_init_secret(state->secret, seed);
+	state->buffered = 0;
+	state->stripes_so_far = 0;
+	state->total_len = 0;
+	state->seed = seed;
+}
+
+/* Feeds nstripes stripes to the accumulators, scrambling whenever a block's worth of secret has been used up */
+static void xxh3_consume_stripes(uint64 acc[8], size_t * stripes_so_far, const uint8 * input, size_t nstripes, const uint8 * secret) {
+	const XXH3_IMPL& impl = xxh3_impl();
+	while (nstripes > 0) {
+		size_t n = XXH_STRIPES_PER_BLOCK - *stripes_so_far;
+		if (n > nstripes) {
+			n = nstripes;
+		}
+		impl.accumulate(acc, input, secret + (*stripes_so_far * XXH_SECRET_CONSUME_RATE), n);
+		*stripes_so_far += n;
+		if (*stripes_so_far == XXH_STRIPES_PER_BLOCK) {
+			impl.scramble(acc, secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN);
+			*stripes_so_far = 0;
+		}
+		input += n * XXH_STRIPE_LEN;
+		nstripes -= n;
+	}
+}
+
+void DSL_CC xxh3_update(xxh3_state * state, const void * data, size_t len) {
+	const uint8 * input = (const uint8 *)data;
+	state->total_len += len;
+	if (len <= XXH_BUFFER_SIZE - state->buffered) {
+		memcpy(state->buffer + state->buffered, input, len);
+		state->buffered += (uint32)len;
+		return;
+	}
+
+	/*
+	 * There is more than a buffer full, so everything but the last (up to) 256 bytes can be hashed now.
+	 * The buffer is only emptied when more data comes in since the last stripe gets special treatment at the end.
+	 */
+	if (state->buffered > 0) {
+		size_t take = XXH_BUFFER_SIZE - state->buffered;
+		memcpy(state->buffer + state->buffered, input, take);
+		input += take;
+		len -= take;
+		xxh3_consume_stripes(state->acc, &state->stripes_so_far, state->buffer, XXH_BUFFER_SIZE / XXH_STRIPE_LEN, state->secret);
+		state->buffered = 0;
+	}
+
+	if (len > XXH_BUFFER_SIZE) {
+		size_t nstripes = (len - 1) / XXH_STRIPE_LEN;
+		xxh3_consume_stripes(state->acc, &state->stripes_so_far, input, nstripes, state->secret);
+		input += nstripes * XXH_STRIPE_LEN;
+		len -= nstripes * XXH_STRIPE_LEN;
+		// keep the stripe before what is left over, the final stripe might need some of it
+		memcpy(state->buffer + XXH_BUFFER_SIZE - XXH_STRIPE_LEN, input - XXH_STRIPE_LEN, XXH_STRIPE_LEN);
+	}
+
+	memcpy(state->buffer, input, len);
+	state->buffered = (uint32)len;
+}
+
+static void xxh3_digest_long(const xxh3_state * state, uint64 acc[8]) {
+	memcpy(acc, state->acc, sizeof(state->acc));
+	uint8 last_stripe[XXH_STRIPE_LEN];
+	const uint8 * last;
+	if (state->buffered >= XXH_STRIPE_LEN) {
+		size_t stripes_so_far = state->stripes_so_far;
+		xxh3_consume_stripes(acc, &stripes_so_far, state->buffer, (state->buffered - 1) / XXH_STRIPE_LEN, state->secret);
+		last = state->buffer + state->buffered - XXH_STRIPE_LEN;
+	} else {
+		// the last stripe starts in the previous buffer full, its end is still at the end of the buffer
+		size_t catchup = XXH_STRIPE_LEN - state->buffered;
+		memcpy(last_stripe, state->buffer + XXH_BUFFER_SIZE - catchup, catchup);
+		memcpy(last_stripe + catchup, state->buffer, state->buffered);
+		last = last_stripe;
+	}
+	xxh3_impl().accumulate(acc, last, state->secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN - XXH_SECRET_LASTACC_START, 1);
+}
+
+uint64 DSL_CC xxh3_digest64(const xxh3_state * state) {
+	if (state->total_len > XXH_MIDSIZE_MAX) {
+		uint64 acc[8];
+		xxh3_digest_long(state, acc);
+		return xxh3_merge64(acc, state->secret, state->total_len);
+	}
+	return xxh3_64(state->buffer, (size_t)state->total_len, state->seed);
+}
+
+xxh3_128_hash DSL_CC xxh3_digest128(const xxh3_state * state) {
+	if (state->total_len > XXH_MIDSIZE_MAX) {
+		uint64 acc[8];
+		xxh3_digest_long(state, acc);
+		return xxh3_merge128(acc, state->secret, state->total_len);
+	}
+	return xxh3_128(state->buffer, (size_t)state->total_len, state->seed);
+}
+
+/* wyhash */
+
+static const uint64 wyhash_secret[4] = { 0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL };
+
+static inline uint64 wyhash_mix(uint64 a, uint64 b) {
+	return fh_mul128_fold64(a, b);
+}
+
+uint64 DSL_CC wyhash(const void * data, size_t len, uint64 seed) {
+	const uint8 * p = (const uint8 *)data;
+	const uint64 * secret = wyhash_secret;
+	seed ^= wyhash_mix(seed ^ secret[0], secret[1]);
+	uint64 a, b;
+	if (len <= 16) {
+		if (len >= 4) {
+			a = ((uint64)fh_read32(p) << 32) | fh_read32(p + ((len >> 3) << 2));
+			b = ((uint64)fh_read32(p + len - 4) << 32) | fh_read32(p + len - 4 - ((len >> 3) << 2));
+		} else if (len > 0) {
+			a = ((uint64)p[0] << 16) | ((uint64)p[len >> 1] << 8) | p[len - 1];
+			b = 0;
+		} else {
+			a = b = 0;
+		}
+	} else {
+		size_t i = len;
+		if (i >= 48) {
+			uint64 see1 = seed, see2 = seed;
+			do {
+				seed = wyhash_mix(fh_read64(p) ^ secret[1], fh_read64(p + 8) ^ seed);
+				see1 = wyhash_mix(fh_read64(p + 16) ^ secret[2], fh_read64(p + 24) ^ see1);
+				see2 = wyhash_mix(fh_read64(p + 32) ^ secret[3], fh_read64(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i >= 48);
+			seed ^= see1 ^ see2;
+		}
+		while (i > 16) {
+			seed = wyhash_mix(fh_read64(p) ^ secret[1], fh_read64(p + 8) ^ seed);
+			i -= 16;
+			p += 16;
+		}
+		a = fh_read64(p + i - 16);
+		b = fh_read64(p + i - 8);
+	}
+	a ^= secret[1];
+	b ^= seed;
+	fh_mul128(a, b, &a, &b);
+	return wyhash_mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
@@ -0,0 +1,118 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+#if defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#elif defined(__aarch64__) && defined(__APPLE__)
+#include <sys/sysctl.h>
+#endif
+
+#include <drift/dslcore.h>
+#include <drift/algo/hash_accel.h>
+
+#if defined(DSL_HASH_X86)
+
+static void dsl_hash_cpuid(uint32 regs[4], uint32 leaf) {
+#if defined(_MSC_VER)
+	__cpuidex((int *)regs, (int)leaf, 0);
+#else
+	__cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static uint64 dsl_hash_xgetbv() {
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	uint32 lo, hi;
+	__asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return ((uint64)hi << 32) | lo;
+#endif
+}
+
+static void dsl_hash_detect(DSL_HASH_CPU& cpu) {
+	uint32 regs[4];
+	dsl_hash_cpuid(regs, 0);
+	uint32 max_leaf = regs[0];
+	if (max_leaf < 1) {
+		return;
+	}
+
+	dsl_hash_cpuid(regs, 1);
+	uint32 ecx1 = regs[2];
+	cpu.ssse3 = (ecx1 & (1 << 9)) != 0;
+	cpu.sse41 = (ecx1 & (1 << 19)) != 0;
+	cpu.sse42 = (ecx1 & (1 << 20)) != 0;
+	cpu.pclmul = (ecx1 & (1 << 1)) != 0;
+
+	// the wider registers are only usable if the OS saves them on a context switch
+	uint64 xcr0 = (ecx1 & (1 << 27)) ? dsl_hash_xgetbv() : 0;
+	bool os_avx = (ecx1 & (1 << 28)) && (xcr0 & 0x06) == 0x06;
+	bool os_avx512 = os_avx && (xcr0 & 0xE0) == 0xE0;
+
+	if (max_leaf >= 7) {
+		dsl_hash_cpuid(regs, 7);
+		uint32 ebx7 = regs[1];
+		cpu.avx2 = os_avx && (ebx7 & (1 << 5)) && (ebx7 & (1 << 8));
+		cpu.avx512 = os_avx512 && cpu.avx2 && (ebx7 & (1 << 16)) && (ebx7 & (1u << 30)) && (ebx7 & (1u << 31));
+		cpu.sha = cpu.sse41 && cpu.ssse3 && (ebx7 & (1 << 29));
+	}
+}
+
+#elif defined(DSL_HASH_ARM64)
+
+static void dsl_hash_detect(DSL_HASH_CPU& cpu) {
+#if defined(__linux__)
+	unsigned long hwcap = getauxval(AT_HWCAP);
+	cpu.arm_pmull = (hwcap & (1 << 4)) != 0;
+	cpu.arm_sha1 = (hwcap & (1 << 5)) != 0;
+	cpu.arm_sha2 = (hwcap & (1 << 6)) != 0;
+	cpu.arm_crc32 = (hwcap & (1 << 7)) != 0;
+	cpu.arm_sha3 = (hwcap & (1 << 17)) != 0;
+	cpu.arm_sha512 = (hwcap & (1 << 21)) != 0;
+#elif defined(__APPLE__)
+	// every Apple Silicon chip has the base crypto extensions
+	cpu.arm_pmull = cpu.arm_sha1 = cpu.arm_sha2 = cpu.arm_crc32 = true;
+	int val = 0;
+	size_t len = sizeof(val);
+	cpu.arm_sha512 = (sysctlbyname("hw.optional.armv8_2_sha512", &val, &len, NULL, 0) == 0 && val);
+	val = 0;
+	len = sizeof(val);
+	cpu.arm_sha3 = (sysctlbyname("hw.optional.armv8_2_sha3", &val, &len, NULL, 0) == 0 && val);
+#elif defined(WIN32)
+	cpu.arm_pmull = cpu.arm_sha1 = cpu.arm_sha2 = IsProcessorFeaturePresent(PF_ARM_V8_CRYPTO_INSTRUCTIONS_AVAILABLE);
+	cpu.arm_crc32 = IsProcessorFeaturePresent(PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE);
+#endif
+}
+
+#else
+
+static void dsl_hash_detect(DSL_HASH_CPU& cpu) {
+}
+
+#endif
+
+const DSL_HASH_CPU * dsl_hash_cpu() {
+	static const DSL_HASH_CPU cpu = []() {
+		DSL_HASH_CPU ret;
+		memset(&ret, 0, sizeof(ret));
+		const char * p = getenv("DSL_NO_HASH_ACCEL");
+		if (p == NULL || strcmp(p, "0") == 0) {
+			dsl_hash_detect(ret);
+		}
+		return ret;
+	}();
+	return &cpu;
+}
@@ -0,0 +1,666 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+/*
+ * Multi-buffer hashing for hash_batch(): N independent messages are hashed at once, one per 32-bit SIMD lane (8 with AVX2, 16 with AVX-512),
+ * or for SHA-3/Keccak one per 64-bit lane (4 with AVX2, 8 with AVX-512).
+ * A lane that finishes its message picks up the next one, so messages of different lengths keep the lanes busy. When the work runs out the
+ * last few messages are finished with the normal single-buffer code instead of dragging mostly empty vectors along.
+ */
+
+#include <drift/dslcore.h>
+#include <drift/hash.h>
+#include <drift/algo/hash_accel.h>
+#include <drift/algo/sha1.h>
+#include <drift/algo/sha2.h>
+#include <drift/algo/md5.h>
+
+extern uint32 sha256_k[64];
+
+static const uint32 md5_iv[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+static const uint32 sha1_iv[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+static const uint32 sha256_iv[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+
+struct MB_ALGO {
+	size_t words; ///< 32-bit state words, all of them are output
+	const uint32 * iv;
+	bool big_endian; ///< for the message words, length and digest
+	void (*single)(uint32 * h, const uint8 * data, size_t nblocks); ///< the single-buffer block function
+};
+
+static void md5_blocks_single(uint32 * h, const uint8 * data, size_t nblocks) {
+	uint32 in[16];
+	for (; nblocks > 0; nblocks--, data += 64) {
+		for (int i = 0; i < 16; i++) {
+			in[i] = (uint32)data[i * 4] | ((uint32)data[i * 4 + 1] << 8) | ((uint32)data[i * 4 + 2] << 16) | ((uint32)data[i * 4 + 3] << 24);
+		}
+		md5_transform(h, in);
+	}
+}
+static void sha1_blocks_single(uint32 * h, const uint8 * data, size_t nblocks) {
+	sha1_get_blocks()(h, data, nblocks);
+}
+static void sha256_blocks_single(uint32 * h, const uint8 * data, size_t nblocks) {
+	sha256_get_blocks()(h, data, nblocks);
+}
+
+static const MB_ALGO mb_md5 = { 4, md5_iv, false, md5_blocks_single };
+static const MB_ALGO mb_sha1 = { 5, sha1_iv, true, sha1_blocks_single };
+static const MB_ALGO mb_sha256 = { 8, sha256_iv, true, sha256_blocks_single };
+
+static inline void mb_put32(uint8 * p, uint32 x, bool big_endian) {
+	if (big_endian) {
+		p[0] = (uint8)(x >> 24); p[1] = (uint8)(x >> 16); p[2] = (uint8)(x >> 8); p[3] = (uint8)x;
+	} else {
+		p[0] = (uint8)x; p[1] = (uint8)(x >> 8); p[2] = (uint8)(x >> 16); p[3] = (uint8)(x >> 24);
+	}
+}
+
+/* The padded last block(s) of a message, MD5/SHA-1/SHA-256 all pad the same way apart from the length's byte order */
+static size_t mb_make_tail(uint8 tail[128], const uint8 * data, size_t len, bool big_endian) {
+	size_t rem = len % 64;
+	size_t blocks = (rem + 9 > 64) ? 2 : 1;
+	memcpy(tail, data + (len - rem), rem);
+	tail[rem] = 0x80;
+	memset(tail + rem + 1, 0, (blocks * 64) - rem - 1);
+	uint64 bits = (uint64)len * 8;
+	uint8 * p = tail + (blocks * 64) - 8;
+	if (big_endian) {
+		mb_put32(p, (uint32)(bits >> 32), true);
+		mb_put32(p + 4, (uint32)bits, true);
+	} else {
+		mb_put32(p, (uint32)bits, false);
+		mb_put32(p + 4, (uint32)(bits >> 32), false);
+	}
+	return blocks;
+}
+
+/* Hashes each item on its own with the single-buffer code, no allocations */
+static void mb_run_single(const MB_ALGO& algo, const HASH_BATCH_ITEM * items, size_t count, uint8 * out) {
+	uint8 tail[128];
+	uint32 h[8];
+	for (size_t i = 0; i < count; i++) {
+		memcpy(h, algo.iv, algo.words * 4);
+		algo.single(h, items[i].data, items[i].length / 64);
+		size_t nblocks = mb_make_tail(tail, items[i].data, items[i].length, algo.big_endian);
+		algo.single(h, tail, nblocks);
+		for (size_t j = 0; j < algo.words; j++) {
+			mb_put32(out + (i * algo.words * 4) + (j * 4), h[j], algo.big_endian);
+		}
+	}
+}
+
+#if defined(DSL_HASH_MB)
+
+/*
+ * The kernels are written once with GCC vector extensions and instantiated for 8 and 16 lanes. They are force-inlined into the small
+ * per-ISA wrappers at the bottom so the compiler generates AVX2 or AVX-512 code for each one.
+ * State is in struct-of-arrays form: st[word * N + lane].
+ */
+typedef uint32 mb_u32x8 __attribute__((vector_size(32)));
+typedef uint32 mb_u32x16 __attribute__((vector_size(64)));
+
+#define MB_INLINE DSL_HASH_TARGET("avx2") inline __attribute__((always_inline))
+#define MB_ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define MB_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+/* Transposes word t of every lane's block into one vector per word */
+template <typename V, size_t N> MB_INLINE void mb_load_words(V w[16], const uint8 * const * blocks, bool big_endian) {
+	alignas(64) uint32 tmp[16][N];
+	for (size_t l = 0; l < N; l++) {
+		const uint8 * p = blocks[l];
+		for (int t = 0; t < 16; t++) {
+			uint32 x;
+			memcpy(&x, p + (t * 4), 4);
+			tmp[t][l] = big_endian ? __builtin_bswap32(x) : x;
+		}
+	}
+	memcpy(w, tmp, sizeof(tmp));
+}
+
+template <typename V, size_t N> MB_INLINE void mb_md5_compress(uint32 * st, const uint8 * const * blocks) {
+	static const uint32 k[64] = {
+		0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+		0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+		0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+		0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+		0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+		0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+		0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+		0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+	};
+	static const int r[4][4] = { { 7, 12, 17, 22 }, { 5, 9, 14, 20 }, { 4, 11, 16, 23 }, { 6, 10, 15, 21 } };
+	V w[16];
+	mb_load_words<V, N>(w, blocks, false);
+
+	V a, b, c, d;
+	memcpy(&a, st, sizeof(V));
+	memcpy(&b, st + N, sizeof(V));
+	memcpy(&c, st + (2 * N), sizeof(V));
+	memcpy(&d, st + (3 * N), sizeof(V));
+	V sa = a, sb = b, sc = c, sd = d;
+
+	for (int i = 0; i < 64; i++) {
+		V f;
+		int g;
+		switch (i >> 4) {
+			case 0:
+				f = d ^ (b & (c ^ d));
+				g = i;
+				break;
+			case 1:
+				f = c ^ (d & (b ^ c));
+				g = ((5 * i) + 1) & 15;
+				break;
+			case 2:
+				f = b ^ c ^ d;
+				g = ((3 * i) + 5) & 15;
+				break;
+			default:
+				f = c ^ (b | ~d);
+				g = (7 * i) & 15;
+				break;
+		}
+		int s = r[i >> 4][i & 3];
+		V tmp = a + f + k[i] + w[g];
+		a = d;
+		d = c;
+		c = b;
+		b = b + MB_ROTL(tmp, s);
+	}
+
+	a += sa; b += sb; c += sc; d += sd;
+	memcpy(st, &a, sizeof(V));
+	memcpy(st + N, &b, sizeof(V));
+	memcpy(st + (2 * N), &c, sizeof(V));
+	memcpy(st + (3 * N), &d, sizeof(V));
+}
+
+template <typename V, size_t N> MB_INLINE void mb_sha1_compress(uint32 * st, const uint8 * const * blocks) {
+	V w[16];
+	mb_load_words<V, N>(w, blocks, true);
+
+	V a, b, c, d, e;
+	memcpy(&a, st, sizeof(V));
+	memcpy(&b, st + N, sizeof(V));
+	memcpy(&c, st + (2 * N), sizeof(V));
+	memcpy(&d, st + (3 * N), sizeof(V));
+	memcpy(&e, st + (4 * N), sizeof(V));
+	V sa = a, sb = b, sc = c, sd = d, se = e;
+
+	for (int t = 0; t < 80; t++) {
+		int s = t & 15;
+		if (t >= 16) {
+			w[s] = MB_ROTL(w[(s + 13) & 15] ^ w[(s + 8) & 15] ^ w[(s + 2) & 15] ^ w[s], 1);
+		}
+		V f;
+		uint32 k;
+		if (t < 20) {
+			f = d ^ (b & (c ^ d));
+			k = 0x5a827999;
+		} else if (t < 40) {
+			f = b ^ c ^ d;
+			k = 0x6ed9eba1;
+		} else if (t < 60) {
+			f = (b & c) | (d & (b | c));
+			k = 0x8f1bbcdc;
+		} else {
+			f = b ^ c ^ d;
+			k = 0xca62c1d6;
+		}
+		V tmp = MB_ROTL(a, 5) + f + e + w[s] + k;
+		e = d;
+		d = c;
+		c = MB_ROTL(b, 30);
+		b = a;
+		a = tmp;
+	}
+
+	a += sa; b += sb; c += sc; d += sd; e += se;
+	memcpy(st, &a, sizeof(V));
+	memcpy(st + N, &b, sizeof(V));
+	memcpy(st + (2 * N), &c, sizeof(V));
+	memcpy(st + (3 * N), &d, sizeof(V));
+	memcpy(st + (4 * N), &e, sizeof(V));
+}
+
+template <typename V, size_t N> MB_INLINE void mb_sha256_compress(uint32 * st, const uint8 * const * blocks) {
+	V w[16];
+	mb_load_words<V, N>(w, blocks, true);
+
+	V s[8], v[8];
+	for (int i = 0; i < 8; i++) {
+		memcpy(&s[i], st + (i * N), sizeof(V));
+		v[i] = s[i];
+	}
+
+	for (int t = 0; t < 64; t++) {
+		int j = t & 15;
+		if (t >= 16) {
+			V w15 = w[(j + 1) & 15], w2 = w[(j + 14) & 15];
+			w[j] += (MB_ROTR(w2, 17) ^ MB_ROTR(w2, 19) ^ (w2 >> 10)) + w[(j + 9) & 15] + (MB_ROTR(w15, 7) ^ MB_ROTR(w15, 18) ^ (w15 >> 3));
+		}
+		V t1 = v[7] + (MB_ROTR(v[4], 6) ^ MB_ROTR(v[4], 11) ^ MB_ROTR(v[4], 25)) + (v[6] ^ (v[4] & (v[5] ^ v[6]))) + sha256_k[t] + w[j];
+		V t2 = (MB_ROTR(v[0], 2) ^ MB_ROTR(v[0], 13) ^ MB_ROTR(v[0], 22)) + ((v[0] & v[1]) | (v[2] & (v[0] | v[1])));
+		v[7] = v[6];
+		v[6] = v[5];
+		v[5] = v[4];
+		v[4] = v[3] + t1;
+		v[3] = v[2];
+		v[2] = v[1];
+		v[1] = v[0];
+		v[0] = t1 + t2;
+	}
+
+	for (int i = 0; i < 8; i++) {
+		s[i] += v[i];
+		memcpy(st + (i * N), &s[i], sizeof(V));
+	}
+}
+
+DSL_HASH_TARGET("avx2") static void md5_x8_avx2(uint32 * st, const uint8 * const * blocks) { mb_md5_compress<mb_u32x8, 8>(st, blocks); }
+DSL_HASH_TARGET("avx2") static void sha1_x8_avx2(uint32 * st, const uint8 * const * blocks) { mb_sha1_compress<mb_u32x8, 8>(st, blocks); }
+DSL_HASH_TARGET("avx2") static void sha256_x8_avx2(uint32 * st, const uint8 * const * blocks) { mb_sha256_compress<mb_u32x8, 8>(st, blocks); }
+DSL_HASH_TARGET("avx512f,avx512vl,avx2") static void md5_x16_avx512(uint32 * st, const uint8 * const * blocks) { mb_md5_compress<mb_u32x16, 16>(st, blocks); }
+DSL_HASH_TARGET("avx512f,avx512vl,avx2") static void sha1_x16_avx512(uint32 * st, const uint8 * const * blocks) { mb_sha1_compress<mb_u32x16, 16>(st, blocks); }
+DSL_HASH_TARGET("avx512f,avx512vl,avx2") static void sha256_x16_avx512(uint32 * st, const uint8 * const * blocks) { mb_sha256_compress<mb_u32x16, 16>(st, blocks); }
+
+struct MB_LANE {
+	size_t item; ///< SIZE_MAX when the lane is idle
+	const uint8 * data; ///< whole blocks still to hash straight from the message
+	size_t full_blocks;
+	uint8 tail[128];
+	size_t tail_blocks;
+	size_t tail_done;
+};
+
+template <size_t N> static void mb_run(const MB_ALGO& algo, void (*compress)(uint32 * st, const uint8 * const * blocks), const HASH_BATCH_ITEM * items, size_t count, uint8 * out) {
+	alignas(64) uint32 st[8 * N];
+	MB_LANE lanes[N];
+	const uint8 * blocks[N];
+	size_t next = 0, active = 0;
+	size_t digest_size = algo.words * 4;
+
+	auto assign = [&](size_t l) {
+		MB_LANE& lane = lanes[l];
+		if (next >= count) {
+			lane.item = SIZE_MAX;
+			return;
+		}
+		lane.item = next++;
+		lane.data = items[lane.item].data;
+		lane.full_blocks = items[lane.item].length / 64;
+		lane.tail_blocks = mb_make_tail(lane.tail, lane.data, items[lane.item].length, algo.big_endian);
+		lane.tail_done = 0;
+		for (size_t j = 0; j < algo.words; j++) {
+			st[(j * N) + l] = algo.iv[j];
+		}
+		active++;
+	};
+	auto output = [&](size_t l, const uint32 * h, size_t stride) {
+		for (size_t j = 0; j < algo.words; j++) {
+			mb_put32(out + (lanes[l].item * digest_size) + (j * 4), h[j * stride], algo.big_endian);
+		}
+	};
+
+	for (size_t l = 0; l < N; l++) {
+		assign(l);
+	}
+	while (active > 0) {
+		if (next >= count && active <= N / 2) {
+			// not enough left to fill the vectors, finish the stragglers one by one
+			for (size_t l = 0; l < N; l++) {
+				MB_LANE& lane = lanes[l];
+				if (lane.item == SIZE_MAX) {
+					continue;
+				}
+				uint32 h[8];
+				for (size_t j = 0; j < algo.words; j++) {
+					h[j] = st[(j * N) + l];
+				}
+				algo.single(h, lane.data, lane.full_blocks);
+				algo.single(h, lane.tail + (lane.tail_done * 64), lane.tail_blocks - lane.tail_done);
+				output(l, h, 1);
+			}
+			return;
+		}
+
+		for (size_t l = 0; l < N; l++) {
+			const MB_LANE& lane = lanes[l];
+			if (lane.item == SIZE_MAX) {
+				blocks[l] = lane.tail; // its result is never used
+			} else if (lane.full_blocks > 0) {
+				blocks[l] = lane.data;
+			} else {
+				blocks[l] = lane.tail + (lane.tail_done * 64);
+			}
+		}
+		compress(st, blocks);
+		for (size_t l = 0; l < N; l++) {
+			MB_LANE& lane = lanes[l];
+			if (lane.item == SIZE_MAX) {
+				continue;
+			}
+			if (lane.full_blocks > 0) {
+				lane.data += 64;
+				lane.full_blocks--;
+			} else if (++lane.tail_done == lane.tail_blocks) {
+				output(l, st + l, N);
+				active--;
+				assign(l);
+			}
+		}
+	}
+}
+
+#endif // DSL_HASH_MB
+
+/*
+ * Below this many messages the vectors would mostly be empty, so the single-buffer code wins.
+ * SHA-NI is quick enough that 8 AVX2 lanes of SHA-1/SHA-256 barely keep up with it, so only AVX-512 is used on top of it.
+ */
+#define MB_MIN_ITEMS 4
+
+static void mb_dispatch(const MB_ALGO& algo, const HASH_BATCH_ITEM * items, size_t count, uint8 * out, bool has_single_accel,
+	void (*x8)(uint32 *, const uint8 * const *), void (*x16)(uint32 *, const uint8 * const *)) {
+#if defined(DSL_HASH_MB)
+	if (count >= MB_MIN_ITEMS) {
+		const DSL_HASH_CPU * cpu = dsl_hash_cpu();
+		if (cpu->avx512) {
+			mb_run<16>(algo, x16, items, count, out);
+			return;
+		}
+		if (cpu->avx2 && !has_single_accel) {
+			mb_run<8>(algo, x8, items, count, out);
+			return;
+		}
+	}
+#endif
+	mb_run_single(algo, items, count, out);
+}
+
+#if defined(DSL_HASH_MB)
+#define MB_KERNELS(x8, x16) x8, x16
+#else
+#define MB_KERNELS(x8, x16) NULL, NULL
+#endif
+
+void md5_batch(const HASH_BATCH_ITEM * items, size_t count, uint8 * out) {
+	mb_dispatch(mb_md5, items, count, out, false, MB_KERNELS(md5_x8_avx2, md5_x16_avx512));
+}
+
+void sha1_batch(const HASH_BATCH_ITEM * items, size_t count, uint8 * out) {
+	mb_dispatch(mb_sha1, items, count, out, dsl_hash_cpu()->sha, MB_KERNELS(sha1_x8_avx2, sha1_x16_avx512));
+}
+
+void sha256_batch(const HASH_BATCH_ITEM * items, size_t count, uint8 * out) {
+	mb_dispatch(mb_sha256, items, count, out, dsl_hash_cpu()->sha, MB_KERNELS(sha256_x8_avx2, sha256_x16_avx512));
+}
+
+/*
+ * SHA-3 and Keccak (the original padding, as used by Ethereum.) Each vector lane holds one message's 64-bit sponge word, the state is
+ * st[word * N + lane] like above. Every message absorbs its whole blocks and then a single padded block.
+ */
+struct MB_KECCAK_ALGO {
+	size_t rate; ///< bytes absorbed per permutation
+	size_t digest_size;
+	uint8 pad; ///< first padding byte: 0x06 for SHA-3, 0x01 for Keccak
+};
+
+static const MB_KECCAK_ALGO mb_sha3_256 = { 136, 32, 0x06 };
+static const MB_KECCAK_ALGO mb_sha3_512 = { 72, 64, 0x06 };
+static const MB_KECCAK_ALGO mb_keccak256 = { 136, 32, 0x01 };
+static const MB_KECCAK_ALGO mb_keccak512 = { 72, 64, 0x01 };
+
+static inline uint64 mb_get64le(const uint8 * p) {
+	uint64 x = 0;
+	for (int i = 7; i >= 0; i--) {
+		x = (x << 8) | p[i];
+	}
+	return x;
+}
+
+static void mb_keccak_make_tail(const MB_KECCAK_ALGO& algo, uint8 tail[136], const uint8 * data, size_t len) {
+	size_t rem = len % algo.rate;
+	memcpy(tail, data + (len - rem), rem);
+	memset(tail + rem, 0, algo.rate - rem);
+	tail[rem] ^= algo.pad;
+	tail[algo.rate - 1] ^= 0x80;
+}
+
+static void mb_keccak_absorb(const MB_KECCAK_ALGO& algo, uint64 s[25], const uint8 * data, size_t nblocks) {
+	for (; nblocks > 0; nblocks--, data += algo.rate) {
+		for (size_t i = 0; i < algo.rate / 8; i++) {
+			s[i] ^= mb_get64le(data + (i * 8));
+		}
+		keccakf1600(s);
+	}
+}
+
+static void mb_keccak_output(const MB_KECCAK_ALGO& algo, const uint64 * s, size_t stride, uint8 * out) {
+	for (size_t i = 0; i < algo.digest_size; i++) {
+		out[i] = (uint8)(s[(i / 8) * stride] >> ((i % 8) * 8));
+	}
+}
+
+static void mb_keccak_single(const MB_KECCAK_ALGO& algo, const HASH_BATCH_ITEM * items, size_t count, uint8 * out) {
+	uint8 tail[136];
+	uint64 s[25];
+	for (size_t i = 0; i < count; i++) {
+		memset(s, 0, sizeof(s));
+		mb_keccak_absorb(algo, s, items[i].data, items[i].length / algo.rate);
+		mb_keccak_make_tail(algo, tail, items[i].data, items[i].length);
+		mb_keccak_absorb(algo, s, tail, 1);
+		mb_keccak_output(algo, s, 1, out + (i * algo.digest_size));
+	}
+}
+
+#if defined(DSL_HASH_MB)
+
+typedef uint64 mb_u64x4 __attribute__((vector_size(32)));
+typedef uint64 mb_u64x8 __attribute__((vector_size(64)));
+
+#define MB_ROTL64(x, n) (((x) << (n)) | ((x) >> (64 - (n))))
+
+/* Same round as keccakf1600() minus the lane complementing, vectors have an and-not so it wouldn't save anything */
+#define MB_KECCAK_ROUND(A, E, rc) { \
+	V C0, C1, C2, C3, C4, D0, D1, D2, D3, D4, B0, B1, B2, B3, B4; \
+	C0 = A[0] ^ A[5] ^ A[10] ^ A[15] ^ A[20]; \
+	C1 = A[1] ^ A[6] ^ A[11] ^ A[16] ^ A[21]; \
+	C2 = A[2] ^ A[7] ^ A[12] ^ A[17] ^ A[22]; \
+	C3 = A[3] ^ A[8] ^ A[13] ^ A[18] ^ A[23]; \
+	C4 = A[4] ^ A[9] ^ A[14] ^ A[19] ^ A[24]; \
+	D0 = C4 ^ MB_ROTL64(C1, 1); \
+	D1 = C0 ^ MB_ROTL64(C2, 1); \
+	D2 = C1 ^ MB_ROTL64(C3, 1); \
+	D3 = C2 ^ MB_ROTL64(C4, 1); \
+	D4 = C3 ^ MB_ROTL64(C0, 1); \
+	B0 = A[0] ^ D0; \
+	B1 = MB_ROTL64(A[6] ^ D1, 44); \
+	B2 = MB_ROTL64(A[12] ^ D2, 43); \
+	B3 = MB_ROTL64(A[18] ^ D3, 21); \
+	B4 = MB_ROTL64(A[24] ^ D4, 14); \
+	E[0] = B0 ^ (~B1 & B2) ^ (rc); \
+	E[1] = B1 ^ (~B2 & B3); \
+	E[2] = B2 ^ (~B3 & B4); \
+	E[3] = B3 ^ (~B4 & B0); \
+	E[4] = B4 ^ (~B0 & B1); \
+	B0 = MB_ROTL64(A[3] ^ D3, 28); \
+	B1 = MB_ROTL64(A[9] ^ D4, 20); \
+	B2 = MB_ROTL64(A[10] ^ D0, 3); \
+	B3 = MB_ROTL64(A[16] ^ D1, 45); \
+	B4 = MB_ROTL64(A[22] ^ D2, 61); \
+	E[5] = B0 ^ (~B1 & B2); \
+	E[6] = B1 ^ (~B2 & B3); \
+	E[7] = B2 ^ (~B3 & B4); \
+	E[8] = B3 ^ (~B4 & B0); \
+	E[9] = B4 ^ (~B0 & B1); \
+	B0 = MB_ROTL64(A[1] ^ D1, 1); \
+	B1 = MB_ROTL64(A[7] ^ D2, 6); \
+	B2 = MB_ROTL64(A[13] ^ D3, 25); \
+	B3 = MB_ROTL64(A[19] ^ D4, 8); \
+	B4 = MB_ROTL64(A[20] ^ D0, 18); \
+	E[10] = B0 ^ (~B1 & B2); \
+	E[11] = B1 ^ (~B2 & B3); \
+	E[12] = B2 ^ (~B3 & B4); \
+	E[13] = B3 ^ (~B4 & B0); \
+	E[14] = B4 ^ (~B0 & B1); \
+	B0 = MB_ROTL64(A[4] ^ D4, 27); \
+	B1 = MB_ROTL64(A[5] ^ D0, 36); \
+	B2 = MB_ROTL64(A[11] ^ D1, 10); \
+	B3 = MB_ROTL64(A[17] ^ D2, 15); \
+	B4 = MB_ROTL64(A[23] ^ D3, 56); \
+	E[15] = B0 ^ (~B1 & B2); \
+	E[16] = B1 ^ (~B2 & B3); \
+	E[17] = B2 ^ (~B3 & B4); \
+	E[18] = B3 ^ (~B4 & B0); \
+	E[19] = B4 ^ (~B0 & B1); \
+	B0 = MB_ROTL64(A[2] ^ D2, 62); \
+	B1 = MB_ROTL64(A[8] ^ D3, 55); \
+	B2 = MB_ROTL64(A[14] ^ D4, 39); \
+	B3 = MB_ROTL64(A[15] ^ D0, 41); \
+	B4 = MB_ROTL64(A[21] ^ D1, 2); \
+	E[20] = B0 ^ (~B1 & B2); \
+	E[21] = B1 ^ (~B2 & B3); \
+	E[22] = B2 ^ (~B3 & B4); \
+	E[23] = B3 ^ (~B4 & B0); \
+	E[24] = B4 ^ (~B0 & B1); \
+}
+
+/* XORs one block per lane into the state and runs the permutation on all N states at once */
+template <typename V, size_t N> MB_INLINE void mb_keccak_absorb_xN(uint64 * st, const uint8 * const * blocks, size_t rate_words) {
+	V A[25], E[25];
+	memcpy(A, st, sizeof(A));
+	for (size_t w = 0; w < rate_words; w++) {
+		alignas(64) uint64 tmp[N];
+		for (size_t l = 0; l < N; l++) {
+			tmp[l] = mb_get64le(blocks[l] + (w * 8));
+		}
+		V t;
+		memcpy(&t, tmp, sizeof(t));
+		A[w] ^= t;
+	}
+	for (int round = 0; round < 24; round += 2) {
+		MB_KECCAK_ROUND(A, E, keccakf_rndc[round]);
+		MB_KECCAK_ROUND(E, A, keccakf_rndc[round + 1]);
+	}
+	memcpy(st, A, sizeof(A));
+}
+
+DSL_HASH_TARGET("avx2") static void keccak_x4_avx2(uint64 * st, const uint8 * const * blocks, size_t rate_words) { mb_keccak_absorb_xN<mb_u64x4, 4>(st, blocks, rate_words); }
+DSL_HASH_TARGET("avx512f,avx512vl,avx2") static void keccak_x8_avx512(uint64 * st, const uint8 * const * blocks, size_t rate_words) { mb_keccak_absorb_xN<mb_u64x8, 8>(st, blocks, rate_words); }
+
+struct MB_KECCAK_LANE {
+	size_t item; ///< SIZE_MAX when the lane is idle
+	const uint8 * data; ///< whole blocks still to absorb straight from the message
+	size_t full_blocks;
+	uint8 tail[136];
+};
+
+template <size_t N> static void mb_keccak_run(const MB_KECCAK_ALGO& algo, void (*absorb)(uint64 * st, const uint8 * const * blocks, size_t rate_words), const HASH_BATCH_ITEM * items, size_t count, uint8 * out) {
+	alignas(64) uint64 st[25 * N];
+	MB_KECCAK_LANE lanes[N];
+	const uint8 * blocks[N];
+	size_t next = 0, active = 0;
+
+	auto assign = [&](size_t l) {
+		MB_KECCAK_LANE& lane = lanes[l];
+		if (next >= count) {
+			lane.item = SIZE_MAX;
+			return;
+		}
+		lane.item = next++;
+		lane.data = items[lane.item].data;
+		lane.full_blocks = items[lane.item].length / algo.rate;
+		mb_keccak_make_tail(algo, lane.tail, lane.data, items[lane.item].length);
+		for (size_t w = 0; w < 25; w++) {
+			st[(w * N) + l] = 0;
+		}
+		active++;
+	};
+
+	for (size_t l = 0; l < N; l++) {
+		assign(l);
+	}
+	while (active > 0) {
+		if (next >= count && active <= N / 2) {
+			// not enough left to fill the vectors, finish the stragglers one by one
+			for (size_t l = 0; l < N; l++) {
+				MB_KECCAK_LANE& lane = lanes[l];
+				if (lane.item == SIZE_MAX) {
+					continue;
+				}
+				uint64 s[25];
+				for (size_t w = 0; w < 25; w++) {
+					s[w] = st[(w * N) + l];
+				}
+				mb_keccak_absorb(algo, s, lane.data, lane.full_blocks);
+				mb_keccak_absorb(algo, s, lane.tail, 1);
+				mb_keccak_output(algo, s, 1, out + (lane.item * algo.digest_size));
+			}
+			return;
+		}
+
+		for (size_t l = 0; l < N; l++) {
+			const MB_KECCAK_LANE& lane = lanes[l];
+			blocks[l] = (lane.item != SIZE_MAX && lane.full_blocks > 0) ? lane.data : lane.tail;
+		}
+		absorb(st, blocks, algo.rate / 8);
+		for (size_t l = 0; l < N; l++) {
+			MB_KECCAK_LANE& lane = lanes[l];
+			if (lane.item == SIZE_MAX) {
+				continue;
+			}
+			if (lane.full_blocks > 0) {
+				lane.data += algo.rate;
+				lane.full_blocks--;
+			} else {
+				mb_keccak_output(algo, st + l, N, out + (lane.item * algo.digest_size));
+				active--;
+				assign(l);
+			}
+		}
+	}
+}
+
+#endif // DSL_HASH_MB
+
+static void mb_keccak_dispatch(const MB_KECCAK_ALGO& algo, const HASH_BATCH_ITEM * items, size_t count, uint8 * out) {
+#if defined(DSL_HASH_MB)
+	if (count >= MB_MIN_ITEMS) {
+		const DSL_HASH_CPU * cpu = dsl_hash_cpu();
+		if (cpu->avx512) {
+			mb_keccak_run<8>(algo, keccak_x8_avx512, items, count, out);
+			return;
+		}
+		if (cpu->avx2) {
+			mb_keccak_run<4>(algo, keccak_x4_avx2, items, count, out);
+			return;
+		}
+	}
+#endif
+	mb_keccak_single(algo, items, count, out);
+}
+
+void sha3_256_batch(const HASH_BATCH_ITEM * items, size_t count, uint8 * out) {
+	mb_keccak_dispatch(mb_sha3_256, items, count, out);
+}
+
+void sha3_512_batch(const HASH_BATCH_ITEM * items, size_t count, uint8 * out) {
+	mb_keccak_dispatch(mb_sha3_512, items, count, out);
+}
+
+void keccak256_batch(const HASH_BATCH_ITEM * items, size_t count, uint8 * out) {
+	mb_keccak_dispatch(mb_keccak256, items, count, out);
+}
+
+void keccak512_batch(const HASH_BATCH_ITEM * items, size_t count, uint8 * out) {
+	mb_keccak_dispatch(mb_keccak512, items, count, out);
+}
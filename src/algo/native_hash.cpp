@@ -14,14 +14,15 @@
 #include <drift/algo/sha2.h>
 #include <drift/algo/sha3.h>
 #include <drift/algo/md5.h>
+#include <drift/algo/blake3.h>
+#include <drift/algo/fasthash.h>
+#include <drift/algo/hash_accel.h>
 
 /* SHA-1 */
 
 bool native_sha1_init(HASH_CTX * ctx) {
-	sha1_ctxt * sctx = (sha1_ctxt *)dsl_malloc(sizeof(sha1_ctxt));
-	memset(sctx, 0, sizeof(sha1_ctxt));
+	sha1_ctxt * sctx = (sha1_ctxt *)ctx->pptr1;
 	sha1_init(sctx);
-	ctx->pptr1 = sctx;
 	return true;
 }
 
@@ -30,7 +31,6 @@ void native_sha1_update(HASH_CTX * ctx, const uint8 *input, size_t length) {
 }
 bool native_sha1_finish(HASH_CTX * ctx, uint8 * out) {
 	sha1_result((sha1_ctxt *)ctx->pptr1, out);
-	dsl_free(ctx->pptr1);
 	return true;
 }
 
@@ -40,16 +40,16 @@ HASH_NATIVE hash_sha1 = {
 
 	native_sha1_init,
 	native_sha1_update,
-	native_sha1_finish
+	native_sha1_finish,
+	sha1_batch,
+	sizeof(sha1_ctxt)
 };
 
 /* SHA-2 */
 
 bool native_sha256_init(HASH_CTX * ctx) {
-	sha256_ctx * sctx = (sha256_ctx *)dsl_malloc(sizeof(sha256_ctx));
-	memset(sctx, 0, sizeof(sha256_ctx));
+	sha256_ctx * sctx = (sha256_ctx *)ctx->pptr1;
 	sha256_init(sctx);
-	ctx->pptr1 = sctx;
 	return true;
 }
 
@@ -58,7 +58,6 @@ void native_sha256_update(HASH_CTX * ctx, const uint8 *input, size_t length) {
 }
 bool native_sha256_finish(HASH_CTX * ctx, uint8 * out) {
 	sha256_final((sha256_ctx *)ctx->pptr1, out);
-	dsl_free(ctx->pptr1);
 	return true;
 }
 
@@ -68,14 +67,14 @@ HASH_NATIVE hash_sha256 = {
 
 	native_sha256_init,
 	native_sha256_update,
-	native_sha256_finish
+	native_sha256_finish,
+	sha256_batch,
+	sizeof(sha256_ctx)
 };
 
 bool native_sha512_init(HASH_CTX * ctx) {
-	sha512_ctx * sctx = (sha512_ctx *)dsl_malloc(sizeof(sha512_ctx));
-	memset(sctx, 0, sizeof(sha512_ctx));
+	sha512_ctx * sctx = (sha512_ctx *)ctx->pptr1;
 	sha512_init(sctx);
-	ctx->pptr1 = sctx;
 	return true;
 }
 
@@ -84,7 +83,6 @@ void native_sha512_update(HASH_CTX * ctx, const uint8 *input, size_t length) {
 }
 bool native_sha512_finish(HASH_CTX * ctx, uint8 * out) {
 	sha512_final((sha512_ctx *)ctx->pptr1, out);
-	dsl_free(ctx->pptr1);
 	return true;
 }
 
@@ -94,17 +92,61 @@ HASH_NATIVE hash_sha512 = {
 
 	native_sha512_init,
 	native_sha512_update,
-	native_sha512_finish
+	native_sha512_finish,
+	NULL,
+	sizeof(sha512_ctx)
+};
+
+bool native_sha384_init(HASH_CTX * ctx) {
+	sha384_ctx * sctx = (sha384_ctx *)ctx->pptr1;
+	sha384_init(sctx);
+	return true;
+}
+
+bool native_sha384_finish(HASH_CTX * ctx, uint8 * out) {
+	sha384_final((sha384_ctx *)ctx->pptr1, out);
+	return true;
+}
+
+HASH_NATIVE hash_sha384 = {
+	SHA384_DIGEST_SIZE,
+	128,
+
+	native_sha384_init,
+	native_sha512_update,
+	native_sha384_finish,
+	NULL,
+	sizeof(sha384_ctx)
+};
+
+bool native_sha512_256_init(HASH_CTX * ctx) {
+	sha512_ctx * sctx = (sha512_ctx *)ctx->pptr1;
+	sha512_256_init(sctx);
+	return true;
+}
+
+bool native_sha512_256_finish(HASH_CTX * ctx, uint8 * out) {
+	sha512_256_final((sha512_ctx *)ctx->pptr1, out);
+	return true;
+}
+
+HASH_NATIVE hash_sha512_256 = {
+	SHA512_256_DIGEST_SIZE,
+	128,
+
+	native_sha512_256_init,
+	native_sha512_update,
+	native_sha512_256_finish,
+	NULL,
+	sizeof(sha512_ctx)
 };
 
 /* SHA-3 */
 
 bool native_keccak256_init(HASH_CTX * ctx) {
-	sha3_context * sha3ctx = (sha3_context *)dsl_malloc(sizeof(sha3_context));
-	memset(sha3ctx, 0, sizeof(sha3_context));
+	sha3_context * sha3ctx = (sha3_context *)ctx->pptr1;
 	sha3_Init256(sha3ctx);
 	sha3_SetFlags(sha3ctx, SHA3_FLAGS_KECCAK);
-	ctx->pptr1 = sha3ctx;
 	return true;
 }
 
@@ -114,7 +156,6 @@ void native_keccak256_update(HASH_CTX * ctx, const uint8 *input, size_t length)
 bool native_keccak256_finish(HASH_CTX * ctx, uint8 * out) {
 	const uint8_t * hash = (const uint8_t *)sha3_Finalize((sha3_context *)ctx->pptr1);
 	memcpy(out, hash, ctx->hashSize);
-	dsl_free(ctx->pptr1);
 	return true;
 }
 
@@ -124,15 +165,15 @@ HASH_NATIVE hash_keccak256 = {
 
 	native_keccak256_init,
 	native_keccak256_update,
-	native_keccak256_finish
+	native_keccak256_finish,
+	keccak256_batch,
+	sizeof(sha3_context)
 };
 
 bool native_keccak512_init(HASH_CTX * ctx) {
-	sha3_context * sha3ctx = (sha3_context *)dsl_malloc(sizeof(sha3_context));
-	memset(sha3ctx, 0, sizeof(sha3_context));
+	sha3_context * sha3ctx = (sha3_context *)ctx->pptr1;
 	sha3_Init512(sha3ctx);
 	sha3_SetFlags(sha3ctx, SHA3_FLAGS_KECCAK);
-	ctx->pptr1 = sha3ctx;
 	return true;
 }
 
@@ -142,7 +183,6 @@ void native_keccak512_update(HASH_CTX * ctx, const uint8 *input, size_t length)
 bool native_keccak512_finish(HASH_CTX * ctx, uint8 * out) {
 	const uint8_t * hash = (const uint8_t *)sha3_Finalize((sha3_context *)ctx->pptr1);
 	memcpy(out, hash, ctx->hashSize);
-	dsl_free(ctx->pptr1);
 	return true;
 }
 
@@ -152,14 +192,14 @@ HASH_NATIVE hash_keccak512 = {
 
 	native_keccak512_init,
 	native_keccak512_update,
-	native_keccak512_finish
+	native_keccak512_finish,
+	keccak512_batch,
+	sizeof(sha3_context)
 };
 
 bool native_sha3_256_init(HASH_CTX * ctx) {
-	sha3_context * sha3ctx = (sha3_context *)dsl_malloc(sizeof(sha3_context));
-	memset(sha3ctx, 0, sizeof(sha3_context));
+	sha3_context * sha3ctx = (sha3_context *)ctx->pptr1;
 	sha3_Init256(sha3ctx);
-	ctx->pptr1 = sha3ctx;
 	return true;
 }
 
@@ -169,7 +209,6 @@ void native_sha3_256_update(HASH_CTX * ctx, const uint8 *input, size_t length) {
 bool native_sha3_256_finish(HASH_CTX * ctx, uint8 * out) {
 	const uint8_t * hash = (const uint8_t *)sha3_Finalize((sha3_context *)ctx->pptr1);
 	memcpy(out, hash, ctx->hashSize);
-	dsl_free(ctx->pptr1);
 	return true;
 }
 
@@ -179,14 +218,14 @@ HASH_NATIVE hash_sha3_256 = {
 
 	native_sha3_256_init,
 	native_sha3_256_update,
-	native_sha3_256_finish
+	native_sha3_256_finish,
+	sha3_256_batch,
+	sizeof(sha3_context)
 };
 
 bool native_sha3_512_init(HASH_CTX * ctx) {
-	sha3_context * sha3ctx = (sha3_context *)dsl_malloc(sizeof(sha3_context));
-	memset(sha3ctx, 0, sizeof(sha3_context));
+	sha3_context * sha3ctx = (sha3_context *)ctx->pptr1;
 	sha3_Init512(sha3ctx);
-	ctx->pptr1 = sha3ctx;
 	return true;
 }
 
@@ -196,7 +235,6 @@ void native_sha3_512_update(HASH_CTX * ctx, const uint8 *input, size_t length) {
 bool native_sha3_512_finish(HASH_CTX * ctx, uint8 * out) {
 	const uint8_t * hash = (const uint8_t *)sha3_Finalize((sha3_context *)ctx->pptr1);
 	memcpy(out, hash, ctx->hashSize);
-	dsl_free(ctx->pptr1);
 	return true;
 }
 
@@ -206,16 +244,16 @@ HASH_NATIVE hash_sha3_512 = {
 
 	native_sha3_512_init,
 	native_sha3_512_update,
-	native_sha3_512_finish
+	native_sha3_512_finish,
+	sha3_512_batch,
+	sizeof(sha3_context)
 };
 
 /* MD5 */
 
 bool native_md5_init(HASH_CTX * ctx) {
-	md5_context * md5ctx = (md5_context *)dsl_malloc(sizeof(md5_context));
-	memset(md5ctx, 0, sizeof(md5_context));
+	md5_context * md5ctx = (md5_context *)ctx->pptr1;
 	md5_init(md5ctx);
-	ctx->pptr1 = md5ctx;
 	return true;
 }
 
@@ -224,7 +262,6 @@ void native_md5_update(HASH_CTX * ctx, const uint8 *input, size_t length) {
 }
 bool native_md5_finish(HASH_CTX * ctx, uint8 * out) {
 	md5_finish((md5_context *)ctx->pptr1, out);
-	dsl_free(ctx->pptr1);
 	return true;
 }
 
@@ -234,7 +271,167 @@ HASH_NATIVE hash_md5 = {
 
 	native_md5_init,
 	native_md5_update,
-	native_md5_finish
+	native_md5_finish,
+	md5_batch,
+	sizeof(md5_context)
+};
+
+/* BLAKE3 */
+
+bool native_blake3_init(HASH_CTX * ctx) {
+	blake3_hasher_init((blake3_hasher *)ctx->pptr1);
+	return true;
+}
+
+void native_blake3_update(HASH_CTX * ctx, const uint8 *input, size_t length) {
+	blake3_hasher_update((blake3_hasher *)ctx->pptr1, input, length);
+}
+bool native_blake3_finish(HASH_CTX * ctx, uint8 * out) {
+	blake3_hasher_finalize((blake3_hasher *)ctx->pptr1, out, ctx->hashSize);
+	return true;
+}
+
+HASH_NATIVE hash_blake3 = {
+	BLAKE3_OUT_LEN,
+	BLAKE3_BLOCK_LEN,
+
+	native_blake3_init,
+	native_blake3_update,
+	native_blake3_finish,
+	NULL,
+	sizeof(blake3_hasher)
+};
+
+/* Non-cryptographic hashes, the digests are big endian so the hex is the same as other tools print */
+
+static void native_store_be(uint8 * out, uint64 x, int bytes) {
+	for (int i = bytes - 1; i >= 0; i--) {
+		out[i] = (uint8)x;
+		x >>= 8;
+	}
+}
+
+bool native_xxh3_init(HASH_CTX * ctx) {
+	xxh3_init((xxh3_state *)ctx->pptr1);
+	return true;
+}
+
+void native_xxh3_update(HASH_CTX * ctx, const uint8 *input, size_t length) {
+	xxh3_update((xxh3_state *)ctx->pptr1, input, length);
+}
+bool native_xxh3_64_finish(HASH_CTX * ctx, uint8 * out) {
+	native_store_be(out, xxh3_digest64((xxh3_state *)ctx->pptr1), 8);
+	return true;
+}
+bool native_xxh3_128_finish(HASH_CTX * ctx, uint8 * out) {
+	xxh3_128_hash h = xxh3_digest128((xxh3_state *)ctx->pptr1);
+	native_store_be(out, h.high, 8);
+	native_store_be(out + 8, h.low, 8);
+	return true;
+}
+
+HASH_NATIVE hash_xxh3_64 = {
+	8,
+	64,
+
+	native_xxh3_init,
+	native_xxh3_update,
+	native_xxh3_64_finish,
+	NULL,
+	sizeof(xxh3_state)
+};
+
+HASH_NATIVE hash_xxh3_128 = {
+	16,
+	64,
+
+	native_xxh3_init,
+	native_xxh3_update,
+	native_xxh3_128_finish,
+	NULL,
+	sizeof(xxh3_state)
+};
+
+bool native_crc_init(HASH_CTX * ctx) {
+	*(uint32 *)ctx->pptr1 = 0;
+	return true;
+}
+
+void native_crc32_update(HASH_CTX * ctx, const uint8 *input, size_t length) {
+	uint32 * crc = (uint32 *)ctx->pptr1;
+	*crc = dsl_crc32(*crc, input, length);
+}
+void native_crc32c_update(HASH_CTX * ctx, const uint8 *input, size_t length) {
+	uint32 * crc = (uint32 *)ctx->pptr1;
+	*crc = dsl_crc32c(*crc, input, length);
+}
+bool native_crc_finish(HASH_CTX * ctx, uint8 * out) {
+	native_store_be(out, *(uint32 *)ctx->pptr1, 4);
+	return true;
+}
+
+HASH_NATIVE hash_crc32 = {
+	4,
+	64,
+
+	native_crc_init,
+	native_crc32_update,
+	native_crc_finish,
+	NULL,
+	sizeof(uint32)
+};
+
+HASH_NATIVE hash_crc32c = {
+	4,
+	64,
+
+	native_crc_init,
+	native_crc32c_update,
+	native_crc_finish,
+	NULL,
+	sizeof(uint32)
+};
+
+// wyhash can't be done incrementally so the input is collected until finish()
+struct NATIVE_WYHASH_CTX {
+	uint8 * data;
+	size_t len;
+	size_t size;
+};
+
+bool native_wyhash_init(HASH_CTX * ctx) {
+	NATIVE_WYHASH_CTX * wctx = dsl_new(NATIVE_WYHASH_CTX)
+	memset(wctx, 0, sizeof(*wctx));
+	ctx->pptr1 = wctx;
+	return true;
+}
+
+void native_wyhash_update(HASH_CTX * ctx, const uint8 *input, size_t length) {
+	NATIVE_WYHASH_CTX * wctx = (NATIVE_WYHASH_CTX *)ctx->pptr1;
+	if (wctx->len + length > wctx->size) {
+		wctx->size = (wctx->len + length) * 2;
+		wctx->data = (uint8 *)dsl_realloc(wctx->data, wctx->size);
+	}
+	memcpy(wctx->data + wctx->len, input, length);
+	wctx->len += length;
+}
+bool native_wyhash_finish(HASH_CTX * ctx, uint8 * out) {
+	NATIVE_WYHASH_CTX * wctx = (NATIVE_WYHASH_CTX *)ctx->pptr1;
+	native_store_be(out, wyhash(wctx->data, wctx->len), 8);
+	dsl_free(wctx->data);
+	dsl_free(wctx);
+	return true;
+}
+
+HASH_NATIVE hash_wyhash = {
+	8,
+	64,
+
+	native_wyhash_init,
+	native_wyhash_update,
+	native_wyhash_finish,
+	NULL,
+	0
 };
 
 /* Hashing interface */
@@ -253,10 +450,22 @@ vector<HASH_MAP> algos {
 	{ "sha-256", &hash_sha256 },
 	{ "sha512", &hash_sha512 },
 	{ "sha-512", &hash_sha512 },
+	{ "sha384", &hash_sha384 },
+	{ "sha-384", &hash_sha384 },
+	{ "sha512-256", &hash_sha512_256 },
+	{ "sha-512/256", &hash_sha512_256 },
 	{ "keccak256", &hash_keccak256 },
 	{ "keccak512", &hash_keccak512 },
 	{ "sha3-256", &hash_sha3_256 },
 	{ "sha3-512", &hash_sha3_512 },
+	{ "blake3", &hash_blake3 },
+	{ "xxh3-64", &hash_xxh3_64 },
+	{ "xxh3", &hash_xxh3_64 },
+	{ "xxh3-128", &hash_xxh3_128 },
+	{ "xxh128", &hash_xxh3_128 },
+	{ "wyhash", &hash_wyhash },
+	{ "crc32", &hash_crc32 },
+	{ "crc32c", &hash_crc32c },
 };
 
 void DSL_CC dsl_add_native_hash(const char * name, const HASH_NATIVE * p) {
@@ -266,30 +475,135 @@ void DSL_CC dsl_add_native_hash(const char * name, const HASH_NATIVE * p) {
 	algos.push_back(m);
 }
 
-HASH_CTX * dsl_native_hash_init(const char * name) {
-	HASH_CTX * ret = dsl_new(HASH_CTX);
-	memset(ret, 0, sizeof(HASH_CTX));
+const void * dsl_native_hash_lookup(const char * name) {
 	for (int i = 0; i < algos.size(); i++) {
 		if (!stricmp(name, algos[i].name.c_str())) {
-			ret->hashSize = algos[i].algo->hashSize;
-			ret->blockSize = algos[i].algo->blockSize;
-			ret->impl = algos[i].algo;
-			if (algos[i].algo->init(ret)) {
-				return ret;
-			}
-			break;
+			return algos[i].algo;
 		}
 	}
-	dsl_free(ret);
 	return NULL;
 }
 
+/* The HASH_CTX and the algorithm's state share one block, on the heap or in caller storage */
+#define NATIVE_CTX_HDR ((sizeof(HASH_CTX) + DSL_HASH_CTX_ALIGN - 1) & ~((size_t)DSL_HASH_CTX_ALIGN - 1))
+
+static HASH_CTX * dsl_native_hash_setup(const HASH_NATIVE * algo, void * storage, bool inplace) {
+	HASH_CTX * ret = (HASH_CTX *)storage;
+	memset(ret, 0, NATIVE_CTX_HDR + algo->stateSize);
+	ret->hashSize = algo->hashSize;
+	ret->blockSize = algo->blockSize;
+	ret->impl = algo;
+	ret->inplace = inplace;
+	if (algo->stateSize > 0) {
+		ret->pptr1 = (uint8 *)storage + NATIVE_CTX_HDR;
+	}
+	return algo->init(ret) ? ret : NULL;
+}
+
+HASH_CTX * dsl_native_hash_init_algo(const void * impl) {
+	const HASH_NATIVE * algo = (const HASH_NATIVE *)impl;
+	void * p = dsl_malloc(NATIVE_CTX_HDR + algo->stateSize);
+	HASH_CTX * ret = dsl_native_hash_setup(algo, p, false);
+	if (ret == NULL) {
+		dsl_free(p);
+	}
+	return ret;
+}
+
+HASH_CTX * dsl_native_hash_init(const char * name) {
+	const void * algo = dsl_native_hash_lookup(name);
+	return (algo != NULL) ? dsl_native_hash_init_algo(algo) : NULL;
+}
+
+size_t dsl_native_hash_ctx_size(const void * impl) {
+	const HASH_NATIVE * algo = (const HASH_NATIVE *)impl;
+	return (algo->stateSize > 0) ? NATIVE_CTX_HDR + algo->stateSize : 0;
+}
+
+HASH_CTX * dsl_native_hash_init_inplace(const void * impl, void * storage) {
+	return dsl_native_hash_setup((const HASH_NATIVE *)impl, storage, true);
+}
+
 void dsl_native_hash_update(HASH_CTX *ctx, const uint8 *data, size_t len) {
+	// some of the algorithms take a 32-bit length
+	while (len > 0x40000000) {
+		ctx->impl->update(ctx, data, 0x40000000);
+		data += 0x40000000;
+		len -= 0x40000000;
+	}
 	ctx->impl->update(ctx, data, len);
 }
 
 bool dsl_native_hash_finish(HASH_CTX *ctx, uint8 * out, size_t outlen) {
 	bool ret = ctx->impl->finish(ctx, out);
+	if (!ctx->inplace) {
+		dsl_free(ctx);
+	}
+	return ret;
+}
+
+bool dsl_native_hash_reset(HASH_CTX *ctx, uint8 * out, size_t outlen) {
+	const HASH_NATIVE * algo = ctx->impl;
+	bool ret;
+	if (out != NULL) {
+		ret = algo->finish(ctx, out);
+	} else {
+		// algorithms without stateSize only free their state in finish()
+		uint8 * tmp = (uint8 *)dsl_malloc(algo->hashSize);
+		ret = algo->finish(ctx, tmp);
+		dsl_free(tmp);
+	}
+	if (algo->stateSize > 0) {
+		memset(ctx->pptr1, 0, algo->stateSize);
+	}
+	return algo->init(ctx) && ret;
+}
+
+HASH_CTX * dsl_native_hash_clone(const HASH_CTX *ctx, void * storage, size_t size) {
+	const HASH_NATIVE * algo = ctx->impl;
+	size_t need = NATIVE_CTX_HDR + algo->stateSize;
+	if (algo->stateSize == 0 || (storage != NULL && size < need)) {
+		return NULL;
+	}
+	HASH_CTX * ret = (HASH_CTX *)((storage != NULL) ? storage : dsl_malloc(need));
+	memcpy(ret, ctx, need);
+	ret->pptr1 = (uint8 *)ret + NATIVE_CTX_HDR;
+	ret->inplace = (storage != NULL);
+	return ret;
+}
+
+bool dsl_native_hash_batch(const char * name, const HASH_BATCH_ITEM * items, size_t count, uint8 * out, size_t outlen) {
+	const HASH_NATIVE * algo = (const HASH_NATIVE *)dsl_native_hash_lookup(name);
+	if (algo == NULL || outlen / algo->hashSize < count) {
+		return false;
+	}
+	if (algo->batch != NULL) {
+		algo->batch(items, count, out);
+		return true;
+	}
+	if (algo->stateSize == 0) {
+		for (size_t j = 0; j < count; j++) {
+			HASH_CTX * ctx = dsl_native_hash_init_algo(algo);
+			if (ctx == NULL) {
+				return false;
+			}
+			algo->update(ctx, items[j].data, items[j].length);
+			if (!dsl_native_hash_finish(ctx, out + (j * algo->hashSize), algo->hashSize)) {
+				return false;
+			}
+		}
+		return true;
+	}
+	// no lanes for this one, but one ctx is reused for every message
+	HASH_CTX * ctx = dsl_native_hash_init_algo(algo);
+	if (ctx == NULL) {
+		return false;
+	}
+	bool ret = true;
+	for (size_t j = 0; ret && j < count; j++) {
+		algo->update(ctx, items[j].data, items[j].length);
+		ret = dsl_native_hash_reset(ctx, out + (j * algo->hashSize), algo->hashSize);
+	}
 	dsl_free(ctx);
 	return ret;
 }
@@ -298,5 +612,12 @@ const HASH_PROVIDER dsl_native_hashers = {
 	"native",
 	dsl_native_hash_init,
 	dsl_native_hash_update,
-	dsl_native_hash_finish
+	dsl_native_hash_finish,
+	dsl_native_hash_batch,
+	dsl_native_hash_lookup,
+	dsl_native_hash_init_algo,
+	dsl_native_hash_ctx_size,
+	dsl_native_hash_init_inplace,
+	dsl_native_hash_reset,
+	dsl_native_hash_clone
 };
@@ -15,10 +15,7 @@
 /* SHA-2 */
 
 bool native_hmac_sha256_init(HASH_HMAC_CTX * ctx, const uint8 *key, size_t length) {
-	hmac_sha256_ctx * sctx = (hmac_sha256_ctx *)dsl_malloc(sizeof(hmac_sha256_ctx));
-	memset(sctx, 0, sizeof(hmac_sha256_ctx));
-	hmac_sha256_init(sctx, key, length);
-	ctx->pptr1 = sctx;
+	hmac_sha256_init((hmac_sha256_ctx *)ctx->pptr1, key, length);
 	return true;
 }
 
@@ -27,7 +24,10 @@ void native_hmac_sha256_update(HASH_HMAC_CTX * ctx, const uint8 *input, size_t l
 }
 bool native_hmac_sha256_finish(HASH_HMAC_CTX * ctx, uint8 * out) {
 	hmac_sha256_final((hmac_sha256_ctx *)ctx->pptr1, out, ctx->hashSize);
-	dsl_free(ctx->pptr1);
+	return true;
+}
+bool native_hmac_sha256_reset(HASH_HMAC_CTX * ctx) {
+	hmac_sha256_reinit((hmac_sha256_ctx *)ctx->pptr1);
 	return true;
 }
 
@@ -36,14 +36,13 @@ HMAC_NATIVE hash_hmac_sha256 = {
 
 	native_hmac_sha256_init,
 	native_hmac_sha256_update,
-	native_hmac_sha256_finish
+	native_hmac_sha256_finish,
+	native_hmac_sha256_reset,
+	sizeof(hmac_sha256_ctx)
 };
 
 bool native_hmac_sha512_init(HASH_HMAC_CTX * ctx, const uint8 *key, size_t length) {
-	hmac_sha512_ctx * sctx = (hmac_sha512_ctx *)dsl_malloc(sizeof(hmac_sha512_ctx));
-	memset(sctx, 0, sizeof(hmac_sha512_ctx));
-	hmac_sha512_init(sctx, key, length);
-	ctx->pptr1 = sctx;
+	hmac_sha512_init((hmac_sha512_ctx *)ctx->pptr1, key, length);
 	return true;
 }
 
@@ -52,7 +51,10 @@ void native_hmac_sha512_update(HASH_HMAC_CTX * ctx, const uint8 *input, size_t l
 }
 bool native_hmac_sha512_finish(HASH_HMAC_CTX * ctx, uint8 * out) {
 	hmac_sha512_final((hmac_sha512_ctx *)ctx->pptr1, out, ctx->hashSize);
-	dsl_free(ctx->pptr1);
+	return true;
+}
+bool native_hmac_sha512_reset(HASH_HMAC_CTX * ctx) {
+	hmac_sha512_reinit((hmac_sha512_ctx *)ctx->pptr1);
 	return true;
 }
 
@@ -61,7 +63,9 @@ HMAC_NATIVE hash_hmac_sha512 = {
 
 	native_hmac_sha512_init,
 	native_hmac_sha512_update,
-	native_hmac_sha512_finish
+	native_hmac_sha512_finish,
+	native_hmac_sha512_reset,
+	sizeof(hmac_sha512_ctx)
 };
 
 /* Hashing interface */
@@ -86,30 +90,87 @@ void DSL_CC dsl_add_native_hmac(const char * name, const HMAC_NATIVE * p) {
 	hmac_algos.push_back(m);
 }
 
-HASH_HMAC_CTX * dsl_native_hmac_init(const char * name, const uint8 *key, size_t length) {
-	HASH_HMAC_CTX * ret = dsl_new(HASH_HMAC_CTX);
-	memset(ret, 0, sizeof(HASH_HMAC_CTX));
+static const HMAC_NATIVE * dsl_native_hmac_lookup(const char * name) {
 	for (int i = 0; i < hmac_algos.size(); i++) {
 		if (!stricmp(name, hmac_algos[i].name.c_str())) {
-			ret->hashSize = hmac_algos[i].algo->hashSize;
-			ret->impl = hmac_algos[i].algo;
-			if (hmac_algos[i].algo->init(ret, key, length)) {
-				return ret;
-			}
-			break;
+			return hmac_algos[i].algo;
 		}
 	}
-	dsl_free(ret);
 	return NULL;
 }
 
+/* The HASH_HMAC_CTX and the algorithm's state share one block, on the heap or in caller storage */
+#define NATIVE_HMAC_CTX_HDR ((sizeof(HASH_HMAC_CTX) + DSL_HMAC_CTX_ALIGN - 1) & ~((size_t)DSL_HMAC_CTX_ALIGN - 1))
+
+static HASH_HMAC_CTX * dsl_native_hmac_setup(const HMAC_NATIVE * algo, const uint8 *key, size_t length, void * storage, bool inplace) {
+	HASH_HMAC_CTX * ret = (HASH_HMAC_CTX *)storage;
+	memset(ret, 0, NATIVE_HMAC_CTX_HDR + algo->stateSize);
+	ret->hashSize = algo->hashSize;
+	ret->impl = algo;
+	ret->inplace = inplace;
+	if (algo->stateSize > 0) {
+		ret->pptr1 = (uint8 *)storage + NATIVE_HMAC_CTX_HDR;
+	}
+	return algo->init(ret, key, length) ? ret : NULL;
+}
+
+HASH_HMAC_CTX * dsl_native_hmac_init(const char * name, const uint8 *key, size_t length) {
+	const HMAC_NATIVE * algo = dsl_native_hmac_lookup(name);
+	if (algo == NULL) {
+		return NULL;
+	}
+	void * p = dsl_malloc(NATIVE_HMAC_CTX_HDR + algo->stateSize);
+	HASH_HMAC_CTX * ret = dsl_native_hmac_setup(algo, key, length, p, false);
+	if (ret == NULL) {
+		dsl_free(p);
+	}
+	return ret;
+}
+
+size_t dsl_native_hmac_ctx_size(const char * name) {
+	const HMAC_NATIVE * algo = dsl_native_hmac_lookup(name);
+	return (algo != NULL && algo->stateSize > 0) ? NATIVE_HMAC_CTX_HDR + algo->stateSize : 0;
+}
+
+HASH_HMAC_CTX * dsl_native_hmac_init_inplace(const char * name, const uint8 *key, size_t length, void * storage) {
+	const HMAC_NATIVE * algo = dsl_native_hmac_lookup(name);
+	return (algo != NULL && algo->stateSize > 0) ? dsl_native_hmac_setup(algo, key, length, storage, true) : NULL;
+}
+
 void dsl_native_hmac_update(HASH_HMAC_CTX *ctx, const uint8 *data, size_t len) {
 	ctx->impl->update(ctx, data, len);
 }
 
 bool dsl_native_hmac_finish(HASH_HMAC_CTX *ctx, uint8 * out, size_t outlen) {
 	bool ret = ctx->impl->finish(ctx, out);
-	dsl_free(ctx);
+	if (!ctx->inplace) {
+		dsl_free(ctx);
+	}
+	return ret;
+}
+
+bool dsl_native_hmac_reset(HASH_HMAC_CTX *ctx, uint8 * out, size_t outlen) {
+	const HMAC_NATIVE * algo = ctx->impl;
+	if (algo->reset == NULL || algo->stateSize == 0) {
+		return false;
+	}
+	bool ret = true;
+	if (out != NULL) {
+		ret = algo->finish(ctx, out);
+	}
+	return algo->reset(ctx) && ret;
+}
+
+HASH_HMAC_CTX * dsl_native_hmac_clone(const HASH_HMAC_CTX *ctx, void * storage, size_t size) {
+	const HMAC_NATIVE * algo = ctx->impl;
+	size_t need = NATIVE_HMAC_CTX_HDR + algo->stateSize;
+	if (algo->stateSize == 0 || (storage != NULL && size < need)) {
+		return NULL;
+	}
+	HASH_HMAC_CTX * ret = (HASH_HMAC_CTX *)((storage != NULL) ? storage : dsl_malloc(need));
+	memcpy(ret, ctx, need);
+	ret->pptr1 = (uint8 *)ret + NATIVE_HMAC_CTX_HDR;
+	ret->inplace = (storage != NULL);
 	return ret;
 }
 
@@ -117,5 +178,9 @@ const HMAC_PROVIDER dsl_native_hmacers = {
 	"native",
 	dsl_native_hmac_init,
 	dsl_native_hmac_update,
-	dsl_native_hmac_finish
+	dsl_native_hmac_finish,
+	dsl_native_hmac_ctx_size,
+	dsl_native_hmac_init_inplace,
+	dsl_native_hmac_reset,
+	dsl_native_hmac_clone
 };
@@ -37,6 +37,7 @@
 #include <drift/dslcore.h>
 #include <drift/hash.h>
 #include <drift/algo/sha1.h>
+#include <drift/algo/hash_accel.h>
 
 /* constant table */
 static uint32_t SHA1_K[] = { 0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6 };
@@ -74,84 +75,88 @@ static uint32_t SHA1_K[] = { 0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6 };
 static void sha1_step(struct sha1_ctxt *);
 
 static void
-sha1_step(struct sha1_ctxt *ctxt)
+sha1_blocks_c(uint32_t *h, const uint8_t *data, size_t nblocks)
 {
 	uint32_t	a, b, c, d, e;
 	size_t t, s;
 	uint32_t	tmp;
+	uint32_t	w[16];
 
-#if !WORDS_BIGENDIAN
-	struct sha1_ctxt tctxt;
-	memmove(&tctxt.m.b8[0], &ctxt->m.b8[0], 64);
-	ctxt->m.b8[0] = tctxt.m.b8[3]; ctxt->m.b8[1] = tctxt.m.b8[2];
-	ctxt->m.b8[2] = tctxt.m.b8[1]; ctxt->m.b8[3] = tctxt.m.b8[0];
-	ctxt->m.b8[4] = tctxt.m.b8[7]; ctxt->m.b8[5] = tctxt.m.b8[6];
-	ctxt->m.b8[6] = tctxt.m.b8[5]; ctxt->m.b8[7] = tctxt.m.b8[4];
-	ctxt->m.b8[8] = tctxt.m.b8[11]; ctxt->m.b8[9] = tctxt.m.b8[10];
-	ctxt->m.b8[10] = tctxt.m.b8[9]; ctxt->m.b8[11] = tctxt.m.b8[8];
-	ctxt->m.b8[12] = tctxt.m.b8[15]; ctxt->m.b8[13] = tctxt.m.b8[14];
-	ctxt->m.b8[14] = tctxt.m.b8[13]; ctxt->m.b8[15] = tctxt.m.b8[12];
-	ctxt->m.b8[16] = tctxt.m.b8[19]; ctxt->m.b8[17] = tctxt.m.b8[18];
-	ctxt->m.b8[18] = tctxt.m.b8[17]; ctxt->m.b8[19] = tctxt.m.b8[16];
-	ctxt->m.b8[20] = tctxt.m.b8[23]; ctxt->m.b8[21] = tctxt.m.b8[22];
-	ctxt->m.b8[22] = tctxt.m.b8[21]; ctxt->m.b8[23] = tctxt.m.b8[20];
-	ctxt->m.b8[24] = tctxt.m.b8[27]; ctxt->m.b8[25] = tctxt.m.b8[26];
-	ctxt->m.b8[26] = tctxt.m.b8[25]; ctxt->m.b8[27] = tctxt.m.b8[24];
-	ctxt->m.b8[28] = tctxt.m.b8[31]; ctxt->m.b8[29] = tctxt.m.b8[30];
-	ctxt->m.b8[30] = tctxt.m.b8[29]; ctxt->m.b8[31] = tctxt.m.b8[28];
-	ctxt->m.b8[32] = tctxt.m.b8[35]; ctxt->m.b8[33] = tctxt.m.b8[34];
-	ctxt->m.b8[34] = tctxt.m.b8[33]; ctxt->m.b8[35] = tctxt.m.b8[32];
-	ctxt->m.b8[36] = tctxt.m.b8[39]; ctxt->m.b8[37] = tctxt.m.b8[38];
-	ctxt->m.b8[38] = tctxt.m.b8[37]; ctxt->m.b8[39] = tctxt.m.b8[36];
-	ctxt->m.b8[40] = tctxt.m.b8[43]; ctxt->m.b8[41] = tctxt.m.b8[42];
-	ctxt->m.b8[42] = tctxt.m.b8[41]; ctxt->m.b8[43] = tctxt.m.b8[40];
-	ctxt->m.b8[44] = tctxt.m.b8[47]; ctxt->m.b8[45] = tctxt.m.b8[46];
-	ctxt->m.b8[46] = tctxt.m.b8[45]; ctxt->m.b8[47] = tctxt.m.b8[44];
-	ctxt->m.b8[48] = tctxt.m.b8[51]; ctxt->m.b8[49] = tctxt.m.b8[50];
-	ctxt->m.b8[50] = tctxt.m.b8[49]; ctxt->m.b8[51] = tctxt.m.b8[48];
-	ctxt->m.b8[52] = tctxt.m.b8[55]; ctxt->m.b8[53] = tctxt.m.b8[54];
-	ctxt->m.b8[54] = tctxt.m.b8[53]; ctxt->m.b8[55] = tctxt.m.b8[52];
-	ctxt->m.b8[56] = tctxt.m.b8[59]; ctxt->m.b8[57] = tctxt.m.b8[58];
-	ctxt->m.b8[58] = tctxt.m.b8[57]; ctxt->m.b8[59] = tctxt.m.b8[56];
-	ctxt->m.b8[60] = tctxt.m.b8[63]; ctxt->m.b8[61] = tctxt.m.b8[62];
-	ctxt->m.b8[62] = tctxt.m.b8[61]; ctxt->m.b8[63] = tctxt.m.b8[60];
-#endif
+	for (; nblocks > 0; nblocks--, data += 64) {
+		for (t = 0; t < 16; t++) {
+			w[t] = ((uint32_t)data[t * 4] << 24) | ((uint32_t)data[t * 4 + 1] << 16) |
+			    ((uint32_t)data[t * 4 + 2] << 8) | (uint32_t)data[t * 4 + 3];
+		}
 
-	a = H(0); b = H(1); c = H(2); d = H(3); e = H(4);
+		a = h[0]; b = h[1]; c = h[2]; d = h[3]; e = h[4];
 
-	for (t = 0; t < 20; t++) {
-		s = t & 0x0f;
-		if (t >= 16) {
-			W(s) = S(1, W((s+13) & 0x0f) ^ W((s+8) & 0x0f) ^ W((s+2) & 0x0f) ^ W(s));
+		for (t = 0; t < 20; t++) {
+			s = t & 0x0f;
+			if (t >= 16) {
+				w[s] = S(1, w[(s+13) & 0x0f] ^ w[(s+8) & 0x0f] ^ w[(s+2) & 0x0f] ^ w[s]);
+			}
+			tmp = S(5, a) + F0(b, c, d) + e + w[s] + K(t);
+			e = d; d = c; c = S(30, b); b = a; a = tmp;
 		}
-		tmp = S(5, a) + F0(b, c, d) + e + W(s) + K(t);
-		e = d; d = c; c = S(30, b); b = a; a = tmp;
-	}
-	for (t = 20; t < 40; t++) {
-		s = t & 0x0f;
-		W(s) = S(1, W((s+13) & 0x0f) ^ W((s+8) & 0x0f) ^ W((s+2) & 0x0f) ^ W(s));
-		tmp = S(5, a) + F1(b, c, d) + e + W(s) + K(t);
-		e = d; d = c; c = S(30, b); b = a; a = tmp;
-	}
-	for (t = 40; t < 60; t++) {
-		s = t & 0x0f;
-		W(s) = S(1, W((s+13) & 0x0f) ^ W((s+8) & 0x0f) ^ W((s+2) & 0x0f) ^ W(s));
-		tmp = S(5, a) + F2(b, c, d) + e + W(s) + K(t);
-		e = d; d = c; c = S(30, b); b = a; a = tmp;
-	}
-	for (t = 60; t < 80; t++) {
-		s = t & 0x0f;
-		W(s) = S(1, W((s+13) & 0x0f) ^ W((s+8) & 0x0f) ^ W((s+2) & 0x0f) ^ W(s));
-		tmp = S(5, a) + F3(b, c, d) + e + W(s) + K(t);
-		e = d; d = c; c = S(30, b); b = a; a = tmp;
+		for (t = 20; t < 40; t++) {
+			s = t & 0x0f;
+			w[s] = S(1, w[(s+13) & 0x0f] ^ w[(s+8) & 0x0f] ^ w[(s+2) & 0x0f] ^ w[s]);
+			tmp = S(5, a) + F1(b, c, d) + e + w[s] + K(t);
+			e = d; d = c; c = S(30, b); b = a; a = tmp;
+		}
+		for (t = 40; t < 60; t++) {
+			s = t & 0x0f;
+			w[s] = S(1, w[(s+13) & 0x0f] ^ w[(s+8) & 0x0f] ^ w[(s+2) & 0x0f] ^ w[s]);
+			tmp = S(5, a) + F2(b, c, d) + e + w[s] + K(t);
+			e = d; d = c; c = S(30, b); b = a; a = tmp;
+		}
+		for (t = 60; t < 80; t++) {
+			s = t & 0x0f;
+			w[s] = S(1, w[(s+13) & 0x0f] ^ w[(s+8) & 0x0f] ^ w[(s+2) & 0x0f] ^ w[s]);
+			tmp = S(5, a) + F3(b, c, d) + e + w[s] + K(t);
+			e = d; d = c; c = S(30, b); b = a; a = tmp;
+		}
+
+		h[0] += a;
+		h[1] += b;
+		h[2] += c;
+		h[3] += d;
+		h[4] += e;
 	}
+}
+
+/* Uses the SHA instructions when the CPU has them */
+static sha1_blocks_func
+sha1_pick_blocks(void)
+{
+#if defined(DSL_HASH_X86)
+	if (dsl_hash_cpu()->sha)
+		return sha1_blocks_shani;
+#elif defined(DSL_HASH_ARM64)
+	if (dsl_hash_cpu()->arm_sha1)
+		return sha1_blocks_armv8;
+#endif
+	return sha1_blocks_c;
+}
 
-	H(0) = H(0) + a;
-	H(1) = H(1) + b;
-	H(2) = H(2) + c;
-	H(3) = H(3) + d;
-	H(4) = H(4) + e;
+/* picked once on first use */
+sha1_blocks_func
+sha1_get_blocks(void)
+{
+	static const sha1_blocks_func blocks = sha1_pick_blocks();
+	return blocks;
+}
 
+static void
+sha1_blocks(struct sha1_ctxt *ctxt, const uint8_t *data, size_t nblocks)
+{
+	sha1_get_blocks()(ctxt->h.b32, data, nblocks);
+}
+
+static void
+sha1_step(struct sha1_ctxt *ctxt)
+{
+	sha1_blocks(ctxt, ctxt->m.b8, 1);
 	memset(&ctxt->m.b8[0], 0, 64);
 }
 
@@ -214,6 +219,15 @@ sha1_loop(struct sha1_ctxt *ctxt, const void *input, size_t len)
 	off = 0;
 
 	while (off < len) {
+		if (COUNT == 0 && len - off >= 64) {
+			/* whole blocks straight from the input, no need to copy them into m first */
+			copysiz = (len - off) & ~(size_t)63;
+			sha1_blocks(ctxt, &input_c[off], copysiz / 64);
+			ctxt->c.b64[0] += copysiz * 8;
+			off += copysiz;
+			continue;
+		}
+
 		gapstart = COUNT % 64;
 		gaplen = 64 - gapstart;
 
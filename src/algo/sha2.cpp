@@ -38,6 +38,7 @@
 #include <drift/dslcore.h>
 #include <drift/hash.h>
 #include <drift/algo/sha2.h>
+#include <drift/algo/hash_accel.h>
 
 #define SHFR(x, n)    (x >> n)
 #define ROTR(x, n)   ((x >> n) | (x << ((sizeof(x) << 3) - n)))
@@ -141,6 +142,12 @@ uint64 sha384_h0[8] =
              0x67332667ffc00b31ULL, 0x8eb44a8768581511ULL,
              0xdb0c2e0d64f98fa7ULL, 0x47b5481dbefa4fa4ULL};
 
+uint64 sha512_256_h0[8] =
+            {0x22312194fc2bf72cULL, 0x9f555fa3c84c64c2ULL,
+             0x2393b86b6f53b151ULL, 0x963877195940eabdULL,
+             0x96283ee2a88effe3ULL, 0xbe5e1e2553863992ULL,
+             0x2b0199fc2c85b8aaULL, 0x0eb72ddc81c52ca2ULL};
+
 uint64 sha512_h0[8] =
             {0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
              0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
@@ -209,8 +216,8 @@ uint64 sha512_k[80] =
 
 /* SHA-256 functions */
 
-void sha256_transf(sha256_ctx *ctx, const unsigned char *message,
-                   unsigned int block_nb)
+static void sha256_transf_c(uint32 h[8], const unsigned char *message,
+                            size_t block_nb)
 {
     uint32 w[64];
     uint32 wv[8];
@@ -235,7 +242,7 @@ void sha256_transf(sha256_ctx *ctx, const unsigned char *message,
         }
 
         for (j = 0; j < 8; j++) {
-            wv[j] = ctx->h[j];
+            wv[j] = h[j];
         }
 
         for (j = 0; j < 64; j++) {
@@ -253,7 +260,7 @@ void sha256_transf(sha256_ctx *ctx, const unsigned char *message,
         }
 
         for (j = 0; j < 8; j++) {
-            ctx->h[j] += wv[j];
+            h[j] += wv[j];
         }
 #else
         PACK32(&sub_block[ 0], &w[ 0]); PACK32(&sub_block[ 4], &w[ 1]);
@@ -278,10 +285,10 @@ void sha256_transf(sha256_ctx *ctx, const unsigned char *message,
         SHA256_SCR(56); SHA256_SCR(57); SHA256_SCR(58); SHA256_SCR(59);
         SHA256_SCR(60); SHA256_SCR(61); SHA256_SCR(62); SHA256_SCR(63);
 
-        wv[0] = ctx->h[0]; wv[1] = ctx->h[1];
-        wv[2] = ctx->h[2]; wv[3] = ctx->h[3];
-        wv[4] = ctx->h[4]; wv[5] = ctx->h[5];
-        wv[6] = ctx->h[6]; wv[7] = ctx->h[7];
+        wv[0] = h[0]; wv[1] = h[1];
+        wv[2] = h[2]; wv[3] = h[3];
+        wv[4] = h[4]; wv[5] = h[5];
+        wv[6] = h[6]; wv[7] = h[7];
 
         SHA256_EXP(0,1,2,3,4,5,6,7, 0); SHA256_EXP(7,0,1,2,3,4,5,6, 1);
         SHA256_EXP(6,7,0,1,2,3,4,5, 2); SHA256_EXP(5,6,7,0,1,2,3,4, 3);
@@ -316,14 +323,42 @@ void sha256_transf(sha256_ctx *ctx, const unsigned char *message,
         SHA256_EXP(4,5,6,7,0,1,2,3,60); SHA256_EXP(3,4,5,6,7,0,1,2,61);
         SHA256_EXP(2,3,4,5,6,7,0,1,62); SHA256_EXP(1,2,3,4,5,6,7,0,63);
 
-        ctx->h[0] += wv[0]; ctx->h[1] += wv[1];
-        ctx->h[2] += wv[2]; ctx->h[3] += wv[3];
-        ctx->h[4] += wv[4]; ctx->h[5] += wv[5];
-        ctx->h[6] += wv[6]; ctx->h[7] += wv[7];
+        h[0] += wv[0]; h[1] += wv[1];
+        h[2] += wv[2]; h[3] += wv[3];
+        h[4] += wv[4]; h[5] += wv[5];
+        h[6] += wv[6]; h[7] += wv[7];
 #endif /* !UNROLL_LOOPS */
     }
 }
 
+static sha256_blocks_func sha256_pick_transf()
+{
+#if defined(DSL_HASH_X86)
+    if (dsl_hash_cpu()->sha) {
+        return sha256_blocks_shani;
+    }
+#elif defined(DSL_HASH_ARM64)
+    if (dsl_hash_cpu()->arm_sha2) {
+        return sha256_blocks_armv8;
+    }
+#endif
+    return sha256_transf_c;
+}
+
+sha256_blocks_func sha256_get_blocks()
+{
+    static const sha256_blocks_func transf = sha256_pick_transf();
+    return transf;
+}
+
+static void sha256_transf(sha256_ctx *ctx, const unsigned char *message,
+                          unsigned int block_nb)
+{
+    if (block_nb > 0) {
+        sha256_get_blocks()(ctx->h, message, block_nb);
+    }
+}
+
 void sha256(const unsigned char *message, unsigned int len, unsigned char *digest)
 {
     sha256_ctx ctx;
@@ -382,14 +417,14 @@ void sha256_update(sha256_ctx *ctx, const unsigned char *message,
            rem_len);
 
     ctx->len = rem_len;
-    ctx->tot_len += (block_nb + 1) << 6;
+    ctx->tot_len += (uint64)(block_nb + 1) << 6;
 }
 
 void sha256_final(sha256_ctx *ctx, unsigned char *digest)
 {
     unsigned int block_nb;
     unsigned int pm_len;
-    unsigned int len_b;
+    uint64 len_b;
 
 #ifndef UNROLL_LOOPS
     int i;
@@ -403,7 +438,7 @@ void sha256_final(sha256_ctx *ctx, unsigned char *digest)
 
     memset(ctx->block + ctx->len, 0, pm_len - ctx->len);
     ctx->block[ctx->len] = 0x80;
-    UNPACK32(len_b, ctx->block + pm_len - 4);
+    UNPACK64(len_b, ctx->block + pm_len - 8);
 
     sha256_transf(ctx, ctx->block, block_nb);
 
@@ -425,8 +460,8 @@ void sha256_final(sha256_ctx *ctx, unsigned char *digest)
 
 /* SHA-512 functions */
 
-void sha512_transf(sha512_ctx *ctx, const unsigned char *message,
-                   unsigned int block_nb)
+static void sha512_transf_c(uint64 h[8], const unsigned char *message,
+                            size_t block_nb)
 {
     uint64 w[80];
     uint64 wv[8];
@@ -447,7 +482,7 @@ void sha512_transf(sha512_ctx *ctx, const unsigned char *message,
         }
 
         for (j = 0; j < 8; j++) {
-            wv[j] = ctx->h[j];
+            wv[j] = h[j];
         }
 
         for (j = 0; j < 80; j++) {
@@ -465,7 +500,7 @@ void sha512_transf(sha512_ctx *ctx, const unsigned char *message,
         }
 
         for (j = 0; j < 8; j++) {
-            ctx->h[j] += wv[j];
+            h[j] += wv[j];
         }
 #else
         PACK64(&sub_block[  0], &w[ 0]); PACK64(&sub_block[  8], &w[ 1]);
@@ -494,10 +529,10 @@ void sha512_transf(sha512_ctx *ctx, const unsigned char *message,
         SHA512_SCR(72); SHA512_SCR(73); SHA512_SCR(74); SHA512_SCR(75);
         SHA512_SCR(76); SHA512_SCR(77); SHA512_SCR(78); SHA512_SCR(79);
 
-        wv[0] = ctx->h[0]; wv[1] = ctx->h[1];
-        wv[2] = ctx->h[2]; wv[3] = ctx->h[3];
-        wv[4] = ctx->h[4]; wv[5] = ctx->h[5];
-        wv[6] = ctx->h[6]; wv[7] = ctx->h[7];
+        wv[0] = h[0]; wv[1] = h[1];
+        wv[2] = h[2]; wv[3] = h[3];
+        wv[4] = h[4]; wv[5] = h[5];
+        wv[6] = h[6]; wv[7] = h[7];
 
         j = 0;
 
@@ -512,14 +547,36 @@ void sha512_transf(sha512_ctx *ctx, const unsigned char *message,
             SHA512_EXP(1,2,3,4,5,6,7,0,j); j++;
         } while (j < 80);
 
-        ctx->h[0] += wv[0]; ctx->h[1] += wv[1];
-        ctx->h[2] += wv[2]; ctx->h[3] += wv[3];
-        ctx->h[4] += wv[4]; ctx->h[5] += wv[5];
-        ctx->h[6] += wv[6]; ctx->h[7] += wv[7];
+        h[0] += wv[0]; h[1] += wv[1];
+        h[2] += wv[2]; h[3] += wv[3];
+        h[4] += wv[4]; h[5] += wv[5];
+        h[6] += wv[6]; h[7] += wv[7];
 #endif /* !UNROLL_LOOPS */
     }
 }
 
+static sha512_blocks_func sha512_pick_transf()
+{
+#if defined(DSL_HASH_X86)
+    if (dsl_hash_cpu()->avx512) {
+        return sha512_blocks_avx512;
+    }
+    if (dsl_hash_cpu()->avx2) {
+        return sha512_blocks_avx2;
+    }
+#endif
+    return sha512_transf_c;
+}
+
+static void sha512_transf(sha512_ctx *ctx, const unsigned char *message,
+                          unsigned int block_nb)
+{
+    static const sha512_blocks_func transf = sha512_pick_transf();
+    if (block_nb > 0) {
+        transf(ctx->h, message, block_nb);
+    }
+}
+
 void sha512(const unsigned char *message, unsigned int len,
             unsigned char *digest)
 {
@@ -548,6 +605,20 @@ void sha512_init(sha512_ctx *ctx)
     ctx->tot_len = 0;
 }
 
+void sha384_init(sha384_ctx *ctx)
+{
+    memcpy(ctx->h, sha384_h0, sizeof(ctx->h));
+    ctx->len = 0;
+    ctx->tot_len = 0;
+}
+
+void sha512_256_init(sha512_ctx *ctx)
+{
+    memcpy(ctx->h, sha512_256_h0, sizeof(ctx->h));
+    ctx->len = 0;
+    ctx->tot_len = 0;
+}
+
 void sha512_update(sha512_ctx *ctx, const unsigned char *message,
                    unsigned int len)
 {
@@ -579,14 +650,14 @@ void sha512_update(sha512_ctx *ctx, const unsigned char *message,
            rem_len);
 
     ctx->len = rem_len;
-    ctx->tot_len += (block_nb + 1) << 7;
+    ctx->tot_len += (uint64)(block_nb + 1) << 7;
 }
 
 void sha512_final(sha512_ctx *ctx, unsigned char *digest)
 {
     unsigned int block_nb;
     unsigned int pm_len;
-    unsigned int len_b;
+    uint64 len_b;
 
 #ifndef UNROLL_LOOPS
     int i;
@@ -600,7 +671,7 @@ void sha512_final(sha512_ctx *ctx, unsigned char *digest)
 
     memset(ctx->block + ctx->len, 0, pm_len - ctx->len);
     ctx->block[ctx->len] = 0x80;
-    UNPACK32(len_b, ctx->block + pm_len - 4);
+    UNPACK64(len_b, ctx->block + pm_len - 8);
 
     sha512_transf(ctx, ctx->block, block_nb);
 
@@ -620,6 +691,38 @@ void sha512_final(sha512_ctx *ctx, unsigned char *digest)
 #endif /* !UNROLL_LOOPS */
 }
 
+/* SHA-384 and SHA-512/256 are SHA-512 with a different IV, truncated */
+
+void sha384_update(sha384_ctx *ctx, const unsigned char *message,
+                   unsigned int len)
+{
+    sha512_update(ctx, message, len);
+}
+
+void sha384_final(sha384_ctx *ctx, unsigned char *digest)
+{
+    unsigned char full[SHA512_DIGEST_SIZE];
+    sha512_final(ctx, full);
+    memcpy(digest, full, SHA384_DIGEST_SIZE);
+}
+
+void sha384(const unsigned char *message, unsigned int len,
+            unsigned char *digest)
+{
+    sha384_ctx ctx;
+
+    sha384_init(&ctx);
+    sha384_update(&ctx, message, len);
+    sha384_final(&ctx, digest);
+}
+
+void sha512_256_final(sha512_ctx *ctx, unsigned char *digest)
+{
+    unsigned char full[SHA512_DIGEST_SIZE];
+    sha512_final(ctx, full);
+    memcpy(digest, full, SHA512_256_DIGEST_SIZE);
+}
+
 #ifdef TEST_VECTORS
 
 /* FIPS 180-2 Validation tests */
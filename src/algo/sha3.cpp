@@ -19,6 +19,7 @@
 #include <drift/dslcore.h>
 #include <drift/hash.h>
 #include <drift/algo/sha3.h>
+#include <drift/algo/hash_accel.h>
 
 #define SHA3_ASSERT( x )
 #if defined(_MSC_VER)
@@ -47,7 +48,7 @@
 	(((x) << (y)) | ((x) >> ((sizeof(uint64_t)*8) - (y))))
 #endif
 
-static const uint64_t keccakf_rndc[24] = {
+const uint64 keccakf_rndc[24] = {
     SHA3_CONST(0x0000000000000001UL), SHA3_CONST(0x0000000000008082UL),
     SHA3_CONST(0x800000000000808aUL), SHA3_CONST(0x8000000080008000UL),
     SHA3_CONST(0x000000000000808bUL), SHA3_CONST(0x0000000080000001UL),
@@ -62,58 +63,126 @@ static const uint64_t keccakf_rndc[24] = {
     SHA3_CONST(0x0000000080000001UL), SHA3_CONST(0x8000000080008008UL)
 };
 
-static const unsigned keccakf_rotc[24] = {
-    1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62,
-    18, 39, 61, 20, 44
-};
-
-static const unsigned keccakf_piln[24] = {
-    10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20,
-    14, 22, 9, 6, 1
-};
+/*
+ * Keccak-f[1600], fully unrolled with the lane complementing transform from the Keccak team's implementation overview:
+ * six lanes are kept inverted between rounds, which turns most of chi's NOT+AND pairs into a single AND or OR.
+ * Two rounds per loop iteration ping-pong between A and E so no lanes need to be copied.
+ * The state is indexed s[x + 5*y].
+ */
+#define KECCAK_ROUND(A, E, rc) { \
+    uint64_t C0, C1, C2, C3, C4, D0, D1, D2, D3, D4, B0, B1, B2, B3, B4; \
+    C0 = A[0] ^ A[5] ^ A[10] ^ A[15] ^ A[20]; \
+    C1 = A[1] ^ A[6] ^ A[11] ^ A[16] ^ A[21]; \
+    C2 = A[2] ^ A[7] ^ A[12] ^ A[17] ^ A[22]; \
+    C3 = A[3] ^ A[8] ^ A[13] ^ A[18] ^ A[23]; \
+    C4 = A[4] ^ A[9] ^ A[14] ^ A[19] ^ A[24]; \
+    D0 = C4 ^ SHA3_ROTL64(C1, 1); \
+    D1 = C0 ^ SHA3_ROTL64(C2, 1); \
+    D2 = C1 ^ SHA3_ROTL64(C3, 1); \
+    D3 = C2 ^ SHA3_ROTL64(C4, 1); \
+    D4 = C3 ^ SHA3_ROTL64(C0, 1); \
+    \
+    B0 = A[0] ^ D0; \
+    B1 = SHA3_ROTL64(A[6] ^ D1, 44); \
+    B2 = SHA3_ROTL64(A[12] ^ D2, 43); \
+    B3 = SHA3_ROTL64(A[18] ^ D3, 21); \
+    B4 = SHA3_ROTL64(A[24] ^ D4, 14); \
+    E[0] = B0 ^ (B1 | B2) ^ (rc); \
+    E[1] = B1 ^ (~B2 | B3); \
+    E[2] = B2 ^ (B3 & B4); \
+    E[3] = B3 ^ (B4 | B0); \
+    E[4] = B4 ^ (B0 & B1); \
+    \
+    B0 = SHA3_ROTL64(A[3] ^ D3, 28); \
+    B1 = SHA3_ROTL64(A[9] ^ D4, 20); \
+    B2 = SHA3_ROTL64(A[10] ^ D0, 3); \
+    B3 = SHA3_ROTL64(A[16] ^ D1, 45); \
+    B4 = SHA3_ROTL64(A[22] ^ D2, 61); \
+    E[5] = B0 ^ (B1 | B2); \
+    E[6] = B1 ^ (B2 & B3); \
+    E[7] = B2 ^ (B3 | ~B4); \
+    E[8] = B3 ^ (B4 | B0); \
+    E[9] = B4 ^ (B0 & B1); \
+    \
+    B0 = SHA3_ROTL64(A[1] ^ D1, 1); \
+    B1 = SHA3_ROTL64(A[7] ^ D2, 6); \
+    B2 = SHA3_ROTL64(A[13] ^ D3, 25); \
+    B3 = SHA3_ROTL64(A[19] ^ D4, 8); \
+    B4 = SHA3_ROTL64(A[20] ^ D0, 18); \
+    E[10] = B0 ^ (B1 | B2); \
+    E[11] = B1 ^ (B2 & B3); \
+    E[12] = B2 ^ (~B3 & B4); \
+    E[13] = ~B3 ^ (B4 | B0); \
+    E[14] = B4 ^ (B0 & B1); \
+    \
+    B0 = SHA3_ROTL64(A[4] ^ D4, 27); \
+    B1 = SHA3_ROTL64(A[5] ^ D0, 36); \
+    B2 = SHA3_ROTL64(A[11] ^ D1, 10); \
+    B3 = SHA3_ROTL64(A[17] ^ D2, 15); \
+    B4 = SHA3_ROTL64(A[23] ^ D3, 56); \
+    E[15] = B0 ^ (B1 & B2); \
+    E[16] = B1 ^ (B2 | B3); \
+    E[17] = B2 ^ (~B3 | B4); \
+    E[18] = ~B3 ^ (B4 & B0); \
+    E[19] = B4 ^ (B0 | B1); \
+    \
+    B0 = SHA3_ROTL64(A[2] ^ D2, 62); \
+    B1 = SHA3_ROTL64(A[8] ^ D3, 55); \
+    B2 = SHA3_ROTL64(A[14] ^ D4, 39); \
+    B3 = SHA3_ROTL64(A[15] ^ D0, 41); \
+    B4 = SHA3_ROTL64(A[21] ^ D1, 2); \
+    E[20] = B0 ^ (~B1 & B2); \
+    E[21] = ~B1 ^ (B2 | B3); \
+    E[22] = B2 ^ (B3 & B4); \
+    E[23] = B3 ^ (B4 | B0); \
+    E[24] = B4 ^ (B0 & B1); \
+}
 
 /* generally called after SHA3_KECCAK_SPONGE_WORDS-ctx->capacityWords words 
  * are XORed into the state s 
  */
-static void
-keccakf(uint64_t s[25])
+void
+keccakf1600(uint64 s[25])
 {
-    int i, j, round;
-    uint64_t t, bc[5];
-#define KECCAK_ROUNDS 24
-
-    for(round = 0; round < KECCAK_ROUNDS; round++) {
-
-        /* Theta */
-        for(i = 0; i < 5; i++)
-            bc[i] = s[i] ^ s[i + 5] ^ s[i + 10] ^ s[i + 15] ^ s[i + 20];
-
-        for(i = 0; i < 5; i++) {
-            t = bc[(i + 4) % 5] ^ SHA3_ROTL64(bc[(i + 1) % 5], 1);
-            for(j = 0; j < 25; j += 5)
-                s[j + i] ^= t;
-        }
-
-        /* Rho Pi */
-        t = s[1];
-        for(i = 0; i < 24; i++) {
-            j = keccakf_piln[i];
-            bc[0] = s[j];
-            s[j] = SHA3_ROTL64(t, keccakf_rotc[i]);
-            t = bc[0];
-        }
+    uint64_t A[25], E[25];
+    int i, round;
+
+    for(i = 0; i < 25; i++)
+        A[i] = s[i];
+    A[1] = ~A[1];
+    A[2] = ~A[2];
+    A[8] = ~A[8];
+    A[12] = ~A[12];
+    A[17] = ~A[17];
+    A[20] = ~A[20];
+
+    for(round = 0; round < 24; round += 2) {
+        KECCAK_ROUND(A, E, keccakf_rndc[round]);
+        KECCAK_ROUND(E, A, keccakf_rndc[round + 1]);
+    }
 
-        /* Chi */
-        for(j = 0; j < 25; j += 5) {
-            for(i = 0; i < 5; i++)
-                bc[i] = s[j + i];
-            for(i = 0; i < 5; i++)
-                s[j + i] ^= (~bc[(i + 1) % 5]) & bc[(i + 2) % 5];
-        }
+    A[1] = ~A[1];
+    A[2] = ~A[2];
+    A[8] = ~A[8];
+    A[12] = ~A[12];
+    A[17] = ~A[17];
+    A[20] = ~A[20];
+    for(i = 0; i < 25; i++)
+        s[i] = A[i];
+}
 
-        /* Iota */
-        s[0] ^= keccakf_rndc[round];
-    }
+/* endian-independent, compilers turn this into a plain load on little-endian CPUs */
+static inline uint64_t
+sha3_load64(const uint8_t *buf)
+{
+    return (uint64_t) (buf[0]) |
+            ((uint64_t) (buf[1]) << 8 * 1) |
+            ((uint64_t) (buf[2]) << 8 * 2) |
+            ((uint64_t) (buf[3]) << 8 * 3) |
+            ((uint64_t) (buf[4]) << 8 * 4) |
+            ((uint64_t) (buf[5]) << 8 * 5) |
+            ((uint64_t) (buf[6]) << 8 * 6) |
+            ((uint64_t) (buf[7]) << 8 * 7);
 }
 
 /* *************************** Public Inteface ************************ */
@@ -200,7 +269,7 @@ sha3_Update(void *priv, void const *bufIn, size_t len)
         ctx->saved = 0;
         if(++ctx->wordIndex ==
                 (SHA3_KECCAK_SPONGE_WORDS - SHA3_CW(ctx->capacityWords))) {
-            keccakf(ctx->s);
+            keccakf1600(ctx->s);
             ctx->wordIndex = 0;
         }
     }
@@ -209,27 +278,31 @@ sha3_Update(void *priv, void const *bufIn, size_t len)
 
     SHA3_ASSERT(ctx->byteIndex == 0);
 
+    /* whole blocks go straight into the sponge without the per-word bookkeeping */
+    if(ctx->wordIndex == 0) {
+        const unsigned rateWords = SHA3_KECCAK_SPONGE_WORDS - SHA3_CW(ctx->capacityWords);
+        while(len >= rateWords * sizeof(uint64_t)) {
+            for(i = 0; i < rateWords; i++, buf += sizeof(uint64_t))
+                ctx->s[i] ^= sha3_load64(buf);
+            keccakf1600(ctx->s);
+            len -= rateWords * sizeof(uint64_t);
+        }
+    }
+
     words = len / sizeof(uint64_t);
     tail = len - words * sizeof(uint64_t);
 
     SHA3_TRACE("have %d full words to process", (unsigned)words);
 
     for(i = 0; i < words; i++, buf += sizeof(uint64_t)) {
-        const uint64_t t = (uint64_t) (buf[0]) |
-                ((uint64_t) (buf[1]) << 8 * 1) |
-                ((uint64_t) (buf[2]) << 8 * 2) |
-                ((uint64_t) (buf[3]) << 8 * 3) |
-                ((uint64_t) (buf[4]) << 8 * 4) |
-                ((uint64_t) (buf[5]) << 8 * 5) |
-                ((uint64_t) (buf[6]) << 8 * 6) |
-                ((uint64_t) (buf[7]) << 8 * 7);
+        const uint64_t t = sha3_load64(buf);
 #if defined(__x86_64__ ) || defined(__i386__)
         SHA3_ASSERT(memcmp(&t, buf, 8) == 0);
 #endif
         ctx->s[ctx->wordIndex] ^= t;
         if(++ctx->wordIndex ==
                 (SHA3_KECCAK_SPONGE_WORDS - SHA3_CW(ctx->capacityWords))) {
-            keccakf(ctx->s);
+            keccakf1600(ctx->s);
             ctx->wordIndex = 0;
         }
     }
@@ -277,7 +350,7 @@ sha3_Finalize(void *priv)
 
     ctx->s[SHA3_KECCAK_SPONGE_WORDS - SHA3_CW(ctx->capacityWords) - 1] ^=
             SHA3_CONST(0x8000000000000000UL);
-    keccakf(ctx->s);
+    keccakf1600(ctx->s);
 
     /* Return first bytes of the ctx->s. This conversion is not needed for
      * little-endian platforms e.g. wrap with #if !defined(__BYTE_ORDER__)
@@ -0,0 +1,302 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+/*
+ * SHA-1 and SHA-256 block functions using the Intel SHA extensions and the ARMv8 crypto extensions, and SHA-512 with AVX2/AVX-512.
+ * Only called after dsl_hash_cpu() says the instructions are there, see sha1.cpp/sha2.cpp.
+ */
+
+// the intrinsic headers have to come before dslcore.h poisons malloc & co.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#endif
+
+#include <drift/dslcore.h>
+#include <drift/algo/hash_accel.h>
+
+extern uint32 sha256_k[64];
+extern uint64 sha512_k[80];
+
+#if defined(DSL_HASH_X86)
+
+/*
+ * SHA-256: the state is kept as ABEF/CDGH pairs, which is what sha256rnds2 wants. Each step does 4 rounds and extends the message schedule by 4 words.
+ * m0 holds W[4i..4i+3], m1-m3 the next 3 groups, so the new group replaces m0.
+ */
+#define SHA256_NI_ROUNDS(i, m0, m1, m2, m3) \
+	msg = _mm_add_epi32(m0, _mm_loadu_si128((const __m128i *)&sha256_k[(i) * 4])); \
+	state1 = _mm_sha256rnds2_epu32(state1, state0, msg); \
+	state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0E)); \
+	if ((i) < 12) { \
+		m0 = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(m0, m1), _mm_alignr_epi8(m3, m2, 4)), m3); \
+	}
+
+DSL_HASH_TARGET("sha,sse4.1,ssse3") void sha256_blocks_shani(uint32 h[8], const uint8 * data, size_t nblocks) {
+	const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+	__m128i msg, m0, m1, m2, m3;
+
+	__m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&h[0]), 0xB1); // CDAB
+	__m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&h[4]), 0x1B); // EFGH
+	__m128i state0 = _mm_alignr_epi8(tmp, state1, 8); // ABEF
+	state1 = _mm_blend_epi16(state1, tmp, 0xF0); // CDGH
+
+	for (; nblocks > 0; nblocks--, data += 64) {
+		__m128i save0 = state0;
+		__m128i save1 = state1;
+
+		m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data)), bswap);
+		m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), bswap);
+		m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), bswap);
+		m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), bswap);
+
+		for (int i = 0; i < 16; i += 4) {
+			SHA256_NI_ROUNDS(i, m0, m1, m2, m3);
+			SHA256_NI_ROUNDS(i + 1, m1, m2, m3, m0);
+			SHA256_NI_ROUNDS(i + 2, m2, m3, m0, m1);
+			SHA256_NI_ROUNDS(i + 3, m3, m0, m1, m2);
+		}
+
+		state0 = _mm_add_epi32(state0, save0);
+		state1 = _mm_add_epi32(state1, save1);
+	}
+
+	tmp = _mm_shuffle_epi32(state0, 0x1B); // FEBA
+	state1 = _mm_shuffle_epi32(state1, 0xB1); // DCHG
+	state0 = _mm_blend_epi16(tmp, state1, 0xF0); // DCBA
+	state1 = _mm_alignr_epi8(state1, tmp, 8); // HGFE
+	_mm_storeu_si128((__m128i *)&h[0], state0);
+	_mm_storeu_si128((__m128i *)&h[4], state1);
+}
+
+/*
+ * SHA-1: 4 rounds per step, the round function (f) changes every 5 steps. prev is ABCD from before the last step, sha1nexte turns it into the next E.
+ * Like SHA-256 above m0 holds the current message group and gets replaced by the one 4 steps ahead.
+ */
+#define SHA1_NI_ROUNDS(i, f, m0, m1, m2, m3) \
+	if ((i) >= 4) { \
+		m0 = _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(m0, m1), m2), m3); \
+	} \
+	e = _mm_sha1nexte_epu32(prev, m0); \
+	prev = abcd; \
+	abcd = _mm_sha1rnds4_epu32(abcd, e, f);
+
+DSL_HASH_TARGET("sha,sse4.1,ssse3") void sha1_blocks_shani(uint32 h[5], const uint8 * data, size_t nblocks) {
+	const __m128i bswap = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+	__m128i e, prev, m0, m1, m2, m3;
+
+	__m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)h), 0x1B);
+	__m128i e0 = _mm_set_epi32((int)h[4], 0, 0, 0);
+
+	for (; nblocks > 0; nblocks--, data += 64) {
+		__m128i save_abcd = abcd;
+
+		m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data)), bswap);
+		m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), bswap);
+		m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), bswap);
+		m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), bswap);
+
+		// the first E comes straight from the state
+		e = _mm_add_epi32(e0, m0);
+		prev = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e, 0);
+
+		// step 0 is above, 1-3 still use the loaded message
+		e = _mm_sha1nexte_epu32(prev, m1); prev = abcd; abcd = _mm_sha1rnds4_epu32(abcd, e, 0);
+		e = _mm_sha1nexte_epu32(prev, m2); prev = abcd; abcd = _mm_sha1rnds4_epu32(abcd, e, 0);
+		e = _mm_sha1nexte_epu32(prev, m3); prev = abcd; abcd = _mm_sha1rnds4_epu32(abcd, e, 0);
+
+		SHA1_NI_ROUNDS(4, 0, m0, m1, m2, m3);
+		SHA1_NI_ROUNDS(5, 1, m1, m2, m3, m0);
+		SHA1_NI_ROUNDS(6, 1, m2, m3, m0, m1);
+		SHA1_NI_ROUNDS(7, 1, m3, m0, m1, m2);
+		SHA1_NI_ROUNDS(8, 1, m0, m1, m2, m3);
+		SHA1_NI_ROUNDS(9, 1, m1, m2, m3, m0);
+		SHA1_NI_ROUNDS(10, 2, m2, m3, m0, m1);
+		SHA1_NI_ROUNDS(11, 2, m3, m0, m1, m2);
+		SHA1_NI_ROUNDS(12, 2, m0, m1, m2, m3);
+		SHA1_NI_ROUNDS(13, 2, m1, m2, m3, m0);
+		SHA1_NI_ROUNDS(14, 2, m2, m3, m0, m1);
+		SHA1_NI_ROUNDS(15, 3, m3, m0, m1, m2);
+		SHA1_NI_ROUNDS(16, 3, m0, m1, m2, m3);
+		SHA1_NI_ROUNDS(17, 3, m1, m2, m3, m0);
+		SHA1_NI_ROUNDS(18, 3, m2, m3, m0, m1);
+		SHA1_NI_ROUNDS(19, 3, m3, m0, m1, m2);
+
+		e0 = _mm_sha1nexte_epu32(prev, e0);
+		abcd = _mm_add_epi32(abcd, save_abcd);
+	}
+
+	abcd = _mm_shuffle_epi32(abcd, 0x1B);
+	_mm_storeu_si128((__m128i *)h, abcd);
+	h[4] = (uint32)_mm_extract_epi32(e0, 3);
+}
+
+/*
+ * SHA-512: there are no SHA-512 instructions on x86, but the message schedule vectorizes well. Two blocks are scheduled at once, one per 128-bit lane,
+ * then the rounds run in plain 64-bit registers from the precomputed W+K. Each vector holds 2 schedule words so x0-x7 are the last 16.
+ * AVX-512 only adds native 64-bit rotates (vprorq), which is most of the sigma work.
+ */
+#define SHA512_SIMD_SHR(x, n) _mm256_srli_epi64(x, n)
+#define SHA512_ROR_AVX2(x, n) _mm256_or_si256(_mm256_srli_epi64(x, n), _mm256_slli_epi64(x, 64 - (n)))
+#define SHA512_ROR_AVX512(x, n) _mm256_ror_epi64(x, n)
+#define SHA512_SIMD_SIG0(ROR, x) _mm256_xor_si256(_mm256_xor_si256(ROR(x, 1), ROR(x, 8)), SHA512_SIMD_SHR(x, 7))
+#define SHA512_SIMD_SIG1(ROR, x) _mm256_xor_si256(_mm256_xor_si256(ROR(x, 19), ROR(x, 61)), SHA512_SIMD_SHR(x, 6))
+
+// W[t..t+1] = x0 + sig0(W[t-15..t-14]) + W[t-7..t-6] + sig1(x7), the new pair replaces x0
+#define SHA512_SIMD_SCHED(ROR, t, x0, x1, x4, x5, x7) \
+	x0 = _mm256_add_epi64(_mm256_add_epi64(x0, SHA512_SIMD_SIG0(ROR, _mm256_alignr_epi8(x1, x0, 8))), \
+		_mm256_add_epi64(_mm256_alignr_epi8(x5, x4, 8), SHA512_SIMD_SIG1(ROR, x7))); \
+	SHA512_SIMD_STORE_WK(t, x0);
+
+#define SHA512_SIMD_STORE_WK(t, x) { \
+	__m256i wk = _mm256_add_epi64(x, _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)&sha512_k[t]))); \
+	_mm_store_si128((__m128i *)&wk0[t], _mm256_castsi256_si128(wk)); \
+	_mm_store_si128((__m128i *)&wk1[t], _mm256_extracti128_si256(wk, 1)); \
+}
+
+// words 2i and 2i+1 of both blocks
+#define SHA512_SIMD_LOAD(i, x) \
+	x = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(data + ((i) * 16)))), \
+		_mm_loadu_si128((const __m128i *)(second + ((i) * 16))), 1), bswap); \
+	SHA512_SIMD_STORE_WK((i) * 2, x);
+
+#define SHA512_SIMD_BLOCKS(ROR) \
+	const __m256i bswap = _mm256_set_epi64x(0x08090a0b0c0d0e0fULL, 0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL, 0x0001020304050607ULL); \
+	alignas(32) uint64 wk0[80]; \
+	alignas(32) uint64 wk1[80]; \
+	while (nblocks > 0) { \
+		/* with an odd number of blocks the last one is scheduled twice and the copy is ignored */ \
+		const uint8 * second = (nblocks > 1) ? data + 128 : data; \
+		__m256i x0, x1, x2, x3, x4, x5, x6, x7; \
+		SHA512_SIMD_LOAD(0, x0); SHA512_SIMD_LOAD(1, x1); SHA512_SIMD_LOAD(2, x2); SHA512_SIMD_LOAD(3, x3); \
+		SHA512_SIMD_LOAD(4, x4); SHA512_SIMD_LOAD(5, x5); SHA512_SIMD_LOAD(6, x6); SHA512_SIMD_LOAD(7, x7); \
+		for (int t = 16; t < 80; t += 16) { \
+			SHA512_SIMD_SCHED(ROR, t, x0, x1, x4, x5, x7); \
+			SHA512_SIMD_SCHED(ROR, t + 2, x1, x2, x5, x6, x0); \
+			SHA512_SIMD_SCHED(ROR, t + 4, x2, x3, x6, x7, x1); \
+			SHA512_SIMD_SCHED(ROR, t + 6, x3, x4, x7, x0, x2); \
+			SHA512_SIMD_SCHED(ROR, t + 8, x4, x5, x0, x1, x3); \
+			SHA512_SIMD_SCHED(ROR, t + 10, x5, x6, x1, x2, x4); \
+			SHA512_SIMD_SCHED(ROR, t + 12, x6, x7, x2, x3, x5); \
+			SHA512_SIMD_SCHED(ROR, t + 14, x7, x0, x3, x4, x6); \
+		} \
+		sha512_rounds(h, wk0); \
+		if (nblocks == 1) { \
+			break; \
+		} \
+		sha512_rounds(h, wk1); \
+		nblocks -= 2; \
+		data += 256; \
+	}
+
+#define SHA512_ROTR(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+// the 80 rounds with the message schedule already done
+static inline void sha512_rounds(uint64 h[8], const uint64 * wk) {
+	uint64 a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+	for (int j = 0; j < 80; j++) {
+		uint64 t1 = hh + (SHA512_ROTR(e, 14) ^ SHA512_ROTR(e, 18) ^ SHA512_ROTR(e, 41)) + ((e & f) ^ (~e & g)) + wk[j];
+		uint64 t2 = (SHA512_ROTR(a, 28) ^ SHA512_ROTR(a, 34) ^ SHA512_ROTR(a, 39)) + ((a & b) ^ (a & c) ^ (b & c));
+		hh = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+	h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+	h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+}
+
+DSL_HASH_TARGET("avx2,bmi2") void sha512_blocks_avx2(uint64 h[8], const uint8 * data, size_t nblocks) {
+	SHA512_SIMD_BLOCKS(SHA512_ROR_AVX2)
+}
+
+DSL_HASH_TARGET("avx512f,avx512vl,avx2,bmi2") void sha512_blocks_avx512(uint64 h[8], const uint8 * data, size_t nblocks) {
+	SHA512_SIMD_BLOCKS(SHA512_ROR_AVX512)
+}
+
+#endif // DSL_HASH_X86
+
+#if defined(DSL_HASH_ARM64)
+
+DSL_HASH_TARGET_ARM_CRYPTO void sha256_blocks_armv8(uint32 h[8], const uint8 * data, size_t nblocks) {
+	uint32x4_t state0 = vld1q_u32(&h[0]);
+	uint32x4_t state1 = vld1q_u32(&h[4]);
+
+	for (; nblocks > 0; nblocks--, data += 64) {
+		uint32x4_t save0 = state0;
+		uint32x4_t save1 = state1;
+		uint32x4_t m[4];
+		for (int i = 0; i < 4; i++) {
+			m[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + (i * 16))));
+		}
+
+		// 4 rounds per step, the message group 4 steps ahead replaces the current one
+		for (int i = 0; i < 16; i++) {
+			uint32x4_t wk = vaddq_u32(m[i & 3], vld1q_u32(&sha256_k[i * 4]));
+			if (i < 12) {
+				m[i & 3] = vsha256su1q_u32(vsha256su0q_u32(m[i & 3], m[(i + 1) & 3]), m[(i + 2) & 3], m[(i + 3) & 3]);
+			}
+			uint32x4_t abcd = state0;
+			state0 = vsha256hq_u32(state0, state1, wk);
+			state1 = vsha256h2q_u32(state1, abcd, wk);
+		}
+
+		state0 = vaddq_u32(state0, save0);
+		state1 = vaddq_u32(state1, save1);
+	}
+
+	vst1q_u32(&h[0], state0);
+	vst1q_u32(&h[4], state1);
+}
+
+DSL_HASH_TARGET_ARM_CRYPTO void sha1_blocks_armv8(uint32 h[5], const uint8 * data, size_t nblocks) {
+	static const uint32 k[4] = { 0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6 };
+	uint32x4_t abcd = vld1q_u32(h);
+	uint32 e0 = h[4];
+
+	for (; nblocks > 0; nblocks--, data += 64) {
+		uint32x4_t save_abcd = abcd;
+		uint32 e = e0;
+		uint32x4_t m[4];
+		for (int i = 0; i < 4; i++) {
+			m[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + (i * 16))));
+		}
+
+		for (int i = 0; i < 20; i++) {
+			uint32x4_t wk = vaddq_u32(m[i & 3], vdupq_n_u32(k[i / 5]));
+			if (i < 16) {
+				m[i & 3] = vsha1su1q_u32(vsha1su0q_u32(m[i & 3], m[(i + 1) & 3], m[(i + 2) & 3]), m[(i + 3) & 3]);
+			}
+			uint32 next_e = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+			if (i < 5) {
+				abcd = vsha1cq_u32(abcd, e, wk);
+			} else if (i >= 10 && i < 15) {
+				abcd = vsha1mq_u32(abcd, e, wk);
+			} else {
+				abcd = vsha1pq_u32(abcd, e, wk);
+			}
+			e = next_e;
+		}
+
+		abcd = vaddq_u32(abcd, save_abcd);
+		e0 += e;
+	}
+
+	vst1q_u32(h, abcd);
+	h[4] = e0;
+}
+
+#endif // DSL_HASH_ARM64
@@ -10,24 +10,227 @@
 
 #include <drift/dslcore.h>
 #include <drift/buffer.h>
+#include <drift/mmap.h>
+#include <drift/GenLib.h>
 
 #pragma warning(disable: 4244)
 
-static void buffer_grow(DSL_BUFFER * buf, int64 needed) {
-	if (needed <= buf->capacity) { return; }
+static void buffer_compact_int(DSL_BUFFER * buf) {
+	if (buf->head == 0) { return; }
+	char * base = buf->data - buf->head;
+	if (buf->len > 0) {
+		memmove(base, buf->data, buf->len);
+	}
+	buf->data = base;
+	buf->head = 0;
+}
+
+/* Spill-to-disk support */
+
+struct DSL_BUFFER_SPILL {
+	DSL_MMAP_OS_HANDLE fd;
+	DSL_MMAP_HANDLE * map;
+};
+
+static int64 buffer_spill_default_threshold = 0;
+static string buffer_spill_tmpdir;
+
+static bool buffer_spill_set_size(DSL_BUFFER_SPILL * sp, int64 size) {
+#ifdef WIN32
+	LARGE_INTEGER li;
+	li.QuadPart = size;
+	return (SetFilePointerEx(sp->fd, li, NULL, FILE_BEGIN) && SetEndOfFile(sp->fd));
+#else
+	return (ftruncate(sp->fd, size) == 0);
+#endif
+}
+
+static DSL_MMAP_HANDLE * buffer_spill_map(DSL_BUFFER_SPILL * sp, int64 size) {
+#ifdef WIN32
+	return dsl_map_handle(sp->fd, size, 0, DSL_MMAP_READ | DSL_MMAP_WRITE);
+#else
+	// dsl_unmap_file() closes the descriptor, so give each mapping its own
+	int fd = dup(sp->fd);
+	if (fd == -1) {
+		return NULL;
+	}
+	DSL_MMAP_HANDLE * ret = dsl_map_handle(fd, size, 0, DSL_MMAP_READ | DSL_MMAP_WRITE | DSL_MMAP_CLOSE);
+	if (ret == NULL) {
+		close(fd);
+	}
+	return ret;
+#endif
+}
+
+static void buffer_spill_close(DSL_BUFFER * buf) {
+	DSL_BUFFER_SPILL * sp = buf->spill;
+	if (sp->map) {
+		dsl_unmap_file(sp->map);
+	}
+#ifdef WIN32
+	CloseHandle(sp->fd);
+#else
+	close(sp->fd);
+#endif
+	dsl_free(sp);
+	buf->spill = NULL;
+	buf->flags &= ~DSL_BUFFER_FLAG_SPILLED;
+}
+
+static bool buffer_spill_open(DSL_BUFFER * buf) {
+	DSL_BUFFER_SPILL * sp = dsl_znew(DSL_BUFFER_SPILL);
+#ifdef WIN32
+	char dir[MAX_PATH], fn[MAX_PATH];
+	if (buffer_spill_tmpdir.length()) {
+		sstrcpy(dir, buffer_spill_tmpdir.c_str());
+	} else if (GetTempPathA(sizeof(dir), dir) == 0) {
+		dsl_free(sp);
+		return false;
+	}
+	if (GetTempFileNameA(dir, "dsl", 0, fn) == 0) {
+		dsl_free(sp);
+		return false;
+	}
+	sp->fd = CreateFileA(fn, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+	if (sp->fd == INVALID_HANDLE_VALUE) {
+		DeleteFileA(fn);
+		dsl_free(sp);
+		return false;
+	}
+#else
+	string fn = buffer_spill_tmpdir;
+	if (fn.length() == 0) {
+		const char * p = getenv("TMPDIR");
+		fn = (p != NULL && *p) ? p : "/tmp";
+	}
+	fn += "/dsl_buffer_XXXXXX";
+	char * tmp = dsl_strdup(fn.c_str());
+	sp->fd = mkstemp(tmp);
+	if (sp->fd == -1) {
+		dsl_free(tmp);
+		dsl_free(sp);
+		return false;
+	}
+	// nobody else needs to see it and it goes away by itself when we close it (or crash)
+	unlink(tmp);
+	dsl_free(tmp);
+#endif
+	buf->spill = sp;
+	buf->flags |= DSL_BUFFER_FLAG_SPILLED;
+	return true;
+}
+
+static bool buffer_spill_grow(DSL_BUFFER * buf, int64 newcap) {
+	// data has already been compacted, so only the first len bytes matter
+	DSL_BUFFER_SPILL * sp = buf->spill;
+	if (!buffer_spill_set_size(sp, newcap)) {
+		return false;
+	}
+	DSL_MMAP_HANDLE * map = buffer_spill_map(sp, newcap);
+	if (map == NULL) {
+		return false;
+	}
+	if (sp->map) {
+		dsl_unmap_file(sp->map);
+	}
+	sp->map = map;
+	buf->data = (char *)map->data;
+	buf->capacity = newcap;
+	return true;
+}
+
+static bool buffer_spill(DSL_BUFFER * buf, int64 newcap) {
+	if (!buffer_spill_open(buf)) {
+		return false;
+	}
+	if (!buffer_spill_grow(buf, newcap)) {
+		buffer_spill_close(buf);
+		return false;
+	}
+	return true;
+}
+
+static bool buffer_grow(DSL_BUFFER * buf, int64 needed) {
+	if (buf->head + needed <= buf->capacity) { return true; }
+	/*
+	 Only compact in place when the consumed space is at least as large as the data we have to move,
+	 that way each byte is moved at most once per byte consumed and streaming use stays linear.
+	*/
+	if (needed <= buf->capacity && buf->head >= buf->len) {
+		buffer_compact_int(buf);
+		return true;
+	}
+	buffer_compact_int(buf);
 	int64 newcap = buf->capacity ? buf->capacity : 64;
 	while (newcap < needed) { newcap *= 2; }
-	buf->data = (char *)dsl_realloc(buf->data, newcap);
+	if (newcap == buf->capacity) { newcap *= 2; } // the consumed space alone wasn't worth reclaiming
+
+	if (buf->flags & DSL_BUFFER_FLAG_SPILLED) {
+		return buffer_spill_grow(buf, newcap);
+	}
+	if (buf->spill_threshold > 0 && newcap > buf->spill_threshold) {
+		// move to a temp file, if that fails for some reason just keep going in RAM
+		char * old = buf->data;
+		bool was_inline = (buf->flags & DSL_BUFFER_FLAG_INLINE) != 0;
+		if (buffer_spill(buf, newcap)) {
+			if (buf->len > 0) {
+				memcpy(buf->data, old, buf->len);
+			}
+			if (old && !was_inline) {
+				dsl_free(old);
+			}
+			buf->flags &= ~DSL_BUFFER_FLAG_INLINE;
+			return true;
+		}
+	}
+
+	char * ptr;
+	if (buf->flags & DSL_BUFFER_FLAG_INLINE) {
+		// outgrew the caller's storage, move to the heap
+		ptr = (char *)dsl_malloc(newcap);
+		if (ptr == NULL) { return false; }
+		if (buf->len > 0) {
+			memcpy(ptr, buf->data, buf->len);
+		}
+		buf->flags &= ~DSL_BUFFER_FLAG_INLINE;
+	} else {
+		ptr = (char *)dsl_realloc(buf->data, newcap);
+		if (ptr == NULL) { return false; }
+	}
+	buf->data = ptr;
 	buf->capacity = newcap;
+	return true;
 }
 
 void DSL_CC buffer_init(DSL_BUFFER * buf, bool useMutex) {
 	memset(buf, 0, sizeof(DSL_BUFFER));
+	buf->spill_threshold = buffer_spill_default_threshold;
 	if (useMutex) { buf->hMutex = new DSL_Mutex(); }
 }
 
+void DSL_CC buffer_init_spill(DSL_BUFFER * buf, int64 threshold, bool useMutex) {
+	buffer_init(buf, useMutex);
+	buf->spill_threshold = threshold;
+}
+
+void DSL_CC buffer_set_spill_defaults(int64 threshold, const char * tmpdir) {
+	buffer_spill_default_threshold = threshold;
+	buffer_spill_tmpdir = (tmpdir != NULL) ? tmpdir : "";
+}
+
+void DSL_CC buffer_init_inline(DSL_BUFFER * buf, void * storage, int64 size) {
+	memset(buf, 0, sizeof(DSL_BUFFER));
+	buf->data = (char *)storage;
+	buf->capacity = size;
+	buf->flags = DSL_BUFFER_FLAG_INLINE;
+}
+
 void DSL_CC buffer_free(DSL_BUFFER * buf) {
-	dsl_freenn(buf->data);
+	if (buf->flags & DSL_BUFFER_FLAG_SPILLED) {
+		buffer_spill_close(buf);
+	} else if (buf->data && !(buf->flags & DSL_BUFFER_FLAG_INLINE)) {
+		dsl_free(buf->data - buf->head);
+	}
 	if (buf->hMutex) { delete buf->hMutex; }
 	memset(buf, 0xFE, sizeof(DSL_BUFFER));
 }
@@ -45,7 +248,15 @@ string buffer_as_string(DSL_BUFFER * buf) {
 void DSL_CC buffer_clear(DSL_BUFFER * buf, bool force_free) {
 	if (buf->hMutex) { buf->hMutex->Lock(); }
 	buf->len = 0;
-	if (force_free) {
+	if (buf->data) {
+		buf->data -= buf->head;
+	}
+	buf->head = 0;
+	if (force_free && (buf->flags & DSL_BUFFER_FLAG_SPILLED)) {
+		buffer_spill_close(buf);
+		buf->capacity = 0;
+		buf->data = NULL;
+	} else if (force_free && !(buf->flags & DSL_BUFFER_FLAG_INLINE)) {
 		dsl_freenn(buf->data);
 		buf->capacity = 0;
 		buf->data = NULL;
@@ -55,16 +266,28 @@ void DSL_CC buffer_clear(DSL_BUFFER * buf, bool force_free) {
 
 void DSL_CC buffer_set(DSL_BUFFER * buf, const char * ptr, int64 len) {
 	if (buf->hMutex) { buf->hMutex->Lock(); }
-	buffer_grow(buf, len);
-	memcpy(buf->data, ptr, len);
-	buf->len = len;
+	buf->len = 0;
+	buffer_compact_int(buf);
+	if (buffer_grow(buf, len)) {
+		memcpy(buf->data, ptr, len);
+		buf->len = len;
+	}
 	if (buf->hMutex) { buf->hMutex->Release(); }
 }
 
-void DSL_CC buffer_resize(DSL_BUFFER * buf, int64 len) {
+bool DSL_CC buffer_resize(DSL_BUFFER * buf, int64 len) {
+	if (buf->hMutex) { buf->hMutex->Lock(); }
+	bool ret = buffer_grow(buf, len);
+	if (ret) {
+		buf->len = len;
+	}
+	if (buf->hMutex) { buf->hMutex->Release(); }
+	return ret;
+}
+
+void DSL_CC buffer_compact(DSL_BUFFER * buf) {
 	if (buf->hMutex) { buf->hMutex->Lock(); }
-	buffer_grow(buf, len);
-	buf->len = len;
+	buffer_compact_int(buf);
 	if (buf->hMutex) { buf->hMutex->Release(); }
 }
 
@@ -72,10 +295,13 @@ void DSL_CC buffer_remove_front(DSL_BUFFER * buf, int64 len) {
 	if (len <= 0) { return; }
 	if (buf->hMutex) { buf->hMutex->Lock(); }
 	if (len >= buf->len) {
+		// nothing left, rewind to the start of the allocation for free
 		buf->len = 0;
+		buffer_compact_int(buf);
 	} else {
 		buf->len -= len;
-		memmove(buf->data, buf->data + len, buf->len);
+		buf->data += len;
+		buf->head += len;
 	}
 	if (buf->hMutex) { buf->hMutex->Release(); }
 }
@@ -93,8 +319,17 @@ bool DSL_CC buffer_prepend(DSL_BUFFER * buf, const char * ptr, int64 len) {
 	if (len <= 0) { return true; }
 	if (buf->hMutex) { buf->hMutex->Lock(); }
 
-	buffer_grow(buf, buf->len + len);
-	memmove(buf->data + len, buf->data, buf->len);
+	if (buf->head >= len) {
+		buf->data -= len;
+		buf->head -= len;
+	} else {
+		if (!buffer_grow(buf, buf->len + len)) {
+			if (buf->hMutex) { buf->hMutex->Release(); }
+			return false;
+		}
+		buffer_compact_int(buf);
+		memmove(buf->data + len, buf->data, buf->len);
+	}
 	memcpy(buf->data, ptr, len);
 	buf->len += len;
 
@@ -105,10 +340,77 @@ bool DSL_CC buffer_append(DSL_BUFFER * buf, const char * ptr, int64 len) {
 	if (len <= 0) { return true; }
 	if (buf->hMutex) { buf->hMutex->Lock(); }
 
-	buffer_grow(buf, buf->len + len);
+	if (!buffer_grow(buf, buf->len + len)) {
+		if (buf->hMutex) { buf->hMutex->Release(); }
+		return false;
+	}
 	memcpy(buf->data + buf->len, ptr, len);
 	buf->len += len;
 
 	if (buf->hMutex) { buf->hMutex->Release(); }
 	return true;
 }
+
+/* Thread-local buffer pool */
+
+#define DSL_BUFFER_POOL_MIN_SHIFT 6 // 64 bytes, the same as the smallest buffer_grow() allocation
+#define DSL_BUFFER_POOL_CLASSES 15 // up to 1MB
+#define DSL_BUFFER_POOL_MAX_PER_CLASS 8
+
+class DSL_BufferPool {
+public:
+	DSL_BUFFER * bufs[DSL_BUFFER_POOL_CLASSES][DSL_BUFFER_POOL_MAX_PER_CLASS];
+	int count[DSL_BUFFER_POOL_CLASSES] = { 0 };
+
+	void Trim() {
+		for (int i = 0; i < DSL_BUFFER_POOL_CLASSES; i++) {
+			while (count[i] > 0) {
+				DSL_BUFFER * buf = bufs[i][--count[i]];
+				buffer_free(buf);
+				dsl_free(buf);
+			}
+		}
+	}
+	~DSL_BufferPool() {
+		Trim();
+	}
+};
+
+static thread_local DSL_BufferPool buffer_pool;
+
+DSL_BUFFER * DSL_CC buffer_acquire(int64 capacity) {
+	// smallest class that is guaranteed to hold capacity
+	int cls = 0;
+	while (cls < DSL_BUFFER_POOL_CLASSES && (int64(1) << (cls + DSL_BUFFER_POOL_MIN_SHIFT)) < capacity) { cls++; }
+	for (int i = cls; i < DSL_BUFFER_POOL_CLASSES && i <= cls + 1; i++) {
+		if (buffer_pool.count[i] > 0) {
+			return buffer_pool.bufs[i][--buffer_pool.count[i]];
+		}
+	}
+
+	DSL_BUFFER * ret = dsl_new(DSL_BUFFER);
+	buffer_init(ret);
+	if (capacity > 0) {
+		buffer_grow(ret, (cls < DSL_BUFFER_POOL_CLASSES) ? (int64(1) << (cls + DSL_BUFFER_POOL_MIN_SHIFT)) : capacity);
+	}
+	return ret;
+}
+
+void DSL_CC buffer_release(DSL_BUFFER * buf) {
+	if (buf->hMutex == NULL && !(buf->flags & (DSL_BUFFER_FLAG_INLINE | DSL_BUFFER_FLAG_SPILLED)) && buf->capacity >= (int64(1) << DSL_BUFFER_POOL_MIN_SHIFT)) {
+		// largest class the buffer fully covers
+		int cls = 0;
+		while (cls + 1 < DSL_BUFFER_POOL_CLASSES && (int64(1) << (cls + 1 + DSL_BUFFER_POOL_MIN_SHIFT)) <= buf->capacity) { cls++; }
+		if (buf->capacity < (int64(1) << (DSL_BUFFER_POOL_CLASSES + DSL_BUFFER_POOL_MIN_SHIFT)) && buffer_pool.count[cls] < DSL_BUFFER_POOL_MAX_PER_CLASS) {
+			buffer_clear(buf);
+			buffer_pool.bufs[cls][buffer_pool.count[cls]++] = buf;
+			return;
+		}
+	}
+	buffer_free(buf);
+	dsl_free(buf);
+}
+
+void DSL_CC buffer_pool_trim() {
+	buffer_pool.Trim();
+}
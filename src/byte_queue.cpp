@@ -0,0 +1,192 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+#include <drift/dslcore.h>
+#include <drift/byte_queue.h>
+#include <drift/GenLib.h>
+#include <thread>
+
+size_t DSL_ByteQueue_Reservation::Write(const void * pdata, size_t plen) {
+	const uint8 * p = (const uint8 *)pdata;
+	size_t ret = 0;
+	while (plen > 0 && written < size) {
+		size_t off = written;
+		int part = 0;
+		if (off >= len[0]) {
+			off -= len[0];
+			part = 1;
+		}
+		size_t n = len[part] - off;
+		if (n > plen) { n = plen; }
+		memcpy(ptr[part] + off, p, n);
+		p += n;
+		plen -= n;
+		written += n;
+		ret += n;
+	}
+	return ret;
+}
+
+DSL_ByteQueue::DSL_ByteQueue(size_t pcapacity, bool pmulti_producer) {
+	capacity = 64;
+	while (capacity < pcapacity) { capacity <<= 1; }
+	mask = capacity - 1;
+	multi_producer = pmulti_producer;
+	data = (uint8 *)dsl_malloc(capacity);
+	reserved = 0;
+	committed = 0;
+	head = 0;
+}
+
+DSL_ByteQueue::~DSL_ByteQueue() {
+	dsl_free(data);
+}
+
+template <typename T> bool DSL_ByteQueue::wait_for(DSL_EventCount& ev, int timeout, T cond) {
+	if (cond()) { return true; }
+	if (timeout == 0) { return false; }
+	uint64 end = (timeout > 0) ? GetTickCount64() + timeout : 0;
+	while (1) {
+		uint32 key = ev.PrepareWait();
+		if (cond()) {
+			ev.CancelWait();
+			return true;
+		}
+		int left = -1;
+		if (timeout > 0) {
+			uint64 now = GetTickCount64();
+			if (now >= end) {
+				ev.CancelWait();
+				return false;
+			}
+			left = (int)(end - now);
+		}
+		ev.Wait(key, left);
+	}
+}
+
+bool DSL_ByteQueue::Reserve(size_t len, DSL_ByteQueue_Reservation * res, int timeout) {
+	if (len > capacity) { return false; }
+
+	uint64 start;
+	if (multi_producer) {
+		start = reserved.load(memory_order_relaxed);
+		while (1) {
+			if (start + len - head.load(memory_order_acquire) <= capacity) {
+				if (reserved.compare_exchange_weak(start, start + len, memory_order_acq_rel, memory_order_relaxed)) {
+					break;
+				}
+				continue;
+			}
+			if (!wait_for(space_event, timeout, [&] { start = reserved.load(memory_order_relaxed); return start + len - head.load(memory_order_acquire) <= capacity; })) {
+				return false;
+			}
+		}
+	} else {
+		start = reserved.load(memory_order_relaxed);
+		if (!wait_for(space_event, timeout, [&] { return start + len - head.load(memory_order_acquire) <= capacity; })) {
+			return false;
+		}
+		reserved.store(start + len, memory_order_relaxed);
+	}
+
+	size_t off = start & mask;
+	res->start = start;
+	res->size = len;
+	res->written = 0;
+	res->ptr[0] = data + off;
+	res->len[0] = (off + len > capacity) ? capacity - off : len;
+	res->ptr[1] = data;
+	res->len[1] = len - res->len[0];
+	return true;
+}
+
+void DSL_ByteQueue::Commit(DSL_ByteQueue_Reservation * res) {
+	if (res->written < res->size) {
+		static const uint8 zeroes[256] = { 0 };
+		while (res->written < res->size) {
+			size_t n = res->size - res->written;
+			res->Write(zeroes, (n > sizeof(zeroes)) ? sizeof(zeroes) : n);
+		}
+	}
+	if (multi_producer) {
+		// commits have to be in reservation order so the consumer never sees a hole
+		int spins = 0;
+		while (committed.load(memory_order_acquire) != res->start) {
+			if (++spins >= 64) {
+				this_thread::yield();
+				spins = 0;
+			}
+		}
+	}
+	committed.store(res->start + res->size, memory_order_release);
+	data_event.Notify();
+}
+
+bool DSL_ByteQueue::Append(const void * ptr, size_t len, int timeout) {
+	if (len == 0) { return true; }
+	DSL_ByteQueue_Reservation res;
+	if (!Reserve(len, &res, timeout)) {
+		return false;
+	}
+	res.Write(ptr, len);
+	Commit(&res);
+	return true;
+}
+
+bool DSL_ByteQueue::WaitForSpace(size_t len, int timeout) {
+	if (len > capacity) { return false; }
+	return wait_for(space_event, timeout, [&] { return reserved.load(memory_order_relaxed) + len - head.load(memory_order_acquire) <= capacity; });
+}
+
+size_t DSL_ByteQueue::Length() {
+	return committed.load(memory_order_acquire) - head.load(memory_order_relaxed);
+}
+
+size_t DSL_ByteQueue::Peek(void * buf, size_t len, size_t offset) {
+	size_t avail = Length();
+	if (offset >= avail) { return 0; }
+	avail -= offset;
+	if (len > avail) { len = avail; }
+	size_t off = (head.load(memory_order_relaxed) + offset) & mask;
+	size_t n = capacity - off;
+	if (n > len) { n = len; }
+	memcpy(buf, data + off, n);
+	if (n < len) {
+		memcpy((uint8 *)buf + n, data, len - n);
+	}
+	return len;
+}
+
+size_t DSL_ByteQueue::Read(void * buf, size_t len) {
+	size_t ret = Peek(buf, len);
+	Consume(ret);
+	return ret;
+}
+
+size_t DSL_ByteQueue::GetReadPtr(const uint8 ** ptr) {
+	size_t avail = Length();
+	size_t off = head.load(memory_order_relaxed) & mask;
+	*ptr = data + off;
+	return (off + avail > capacity) ? capacity - off : avail;
+}
+
+void DSL_ByteQueue::Consume(size_t len) {
+	size_t avail = Length();
+	if (len > avail) { len = avail; }
+	if (len == 0) { return; }
+	head.store(head.load(memory_order_relaxed) + len, memory_order_release);
+	space_event.Notify();
+}
+
+bool DSL_ByteQueue::WaitForData(size_t len, int timeout) {
+	if (len > capacity) { return false; }
+	return wait_for(data_event, timeout, [&] { return Length() >= len; });
+}
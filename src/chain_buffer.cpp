@@ -0,0 +1,427 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+#include <drift/dslcore.h>
+#include <drift/chain_buffer.h>
+
+#pragma warning(disable: 4244)
+
+static DSL_CHAIN_SEGMENT * chain_segment_new(int64 capacity) {
+	// owned segments keep their data right after the header so they only take one allocation
+	DSL_CHAIN_SEGMENT * seg = (DSL_CHAIN_SEGMENT *)dsl_malloc(sizeof(DSL_CHAIN_SEGMENT) + capacity);
+	memset(seg, 0, sizeof(DSL_CHAIN_SEGMENT));
+	seg->base = seg->data = (uint8 *)(seg + 1);
+	seg->capacity = capacity;
+	seg->owned = true;
+	return seg;
+}
+
+static DSL_CHAIN_SEGMENT * chain_segment_new_ref(const void * ptr, int64 len, chain_buffer_release_func release, void * user_ptr) {
+	DSL_CHAIN_SEGMENT * seg = dsl_znew(DSL_CHAIN_SEGMENT);
+	seg->base = seg->data = (uint8 *)ptr;
+	seg->len = seg->capacity = len;
+	seg->release = release;
+	seg->release_ptr = (void *)ptr;
+	seg->release_len = len;
+	seg->user_ptr = user_ptr;
+	return seg;
+}
+
+static void chain_segment_free(DSL_CHAIN_SEGMENT * seg) {
+	if (seg->release) {
+		seg->release(seg->release_ptr, seg->release_len, seg->user_ptr);
+	}
+	dsl_free(seg);
+}
+
+static void chain_release_dsl_free(void * ptr, int64 len, void * user_ptr) {
+	dsl_free(ptr);
+}
+
+static void chain_link_back(DSL_CHAIN_BUFFER * buf, DSL_CHAIN_SEGMENT * seg) {
+	seg->next = NULL;
+	seg->prev = buf->last;
+	if (buf->last) {
+		buf->last->next = seg;
+	} else {
+		buf->first = seg;
+	}
+	buf->last = seg;
+	buf->len += seg->len;
+	buf->num_segments++;
+}
+
+static void chain_link_front(DSL_CHAIN_BUFFER * buf, DSL_CHAIN_SEGMENT * seg) {
+	seg->prev = NULL;
+	seg->next = buf->first;
+	if (buf->first) {
+		buf->first->prev = seg;
+	} else {
+		buf->last = seg;
+	}
+	buf->first = seg;
+	buf->len += seg->len;
+	buf->num_segments++;
+}
+
+static void chain_buffer_clear_int(DSL_CHAIN_BUFFER * buf) {
+	DSL_CHAIN_SEGMENT * seg = buf->first;
+	while (seg != NULL) {
+		DSL_CHAIN_SEGMENT * next = seg->next;
+		chain_segment_free(seg);
+		seg = next;
+	}
+	buf->first = buf->last = NULL;
+	buf->len = 0;
+	buf->num_segments = 0;
+}
+
+static void chain_buffer_remove_front_int(DSL_CHAIN_BUFFER * buf, int64 len) {
+	while (len > 0 && buf->first != NULL) {
+		DSL_CHAIN_SEGMENT * seg = buf->first;
+		if (len < seg->len) {
+			seg->data += len;
+			seg->len -= len;
+			buf->len -= len;
+			return;
+		}
+		len -= seg->len;
+		buf->len -= seg->len;
+		buf->first = seg->next;
+		if (buf->first) {
+			buf->first->prev = NULL;
+		} else {
+			buf->last = NULL;
+		}
+		buf->num_segments--;
+		chain_segment_free(seg);
+	}
+}
+
+static int64 chain_buffer_peek_int(DSL_CHAIN_BUFFER * buf, void * dst, int64 len, int64 offset) {
+	int64 ret = 0;
+	uint8 * p = (uint8 *)dst;
+	for (DSL_CHAIN_SEGMENT * seg = buf->first; seg != NULL && len > 0; seg = seg->next) {
+		if (offset >= seg->len) {
+			offset -= seg->len;
+			continue;
+		}
+		int64 n = seg->len - offset;
+		if (n > len) { n = len; }
+		memcpy(p, seg->data + offset, n);
+		offset = 0;
+		p += n;
+		len -= n;
+		ret += n;
+	}
+	return ret;
+}
+
+void DSL_CC chain_buffer_init(DSL_CHAIN_BUFFER * buf, int64 segment_size, bool useMutex) {
+	memset(buf, 0, sizeof(DSL_CHAIN_BUFFER));
+	buf->segment_size = (segment_size > 0) ? segment_size : DSL_CHAIN_BUFFER_DEFAULT_SEGMENT_SIZE;
+	if (useMutex) { buf->hMutex = new DSL_Mutex(); }
+}
+
+void DSL_CC chain_buffer_free(DSL_CHAIN_BUFFER * buf) {
+	chain_buffer_clear_int(buf);
+	if (buf->hMutex) { delete buf->hMutex; }
+	memset(buf, 0xFE, sizeof(DSL_CHAIN_BUFFER));
+}
+
+void DSL_CC chain_buffer_clear(DSL_CHAIN_BUFFER * buf) {
+	if (buf->hMutex) { buf->hMutex->Lock(); }
+	chain_buffer_clear_int(buf);
+	if (buf->hMutex) { buf->hMutex->Release(); }
+}
+
+string chain_buffer_as_string(DSL_CHAIN_BUFFER * buf) {
+	string ret;
+	if (buf->hMutex) { buf->hMutex->Lock(); }
+	ret.reserve(buf->len);
+	for (DSL_CHAIN_SEGMENT * seg = buf->first; seg != NULL; seg = seg->next) {
+		ret.append((const char *)seg->data, seg->len);
+	}
+	if (buf->hMutex) { buf->hMutex->Release(); }
+	return ret;
+}
+
+bool DSL_CC chain_buffer_append(DSL_CHAIN_BUFFER * buf, const char * ptr, int64 len) {
+	if (len <= 0) { return true; }
+	if (buf->hMutex) { buf->hMutex->Lock(); }
+
+	DSL_CHAIN_SEGMENT * seg = buf->last;
+	if (seg != NULL && seg->owned) {
+		int64 avail = seg->capacity - ((seg->data - seg->base) + seg->len);
+		if (avail > 0) {
+			if (avail > len) { avail = len; }
+			memcpy(seg->data + seg->len, ptr, avail);
+			seg->len += avail;
+			buf->len += avail;
+			ptr += avail;
+			len -= avail;
+		}
+	}
+	if (len > 0) {
+		// whatever is left goes in one new segment, big writes don't need to be split up
+		seg = chain_segment_new((len > buf->segment_size) ? len : buf->segment_size);
+		memcpy(seg->data, ptr, len);
+		seg->len = len;
+		chain_link_back(buf, seg);
+	}
+
+	if (buf->hMutex) { buf->hMutex->Release(); }
+	return true;
+}
+
+bool DSL_CC chain_buffer_prepend(DSL_CHAIN_BUFFER * buf, const char * ptr, int64 len) {
+	if (len <= 0) { return true; }
+	if (buf->hMutex) { buf->hMutex->Lock(); }
+
+	DSL_CHAIN_SEGMENT * seg = buf->first;
+	if (seg != NULL && seg->owned && (seg->data - seg->base) >= len) {
+		seg->data -= len;
+		seg->len += len;
+		buf->len += len;
+		memcpy(seg->data, ptr, len);
+	} else {
+		// put the data at the end of the new segment so further prepends have room
+		int64 cap = (len > buf->segment_size) ? len : buf->segment_size;
+		seg = chain_segment_new(cap);
+		seg->data = seg->base + (cap - len);
+		memcpy(seg->data, ptr, len);
+		seg->len = len;
+		chain_link_front(buf, seg);
+	}
+
+	if (buf->hMutex) { buf->hMutex->Release(); }
+	return true;
+}
+
+bool DSL_CC chain_buffer_append_ref(DSL_CHAIN_BUFFER * buf, const void * ptr, int64 len, chain_buffer_release_func release, void * user_ptr) {
+	if (len <= 0) {
+		if (release) { release((void *)ptr, len, user_ptr); }
+		return true;
+	}
+	DSL_CHAIN_SEGMENT * seg = chain_segment_new_ref(ptr, len, release, user_ptr);
+	if (buf->hMutex) { buf->hMutex->Lock(); }
+	chain_link_back(buf, seg);
+	if (buf->hMutex) { buf->hMutex->Release(); }
+	return true;
+}
+
+bool DSL_CC chain_buffer_prepend_ref(DSL_CHAIN_BUFFER * buf, const void * ptr, int64 len, chain_buffer_release_func release, void * user_ptr) {
+	if (len <= 0) {
+		if (release) { release((void *)ptr, len, user_ptr); }
+		return true;
+	}
+	DSL_CHAIN_SEGMENT * seg = chain_segment_new_ref(ptr, len, release, user_ptr);
+	if (buf->hMutex) { buf->hMutex->Lock(); }
+	chain_link_front(buf, seg);
+	if (buf->hMutex) { buf->hMutex->Release(); }
+	return true;
+}
+
+bool DSL_CC chain_buffer_append_buffer(DSL_CHAIN_BUFFER * buf, DSL_BUFFER * src) {
+	if (src->hMutex) { src->hMutex->Lock(); }
+	if (src->len <= 0) {
+		if (src->hMutex) { src->hMutex->Release(); }
+		return true;
+	}
+
+	if (src->flags & (DSL_BUFFER_FLAG_INLINE | DSL_BUFFER_FLAG_SPILLED)) {
+		// caller-owned storage or a file mapping, we can't take it so copy it instead
+		bool ret = chain_buffer_append(buf, src->data, src->len);
+		src->len = 0;
+		src->data -= src->head;
+		src->head = 0;
+		if (src->hMutex) { src->hMutex->Release(); }
+		return ret;
+	}
+
+	// the DSL_BUFFER memory came from dsl_malloc so the chain can own it and keep appending into the unused space
+	char * base = src->data - src->head;
+	DSL_CHAIN_SEGMENT * seg = chain_segment_new_ref(base, src->capacity, chain_release_dsl_free, NULL);
+	seg->data = (uint8 *)src->data;
+	seg->len = src->len;
+	seg->owned = true;
+	src->data = NULL;
+	src->len = src->capacity = src->head = 0;
+	if (src->hMutex) { src->hMutex->Release(); }
+
+	if (buf->hMutex) { buf->hMutex->Lock(); }
+	chain_link_back(buf, seg);
+	if (buf->hMutex) { buf->hMutex->Release(); }
+	return true;
+}
+
+void DSL_CC chain_buffer_append_chain(DSL_CHAIN_BUFFER * buf, DSL_CHAIN_BUFFER * src) {
+	// detach the segments from src first and then attach them to buf, so the two locks are never held together and threads appending in opposite directions can't deadlock
+	if (src->hMutex) { src->hMutex->Lock(); }
+	DSL_CHAIN_SEGMENT * first = src->first;
+	DSL_CHAIN_SEGMENT * last = src->last;
+	int64 len = src->len;
+	uint32 num_segments = src->num_segments;
+	src->first = src->last = NULL;
+	src->len = 0;
+	src->num_segments = 0;
+	if (src->hMutex) { src->hMutex->Release(); }
+	if (first == NULL) {
+		return;
+	}
+
+	if (buf->hMutex) { buf->hMutex->Lock(); }
+	first->prev = buf->last;
+	if (buf->last) {
+		buf->last->next = first;
+	} else {
+		buf->first = first;
+	}
+	buf->last = last;
+	buf->len += len;
+	buf->num_segments += num_segments;
+	if (buf->hMutex) { buf->hMutex->Release(); }
+}
+
+int64 DSL_CC chain_buffer_peek(DSL_CHAIN_BUFFER * buf, void * dst, int64 len, int64 offset) {
+	if (len <= 0 || offset < 0) { return 0; }
+	if (buf->hMutex) { buf->hMutex->Lock(); }
+	int64 ret = chain_buffer_peek_int(buf, dst, len, offset);
+	if (buf->hMutex) { buf->hMutex->Release(); }
+	return ret;
+}
+
+int64 DSL_CC chain_buffer_read(DSL_CHAIN_BUFFER * buf, void * dst, int64 len) {
+	if (len <= 0) { return 0; }
+	if (buf->hMutex) { buf->hMutex->Lock(); }
+	int64 ret = chain_buffer_peek_int(buf, dst, len, 0);
+	chain_buffer_remove_front_int(buf, ret);
+	if (buf->hMutex) { buf->hMutex->Release(); }
+	return ret;
+}
+
+void DSL_CC chain_buffer_remove_front(DSL_CHAIN_BUFFER * buf, int64 len) {
+	if (len <= 0) { return; }
+	if (buf->hMutex) { buf->hMutex->Lock(); }
+	chain_buffer_remove_front_int(buf, len);
+	if (buf->hMutex) { buf->hMutex->Release(); }
+}
+
+bool DSL_CC chain_buffer_to_buffer(DSL_CHAIN_BUFFER * buf, DSL_BUFFER * dst, int64 len) {
+	bool ret = true;
+	if (buf->hMutex) { buf->hMutex->Lock(); }
+	if (len < 0 || len > buf->len) { len = buf->len; }
+	for (DSL_CHAIN_SEGMENT * seg = buf->first; seg != NULL && len > 0 && ret; seg = seg->next) {
+		int64 n = (seg->len > len) ? len : seg->len;
+		ret = buffer_append(dst, (const char *)seg->data, n);
+		len -= n;
+	}
+	if (buf->hMutex) { buf->hMutex->Release(); }
+	return ret;
+}
+
+int DSL_CC chain_buffer_get_iovec(DSL_CHAIN_BUFFER * buf, DSL_IOVEC * iov, int max_iov, int64 max_bytes) {
+	int ret = 0;
+	if (buf->hMutex) { buf->hMutex->Lock(); }
+	for (DSL_CHAIN_SEGMENT * seg = buf->first; seg != NULL && ret < max_iov && max_bytes != 0; seg = seg->next) {
+		int64 n = seg->len;
+		if (max_bytes > 0 && n > max_bytes) { n = max_bytes; }
+#if defined(WIN32)
+		if (n > ULONG_MAX) { n = ULONG_MAX; }
+		iov[ret].buf = (CHAR *)seg->data;
+		iov[ret].len = (ULONG)n;
+#else
+		iov[ret].iov_base = seg->data;
+		iov[ret].iov_len = n;
+#endif
+		if (max_bytes > 0) { max_bytes -= n; }
+		ret++;
+	}
+	if (buf->hMutex) { buf->hMutex->Release(); }
+	return ret;
+}
+
+struct TP_CHAINHANDLE {
+	DSL_FILE _handle;
+	DSL_CHAIN_BUFFER * buf;
+	bool bFree;
+	int64 offset;
+};
+
+static int64 chain_read(void * buf, int64 size, DSL_FILE * fp) {
+	TP_CHAINHANDLE * h = (TP_CHAINHANDLE *)fp;
+	int64 n = chain_buffer_read(h->buf, buf, size);
+	h->offset += n;
+	return n;
+}
+
+static int64 chain_write(void * buf, int64 size, DSL_FILE * fp) {
+	TP_CHAINHANDLE * h = (TP_CHAINHANDLE *)fp;
+	if (size <= 0) { return 0; }
+	if (!chain_buffer_append(h->buf, (const char *)buf, size)) {
+		return -1;
+	}
+	return size;
+}
+
+static bool chain_seek(DSL_FILE * fp, int64 pos, int mode) {
+	TP_CHAINHANDLE * h = (TP_CHAINHANDLE *)fp;
+	if (mode == SEEK_SET && pos >= h->offset) {
+		pos -= h->offset;
+	} else if (mode != SEEK_CUR || pos < 0) {
+		return false;
+	}
+	if (h->buf->hMutex) { h->buf->hMutex->Lock(); }
+	if (pos > h->buf->len) { pos = h->buf->len; }
+	chain_buffer_remove_front_int(h->buf, pos);
+	if (h->buf->hMutex) { h->buf->hMutex->Release(); }
+	h->offset += pos;
+	return true;
+}
+
+static int64 chain_tell(DSL_FILE * fp) {
+	TP_CHAINHANDLE * h = (TP_CHAINHANDLE *)fp;
+	return h->offset;
+}
+
+static bool chain_eof(DSL_FILE * fp) {
+	TP_CHAINHANDLE * h = (TP_CHAINHANDLE *)fp;
+	return (h->buf->len <= 0);
+}
+
+static bool chain_flush(DSL_FILE * fp) {
+	return true;
+}
+
+static void chain_close(DSL_FILE * fp) {
+	TP_CHAINHANDLE * h = (TP_CHAINHANDLE *)fp;
+	if (h->bFree) {
+		chain_buffer_free(h->buf);
+	}
+	dsl_free(fp);
+}
+
+DSL_FILE * DSL_CC RW_ConvertChainBuffer(DSL_CHAIN_BUFFER * buf, bool autofree) {
+	TP_CHAINHANDLE * h = dsl_znew(TP_CHAINHANDLE);
+	DSL_FILE * ret = (DSL_FILE *)&h->_handle;
+
+	h->buf = buf;
+	h->bFree = autofree;
+
+	ret->read = chain_read;
+	ret->write = chain_write;
+	ret->seek = chain_seek;
+	ret->tell = chain_tell;
+	ret->eof = chain_eof;
+	ret->flush = chain_flush;
+	ret->close = chain_close;
+
+	return ret;
+}
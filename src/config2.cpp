@@ -35,6 +35,7 @@ void ConfigSection::FreeSection(ConfigSection * Scan) {
 */
 
 void ConfigSection::Clear() {
+	AutoWriteLock(hLock);
 	for (auto& x : sections) {
 		delete x.second;
 	}
@@ -46,6 +47,7 @@ void ConfigSection::Clear() {
 }
 
 ConfigSection * ConfigSection::GetSection(const string& name) {
+	AutoReadLock(hLock);
 	auto x = sections.find(name);
 	if (x != sections.end()) {
 		return x->second;
@@ -55,6 +57,7 @@ ConfigSection * ConfigSection::GetSection(const string& name) {
 
 bool ConfigSection::GetSections(const string& name, vector<ConfigSection *>& psections) {
 	psections.clear();
+	AutoReadLock(hLock);
 	auto matches = sections.equal_range(name);
 	for (auto i = matches.first; i != matches.second; ++i) {
 		psections.push_back(i->second);
@@ -63,6 +66,7 @@ bool ConfigSection::GetSections(const string& name, vector<ConfigSection *>& pse
 }
 
 bool ConfigSection::HasValue(const string& name) const {
+	AutoReadLock(hLock);
 	return (values.count(name) > 0);
 	//return (values.find(name) != values.end());
 }
@@ -78,6 +82,7 @@ ConfigValue ConfigSection::GetValue(const string& name) {
 */
 
 const ConfigValue * const ConfigSection::GetValue(const string& name) const {
+	AutoReadLock(hLock);
 	auto x = values.find(name);
 	if (x != values.end()) {
 		return x->second;
@@ -86,6 +91,7 @@ const ConfigValue * const ConfigSection::GetValue(const string& name) const {
 }
 
 bool ConfigSection::GetValue(const string& name, ConfigValue& value) const {
+	AutoReadLock(hLock);
 	auto x = values.find(name);
 	if (x != values.end()) {
 		value = *x->second;
@@ -95,6 +101,7 @@ bool ConfigSection::GetValue(const string& name, ConfigValue& value) const {
 }
 
 void ConfigSection::SetValue(const string& name, const ConfigValue& val) {
+	AutoWriteLock(hLock);
 	auto x = values.find(name);
 	if (x != values.end()) {
 		*x->second = val;
@@ -104,10 +111,11 @@ void ConfigSection::SetValue(const string& name, const ConfigValue& val) {
 }
 
 ConfigSection * ConfigSection::FindOrAddSection(const string& name, bool force_new) {
+	AutoWriteLock(hLock);
 	if (!force_new) {
-		ConfigSection * ret = GetSection(name);
-		if (ret != NULL) {
-			return ret;
+		auto x = sections.find(name);
+		if (x != sections.end()) {
+			return x->second;
 		}
 	}
 
@@ -237,6 +245,7 @@ bool ConfigSection::loadFromStringConf(const char ** pconfig, size_t& line, cons
 		strtrim(buf);
 		strtrim(value);
 		if (buf[0] && value[0]) {
+			AutoWriteLock(hLock);
 			auto x = values.find(buf);
 			if (x != values.end()) {
 				x->second->ParseString(value);
@@ -290,6 +299,8 @@ void ConfigSection::writeSectionConf(stringstream& sstr, int level, bool single)
 
 	sstr << pref << name << " {\n";
 
+	AutoReadLock(hLock);
+
 	if (!single) {
 		for (auto& x : sections) {
 			x.second->writeSectionConf(sstr, level + 1);
@@ -326,6 +337,7 @@ bool ConfigSection::WriteToFile(FILE * fp, const string& filename, DSL_CONFIG_FO
 
 string ConfigSection::WriteToString(DSL_CONFIG_FORMAT f) const {
 	stringstream sstr;
+	AutoReadLock(hLock);
 	for (auto& x : sections) {
 		if (f == DCF_INI) {
 			x.second->writeSectionINI(sstr, 0);
@@ -343,6 +355,7 @@ void ConfigSection::printSection(size_t level) const {
 	pref[level] = 0;
 
 	printf("%sSection: %s\n", pref, name.c_str());
+	AutoReadLock(hLock);
 	strcat(pref,"\t");
 	for (auto& x : values) {
 		switch(x.second->Type) {
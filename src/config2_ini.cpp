@@ -110,6 +110,7 @@ bool ConfigSection::loadFromStringINI(const char ** pconfig, size_t& line, const
 		strtrim(buf);
 		strtrim(value);
 		if (buf[0] && value[0]) {
+			AutoWriteLock(hLock);
 			auto x = values.find(buf);
 			if (x != values.end()) {
 				x->second->ParseString(value);
@@ -132,6 +133,8 @@ bool ConfigSection::loadFromStringINI(const char ** pconfig, size_t& line, const
 void ConfigSection::writeSectionINI(stringstream& sstr, int level, bool single) const {
 	sstr << "[" << name << "]\n";
 
+	AutoReadLock(hLock);
+
 	for (auto& x : values) {
 		sstr << x.first << " = " << x.second->AsString() << "\n";
 	};
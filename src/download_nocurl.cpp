@@ -169,24 +169,45 @@ bool DSL_Download_NoCurl::Download(DSL_FILE * fWriteTo) {
 
 	uint64 got = 0, fullsize = 0;
 
-	int n=0,ln=0,tries=0;
+	int n=0,ln=0;
 	char buf[16384] = { 0 };
-	while ((n = socks->RecvLine(sock,buf,16384)) >= RL3_NOLINE) {
-		if (n == RL3_NOLINE) {
-			if (tries > 300) {
+	/*
+	 * The headers are read into our own buffer and split into lines here instead of using RecvLine(), which only peeks and would need to be polled when a line arrives in pieces.
+	 * Recv() blocks until more data arrives, so there is no sleeping. With no timeout set, use the same 30 second limit for the headers the old polling loop had.
+	 */
+	if (timeo == 0) {
+		socks->SetRecvTimeout(sock, 30000);
+	}
+	string hdr;
+	while (1) {
+		size_t ind = hdr.find('\n');
+		if (ind == string::npos) {
+			if (hdr.length() >= sizeof(buf) - 1) {
 				this->error = TD_INVALID_RESPONSE;
 				socks->Close(sock);
 				return false;
-			} else {
-				tries++;
-				safe_sleep(100,true);
-				continue;
 			}
+			// never read more than still fits in buf, so a complete line can always be copied there below
+			n = socks->Recv(sock, buf, (int)(sizeof(buf) - 1 - hdr.length()));
+			if (n < 0) {
+				this->error = TD_INVALID_RESPONSE;
+				socks->Close(sock);
+				return false;
+			} else if (n == 0) {
+				break;
+			}
+			hdr.append(buf, n);
+			continue;
 		}
-		buf[n]=0;
-		while (buf[strlen(buf) - 1] == '\n') { buf[strlen(buf) - 1] = 0; }
-		while (buf[strlen(buf) - 1] == '\r') { buf[strlen(buf) - 1] = 0; }
-		while (buf[strlen(buf) - 1] == '\n') { buf[strlen(buf) - 1] = 0; }
+		if (ind >= sizeof(buf)) {
+			this->error = TD_INVALID_RESPONSE;
+			socks->Close(sock);
+			return false;
+		}
+		memcpy(buf, hdr.c_str(), ind);
+		buf[ind] = 0;
+		hdr.erase(0, ind + 1);
+		strtrim(buf, "\r\n");
 		if (strlen(buf) == 0) { break; }
 
 		ln++;
@@ -248,6 +269,24 @@ bool DSL_Download_NoCurl::Download(DSL_FILE * fWriteTo) {
 		}
 	}
 
+	if (timeo == 0) {
+		socks->SetRecvTimeout(sock, 0);
+	}
+	// anything received after the headers is the start of the body
+	if (hdr.length()) {
+		if (fWriteTo->write((void *)hdr.c_str(), hdr.length(), fWriteTo) < (int64)hdr.length()) {
+			this->error = TD_FILE_WRITE_ERROR;
+			socks->Close(sock);
+			return false;
+		}
+		got += hdr.length();
+		if (callback != NULL && !callback(got, fullsize, u_ptr)) {
+			this->error = TD_CALLBACK_ABORT;
+			socks->Close(sock);
+			return false;
+		}
+	}
+
 	while ((n = socks->Recv(sock, buf, 16384)) > 0) {
 		//buf[n]=0;
 		if (fWriteTo->write(buf, n, fWriteTo) < n) {
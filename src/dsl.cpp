@@ -24,6 +24,10 @@ DSL_Mutex * dslMutex()
   return &actualMutex;
 }
 
+extern void dsl_cleanup_default_thread_pool();
+extern void dsl_cleanup_default_scheduler();
+extern void dsl_cleanup_mutex_profiler();
+
 int dsl_init_count = 0;
 bool dsl_init_ret = false;
 uint32 dsl_runtime_options = 0;
@@ -86,6 +90,11 @@ void dsl_cleanup() {
 		return;
 	}
 
+	// the scheduler first since it hands tasks to the pool
+	dsl_cleanup_default_scheduler();
+	dsl_cleanup_default_thread_pool();
+	dsl_cleanup_mutex_profiler();
+
 	for (auto x = dsl_lib_funcs.begin(); x != dsl_lib_funcs.end(); x++) {
 		if (x->has_init && x->cleanup != NULL) {
 			x->cleanup();
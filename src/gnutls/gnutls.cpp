@@ -63,29 +63,50 @@ int dsl_gnutls_hash_block_size(gnutls_digest_algorithm_t alg) {
 	return 64;
 }
 
-HASH_CTX * dsl_gnutls_hash_init(const char * name) {
+const void * dsl_gnutls_hash_lookup(const char * name) {
 	gnutls_digest_algorithm_t alg = dsl_gnutls_hash_get_by_name(name);
-	if (alg == GNUTLS_DIG_UNKNOWN) {
-		return NULL;
-		/*
-		printf("DSL: Unsupported hash algorithm '%s', defaulting to SHA256...\n");
-		alg = GNUTLS_DIG_SHA256;
-		*/
-	}
+	// GNUTLS_DIG_UNKNOWN is 0 so it maps to NULL
+	return (const void *)(uintptr_t)alg;
+}
 
+static HASH_CTX * dsl_gnutls_hash_setup(HASH_CTX * ret, gnutls_digest_algorithm_t alg) {
 	gnutls_hash_hd_t ctx;
 	if (gnutls_hash_init(&ctx, alg) != 0) {
 		return NULL;
 	}
-
-	HASH_CTX * ret = dsl_new(HASH_CTX);
-	memset(ret, 0, sizeof(HASH_CTX));
 	ret->pptr1 = ctx;
 	ret->hashSize = gnutls_hash_get_len(alg);
 	ret->blockSize = dsl_gnutls_hash_block_size(alg);
 	return ret;
 }
 
+HASH_CTX * dsl_gnutls_hash_init_algo(const void * impl) {
+	HASH_CTX * ret = dsl_new(HASH_CTX);
+	memset(ret, 0, sizeof(HASH_CTX));
+	if (dsl_gnutls_hash_setup(ret, (gnutls_digest_algorithm_t)(uintptr_t)impl) == NULL) {
+		dsl_free(ret);
+		return NULL;
+	}
+	return ret;
+}
+
+size_t dsl_gnutls_hash_ctx_size(const void * impl) {
+	// only the HASH_CTX, GnuTLS allocates its handle itself
+	return sizeof(HASH_CTX);
+}
+
+HASH_CTX * dsl_gnutls_hash_init_inplace(const void * impl, void * storage) {
+	HASH_CTX * ret = (HASH_CTX *)storage;
+	memset(ret, 0, sizeof(HASH_CTX));
+	ret->inplace = true;
+	return dsl_gnutls_hash_setup(ret, (gnutls_digest_algorithm_t)(uintptr_t)impl);
+}
+
+HASH_CTX * dsl_gnutls_hash_init(const char * name) {
+	const void * alg = dsl_gnutls_hash_lookup(name);
+	return (alg != NULL) ? dsl_gnutls_hash_init_algo(alg) : NULL;
+}
+
 void dsl_gnutls_hash_update(HASH_CTX *ctx, const uint8 *data, size_t len) {
 	gnutls_hash_hd_t pctx = (gnutls_hash_hd_t)ctx->pptr1;
 	gnutls_hash(pctx, data, len);
@@ -104,15 +125,55 @@ bool dsl_gnutls_hash_finish(HASH_CTX *ctx, uint8 * out, size_t outlen) {
 	} else {
 		gnutls_hash_deinit(pctx, out);
 	}
-	dsl_free(ctx);
+	if (!ctx->inplace) {
+		dsl_free(ctx);
+	}
+	return ret;
+}
+
+bool dsl_gnutls_hash_reset(HASH_CTX *ctx, uint8 * out, size_t outlen) {
+	gnutls_hash_hd_t pctx = (gnutls_hash_hd_t)ctx->pptr1;
+	// gnutls_hash_output() starts the handle over after writing the digest
+	if (out != NULL) {
+		gnutls_hash_output(pctx, out);
+	} else {
+		uint8 tmp[128];
+		gnutls_hash_output(pctx, tmp);
+	}
+	return true;
+}
+
+#if GNUTLS_VERSION_NUMBER >= 0x030609
+HASH_CTX * dsl_gnutls_hash_clone(const HASH_CTX *ctx, void * storage, size_t size) {
+	if (storage != NULL && size < sizeof(HASH_CTX)) {
+		return NULL;
+	}
+	gnutls_hash_hd_t pctx = gnutls_hash_copy((gnutls_hash_hd_t)ctx->pptr1);
+	if (pctx == NULL) {
+		return NULL;
+	}
+	HASH_CTX * ret = (storage != NULL) ? (HASH_CTX *)storage : dsl_new(HASH_CTX);
+	*ret = *ctx;
+	ret->pptr1 = pctx;
+	ret->inplace = (storage != NULL);
 	return ret;
 }
+#else
+#define dsl_gnutls_hash_clone NULL
+#endif
 
 const HASH_PROVIDER gnutls_hash_provider = {
 	"gnutls",
 	dsl_gnutls_hash_init,
 	dsl_gnutls_hash_update,
-	dsl_gnutls_hash_finish
+	dsl_gnutls_hash_finish,
+	NULL,
+	dsl_gnutls_hash_lookup,
+	dsl_gnutls_hash_init_algo,
+	dsl_gnutls_hash_ctx_size,
+	dsl_gnutls_hash_init_inplace,
+	dsl_gnutls_hash_reset,
+	dsl_gnutls_hash_clone
 };
 
 gnutls_mac_algorithm_t dsl_gnutls_hmac_get_by_name(const char * name) {
@@ -144,7 +205,7 @@ gnutls_mac_algorithm_t dsl_gnutls_hmac_get_by_name(const char * name) {
 }
 
 
-HASH_HMAC_CTX * dsl_gnutls_hmac_init(const char * name, const uint8 *key, size_t length) {
+static HASH_HMAC_CTX * dsl_gnutls_hmac_setup(HASH_HMAC_CTX * ret, const char * name, const uint8 *key, size_t length) {
 	gnutls_mac_algorithm_t alg = dsl_gnutls_hmac_get_by_name(name);
 	if (alg == GNUTLS_MAC_UNKNOWN) {
 		return NULL;
@@ -159,13 +220,32 @@ HASH_HMAC_CTX * dsl_gnutls_hmac_init(const char * name, const uint8 *key, size_t
 		return NULL;
 	}
 
-	HASH_HMAC_CTX * ret = dsl_new(HASH_HMAC_CTX);
-	memset(ret, 0, sizeof(HASH_HMAC_CTX));
 	ret->pptr1 = ctx;
 	ret->hashSize = gnutls_hmac_get_len(alg);
 	return ret;
 }
 
+HASH_HMAC_CTX * dsl_gnutls_hmac_init(const char * name, const uint8 *key, size_t length) {
+	HASH_HMAC_CTX * ret = dsl_new(HASH_HMAC_CTX);
+	memset(ret, 0, sizeof(HASH_HMAC_CTX));
+	if (dsl_gnutls_hmac_setup(ret, name, key, length) == NULL) {
+		dsl_free(ret);
+		return NULL;
+	}
+	return ret;
+}
+
+size_t dsl_gnutls_hmac_ctx_size(const char * name) {
+	return (dsl_gnutls_hmac_get_by_name(name) != GNUTLS_MAC_UNKNOWN) ? sizeof(HASH_HMAC_CTX) : 0;
+}
+
+HASH_HMAC_CTX * dsl_gnutls_hmac_init_inplace(const char * name, const uint8 *key, size_t length, void * storage) {
+	HASH_HMAC_CTX * ret = (HASH_HMAC_CTX *)storage;
+	memset(ret, 0, sizeof(HASH_HMAC_CTX));
+	ret->inplace = true;
+	return dsl_gnutls_hmac_setup(ret, name, key, length);
+}
+
 void dsl_gnutls_hmac_update(HASH_HMAC_CTX *ctx, const uint8 *data, size_t len) {
 	gnutls_hmac_hd_t pctx = (gnutls_hmac_hd_t)ctx->pptr1;
 	gnutls_hmac(pctx, data, len);
@@ -182,15 +262,52 @@ bool dsl_gnutls_hmac_finish(HASH_HMAC_CTX *ctx, uint8 * out, size_t outlen) {
 	} else {
 		gnutls_hmac_deinit(pctx, out);
 	}
-	dsl_free(ctx);
+	if (!ctx->inplace) {
+		dsl_free(ctx);
+	}
 	return true;
 }
 
+bool dsl_gnutls_hmac_reset(HASH_HMAC_CTX *ctx, uint8 * out, size_t outlen) {
+	gnutls_hmac_hd_t pctx = (gnutls_hmac_hd_t)ctx->pptr1;
+	// gnutls_hmac_output() starts the handle over with the same key after writing the MAC
+	if (out != NULL) {
+		gnutls_hmac_output(pctx, out);
+	} else {
+		uint8 tmp[128];
+		gnutls_hmac_output(pctx, tmp);
+	}
+	return true;
+}
+
+#if GNUTLS_VERSION_NUMBER >= 0x030609
+HASH_HMAC_CTX * dsl_gnutls_hmac_clone(const HASH_HMAC_CTX *ctx, void * storage, size_t size) {
+	if (storage != NULL && size < sizeof(HASH_HMAC_CTX)) {
+		return NULL;
+	}
+	gnutls_hmac_hd_t pctx = gnutls_hmac_copy((gnutls_hmac_hd_t)ctx->pptr1);
+	if (pctx == NULL) {
+		return NULL;
+	}
+	HASH_HMAC_CTX * ret = (storage != NULL) ? (HASH_HMAC_CTX *)storage : dsl_new(HASH_HMAC_CTX);
+	*ret = *ctx;
+	ret->pptr1 = pctx;
+	ret->inplace = (storage != NULL);
+	return ret;
+}
+#else
+#define dsl_gnutls_hmac_clone NULL
+#endif
+
 const HMAC_PROVIDER gnutls_hmac_provider = {
 	"gnutls",
 	dsl_gnutls_hmac_init,
 	dsl_gnutls_hmac_update,
-	dsl_gnutls_hmac_finish
+	dsl_gnutls_hmac_finish,
+	dsl_gnutls_hmac_ctx_size,
+	dsl_gnutls_hmac_init_inplace,
+	dsl_gnutls_hmac_reset,
+	dsl_gnutls_hmac_clone
 };
 
 bool gnutls_has_init = false;
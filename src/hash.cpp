@@ -8,57 +8,195 @@
 \***********************************************************************/
 //@AUTOHEADER@END@
 
+#include <list>
+#include <thread>
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
 #include <drift/dslcore.h>
 #include <drift/GenLib.h>
 #include <drift/hash.h>
 #include <drift/mutex.h>
+#include <drift/mmap.h>
+#include <drift/parallel.h>
+#include <drift/queue.h>
 
 typedef vector<const HASH_PROVIDER*> hashProviderList;
-hashProviderList * dslHashProviders() {
-	AutoMutexPtr(dslMutex());
-	static hashProviderList hash_providers { &dsl_native_hashers };
-	return &hash_providers;
+
+/*
+ * The provider list is copy-on-write: readers get the current list with a single atomic load and never lock, adding/removing a provider
+ * (which only happens when a library is (un)loaded) publishes a new copy. Old lists and handles are kept until exit since another thread
+ * could still be using one.
+ */
+struct HASH_REGISTRY {
+	atomic<const hashProviderList *> providers;
+	DSL_RWLock lock; ///< for writers and the lookup cache
+	std::list<hashProviderList> lists;
+	std::list<HASH_ALGO> handles;
+	map<string, const HASH_ALGO *> algos; ///< lookup cache, lower case name -> handle
+
+	HASH_REGISTRY() {
+		lists.push_back({ &dsl_native_hashers });
+		providers = &lists.back();
+	}
+	void publish(hashProviderList&& list) {
+		lists.push_back(std::move(list));
+		providers.store(&lists.back());
+		// a new provider may change what a name resolves to, so start over. Existing handles stay valid.
+		algos.clear();
+	}
+};
+static HASH_REGISTRY& dslHashRegistry() {
+	static HASH_REGISTRY reg;
+	return reg;
 }
 
-extern DSL_Mutex * dslMutex();
 void DSL_CC dsl_add_hash_provider(const HASH_PROVIDER * p) {
-	AutoMutexPtr(dslMutex());
-	//dslHashProviders()->push_back(p);
+	HASH_REGISTRY& reg = dslHashRegistry();
+	AutoWriteLock(reg.lock);
+	hashProviderList list = *reg.providers.load();
 	/* 3rd party providers will probably be more optimized than our generic native ones, so put them 1st */
-	hashProviderList* hash_providers = dslHashProviders();
-	hash_providers->insert(hash_providers->begin(), p);
+	list.insert(list.begin(), p);
+	reg.publish(std::move(list));
 }
 void DSL_CC dsl_remove_hash_provider(const HASH_PROVIDER * p) {
-	AutoMutexPtr(dslMutex());
-	hashProviderList * hash_providers = dslHashProviders();
-	for (auto x = hash_providers->begin(); x != hash_providers->end(); x++) {
+	HASH_REGISTRY& reg = dslHashRegistry();
+	AutoWriteLock(reg.lock);
+	hashProviderList list = *reg.providers.load();
+	for (auto x = list.begin(); x != list.end(); x++) {
 		if (*x == p) {
-			hash_providers->erase(x);
+			list.erase(x);
 #ifdef DEBUG
-			printf("Removed hash provider %s -> %zu\n", p->name, hash_providers->size());
+			printf("Removed hash provider %s -> %zu\n", p->name, list.size());
 #endif
+			reg.publish(std::move(list));
 			break;
 		}
 	}
 }
 void DSL_CC dsl_get_hash_providers(vector<const HASH_PROVIDER *>& p) {
-	AutoMutexPtr(dslMutex());
-	p = *dslHashProviders();
+	p = *dslHashRegistry().providers.load();
 }
 
-HASH_CTX * DSL_CC hash_init(const char * name) {
-	AutoMutexPtr(dslMutex());
-	hashProviderList* hash_providers = dslHashProviders();
-	for (auto x = hash_providers->begin(); x != hash_providers->end(); x++) {
-		HASH_CTX * ret = (*x)->hash_init(name);
-		if (ret != NULL) {
-			ret->provider = *x;
-			return ret;
+/* Frees a ctx whose result isn't needed */
+static void hash_discard(HASH_CTX * ctx) {
+	uint8 * tmp = (uint8 *)dsl_malloc(ctx->hashSize);
+	hash_finish(ctx, tmp, ctx->hashSize);
+	dsl_free(tmp);
+}
+
+const HASH_ALGO * DSL_CC hash_algo_lookup(const char * name) {
+	if (name == NULL) {
+		return NULL;
+	}
+	string key = name;
+	strlwr(&key[0]);
+
+	HASH_REGISTRY& reg = dslHashRegistry();
+	{
+		AutoReadLock(reg.lock);
+		auto x = reg.algos.find(key);
+		if (x != reg.algos.end()) {
+			return x->second;
+		}
+	}
+
+	AutoWriteLock(reg.lock);
+	auto x = reg.algos.find(key);
+	if (x != reg.algos.end()) {
+		return x->second;
+	}
+	const hashProviderList * providers = reg.providers.load();
+	for (auto p = providers->begin(); p != providers->end(); p++) {
+		HASH_ALGO algo;
+		algo.provider = *p;
+		algo.impl = NULL;
+		algo.name = name;
+		HASH_CTX * ctx;
+		if ((*p)->hash_lookup != NULL) {
+			algo.impl = (*p)->hash_lookup(name);
+			if (algo.impl == NULL) {
+				continue;
+			}
+			ctx = (*p)->hash_init_algo(algo.impl);
+		} else {
+			ctx = (*p)->hash_init(name);
 		}
+		if (ctx == NULL) {
+			continue;
+		}
+		// sizes come from a throwaway ctx so hash_init_algo() callers can see them up front
+		ctx->provider = *p;
+		algo.hashSize = ctx->hashSize;
+		algo.blockSize = ctx->blockSize;
+		hash_discard(ctx);
+
+		reg.handles.push_back(algo);
+		reg.algos[key] = &reg.handles.back();
+		return &reg.handles.back();
 	}
 	return NULL;
 }
 
+HASH_CTX * DSL_CC hash_init_algo(const HASH_ALGO * algo) {
+	if (algo == NULL) {
+		return NULL;
+	}
+	HASH_CTX * ret = (algo->impl != NULL) ? algo->provider->hash_init_algo(algo->impl) : algo->provider->hash_init(algo->name.c_str());
+	if (ret != NULL) {
+		ret->provider = algo->provider;
+	}
+	return ret;
+}
+
+HASH_CTX * DSL_CC hash_init(const char * name) {
+	return hash_init_algo(hash_algo_lookup(name));
+}
+
+size_t DSL_CC hash_ctx_size(const HASH_ALGO * algo) {
+	if (algo == NULL || algo->impl == NULL || algo->provider->hash_ctx_size == NULL) {
+		return 0;
+	}
+	return algo->provider->hash_ctx_size(algo->impl);
+}
+
+HASH_CTX * DSL_CC hash_ctx_init_inplace(const HASH_ALGO * algo, void * storage, size_t size) {
+	size_t need = hash_ctx_size(algo);
+	if (need == 0 || storage == NULL || size < need || ((uintptr_t)storage % DSL_HASH_CTX_ALIGN) != 0) {
+		return NULL;
+	}
+	HASH_CTX * ret = algo->provider->hash_init_inplace(algo->impl, storage);
+	if (ret != NULL) {
+		ret->provider = algo->provider;
+	}
+	return ret;
+}
+
+bool DSL_CC hash_reset(HASH_CTX * ctx) {
+	if (ctx == NULL || ctx->provider->hash_reset == NULL) {
+		return false;
+	}
+	return ctx->provider->hash_reset(ctx, NULL, 0);
+}
+
+bool DSL_CC hash_finish_reset(HASH_CTX * ctx, uint8 * out, size_t outlen) {
+	if (ctx == NULL || out == NULL || outlen < ctx->hashSize || ctx->provider->hash_reset == NULL) {
+		return false;
+	}
+	return ctx->provider->hash_reset(ctx, out, outlen);
+}
+
+HASH_CTX * DSL_CC hash_clone(const HASH_CTX * ctx, void * storage, size_t size) {
+	if (ctx == NULL || ctx->provider->hash_clone == NULL || ((uintptr_t)storage % DSL_HASH_CTX_ALIGN) != 0) {
+		return NULL;
+	}
+	HASH_CTX * ret = ctx->provider->hash_clone(ctx, storage, size);
+	if (ret != NULL) {
+		ret->provider = ctx->provider;
+	}
+	return ret;
+}
+
 void DSL_CC hash_update(HASH_CTX *ctx, const uint8 *data, size_t len) {
 	if (ctx == NULL || data == NULL) {
 		return;
@@ -80,6 +218,37 @@ bool DSL_CC hash_finish(HASH_CTX *ctx, uint8 * out, size_t outlen) {
 	return ctx->provider->hash_finish(ctx, out, outlen);
 }
 
+bool DSL_CC hash_batch(const char * name, const HASH_BATCH_ITEM * items, size_t count, uint8 * out, size_t outlen) {
+	if (count > 0 && (items == NULL || out == NULL)) {
+		return false;
+	}
+
+	const hashProviderList * hash_providers = dslHashRegistry().providers.load();
+	// a provider with a real batch implementation beats one that would just loop
+	for (auto x = hash_providers->begin(); x != hash_providers->end(); x++) {
+		if ((*x)->hash_batch != NULL && (*x)->hash_batch(name, items, count, out, outlen)) {
+			return true;
+		}
+	}
+
+	// otherwise one at a time with whichever provider has the algorithm
+	const HASH_ALGO * algo = hash_algo_lookup(name);
+	if (algo == NULL || outlen / algo->hashSize < count) {
+		return false;
+	}
+	for (size_t i = 0; i < count; i++) {
+		HASH_CTX * ctx = hash_init_algo(algo);
+		if (ctx == NULL) {
+			return false;
+		}
+		hash_update(ctx, items[i].data, items[i].length);
+		if (!hash_finish(ctx, out + (i * algo->hashSize), algo->hashSize)) {
+			return false;
+		}
+	}
+	return true;
+}
+
 DSL_API bool DSL_CC hashdata(const char * name, const uint8 *data, size_t datalen, char * out, size_t outlen, bool raw_output) {
 	HASH_CTX * ctx = hash_init(name);
 	if (ctx == NULL) {
@@ -130,46 +299,374 @@ DSL_API bool DSL_CC hashfile_fp(const char * name, FILE * fpp, char * out, size_
 	return false;
 }
 
-DSL_API bool DSL_CC hashfile_rw(const char * name, DSL_FILE * fp, char * out, size_t outlen, bool raw_output) {
-	HASH_CTX * ctx = hash_init(name);
-	if (ctx == NULL) {
-		return false;
-	}
-	if (raw_output && outlen < ctx->hashSize) {
-		return false;
-	} else if (!raw_output && outlen < ((ctx->hashSize * 2) + 1)) {
-		return false;
+static bool hash_output_fits(size_t hsize, size_t outlen, bool raw_output) {
+	return raw_output ? (outlen >= hsize) : (outlen >= (hsize * 2) + 1);
+}
+
+// digest into out as raw bytes or a hex string
+static bool hash_output(const uint8 * digest, size_t hsize, char * out, size_t outlen, bool raw_output) {
+	if (raw_output) {
+		memcpy(out, digest, hsize);
+		return true;
 	}
+	return (bin2hex(digest, hsize, out, outlen) != NULL);
+}
 
-	char buf[32768];
+static bool hash_finish_output(HASH_CTX * ctx, char * out, size_t outlen, bool raw_output) {
+	if (raw_output) {
+		return hash_finish(ctx, (uint8 *)out, outlen);
+	}
+	size_t hsize = ctx->hashSize;
+	unsigned char * hashtmp = (unsigned char *)dsl_malloc(hsize);
+	bool ret = hash_finish(ctx, hashtmp, hsize) && hash_output(hashtmp, hsize, out, outlen, false);
+	dsl_free(hashtmp);
+	return ret;
+}
 
+static int64 hash_file_size(DSL_FILE * fp) {
 	fp->seek(fp, 0, SEEK_END);
-	int64 left = fp->tell(fp);
+	int64 ret = fp->tell(fp);
 	fp->seek(fp, 0, SEEK_SET);
+	return ret;
+}
 
-	bool ret = true;
+static bool hash_read_file(HASH_CTX * ctx, DSL_FILE * fp) {
+	char buf[32768];
+
+	int64 left = hash_file_size(fp);
 	while (left) {
 		int64 toRead = (left >= sizeof(buf)) ? sizeof(buf):left;
 		if (fp->read(buf, toRead, fp) == toRead) {
 			hash_update(ctx,(uint8 *)&buf, (size_t)toRead);
 			left -= toRead;
 		} else {
-			ret = false;
-			break;
+			return false;
 		}
 	}
+	return true;
+}
 
-	bool ret2;
-	if (raw_output) {
-		ret2 = hash_finish(ctx, (uint8 *)out, outlen);
-	} else {
-		size_t hsize = ctx->hashSize;
-		unsigned char * hashtmp = (unsigned char *)dsl_malloc(ctx->hashSize);
-		ret2 = hash_finish(ctx, hashtmp, ctx->hashSize);
-		if (ret2) {
-			ret2 = (bin2hex(hashtmp, hsize, out, outlen) != NULL);
+DSL_API bool DSL_CC hashfile_rw(const char * name, DSL_FILE * fp, char * out, size_t outlen, bool raw_output) {
+	HASH_CTX * ctx = hash_init(name);
+	if (ctx == NULL) {
+		return false;
+	}
+	if (!hash_output_fits(ctx->hashSize, outlen, raw_output)) {
+		return false;
+	}
+
+	bool ret = hash_read_file(ctx, fp);
+	bool ret2 = hash_finish_output(ctx, out, outlen, raw_output);
+	return (ret && ret2);
+}
+
+#define HASHFILE_CHUNK (1024*1024)
+#define HASHFILE_BUFFERS 3
+
+struct HASHFILE_BLOCK {
+	int slot;
+	int64 len; ///< 0 = end of file, < 0 = read error
+};
+
+typedef function<bool(const uint8 * data, size_t len)> hash_block_func;
+
+/* Feeds the rest of fp to func in blocks of block_size bytes (only the last one can be short) */
+static bool hash_read_blocks(DSL_FILE * fp, size_t block_size, const hash_block_func& func) {
+	uint8 * buf = (uint8 *)dsl_malloc(block_size);
+	int64 left = hash_file_size(fp);
+	bool ret = true;
+	while (ret && left > 0) {
+		int64 toRead = (left >= (int64)block_size) ? (int64)block_size : left;
+		ret = (fp->read(buf, toRead, fp) == toRead) && func(buf, (size_t)toRead);
+		left -= toRead;
+	}
+	dsl_free(buf);
+	return ret;
+}
+
+/* hash_read_blocks() with the reading done on a second thread into num_bufs rotating buffers, the queues pass buffer numbers back and forth */
+static bool hash_read_blocks_ahead(DSL_FILE * fp, size_t block_size, int num_bufs, const hash_block_func& func) {
+	uint8 * bufs = (uint8 *)dsl_malloc(num_bufs * block_size);
+	DSL_Queue<HASHFILE_BLOCK> free_bufs(num_bufs), full_bufs(num_bufs);
+	for (int i = 0; i < num_bufs; i++) {
+		free_bufs.TryPush({ i, 0 });
+	}
+
+	int64 size = hash_file_size(fp);
+	thread reader([&]() {
+		int64 left = size;
+		HASHFILE_BLOCK b;
+		while (free_bufs.Pop(b)) {
+			int64 toRead = (left >= (int64)block_size) ? (int64)block_size : left;
+			if (toRead > 0 && fp->read(bufs + (b.slot * block_size), toRead, fp) != toRead) {
+				toRead = -1;
+			}
+			b.len = toRead;
+			full_bufs.Push(b);
+			if (toRead <= 0) {
+				break;
+			}
+			left -= toRead;
 		}
-		dsl_free(hashtmp);
+	});
+
+	HASHFILE_BLOCK b = { 0, -1 };
+	bool ret = true;
+	while (full_bufs.Pop(b) && b.len > 0) {
+		if (ret) {
+			ret = func(bufs + (b.slot * block_size), (size_t)b.len);
+		}
+		// keep handing buffers back even after a failure so the reader can get to the end
+		free_bufs.Push(b);
+	}
+	reader.join();
+	dsl_free(bufs);
+	return (ret && b.len == 0);
+}
+
+static bool hash_read_file_ahead(HASH_CTX * ctx, DSL_FILE * fp) {
+	return hash_read_blocks_ahead(fp, HASHFILE_CHUNK, HASHFILE_BUFFERS, [ctx](const uint8 * data, size_t len) {
+		hash_update(ctx, data, len);
+		return true;
+	});
+}
+
+/**
+ * Maps fn read-only for sequential access.
+ * @return 1 if it was mapped into map, 0 if the file is empty (nothing to map), -1 if it can't be mapped.
+ */
+static int hash_map_file(const char * fn, DSL_MMAP_HANDLE ** map) {
+	*map = NULL;
+#ifdef WIN32
+	HANDLE hFile = CreateFile(fn, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return -1;
+	}
+	LARGE_INTEGER li;
+	if (!GetFileSizeEx(hFile, &li)) {
+		CloseHandle(hFile);
+		return -1;
+	}
+	if (li.QuadPart == 0) {
+		CloseHandle(hFile);
+		return 0;
+	}
+	*map = dsl_map_handle(hFile, li.QuadPart, 0, DSL_MMAP_READ | DSL_MMAP_CLOSE);
+	if (*map == NULL) {
+		CloseHandle(hFile);
+		return -1;
+	}
+#else
+	// not dsl_map_file(), that would create fn if it doesn't exist
+	int fd = open(fn, O_RDONLY);
+	if (fd == -1) {
+		return -1;
 	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		close(fd);
+		return -1;
+	}
+	if (st.st_size == 0) {
+		close(fd);
+		return 0;
+	}
+	*map = dsl_map_handle(fd, st.st_size, 0, DSL_MMAP_READ | DSL_MMAP_CLOSE);
+	if (*map == NULL) {
+		close(fd);
+		return -1;
+	}
+	madvise((*map)->data, (*map)->size, MADV_SEQUENTIAL);
+#endif
+	return 1;
+}
+
+/* hash_update() of data that may be a mapped file. On Windows an I/O error or the file shrinking under the mapping is caught and returns false, other OSes raise SIGBUS */
+#ifdef WIN32
+// kept apart from anything with a destructor since it uses SEH
+static bool hash_update_mapped(HASH_CTX * ctx, const uint8 * data, size_t len) {
+	__try {
+		hash_update(ctx, data, len);
+	} __except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH) {
+		return false;
+	}
+	return true;
+}
+#else
+static bool hash_update_mapped(HASH_CTX * ctx, const uint8 * data, size_t len) {
+	hash_update(ctx, data, len);
+	return true;
+}
+#endif
+
+DSL_API bool DSL_CC hashfile_ex(const char * name, const char * fn, char * out, size_t outlen, bool raw_output, uint32 flags) {
+	const HASH_ALGO * algo = hash_algo_lookup(name);
+	if (algo == NULL || !hash_output_fits(algo->hashSize, outlen, raw_output)) {
+		return false;
+	}
+
+	DSL_MMAP_HANDLE * map = NULL;
+	int mapped = (flags & DSL_HASHFILE_MMAP) ? hash_map_file(fn, &map) : -1;
+	DSL_FILE * fp = NULL;
+	if (mapped < 0) {
+		fp = RW_OpenFile(fn, "rb");
+		if (fp == NULL) {
+			return false;
+		}
+	}
+
+	HASH_CTX * ctx = hash_init_algo(algo);
+	bool ret = (ctx != NULL);
+	if (ret) {
+		if (mapped > 0) {
+			ret = hash_update_mapped(ctx, (const uint8 *)map->data, (size_t)map->size);
+		} else if (fp != NULL) {
+			ret = (flags & DSL_HASHFILE_READAHEAD) ? hash_read_file_ahead(ctx, fp) : hash_read_file(ctx, fp);
+		}
+		bool ret2 = hash_finish_output(ctx, out, outlen, raw_output);
+		ret = (ret && ret2);
+	}
+
+	if (map != NULL) {
+		dsl_unmap_file(map);
+	}
+	if (fp != NULL) {
+		fp->close(fp);
+	}
+	return ret;
+}
+
+static bool hash_tree_leaf(const HASH_ALGO * algo, const uint8 * data, size_t len, uint8 * out) {
+	static const uint8 prefix = 0x00;
+	HASH_CTX * ctx = hash_init_algo(algo);
+	if (ctx == NULL) {
+		return false;
+	}
+	hash_update(ctx, &prefix, 1);
+	// data can be a mapped file, this runs on the pool's threads so it needs its own guard
+	bool ret = hash_update_mapped(ctx, data, len);
+	bool ret2 = hash_finish(ctx, out, algo->hashSize);
 	return (ret && ret2);
 }
+
+// hashes the leaves of data into leaves (count * hashSize bytes) on the thread pool
+static bool hash_tree_leaves(const HASH_ALGO * algo, const uint8 * data, size_t len, size_t chunk_size, uint8 * leaves) {
+	size_t count = (len + chunk_size - 1) / chunk_size;
+	atomic<bool> ret(true);
+	DSL_ParallelFor(0, count, [&](size_t i) {
+		size_t off = i * chunk_size;
+		if (!hash_tree_leaf(algo, data + off, std::min(chunk_size, len - off), leaves + (i * algo->hashSize))) {
+			ret = false;
+		}
+	}, 1);
+	return ret;
+}
+
+// the root of count leaf digests, RFC 6962 style
+static bool hash_tree_root(const HASH_ALGO * algo, const uint8 * leaves, size_t count, uint8 * out) {
+	size_t hsize = algo->hashSize;
+	if (count == 1) {
+		memcpy(out, leaves, hsize);
+		return true;
+	}
+	size_t split = 1;
+	while (split * 2 < count) {
+		split *= 2;
+	}
+
+	static const uint8 prefix = 0x01;
+	uint8 * children = (uint8 *)dsl_malloc(hsize * 2);
+	bool ret = hash_tree_root(algo, leaves, split, children) && hash_tree_root(algo, leaves + (split * hsize), count - split, children + hsize);
+	HASH_CTX * ctx = ret ? hash_init_algo(algo) : NULL;
+	if (ctx != NULL) {
+		hash_update(ctx, &prefix, 1);
+		hash_update(ctx, children, hsize * 2);
+		ret = hash_finish(ctx, out, hsize);
+	} else {
+		ret = false;
+	}
+	dsl_free(children);
+	return ret;
+}
+
+static bool hash_tree_output(const HASH_ALGO * algo, const uint8 * leaves, size_t count, char * out, size_t outlen, bool raw_output) {
+	if (count == 0) {
+		// H() of nothing
+		HASH_CTX * ctx = hash_init_algo(algo);
+		return (ctx != NULL && hash_finish_output(ctx, out, outlen, raw_output));
+	}
+	uint8 * root = (uint8 *)dsl_malloc(algo->hashSize);
+	bool ret = hash_tree_root(algo, leaves, count, root) && hash_output(root, algo->hashSize, out, outlen, raw_output);
+	dsl_free(root);
+	return ret;
+}
+
+DSL_API bool DSL_CC hashdata_tree(const char * name, const uint8 *data, size_t datalen, char * out, size_t outlen, bool raw_output, size_t chunk_size) {
+	const HASH_ALGO * algo = hash_algo_lookup(name);
+	if (algo == NULL || chunk_size == 0 || !hash_output_fits(algo->hashSize, outlen, raw_output)) {
+		return false;
+	}
+
+	size_t count = (datalen + chunk_size - 1) / chunk_size;
+	uint8 * leaves = (uint8 *)dsl_malloc((count * algo->hashSize) + 1);
+	bool ret = hash_tree_leaves(algo, data, datalen, chunk_size, leaves) && hash_tree_output(algo, leaves, count, out, outlen, raw_output);
+	dsl_free(leaves);
+	return ret;
+}
+
+DSL_API bool DSL_CC hashfile_tree(const char * name, const char * fn, char * out, size_t outlen, bool raw_output, size_t chunk_size, uint32 flags) {
+	const HASH_ALGO * algo = hash_algo_lookup(name);
+	if (algo == NULL || chunk_size == 0 || !hash_output_fits(algo->hashSize, outlen, raw_output)) {
+		return false;
+	}
+
+	DSL_MMAP_HANDLE * map = NULL;
+	int mapped = (flags & DSL_HASHFILE_MMAP) ? hash_map_file(fn, &map) : -1;
+	if (mapped > 0) {
+		bool ret = hashdata_tree(name, (const uint8 *)map->data, (size_t)map->size, out, outlen, raw_output, chunk_size);
+		dsl_unmap_file(map);
+		return ret;
+	}
+
+	DSL_FILE * fp = RW_OpenFile(fn, "rb");
+	if (fp == NULL) {
+		return false;
+	}
+
+	// read enough chunks at a time to keep every pool thread busy, then hash them in parallel
+	size_t group = std::max<size_t>(DSL_GetDefaultThreadPool()->NumThreads(), 1) * 2;
+	vector<uint8> leaves;
+	hash_block_func add_leaves = [&](const uint8 * data, size_t len) {
+		size_t pos = leaves.size();
+		leaves.resize(pos + (((len + chunk_size - 1) / chunk_size) * algo->hashSize));
+		return hash_tree_leaves(algo, data, len, chunk_size, leaves.data() + pos);
+	};
+	bool ret = (flags & DSL_HASHFILE_READAHEAD) ? hash_read_blocks_ahead(fp, group * chunk_size, 2, add_leaves) : hash_read_blocks(fp, group * chunk_size, add_leaves);
+	fp->close(fp);
+	return ret && hash_tree_output(algo, leaves.data(), leaves.size() / algo->hashSize, out, outlen, raw_output);
+}
+
+DSL_API bool DSL_CC hashfiles(const char * name, const vector<string>& files, vector<string>& out, bool raw_output) {
+	out.clear();
+	out.resize(files.size());
+
+	const HASH_ALGO * algo = hash_algo_lookup(name);
+	if (algo == NULL) {
+		return false;
+	}
+	size_t hsize = algo->hashSize;
+
+	atomic<bool> ret(true);
+	// one file per chunk, files are big enough units of work on their own
+	DSL_ParallelFor(0, files.size(), [&](size_t i) {
+		string& str = out[i];
+		str.resize(raw_output ? hsize : (hsize * 2) + 1);
+		if (hashfile(name, files[i].c_str(), &str[0], str.size(), raw_output)) {
+			str.resize(raw_output ? hsize : hsize * 2);
+		} else {
+			str.clear();
+			ret = false;
+		}
+	}, 1);
+	return ret;
+}
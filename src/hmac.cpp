@@ -14,22 +14,23 @@
 #include <drift/hash.h>
 #include <drift/hmac.h>
 
-extern DSL_Mutex * dslMutex();
-
 typedef vector<const HMAC_PROVIDER*> hmacProviderList;
 hmacProviderList* dslHMACProviders() {
-	AutoMutexPtr(dslMutex());
 	static hmacProviderList hmac_providers { &dsl_native_hmacers };
 	return &hmac_providers;
 }
+DSL_RWLock * dslHMACProvidersLock() {
+	static DSL_RWLock actualLock;
+	return &actualLock;
+}
 
 void DSL_CC dsl_add_hmac_provider(const HMAC_PROVIDER * p) {
-	AutoMutexPtr(dslMutex());
+	AutoWriteLockPtr(dslHMACProvidersLock());
 	hmacProviderList* hmac_providers = dslHMACProviders();
 	hmac_providers->insert(hmac_providers->begin(), p);
 }
 void DSL_CC dsl_remove_hmac_provider(const HMAC_PROVIDER * p) {
-	AutoMutexPtr(dslMutex());
+	AutoWriteLockPtr(dslHMACProvidersLock());
 	hmacProviderList* hmac_providers = dslHMACProviders();
 	for (auto x = hmac_providers->begin(); x != hmac_providers->end(); x++) {
 		if (*x == p) {
@@ -39,12 +40,13 @@ void DSL_CC dsl_remove_hmac_provider(const HMAC_PROVIDER * p) {
 	}
 }
 void DSL_CC dsl_get_hmac_providers(vector<const HMAC_PROVIDER *>& p) {
-	AutoMutexPtr(dslMutex());
+	AutoReadLockPtr(dslHMACProvidersLock());
 	p = *dslHMACProviders();
 }
 
 
 HASH_HMAC_CTX * DSL_CC hmac_init(const char * name, const uint8 *key, size_t length) {
+	AutoReadLockPtr(dslHMACProvidersLock());
 	hmacProviderList* hmac_providers = dslHMACProviders();
 	for (auto x = hmac_providers->begin(); x != hmac_providers->end(); x++) {
 		HASH_HMAC_CTX * ret = (*x)->hmac_init(name, key, length);
@@ -56,6 +58,72 @@ HASH_HMAC_CTX * DSL_CC hmac_init(const char * name, const uint8 *key, size_t len
 	return NULL;
 }
 
+size_t DSL_CC hmac_ctx_size(const char * name) {
+	AutoReadLockPtr(dslHMACProvidersLock());
+	hmacProviderList* hmac_providers = dslHMACProviders();
+	for (auto x = hmac_providers->begin(); x != hmac_providers->end(); x++) {
+		if ((*x)->hmac_ctx_size != NULL) {
+			size_t ret = (*x)->hmac_ctx_size(name);
+			if (ret > 0) {
+				return ret;
+			}
+		}
+	}
+	return 0;
+}
+
+HASH_HMAC_CTX * DSL_CC hmac_init_inplace(const char * name, const uint8 *key, size_t length, void * storage, size_t size) {
+	if (storage == NULL || ((uintptr_t)storage % DSL_HMAC_CTX_ALIGN) != 0) {
+		return NULL;
+	}
+	AutoReadLockPtr(dslHMACProvidersLock());
+	hmacProviderList* hmac_providers = dslHMACProviders();
+	// same provider order as hmac_ctx_size() so the size it returned is the one that counts
+	for (auto x = hmac_providers->begin(); x != hmac_providers->end(); x++) {
+		if ((*x)->hmac_ctx_size == NULL) {
+			continue;
+		}
+		size_t need = (*x)->hmac_ctx_size(name);
+		if (need == 0) {
+			continue;
+		}
+		if (size < need) {
+			return NULL;
+		}
+		HASH_HMAC_CTX * ret = (*x)->hmac_init_inplace(name, key, length, storage);
+		if (ret != NULL) {
+			ret->provider = *x;
+		}
+		return ret;
+	}
+	return NULL;
+}
+
+bool DSL_CC hmac_reset(HASH_HMAC_CTX * ctx) {
+	if (ctx == NULL || ctx->provider->hmac_reset == NULL) {
+		return false;
+	}
+	return ctx->provider->hmac_reset(ctx, NULL, 0);
+}
+
+bool DSL_CC hmac_finish_reset(HASH_HMAC_CTX * ctx, uint8 * out, size_t outlen) {
+	if (ctx == NULL || out == NULL || outlen < ctx->hashSize || ctx->provider->hmac_reset == NULL) {
+		return false;
+	}
+	return ctx->provider->hmac_reset(ctx, out, outlen);
+}
+
+HASH_HMAC_CTX * DSL_CC hmac_clone(const HASH_HMAC_CTX * ctx, void * storage, size_t size) {
+	if (ctx == NULL || ctx->provider->hmac_clone == NULL || ((uintptr_t)storage % DSL_HMAC_CTX_ALIGN) != 0) {
+		return NULL;
+	}
+	HASH_HMAC_CTX * ret = ctx->provider->hmac_clone(ctx, storage, size);
+	if (ret != NULL) {
+		ret->provider = ctx->provider;
+	}
+	return ret;
+}
+
 void DSL_CC hmac_update(HASH_HMAC_CTX *ctx, const uint8 *data, size_t len) {
 	if (ctx == NULL || data == NULL) {
 		return;
@@ -70,6 +138,88 @@ bool DSL_CC hmac_finish(HASH_HMAC_CTX *ctx, uint8 * out, size_t outlen) {
 	return ctx->provider->hmac_finish(ctx, out, outlen);
 }
 
+// a plain memset() before free() can be optimized away
+static void hmac_key_wipe(uint8 * p, size_t len) {
+	volatile uint8 * vp = p;
+	while (len--) {
+		*vp++ = 0;
+	}
+}
+
+HMAC_KEY * DSL_CC hmac_key_create(const char * name, const uint8 *key, size_t length) {
+	HASH_HMAC_CTX * proto = hmac_init(name, key, length);
+	if (proto == NULL) {
+		return NULL;
+	}
+
+	HMAC_KEY * ret = dsl_new(HMAC_KEY);
+	memset(ret, 0, sizeof(HMAC_KEY));
+	ret->hashSize = proto->hashSize;
+	if (proto->provider->hmac_clone != NULL) {
+		ret->proto = proto;
+		if (proto->provider->hmac_ctx_size != NULL) {
+			ret->ctxSize = proto->provider->hmac_ctx_size(name);
+		}
+	} else {
+		// can't copy the prepared state so keep what we need to start from scratch each time
+		uint8 tmp[128];
+		hmac_finish(proto, tmp, sizeof(tmp));
+		ret->name = dsl_strdup(name);
+		ret->key = (uint8 *)dsl_malloc(length + 1);
+		memcpy(ret->key, key, length);
+		ret->keylen = length;
+	}
+	return ret;
+}
+
+void DSL_CC hmac_key_free(HMAC_KEY * key) {
+	if (key == NULL) {
+		return;
+	}
+	if (key->proto != NULL) {
+		uint8 tmp[128];
+		hmac_finish(key->proto, tmp, sizeof(tmp));
+	}
+	if (key->key != NULL) {
+		hmac_key_wipe(key->key, key->keylen);
+		dsl_free(key->key);
+	}
+	dsl_freenn(key->name);
+	dsl_free(key);
+}
+
+HASH_HMAC_CTX * DSL_CC hmac_init_key(const HMAC_KEY * key) {
+	if (key->proto != NULL) {
+		return hmac_clone(key->proto);
+	}
+	return hmac_init(key->name, key->key, key->keylen);
+}
+
+size_t DSL_CC hmac_key_ctx_size(const HMAC_KEY * key) {
+	return key->ctxSize;
+}
+
+HASH_HMAC_CTX * DSL_CC hmac_init_key_inplace(const HMAC_KEY * key, void * storage, size_t size) {
+	if (key->proto == NULL || key->ctxSize == 0 || size < key->ctxSize || storage == NULL) {
+		return NULL;
+	}
+	return hmac_clone(key->proto, storage, size);
+}
+
+bool DSL_CC hmac_key_mac(const HMAC_KEY * key, const uint8 *data, size_t datalen, uint8 * out, size_t outlen) {
+	if (outlen < key->hashSize) {
+		return false;
+	}
+	// big enough for any of the native HMACs
+	alignas(DSL_HMAC_CTX_ALIGN) uint8 storage[2048];
+	HASH_HMAC_CTX * ctx = (key->ctxSize > 0 && key->ctxSize <= sizeof(storage)) ? hmac_init_key_inplace(key, storage, sizeof(storage)) : hmac_init_key(key);
+	if (ctx == NULL) {
+		return false;
+	}
+	hmac_update(ctx, data, datalen);
+	return hmac_finish(ctx, out, outlen);
+}
+
 DSL_API bool DSL_CC hmacdata(const char * name, const uint8 *key, size_t keylen, const uint8 *data, size_t datalen, char * out, size_t outlen) {
 	HASH_HMAC_CTX * ctx = hmac_init(name, key, keylen);
 	if (ctx == NULL) {
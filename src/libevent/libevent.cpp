@@ -42,10 +42,15 @@ DSL_Sockets_Events::DSL_Sockets_Events(DSL_Sockets3_Base * pSocks) {
 	dsl_libevent_init();
 	socks = pSocks;
 	evbase = event_base_new();
+	evpost = event_new(evbase, -1, 0, post_cb, this);
 }
 
 DSL_Sockets_Events::~DSL_Sockets_Events() {
 	assert(sockets.size() == 0);
+	if (evpost != NULL) {
+		event_free(evpost);
+		evpost = NULL;
+	}
 	if (evbase != NULL) {
 		event_base_free(evbase);
 		evbase = NULL;
@@ -173,6 +178,28 @@ void DSL_Sockets_Events::DisableWrite(DSL_SOCKET_LIBEVENT * s) {
 	event_del(s->evwrite);
 }
 
+void DSL_Sockets_Events::post_cb(evutil_socket_t fd, short events, void * ptr) {
+	DSL_Sockets_Events * ev = (DSL_Sockets_Events *)ptr;
+	vector<function<void()>> funcs;
+	ev->post_mutex.Lock();
+	funcs.swap(ev->posted);
+	ev->post_mutex.Release();
+	for (auto& f : funcs) {
+		f();
+	}
+}
+
+void DSL_Sockets_Events::Execute(function<void()> func) {
+	post_mutex.Lock();
+	bool activate = (posted.size() == 0);
+	posted.push_back(std::move(func));
+	post_mutex.Release();
+	if (activate) {
+		// libevent is in thread-safe mode (dsl_libevent_init) so this wakes the loop from any thread
+		event_active(evpost, 0, 0);
+	}
+}
+
 DSL_SOCKET_LIBEVENT * DSL_Sockets_Events::AddTimer(dsl_sockets_event_callback cb, bool persist, void * puser_ptr) {
 	assert(cb != NULL);
 	DSL_SOCKET_LIBEVENT * s = (DSL_SOCKET_LIBEVENT *)dsl_new(DSL_SOCKET_LIBEVENT);
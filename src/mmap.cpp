@@ -31,7 +31,7 @@ size_t DSL_CC dsl_map_page_size() {
 	return page_size;
 }
 
-DSL_MMAP_HANDLE * DSL_CC dsl_map_handle(DSL_MMAP_OS_HANDLE fd, int64 size, int64 offset, uint8 flags) {
+DSL_MMAP_HANDLE * DSL_CC dsl_map_handle(DSL_MMAP_OS_HANDLE fd, int64 size, uint64 offset, uint8 flags) {
 	bool fWrite = (flags & DSL_MMAP_WRITE) != 0;
 	bool fExec = (flags & DSL_MMAP_EXEC) != 0;
 #ifdef WIN32
@@ -42,7 +42,7 @@ DSL_MMAP_HANDLE * DSL_CC dsl_map_handle(DSL_MMAP_OS_HANDLE fd, int64 size, int64
 		}
 		size = li.QuadPart - offset;
 	}
-	if (size <= 0 || offset < 0 || offset >= size) {
+	if (size <= 0 || offset >= (uint64)size) {
 		return NULL;
 	}
 	if (sizeof(SIZE_T) < 8 && size > UINT32_MAX) {
@@ -92,7 +92,7 @@ DSL_MMAP_HANDLE * DSL_CC dsl_map_handle(DSL_MMAP_OS_HANDLE fd, int64 size, int64
 		size = lseek64(fd, 0, SEEK_END);
 		lseek64(fd, 0, SEEK_SET);
 	}
-	if (size <= 0 || offset < 0 || offset >= size) {
+	if (size <= 0 || offset >= (uint64)size) {
 		return NULL;
 	}
 	if (sizeof(size_t) < 8 && size > UINT32_MAX) {
@@ -124,7 +124,7 @@ DSL_MMAP_HANDLE * DSL_CC dsl_map_handle(DSL_MMAP_OS_HANDLE fd, int64 size, int64
 
 }
 
-DSL_MMAP_HANDLE * DSL_CC dsl_map_file(const char * fn, int64 size, int64 offset, uint8 flags) {
+DSL_MMAP_HANDLE * DSL_CC dsl_map_file(const char * fn, int64 size, uint64 offset, uint8 flags) {
 	bool fWrite = (flags & DSL_MMAP_WRITE) != 0;
 #ifdef WIN32
 	if (sizeof(SIZE_T) < 8 && size > UINT32_MAX) {
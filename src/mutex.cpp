@@ -11,22 +11,64 @@
 #include <drift/dslcore.h>
 #include <drift/mutex.h>
 #include <drift/threading.h>
+#include <drift/GenLib.h>
+#include <thread>
+#include <algorithm>
 #include <assert.h>
+#if defined(LINUX)
+#include <linux/futex.h>
+#endif
+#if !defined(WIN32)
+#include <semaphore.h>
+#include <signal.h>
+#endif
 
-DSL_Mutex::DSL_Mutex(int timeout) {
-	lock_timeout = timeout;
+static atomic<bool> mutex_profiler_on(false);
+static atomic<DSL_MUTEX_PROFILE_SITE *> mutex_profiler_sites(NULL);
+
+static inline uint64 profiler_now() {
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-bool DSL_Mutex::Lock() {
-	if (lock_timeout >= 0) {
-		return Lock(lock_timeout);
+static inline void profiler_record(atomic<uint64>& total, atomic<uint64>& max, atomic<uint64> * hist, uint64 ns) {
+	total.fetch_add(ns, memory_order_relaxed);
+	uint64 cur = max.load(memory_order_relaxed);
+	while (ns > cur && !max.compare_exchange_weak(cur, ns, memory_order_relaxed)) {}
+	uint64 us = ns / 1000;
+	int bucket = 0;
+	while (us && bucket < DSL_MUTEX_PROFILE_BUCKETS - 1) {
+		us >>= 1;
+		bucket++;
 	}
+	hist[bucket].fetch_add(1, memory_order_relaxed);
+}
 
-	hMutex.lock();
-	return true;
+DSL_MUTEX_PROFILE_SITE::DSL_MUTEX_PROFILE_SITE(const char * pfile, int pline) {
+	file = pfile;
+	line = pline;
+	Reset();
+	next = mutex_profiler_sites.load();
+	while (!mutex_profiler_sites.compare_exchange_weak(next, this)) {}
 }
 
-bool DSL_Mutex::Lock(int timeout) {
+void DSL_MUTEX_PROFILE_SITE::Reset() {
+	count = 0;
+	contended = 0;
+	wait_total = 0;
+	wait_max = 0;
+	hold_total = 0;
+	hold_max = 0;
+	for (int i = 0; i < DSL_MUTEX_PROFILE_BUCKETS; i++) {
+		wait_hist[i] = 0;
+		hold_hist[i] = 0;
+	}
+}
+
+DSL_Mutex::DSL_Mutex(int timeout) {
+	lock_timeout = timeout;
+}
+
+bool DSL_Mutex::lock_raw(int timeout) {
 	if (timeout < 0) {
 		hMutex.lock();
 		return true;
@@ -38,6 +80,407 @@ bool DSL_Mutex::Lock(int timeout) {
 	}
 }
 
+bool DSL_Mutex::Lock() {
+	return Lock(lock_timeout);
+}
+
+bool DSL_Mutex::Lock(int timeout) {
+	if (!lock_raw(timeout)) {
+		return false;
+	}
+	if (prof_site != NULL) {
+		prof_depth++;
+	}
+	return true;
+}
+
+bool DSL_Mutex::Lock(DSL_MUTEX_PROFILE_SITE * site) {
+	if (site == NULL || !mutex_profiler_on.load(memory_order_relaxed)) {
+		return Lock(lock_timeout);
+	}
+
+	uint64 start = profiler_now();
+	bool contended = !hMutex.try_lock();
+	if (contended && (lock_timeout == 0 || !lock_raw(lock_timeout))) {
+		return false;
+	}
+
+	uint64 now = start;
+	site->count.fetch_add(1, memory_order_relaxed);
+	if (contended) {
+		now = profiler_now();
+		site->contended.fetch_add(1, memory_order_relaxed);
+		profiler_record(site->wait_total, site->wait_max, site->wait_hist, now - start);
+	}
+	if (prof_site == NULL) {
+		prof_site = site;
+		prof_depth = 1;
+		prof_start = now;
+	} else {
+		prof_depth++;
+	}
+	return true;
+}
+
 void DSL_Mutex::Release() {
+	if (prof_site != NULL && --prof_depth == 0) {
+		profiler_record(prof_site->hold_total, prof_site->hold_max, prof_site->hold_hist, profiler_now() - prof_start);
+		prof_site = NULL;
+	}
 	hMutex.unlock();
 }
+
+void DSL_CC dsl_mutex_profiler_enable(bool enable) {
+	mutex_profiler_on = enable;
+}
+bool DSL_CC dsl_mutex_profiler_enabled() {
+	return mutex_profiler_on;
+}
+DSL_MUTEX_PROFILE_SITE * DSL_CC dsl_mutex_profiler_first_site() {
+	return mutex_profiler_sites.load();
+}
+void DSL_CC dsl_mutex_profiler_reset() {
+	for (DSL_MUTEX_PROFILE_SITE * site = mutex_profiler_sites.load(); site != NULL; site = site->next) {
+		site->Reset();
+	}
+}
+
+static void profiler_print_hist(FILE * fp, const char * name, const atomic<uint64> * hist) {
+	fprintf(fp, "    %s:", name);
+	for (int i = 0; i < DSL_MUTEX_PROFILE_BUCKETS; i++) {
+		uint64 n = hist[i].load(memory_order_relaxed);
+		if (n == 0) { continue; }
+		if (i == DSL_MUTEX_PROFILE_BUCKETS - 1) {
+			fprintf(fp, " >=%uus=" U64FMT, 1U << (i - 1), n);
+		} else {
+			fprintf(fp, " <%uus=" U64FMT, 1U << i, n);
+		}
+	}
+	fprintf(fp, "\n");
+}
+
+void DSL_CC dsl_mutex_profiler_report(FILE * fp, bool show_histograms) {
+	vector<DSL_MUTEX_PROFILE_SITE *> sites;
+	for (DSL_MUTEX_PROFILE_SITE * site = mutex_profiler_sites.load(); site != NULL; site = site->next) {
+		if (site->count.load(memory_order_relaxed) > 0) {
+			sites.push_back(site);
+		}
+	}
+	sort(sites.begin(), sites.end(), [](const DSL_MUTEX_PROFILE_SITE * a, const DSL_MUTEX_PROFILE_SITE * b) { return a->wait_total.load() > b->wait_total.load(); });
+
+	fprintf(fp, "DSL_Mutex contention profile (%zu call sites, profiler %s):\n", sites.size(), mutex_profiler_on ? "on" : "off");
+	for (auto * site : sites) {
+		uint64 count = site->count.load(memory_order_relaxed);
+		uint64 contended = site->contended.load(memory_order_relaxed);
+		fprintf(fp, "  %s:%d: " U64FMT " locks, " U64FMT " contended (%.1f%%)\n", site->file, site->line, count, contended, (double)contended * 100 / count);
+		fprintf(fp, "    wait total %.3fms, avg %.3fus, max %.3fms / hold total %.3fms, avg %.3fus, max %.3fms\n",
+			site->wait_total.load() / 1000000.0, contended ? site->wait_total.load() / 1000.0 / contended : 0.0, site->wait_max.load() / 1000000.0,
+			site->hold_total.load() / 1000000.0, site->hold_total.load() / 1000.0 / count, site->hold_max.load() / 1000000.0);
+		if (show_histograms && contended) {
+			profiler_print_hist(fp, "wait", site->wait_hist);
+			profiler_print_hist(fp, "hold", site->hold_hist);
+		}
+	}
+	fflush(fp);
+}
+
+#if !defined(WIN32)
+/*
+ * profiler_started, profiler_sig and profiler_old_sa are only touched under dslMutex(). The dump thread never takes that one since dsl_cleanup() holds it
+ * while waiting for the thread to exit, the file name has its own mutex instead.
+ */
+static sem_t profiler_sem, profiler_done_sem;
+static DSL_FastMutex profiler_dump_mutex;
+static string profiler_dump_fn;
+static atomic<bool> profiler_stop(false);
+static bool profiler_started = false;
+static int profiler_sig = 0;
+static struct sigaction profiler_old_sa;
+
+static void profiler_signal_handler(int sig) {
+	sem_post(&profiler_sem); // about the only thing that is async-signal-safe here
+}
+
+DSL_DEFINE_THREAD(ProfilerDumpThread) {
+	while (1) {
+		if (sem_wait(&profiler_sem) != 0) {
+			continue;
+		}
+		if (profiler_stop.load()) {
+			break;
+		}
+		string fn;
+		{
+			AutoFastMutex(profiler_dump_mutex);
+			fn = profiler_dump_fn;
+		}
+		if (fn.length()) {
+			FILE * fp = fopen(fn.c_str(), "ab");
+			if (fp != NULL) {
+				dsl_mutex_profiler_report(fp);
+				fclose(fp);
+			}
+		} else {
+			dsl_mutex_profiler_report(stderr);
+		}
+	}
+	sem_post(&profiler_done_sem);
+	return NULL;
+}
+
+bool DSL_CC dsl_mutex_profiler_dump_on_signal(int sig, const char * filename) {
+	AutoMutexPtr(dslMutex());
+	{
+		AutoFastMutex(profiler_dump_mutex);
+		profiler_dump_fn = filename ? filename : "";
+	}
+	if (!profiler_started) {
+		if (sem_init(&profiler_sem, 0, 0) != 0) {
+			return false;
+		}
+		if (sem_init(&profiler_done_sem, 0, 0) != 0) {
+			sem_destroy(&profiler_sem);
+			return false;
+		}
+		profiler_stop = false;
+		if (!DSL_StartThreadNoRecord(ProfilerDumpThread, NULL, "Mutex Profiler")) {
+			sem_destroy(&profiler_sem);
+			sem_destroy(&profiler_done_sem);
+			return false;
+		}
+		profiler_started = true;
+	} else if (sig != profiler_sig) {
+		// moving to a different signal, give the old one back its previous handler
+		sigaction(profiler_sig, &profiler_old_sa, NULL);
+		profiler_sig = 0;
+	}
+	if (profiler_sig != 0 && sig == profiler_sig) {
+		return true;
+	}
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = profiler_signal_handler;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = SA_RESTART;
+	if (sigaction(sig, &sa, &profiler_old_sa) != 0) {
+		return false;
+	}
+	profiler_sig = sig;
+	return true;
+}
+
+/* Called by dsl_cleanup() with dslMutex() held */
+void dsl_cleanup_mutex_profiler() {
+	if (!profiler_started) {
+		return;
+	}
+	// put the old handler back first so a late signal can't post to a destroyed semaphore
+	if (profiler_sig != 0) {
+		sigaction(profiler_sig, &profiler_old_sa, NULL);
+		profiler_sig = 0;
+	}
+	profiler_stop = true;
+	sem_post(&profiler_sem);
+	while (sem_wait(&profiler_done_sem) != 0 && errno == EINTR) {}
+	sem_destroy(&profiler_sem);
+	sem_destroy(&profiler_done_sem);
+	profiler_started = false;
+}
+#else
+bool DSL_CC dsl_mutex_profiler_dump_on_signal(int sig, const char * filename) {
+	return false;
+}
+
+void dsl_cleanup_mutex_profiler() {}
+#endif
+
+DSL_EventCount::DSL_EventCount() {
+	seq = 0;
+	waiters = 0;
+}
+
+uint32 DSL_EventCount::PrepareWait() {
+	waiters.fetch_add(1);
+	return seq.load();
+}
+
+void DSL_EventCount::CancelWait() {
+	waiters.fetch_sub(1);
+}
+
+bool DSL_EventCount::Wait(uint32 key, int timeout) {
+	bool ret = true;
+#if defined(LINUX)
+	if (seq.load() == key) {
+		struct timespec ts, * pts = NULL;
+		if (timeout >= 0) {
+			ts.tv_sec = timeout / 1000;
+			ts.tv_nsec = (timeout % 1000) * 1000000;
+			pts = &ts;
+		}
+		if (syscall(SYS_futex, (uint32 *)&seq, FUTEX_WAIT_PRIVATE, key, pts, NULL, 0) == -1 && errno == ETIMEDOUT) {
+			ret = false;
+		}
+	}
+#else
+	unique_lock<mutex> lock(hMutex);
+	if (timeout < 0) {
+		hCond.wait(lock, [&] { return seq.load() != key; });
+	} else {
+		ret = hCond.wait_for(lock, chrono::milliseconds(timeout), [&] { return seq.load() != key; });
+	}
+#endif
+	waiters.fetch_sub(1);
+	return ret;
+}
+
+void DSL_EventCount::Notify(bool all) {
+	// pairs with the waiters increment in PrepareWait() so either we see the waiter or it sees the new state
+	atomic_thread_fence(memory_order_seq_cst);
+	if (waiters.load(memory_order_relaxed) == 0) {
+		return;
+	}
+#if defined(LINUX)
+	seq.fetch_add(1);
+	syscall(SYS_futex, (uint32 *)&seq, FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, NULL, NULL, 0);
+#else
+	{
+		lock_guard<mutex> lock(hMutex);
+		seq.fetch_add(1);
+	}
+	if (all) {
+		hCond.notify_all();
+	} else {
+		hCond.notify_one();
+	}
+#endif
+}
+
+#define FAST_MUTEX_MAX_SPIN 256
+
+static int fast_mutex_max_spin() {
+	// spinning is pointless on a single core machine, the holder can't run while we spin
+	static int max_spin = (thread::hardware_concurrency() > 1) ? FAST_MUTEX_MAX_SPIN : 0;
+	return max_spin;
+}
+
+DSL_FastMutex::DSL_FastMutex() {
+	state = 0;
+	spin_avg = 16;
+}
+
+bool DSL_FastMutex::lock_slow(int timeout) {
+	int max_spin = fast_mutex_max_spin();
+	if (max_spin > 0) {
+		// adaptive spinning like glibc's PTHREAD_MUTEX_ADAPTIVE_NP, spin a bit longer than it usually took to get the lock
+		int avg = spin_avg.load(memory_order_relaxed);
+		int limit = avg * 2 + 10;
+		if (limit > max_spin) { limit = max_spin; }
+		for (int i = 0; i < limit; i++) {
+			dsl_cpu_relax();
+			if (state.load(memory_order_relaxed) == 0 && TryLock()) {
+				spin_avg.store(avg + (i - avg) / 8, memory_order_relaxed);
+				return true;
+			}
+		}
+		spin_avg.store(avg + (limit - avg) / 8, memory_order_relaxed);
+	}
+
+	uint64 end = (timeout > 0) ? GetTickCount64() + timeout : 0;
+	while (state.exchange(2, memory_order_acquire) != 0) {
+		uint32 key = hEvent.PrepareWait();
+		if (state.load() != 2) {
+			hEvent.CancelWait();
+			continue;
+		}
+		int left = -1;
+		if (timeout > 0) {
+			uint64 now = GetTickCount64();
+			if (now >= end) {
+				hEvent.CancelWait();
+				return false;
+			}
+			left = (int)(end - now);
+		}
+		hEvent.Wait(key, left);
+	}
+	return true;
+}
+
+#define DSL_RWLOCK_WRITER 0x80000000
+#define DSL_RWLOCK_WRITER_WAITING 0x40000000
+#define DSL_RWLOCK_READERS 0x3FFFFFFF
+
+DSL_RWLock::DSL_RWLock() {
+	state = 0;
+}
+
+bool DSL_RWLock::TryLockRead() {
+	uint32 s = state.load(memory_order_relaxed);
+	while (!(s & (DSL_RWLOCK_WRITER | DSL_RWLOCK_WRITER_WAITING))) {
+		if (state.compare_exchange_weak(s, s + 1, memory_order_acquire, memory_order_relaxed)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void DSL_RWLock::LockRead() {
+	while (!TryLockRead()) {
+		uint32 key = read_event.PrepareWait();
+		if (state.load() & (DSL_RWLOCK_WRITER | DSL_RWLOCK_WRITER_WAITING)) {
+			read_event.Wait(key);
+		} else {
+			read_event.CancelWait();
+		}
+	}
+}
+
+void DSL_RWLock::ReleaseRead() {
+	uint32 s = state.fetch_sub(1, memory_order_release);
+	if ((s & DSL_RWLOCK_READERS) == 1 && (s & DSL_RWLOCK_WRITER_WAITING)) {
+		write_event.Notify(false);
+	}
+}
+
+bool DSL_RWLock::TryLockWrite() {
+	uint32 s = state.load(memory_order_relaxed);
+	while (!(s & (DSL_RWLOCK_WRITER | DSL_RWLOCK_READERS))) {
+		// this clears WRITER_WAITING, other waiting writers set it again when they wake up
+		if (state.compare_exchange_weak(s, DSL_RWLOCK_WRITER, memory_order_acquire, memory_order_relaxed)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void DSL_RWLock::LockWrite() {
+	while (!TryLockWrite()) {
+		state.fetch_or(DSL_RWLOCK_WRITER_WAITING);
+		uint32 key = write_event.PrepareWait();
+		if (state.load() & (DSL_RWLOCK_WRITER | DSL_RWLOCK_READERS)) {
+			write_event.Wait(key);
+		} else {
+			write_event.CancelWait();
+		}
+	}
+}
+
+void DSL_RWLock::ReleaseWrite() {
+	state.fetch_and(~DSL_RWLOCK_WRITER, memory_order_release);
+	// both are cheap if nobody is waiting, readers that lose to a waiting writer just go back to sleep
+	write_event.Notify(false);
+	read_event.Notify(true);
+}
+
+void DSL_SpinLock::Lock() {
+	int spins = 0;
+	while (!TryLock()) {
+		if (++spins >= 64) {
+			this_thread::yield();
+			spins = 0;
+		} else {
+			dsl_cpu_relax();
+		}
+	}
+}
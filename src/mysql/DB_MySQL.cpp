@@ -144,7 +144,7 @@ uint64 DB_MySQL::AffectedRows() {
 }
 
 uint32 DB_MySQL::GetQueryCount() {
-	return query_count;
+	return (uint32)query_count.Get();
 }
 
 string DB_MySQL::GetErrorString() {
@@ -20,24 +20,49 @@ extern "C" {
 }
 #endif
 
-HASH_CTX * dsl_openssl_hash_init(const char * name) {
-	const EVP_MD * md = EVP_get_digestbyname(name);
-	if (md == NULL) {
-		return NULL;
-	}
+const void * dsl_openssl_hash_lookup(const char * name) {
+	return EVP_get_digestbyname(name);
+}
+
+static HASH_CTX * dsl_openssl_hash_setup(HASH_CTX * ret, const EVP_MD * md) {
 	EVP_MD_CTX * ctx = EVP_MD_CTX_create();
 	if (EVP_DigestInit_ex(ctx, md, NULL) == 0) {
 		EVP_MD_CTX_destroy(ctx);
 		return NULL;
 	}
-	HASH_CTX * ret = dsl_new(HASH_CTX);
-	memset(ret, 0, sizeof(HASH_CTX));
 	ret->pptr1 = (void *)ctx;
 	ret->hashSize = EVP_MD_size(md);
 	ret->blockSize = EVP_MD_block_size(md);
 	return ret;
 }
 
+HASH_CTX * dsl_openssl_hash_init_algo(const void * impl) {
+	HASH_CTX * ret = dsl_new(HASH_CTX);
+	memset(ret, 0, sizeof(HASH_CTX));
+	if (dsl_openssl_hash_setup(ret, (const EVP_MD *)impl) == NULL) {
+		dsl_free(ret);
+		return NULL;
+	}
+	return ret;
+}
+
+size_t dsl_openssl_hash_ctx_size(const void * impl) {
+	// only the HASH_CTX, OpenSSL allocates the EVP_MD_CTX itself
+	return sizeof(HASH_CTX);
+}
+
+HASH_CTX * dsl_openssl_hash_init_inplace(const void * impl, void * storage) {
+	HASH_CTX * ret = (HASH_CTX *)storage;
+	memset(ret, 0, sizeof(HASH_CTX));
+	ret->inplace = true;
+	return dsl_openssl_hash_setup(ret, (const EVP_MD *)impl);
+}
+
+HASH_CTX * dsl_openssl_hash_init(const char * name) {
+	const void * md = dsl_openssl_hash_lookup(name);
+	return (md != NULL) ? dsl_openssl_hash_init_algo(md) : NULL;
+}
+
 void dsl_openssl_hash_update(HASH_CTX *ctx, const uint8 *data, size_t len) {
 	EVP_MD_CTX * pctx = (EVP_MD_CTX *)ctx->pptr1;
 	EVP_DigestUpdate(pctx, data, len);
@@ -49,7 +74,36 @@ bool dsl_openssl_hash_finish(HASH_CTX *ctx, uint8 * out, size_t outlen) {
 	unsigned int slen = outlen;
 	bool ret = (EVP_DigestFinal_ex(pctx, out, &slen) != 0);
 	EVP_MD_CTX_destroy(pctx);
-	dsl_free(ctx);
+	if (!ctx->inplace) {
+		dsl_free(ctx);
+	}
+	return ret;
+}
+
+bool dsl_openssl_hash_reset(HASH_CTX *ctx, uint8 * out, size_t outlen) {
+	EVP_MD_CTX * pctx = (EVP_MD_CTX *)ctx->pptr1;
+	bool ret = true;
+	if (out != NULL) {
+		unsigned int slen = outlen;
+		ret = (EVP_DigestFinal_ex(pctx, out, &slen) != 0);
+	}
+	// a NULL type restarts with the digest pctx already has
+	return (EVP_DigestInit_ex(pctx, NULL, NULL) != 0) && ret;
+}
+
+HASH_CTX * dsl_openssl_hash_clone(const HASH_CTX *ctx, void * storage, size_t size) {
+	if (storage != NULL && size < sizeof(HASH_CTX)) {
+		return NULL;
+	}
+	EVP_MD_CTX * pctx = EVP_MD_CTX_create();
+	if (EVP_MD_CTX_copy_ex(pctx, (const EVP_MD_CTX *)ctx->pptr1) == 0) {
+		EVP_MD_CTX_destroy(pctx);
+		return NULL;
+	}
+	HASH_CTX * ret = (storage != NULL) ? (HASH_CTX *)storage : dsl_new(HASH_CTX);
+	*ret = *ctx;
+	ret->pptr1 = (void *)pctx;
+	ret->inplace = (storage != NULL);
 	return ret;
 }
 
@@ -57,44 +111,78 @@ const HASH_PROVIDER openssl_hash_provider = {
 	"openssl",
 	dsl_openssl_hash_init,
 	dsl_openssl_hash_update,
-	dsl_openssl_hash_finish
+	dsl_openssl_hash_finish,
+	NULL,
+	dsl_openssl_hash_lookup,
+	dsl_openssl_hash_init_algo,
+	dsl_openssl_hash_ctx_size,
+	dsl_openssl_hash_init_inplace,
+	dsl_openssl_hash_reset,
+	dsl_openssl_hash_clone
 };
 
-HASH_HMAC_CTX * dsl_openssl_hmac_init(const char * name, const uint8 *key, size_t length) {
-	const EVP_MD * md = EVP_get_digestbyname(name);
-	if (md == NULL) {
-		return NULL;
+static HMAC_CTX * dsl_openssl_hmac_ctx_new() {
+#if OPENSSL_VERSION_NUMBER > 0x10100000
+	return HMAC_CTX_new();
+#else
+	HMAC_CTX * ctx = dsl_new(HMAC_CTX);
+	if (ctx != NULL) {
+		HMAC_CTX_init(ctx);
 	}
+	return ctx;
+#endif
+}
 
+static void dsl_openssl_hmac_ctx_free(HMAC_CTX * ctx) {
 #if OPENSSL_VERSION_NUMBER > 0x10100000
-	HMAC_CTX * ctx = HMAC_CTX_new();
-	if (ctx == NULL) {
+	HMAC_CTX_free(ctx);
+#else
+	HMAC_CTX_cleanup(ctx);
+	dsl_free(ctx);
+#endif
+}
+
+static HASH_HMAC_CTX * dsl_openssl_hmac_setup(HASH_HMAC_CTX * ret, const char * name, const uint8 *key, size_t length) {
+	const EVP_MD * md = EVP_get_digestbyname(name);
+	if (md == NULL) {
 		return NULL;
 	}
-#else
-	HMAC_CTX * ctx = dsl_new(HMAC_CTX);
+
+	HMAC_CTX * ctx = dsl_openssl_hmac_ctx_new();
 	if (ctx == NULL) {
 		return NULL;
 	}
-	HMAC_CTX_init(ctx);
-#endif
 	if (HMAC_Init_ex(ctx, key, length, md, NULL) == 0) {
-#if OPENSSL_VERSION_NUMBER > 0x10100000
-		HMAC_CTX_free(ctx);
-#else
-		HMAC_CTX_cleanup(ctx);
-		dsl_free(ctx);
-#endif
+		dsl_openssl_hmac_ctx_free(ctx);
 		return NULL;
 	}
 
-	HASH_HMAC_CTX * ret = dsl_new(HASH_HMAC_CTX);
-	memset(ret, 0, sizeof(HASH_HMAC_CTX));
 	ret->pptr1 = (void *)ctx;
 	ret->hashSize = EVP_MD_size(md);
 	return ret;
 }
 
+HASH_HMAC_CTX * dsl_openssl_hmac_init(const char * name, const uint8 *key, size_t length) {
+	HASH_HMAC_CTX * ret = dsl_new(HASH_HMAC_CTX);
+	memset(ret, 0, sizeof(HASH_HMAC_CTX));
+	if (dsl_openssl_hmac_setup(ret, name, key, length) == NULL) {
+		dsl_free(ret);
+		return NULL;
+	}
+	return ret;
+}
+
+size_t dsl_openssl_hmac_ctx_size(const char * name) {
+	return (EVP_get_digestbyname(name) != NULL) ? sizeof(HASH_HMAC_CTX) : 0;
+}
+
+HASH_HMAC_CTX * dsl_openssl_hmac_init_inplace(const char * name, const uint8 *key, size_t length, void * storage) {
+	HASH_HMAC_CTX * ret = (HASH_HMAC_CTX *)storage;
+	memset(ret, 0, sizeof(HASH_HMAC_CTX));
+	ret->inplace = true;
+	return dsl_openssl_hmac_setup(ret, name, key, length);
+}
+
 void dsl_openssl_hmac_update(HASH_HMAC_CTX *ctx, const uint8 *data, size_t len) {
 	HMAC_CTX * pctx = (HMAC_CTX *)ctx->pptr1;
 	HMAC_Update(pctx, data, len);
@@ -104,13 +192,40 @@ bool dsl_openssl_hmac_finish(HASH_HMAC_CTX *ctx, uint8 * out, size_t outlen) {
 	HMAC_CTX * pctx = (HMAC_CTX *)ctx->pptr1;
 	unsigned int slen = outlen;
 	bool ret = (HMAC_Final(pctx, out, &slen) != 0);
-#if OPENSSL_VERSION_NUMBER > 0x10100000
-	HMAC_CTX_free(pctx);
-#else
-	HMAC_CTX_cleanup(pctx);
-	dsl_free(pctx);
-#endif
-	dsl_free(ctx);
+	dsl_openssl_hmac_ctx_free(pctx);
+	if (!ctx->inplace) {
+		dsl_free(ctx);
+	}
+	return ret;
+}
+
+bool dsl_openssl_hmac_reset(HASH_HMAC_CTX *ctx, uint8 * out, size_t outlen) {
+	HMAC_CTX * pctx = (HMAC_CTX *)ctx->pptr1;
+	bool ret = true;
+	if (out != NULL) {
+		unsigned int slen = outlen;
+		ret = (HMAC_Final(pctx, out, &slen) != 0);
+	}
+	// a NULL key and md reuse the ones pctx already has
+	return (HMAC_Init_ex(pctx, NULL, 0, NULL, NULL) != 0) && ret;
+}
+
+HASH_HMAC_CTX * dsl_openssl_hmac_clone(const HASH_HMAC_CTX *ctx, void * storage, size_t size) {
+	if (storage != NULL && size < sizeof(HASH_HMAC_CTX)) {
+		return NULL;
+	}
+	HMAC_CTX * pctx = dsl_openssl_hmac_ctx_new();
+	if (pctx == NULL) {
+		return NULL;
+	}
+	if (HMAC_CTX_copy(pctx, (HMAC_CTX *)ctx->pptr1) == 0) {
+		dsl_openssl_hmac_ctx_free(pctx);
+		return NULL;
+	}
+	HASH_HMAC_CTX * ret = (storage != NULL) ? (HASH_HMAC_CTX *)storage : dsl_new(HASH_HMAC_CTX);
+	*ret = *ctx;
+	ret->pptr1 = (void *)pctx;
+	ret->inplace = (storage != NULL);
 	return ret;
 }
 
@@ -118,7 +233,11 @@ const HMAC_PROVIDER openssl_hmac_provider = {
 	"openssl",
 	dsl_openssl_hmac_init,
 	dsl_openssl_hmac_update,
-	dsl_openssl_hmac_finish
+	dsl_openssl_hmac_finish,
+	dsl_openssl_hmac_ctx_size,
+	dsl_openssl_hmac_init_inplace,
+	dsl_openssl_hmac_reset,
+	dsl_openssl_hmac_clone
 };
 
 bool openssl_has_init = false;
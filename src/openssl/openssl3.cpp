@@ -20,24 +20,69 @@ extern "C" {
 }
 #endif
 
-HASH_CTX * dsl_openssl_hash_init(const char * name) {
-	const EVP_MD * md = EVP_get_digestbyname(name);
+/*
+ * OpenSSL 3 re-fetches the implementation on every EVP_DigestInit_ex() with a non-fetched EVP_MD, which takes a global lock inside OpenSSL.
+ * Handles from hash_algo_lookup() hold an explicitly fetched one instead, they are freed in dsl_openssl_cleanup().
+ */
+DSL_Mutex * dslOpenSSLDigestsMutex() {
+	static DSL_Mutex actualMutex;
+	return &actualMutex;
+}
+static vector<EVP_MD *> openssl_fetched_digests;
+
+const void * dsl_openssl_hash_lookup(const char * name) {
+	EVP_MD * md = EVP_MD_fetch(NULL, name, NULL);
 	if (md == NULL) {
-		return NULL;
+		// EVP_get_digestbyname() knows some legacy aliases fetching doesn't
+		const EVP_MD * legacy = EVP_get_digestbyname(name);
+		if (legacy == NULL || (md = EVP_MD_fetch(NULL, EVP_MD_get0_name(legacy), NULL)) == NULL) {
+			return NULL;
+		}
 	}
+	AutoMutexPtr(dslOpenSSLDigestsMutex());
+	openssl_fetched_digests.push_back(md);
+	return md;
+}
+
+static HASH_CTX * dsl_openssl_hash_setup(HASH_CTX * ret, const EVP_MD * md) {
 	EVP_MD_CTX * ctx = EVP_MD_CTX_create();
 	if (EVP_DigestInit_ex(ctx, md, NULL) == 0) {
 		EVP_MD_CTX_destroy(ctx);
 		return NULL;
 	}
-	HASH_CTX * ret = dsl_new(HASH_CTX);
-	memset(ret, 0, sizeof(HASH_CTX));
 	ret->pptr1 = (void *)ctx;
 	ret->hashSize = EVP_MD_size(md);
 	ret->blockSize = EVP_MD_block_size(md);
 	return ret;
 }
 
+HASH_CTX * dsl_openssl_hash_init_algo(const void * impl) {
+	HASH_CTX * ret = dsl_new(HASH_CTX);
+	memset(ret, 0, sizeof(HASH_CTX));
+	if (dsl_openssl_hash_setup(ret, (const EVP_MD *)impl) == NULL) {
+		dsl_free(ret);
+		return NULL;
+	}
+	return ret;
+}
+
+size_t dsl_openssl_hash_ctx_size(const void * impl) {
+	// only the HASH_CTX, OpenSSL allocates the EVP_MD_CTX itself
+	return sizeof(HASH_CTX);
+}
+
+HASH_CTX * dsl_openssl_hash_init_inplace(const void * impl, void * storage) {
+	HASH_CTX * ret = (HASH_CTX *)storage;
+	memset(ret, 0, sizeof(HASH_CTX));
+	ret->inplace = true;
+	return dsl_openssl_hash_setup(ret, (const EVP_MD *)impl);
+}
+
+HASH_CTX * dsl_openssl_hash_init(const char * name) {
+	const EVP_MD * md = EVP_get_digestbyname(name);
+	return (md != NULL) ? dsl_openssl_hash_init_algo(md) : NULL;
+}
+
 void dsl_openssl_hash_update(HASH_CTX *ctx, const uint8 *data, size_t len) {
 	EVP_MD_CTX * pctx = (EVP_MD_CTX *)ctx->pptr1;
 	EVP_DigestUpdate(pctx, data, len);
@@ -49,7 +94,36 @@ bool dsl_openssl_hash_finish(HASH_CTX *ctx, uint8 * out, size_t outlen) {
 	unsigned int slen = outlen;
 	bool ret = (EVP_DigestFinal_ex(pctx, out, &slen) != 0);
 	EVP_MD_CTX_destroy(pctx);
-	dsl_free(ctx);
+	if (!ctx->inplace) {
+		dsl_free(ctx);
+	}
+	return ret;
+}
+
+bool dsl_openssl_hash_reset(HASH_CTX *ctx, uint8 * out, size_t outlen) {
+	EVP_MD_CTX * pctx = (EVP_MD_CTX *)ctx->pptr1;
+	bool ret = true;
+	if (out != NULL) {
+		unsigned int slen = outlen;
+		ret = (EVP_DigestFinal_ex(pctx, out, &slen) != 0);
+	}
+	// a NULL type restarts with the digest pctx already has
+	return (EVP_DigestInit_ex(pctx, NULL, NULL) != 0) && ret;
+}
+
+HASH_CTX * dsl_openssl_hash_clone(const HASH_CTX *ctx, void * storage, size_t size) {
+	if (storage != NULL && size < sizeof(HASH_CTX)) {
+		return NULL;
+	}
+	EVP_MD_CTX * pctx = EVP_MD_CTX_create();
+	if (EVP_MD_CTX_copy_ex(pctx, (const EVP_MD_CTX *)ctx->pptr1) == 0) {
+		EVP_MD_CTX_destroy(pctx);
+		return NULL;
+	}
+	HASH_CTX * ret = (storage != NULL) ? (HASH_CTX *)storage : dsl_new(HASH_CTX);
+	*ret = *ctx;
+	ret->pptr1 = (void *)pctx;
+	ret->inplace = (storage != NULL);
 	return ret;
 }
 
@@ -57,20 +131,27 @@ const HASH_PROVIDER openssl_hash_provider = {
 	"openssl",
 	dsl_openssl_hash_init,
 	dsl_openssl_hash_update,
-	dsl_openssl_hash_finish
+	dsl_openssl_hash_finish,
+	NULL,
+	dsl_openssl_hash_lookup,
+	dsl_openssl_hash_init_algo,
+	dsl_openssl_hash_ctx_size,
+	dsl_openssl_hash_init_inplace,
+	dsl_openssl_hash_reset,
+	dsl_openssl_hash_clone
 };
 
-HASH_HMAC_CTX * dsl_openssl_hmac_init(const char * name, const uint8 *key, size_t length) {
-	EVP_MAC * mac = EVP_MAC_fetch(NULL, "HMAC", NULL);
-	if (mac == NULL) {
+// fetched once in dsl_openssl_init() for the same reason as the digests above
+static EVP_MAC * openssl_hmac_mac = NULL;
+
+static HASH_HMAC_CTX * dsl_openssl_hmac_setup(HASH_HMAC_CTX * ret, const char * name, const uint8 *key, size_t length) {
+	if (openssl_hmac_mac == NULL) {
 		return NULL;
 	}
-	EVP_MAC_CTX * ctx = EVP_MAC_CTX_new(mac);
+	EVP_MAC_CTX * ctx = EVP_MAC_CTX_new(openssl_hmac_mac);
 	if (ctx == NULL) {
-		EVP_MAC_free(mac);
 		return NULL;
 	}
-	EVP_MAC_free(mac);
 
 	OSSL_PARAM params[2];
 	params[0] = OSSL_PARAM_construct_utf8_string("digest", (char *)name, 0);
@@ -81,13 +162,44 @@ HASH_HMAC_CTX * dsl_openssl_hmac_init(const char * name, const uint8 *key, size_
 		return NULL;
 	}
 
-	HASH_HMAC_CTX * ret = dsl_new(HASH_HMAC_CTX);
-	memset(ret, 0, sizeof(HASH_HMAC_CTX));
 	ret->pptr1 = (void *)ctx;
 	ret->hashSize = EVP_MAC_CTX_get_mac_size(ctx);
 	return ret;
 }
 
+HASH_HMAC_CTX * dsl_openssl_hmac_init(const char * name, const uint8 *key, size_t length) {
+	HASH_HMAC_CTX * ret = dsl_new(HASH_HMAC_CTX);
+	memset(ret, 0, sizeof(HASH_HMAC_CTX));
+	if (dsl_openssl_hmac_setup(ret, name, key, length) == NULL) {
+		dsl_free(ret);
+		return NULL;
+	}
+	return ret;
+}
+
+size_t dsl_openssl_hmac_ctx_size(const char * name) {
+	/*
+	 * This is called on every hmac_init_inplace(), so don't go through dsl_openssl_hash_lookup(): that's for hash_algo_lookup() and keeps what it fetches until cleanup.
+	 * The legacy table covers the usual names without taking a reference, anything only a provider knows is fetched and released right away.
+	 */
+	if (EVP_get_digestbyname(name) != NULL) {
+		return sizeof(HASH_HMAC_CTX);
+	}
+	EVP_MD * md = EVP_MD_fetch(NULL, name, NULL);
+	if (md == NULL) {
+		return 0;
+	}
+	EVP_MD_free(md);
+	return sizeof(HASH_HMAC_CTX);
+}
+
+HASH_HMAC_CTX * dsl_openssl_hmac_init_inplace(const char * name, const uint8 *key, size_t length, void * storage) {
+	HASH_HMAC_CTX * ret = (HASH_HMAC_CTX *)storage;
+	memset(ret, 0, sizeof(HASH_HMAC_CTX));
+	ret->inplace = true;
+	return dsl_openssl_hmac_setup(ret, name, key, length);
+}
+
 void dsl_openssl_hmac_update(HASH_HMAC_CTX *ctx, const uint8 *data, size_t len) {
 	EVP_MAC_CTX * pctx = (EVP_MAC_CTX *)ctx->pptr1;
 	EVP_MAC_update(pctx, data, len);
@@ -98,7 +210,35 @@ bool dsl_openssl_hmac_finish(HASH_HMAC_CTX *ctx, uint8 * out, size_t outlen) {
 	size_t slen = outlen;
 	bool ret = (EVP_MAC_final(pctx, out, &slen, outlen) != 0);
 	EVP_MAC_CTX_free(pctx);
-	dsl_free(ctx);
+	if (!ctx->inplace) {
+		dsl_free(ctx);
+	}
+	return ret;
+}
+
+bool dsl_openssl_hmac_reset(HASH_HMAC_CTX *ctx, uint8 * out, size_t outlen) {
+	EVP_MAC_CTX * pctx = (EVP_MAC_CTX *)ctx->pptr1;
+	bool ret = true;
+	if (out != NULL) {
+		size_t slen = outlen;
+		ret = (EVP_MAC_final(pctx, out, &slen, outlen) != 0);
+	}
+	// a NULL key reuses the one pctx already has
+	return (EVP_MAC_init(pctx, NULL, 0, NULL) != 0) && ret;
+}
+
+HASH_HMAC_CTX * dsl_openssl_hmac_clone(const HASH_HMAC_CTX *ctx, void * storage, size_t size) {
+	if (storage != NULL && size < sizeof(HASH_HMAC_CTX)) {
+		return NULL;
+	}
+	EVP_MAC_CTX * pctx = EVP_MAC_CTX_dup((const EVP_MAC_CTX *)ctx->pptr1);
+	if (pctx == NULL) {
+		return NULL;
+	}
+	HASH_HMAC_CTX * ret = (storage != NULL) ? (HASH_HMAC_CTX *)storage : dsl_new(HASH_HMAC_CTX);
+	*ret = *ctx;
+	ret->pptr1 = (void *)pctx;
+	ret->inplace = (storage != NULL);
 	return ret;
 }
 
@@ -106,7 +246,11 @@ const HMAC_PROVIDER openssl_hmac_provider = {
 	"openssl",
 	dsl_openssl_hmac_init,
 	dsl_openssl_hmac_update,
-	dsl_openssl_hmac_finish
+	dsl_openssl_hmac_finish,
+	dsl_openssl_hmac_ctx_size,
+	dsl_openssl_hmac_init_inplace,
+	dsl_openssl_hmac_reset,
+	dsl_openssl_hmac_clone
 };
 
 bool openssl_has_init = false;
@@ -162,6 +306,7 @@ bool dsl_openssl_init() {
 		}
 	}
 	openssl_has_init = true;
+	openssl_hmac_mac = EVP_MAC_fetch(NULL, "HMAC", NULL);
 
 	dsl_add_hash_provider(&openssl_hash_provider);
 	dsl_add_hmac_provider(&openssl_hmac_provider);
@@ -174,6 +319,15 @@ void dsl_openssl_cleanup() {
 	if (openssl_has_init) {
 		dsl_remove_hash_provider(&openssl_hash_provider);
 		dsl_remove_hmac_provider(&openssl_hmac_provider);
+		{
+			AutoMutexPtr(dslOpenSSLDigestsMutex());
+			for (auto x = openssl_fetched_digests.begin(); x != openssl_fetched_digests.end(); x++) {
+				EVP_MD_free(*x);
+			}
+			openssl_fetched_digests.clear();
+		}
+		EVP_MAC_free(openssl_hmac_mac);
+		openssl_hmac_mac = NULL;
 		openssl_has_init = false;
 	}
 }
@@ -68,7 +68,8 @@ bool DSL_CC Is64Bit() {
 
 #ifdef DSL_HAVE_CPUID
 DSL_API void DSL_CC linux_cpuid(int cpuInfo[4], int function_id) {
-	__cpuid(function_id, cpuInfo[0], cpuInfo[1], cpuInfo[2], cpuInfo[3]);
+	// sub-leaf 0, leaf 7 and others return garbage otherwise
+	__cpuid_count(function_id, 0, cpuInfo[0], cpuInfo[1], cpuInfo[2], cpuInfo[3]);
 }
 #endif
 
@@ -0,0 +1,118 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+#include <drift/dslcore.h>
+#include <drift/parallel.h>
+#include <memory>
+#include <exception>
+
+#define DSL_PARALLEL_CHUNKS_PER_THREAD 8
+
+struct DSL_ParallelState {
+	atomic<size_t> next;
+	size_t end = 0;
+	size_t grain = 0;
+	atomic<size_t> chunks_left;
+	const function<void(size_t, size_t)> * body = NULL;
+
+	atomic<bool> failed;
+	DSL_FastMutex error_mutex;
+	exception_ptr error;
+
+	DSL_EventCount done_event;
+};
+
+/* Runs chunks until there are none left to claim. Helpers that start after everything is claimed return without touching body, which may be gone by then */
+static void dsl_parallel_work(DSL_ParallelState * st) {
+	while (1) {
+		size_t first = st->next.fetch_add(st->grain);
+		if (first >= st->end) {
+			return;
+		}
+		size_t last = (st->end - first > st->grain) ? first + st->grain : st->end;
+		if (!st->failed.load(memory_order_relaxed)) {
+			try {
+				(*st->body)(first, last);
+			} catch (...) {
+				AutoFastMutex(st->error_mutex);
+				if (!st->failed.exchange(true)) {
+					st->error = current_exception();
+				}
+			}
+		}
+		if (st->chunks_left.fetch_sub(1) == 1) {
+			st->done_event.Notify(true);
+		}
+	}
+}
+
+size_t DSL_CC DSL_ParallelGrainSize(size_t count, size_t grain, DSL_ThreadPool * pool) {
+	if (grain > 0) {
+		return grain;
+	}
+	if (pool == NULL) {
+		pool = DSL_GetDefaultThreadPool();
+	}
+	grain = count / ((size_t)pool->NumThreads() * DSL_PARALLEL_CHUNKS_PER_THREAD);
+	return (grain > 0) ? grain : 1;
+}
+
+void DSL_CC DSL_ParallelForRange(size_t begin, size_t end, size_t grain, const function<void(size_t, size_t)>& body, DSL_ThreadPool * pool) {
+	if (end <= begin) {
+		return;
+	}
+	if (pool == NULL) {
+		pool = DSL_GetDefaultThreadPool();
+	}
+	grain = DSL_ParallelGrainSize(end - begin, grain, pool);
+	size_t chunks = ((end - begin) + grain - 1) / grain;
+	if (chunks == 1 || pool->NumThreads() < 2) {
+		// nothing to gain from the pool, skip the overhead
+		for (size_t first = begin; first < end; first += grain) {
+			body(first, (end - first > grain) ? first + grain : end);
+		}
+		return;
+	}
+
+	shared_ptr<DSL_ParallelState> st = make_shared<DSL_ParallelState>();
+	st->next = begin;
+	st->end = end;
+	st->grain = grain;
+	st->chunks_left = chunks;
+	st->body = &body;
+	st->failed = false;
+
+	// the calling thread is one of the participants
+	size_t helpers = std::min(chunks - 1, (size_t)pool->NumThreads());
+	vector<DSL_ThreadPool_Task> tasks;
+	tasks.reserve(helpers);
+	for (size_t i = 0; i < helpers; i++) {
+		tasks.push_back([st]() { dsl_parallel_work(st.get()); });
+	}
+	pool->SubmitBatch(tasks);
+
+	dsl_parallel_work(st.get());
+	bool is_worker = pool->IsWorkerThread();
+	while (st->chunks_left.load() > 0) {
+		if (is_worker && pool->RunPendingTask()) {
+			continue;
+		}
+		uint32 key = st->done_event.PrepareWait();
+		if (st->chunks_left.load() == 0) {
+			st->done_event.CancelWait();
+			break;
+		}
+		st->done_event.Wait(key);
+	}
+
+	if (st->failed.load()) {
+		rethrow_exception(st->error);
+	}
+}
@@ -229,8 +229,8 @@ int64 buf_write(void * buf, int64 size, DSL_FILE * fp) {
 	if (size <= 0) { return 0; }
 
 	int64 newoff = mem->offset + size;
-	if (newoff > mem->buf->len) {
-		buffer_resize(mem->buf, newoff);
+	if (newoff > mem->buf->len && !buffer_resize(mem->buf, newoff)) {
+		return 0;
 	}
 
 	memcpy(mem->buf->udata + mem->offset, buf, size);
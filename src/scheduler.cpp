@@ -0,0 +1,249 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+#include <drift/dslcore.h>
+#include <drift/scheduler.h>
+#include <drift/GenLib.h>
+#include <map>
+#include <memory>
+#include <queue>
+
+struct DSL_Scheduler_Entry {
+	uint64 due;
+	uint64 interval; // 0 = run once
+	function<void()> func;
+	DSL_Executor * exec;
+	shared_ptr<atomic<bool>> running; // periodic only, so a slow run doesn't get overlapped by the next one
+};
+
+typedef pair<uint64, DSL_SCHEDULER_ID> DSL_Scheduler_Heap_Entry; // due time, id
+
+struct DSL_Scheduler_Impl {
+	priority_queue<DSL_Scheduler_Heap_Entry, vector<DSL_Scheduler_Heap_Entry>, greater<DSL_Scheduler_Heap_Entry>> heap;
+	map<DSL_SCHEDULER_ID, DSL_Scheduler_Entry *> entries;
+	DSL_FastMutex hMutex;
+	DSL_EventCount wake_event;
+	DSL_SCHEDULER_ID next_id = 1;
+	bool shutting_down = false;
+
+	// the timer thread is detached, it holds its own reference so the scheduler can be deleted while it is still on its way out
+	atomic<int> refs;
+	atomic<bool> timer_done;
+	DSL_EventCount done_event;
+};
+
+static void scheduler_release(DSL_Scheduler_Impl * impl) {
+	if (impl->refs.fetch_sub(1) == 1) {
+		delete impl;
+	}
+}
+
+static void scheduler_timer_main(DSL_Scheduler_Impl * impl) {
+	vector<pair<function<void()>, DSL_Executor *>> ready;
+	while (1) {
+		uint32 key = impl->wake_event.PrepareWait();
+		int timeout = -1;
+		impl->hMutex.Lock();
+		if (impl->shutting_down) {
+			impl->hMutex.Release();
+			impl->wake_event.CancelWait();
+			break;
+		}
+		uint64 now = GetTickCount64();
+		while (!impl->heap.empty()) {
+			DSL_Scheduler_Heap_Entry top = impl->heap.top();
+			auto x = impl->entries.find(top.second);
+			if (x == impl->entries.end() || x->second->due != top.first) {
+				// cancelled
+				impl->heap.pop();
+				continue;
+			}
+			if (top.first > now) {
+				uint64 left = top.first - now;
+				timeout = (left > INT32_MAX) ? INT32_MAX : (int)left;
+				break;
+			}
+			impl->heap.pop();
+			DSL_Scheduler_Entry * e = x->second;
+			if (e->interval > 0) {
+				if (!e->running->exchange(true)) {
+					shared_ptr<atomic<bool>> running = e->running;
+					function<void()> func = e->func;
+					ready.emplace_back([func, running]() {
+						func();
+						running->store(false);
+					}, e->exec);
+				}
+				// fixed rate, but skip runs we're already late for
+				e->due += e->interval;
+				if (e->due <= now) {
+					e->due = now + e->interval;
+				}
+				impl->heap.push(DSL_Scheduler_Heap_Entry(e->due, top.second));
+			} else {
+				ready.emplace_back(std::move(e->func), e->exec);
+				impl->entries.erase(x);
+				delete e;
+			}
+		}
+		impl->hMutex.Release();
+
+		if (ready.size()) {
+			impl->wake_event.CancelWait();
+			for (auto& r : ready) {
+				DSL_Executor * exec = (r.second != NULL) ? r.second : DSL_GetDefaultThreadPool();
+				exec->Execute(std::move(r.first));
+			}
+			ready.clear();
+			continue;
+		}
+		impl->wake_event.Wait(key, timeout);
+	}
+}
+
+DSL_DEFINE_THREAD(DSL_SchedulerThread) {
+	DSL_THREAD_START
+	DSL_Scheduler_Impl * impl = (DSL_Scheduler_Impl *)tt->parm;
+	scheduler_timer_main(impl);
+	impl->timer_done = true;
+	impl->done_event.Notify();
+	scheduler_release(impl);
+	DSL_THREAD_END
+}
+
+DSL_Scheduler::DSL_Scheduler(const char * name) {
+	impl = new DSL_Scheduler_Impl;
+	impl->refs = 2;
+	impl->timer_done = false;
+
+	DSL_THREAD_OPTIONS opts;
+	opts.desc = name;
+	if (DSL_StartThreadEx(DSL_SchedulerThread, impl, opts) == NULL) {
+		// nothing will run, but the rest of the API still behaves
+		impl->refs = 1;
+		impl->timer_done = true;
+	}
+}
+
+DSL_Scheduler::~DSL_Scheduler() {
+	Shutdown();
+	scheduler_release(impl);
+}
+
+static DSL_SCHEDULER_ID scheduler_add(DSL_Scheduler_Impl * impl, uint64 due, uint64 interval, function<void()>& func, DSL_Executor * exec) {
+	DSL_Scheduler_Entry * e = new DSL_Scheduler_Entry;
+	e->due = due;
+	e->interval = interval;
+	e->func = std::move(func);
+	e->exec = exec;
+	if (interval > 0) {
+		e->running = make_shared<atomic<bool>>(false);
+	}
+
+	impl->hMutex.Lock();
+	if (impl->shutting_down) {
+		impl->hMutex.Release();
+		delete e;
+		return 0;
+	}
+	DSL_SCHEDULER_ID id = impl->next_id++;
+	impl->entries[id] = e;
+	bool earliest = (impl->heap.empty() || due < impl->heap.top().first);
+	impl->heap.push(DSL_Scheduler_Heap_Entry(due, id));
+	impl->hMutex.Release();
+
+	// only wake the timer thread if it needs to sleep for less time than it is now
+	if (earliest) {
+		impl->wake_event.Notify();
+	}
+	return id;
+}
+
+DSL_SCHEDULER_ID DSL_Scheduler::ScheduleIn(uint64 delay, function<void()> func, DSL_Executor * exec) {
+	return scheduler_add(impl, GetTickCount64() + delay, 0, func, exec);
+}
+
+DSL_SCHEDULER_ID DSL_Scheduler::ScheduleAt(time_t when, function<void()> func, DSL_Executor * exec) {
+	time_t now = time(NULL);
+	uint64 delay = (when > now) ? (uint64)(when - now) * 1000 : 0;
+	return scheduler_add(impl, GetTickCount64() + delay, 0, func, exec);
+}
+
+DSL_SCHEDULER_ID DSL_Scheduler::ScheduleEvery(uint64 interval, function<void()> func, DSL_Executor * exec, int64 first_delay) {
+	if (interval == 0) {
+		return 0;
+	}
+	uint64 delay = (first_delay >= 0) ? (uint64)first_delay : interval;
+	return scheduler_add(impl, GetTickCount64() + delay, interval, func, exec);
+}
+
+bool DSL_Scheduler::Cancel(DSL_SCHEDULER_ID id) {
+	DSL_Scheduler_Entry * e = NULL;
+	impl->hMutex.Lock();
+	auto x = impl->entries.find(id);
+	if (x != impl->entries.end()) {
+		// the heap entry is skipped when it comes up
+		e = x->second;
+		impl->entries.erase(x);
+	}
+	impl->hMutex.Release();
+	delete e;
+	return (e != NULL);
+}
+
+size_t DSL_Scheduler::NumScheduled() {
+	AutoFastMutex(impl->hMutex);
+	return impl->entries.size();
+}
+
+void DSL_Scheduler::Shutdown() {
+	impl->hMutex.Lock();
+	bool was_shutting_down = impl->shutting_down;
+	impl->shutting_down = true;
+	for (auto& x : impl->entries) {
+		delete x.second;
+	}
+	impl->entries.clear();
+	while (!impl->heap.empty()) {
+		impl->heap.pop();
+	}
+	impl->hMutex.Release();
+	if (was_shutting_down) {
+		return;
+	}
+	impl->wake_event.Notify();
+	while (!impl->timer_done.load()) {
+		uint32 key = impl->done_event.PrepareWait();
+		if (impl->timer_done.load()) {
+			impl->done_event.CancelWait();
+			break;
+		}
+		impl->done_event.Wait(key);
+	}
+}
+
+static DSL_FastMutex default_scheduler_mutex;
+static DSL_Scheduler * default_scheduler = NULL;
+
+DSL_Scheduler * DSL_CC DSL_GetDefaultScheduler() {
+	AutoFastMutex(default_scheduler_mutex);
+	if (default_scheduler == NULL) {
+		default_scheduler = new DSL_Scheduler("DSL Scheduler");
+	}
+	return default_scheduler;
+}
+
+void dsl_cleanup_default_scheduler() {
+	default_scheduler_mutex.Lock();
+	DSL_Scheduler * s = default_scheduler;
+	default_scheduler = NULL;
+	default_scheduler_mutex.Release();
+	delete s;
+}
@@ -34,22 +34,43 @@ bool DSL_Serializable::FromSerialized(DSL_BUFFER * buf) {
 	return Serialize(buf, true);
 }
 
+bool DSL_Serializable::GetSerialized(DSL_CHAIN_BUFFER * buf) {
+	// the chain takes over the memory so there's no point using the pool here
+	DSL_BUFFER tmp;
+	buffer_init(&tmp);
+	bool ret = GetSerialized(&tmp) && chain_buffer_append_buffer(buf, &tmp);
+	buffer_free(&tmp);
+	return ret;
+}
+
+bool DSL_Serializable::FromSerialized(DSL_CHAIN_BUFFER * buf) {
+	DSL_BUFFER * tmp = buffer_acquire(buf->len);
+	bool ret = false;
+	if (chain_buffer_to_buffer(buf, tmp)) {
+		int64 orig_len = tmp->len;
+		if (FromSerialized(tmp)) {
+			chain_buffer_remove_front(buf, orig_len - tmp->len);
+			ret = true;
+		}
+	}
+	buffer_release(tmp);
+	return ret;
+}
+
 string DSL_Serializable::GetSerialized() {
-	DSL_BUFFER buf;
-	buffer_init(&buf);
+	DSL_BUFFER * buf = buffer_acquire();
 	string ret;
-	if (GetSerialized(&buf)) {
-		ret.assign(buf.data, buf.len);
+	if (GetSerialized(buf)) {
+		ret.assign(buf->data, buf->len);
 	}
-	buffer_free(&buf);
+	buffer_release(buf);
 	return ret;
 }
 bool DSL_Serializable::FromSerialized(const string& str) {
-	DSL_BUFFER buf;
-	buffer_init(&buf);
-	buffer_set(&buf, str.data(), str.length());
-	bool ret = FromSerialized(&buf);
-	buffer_free(&buf);
+	DSL_BUFFER * buf = buffer_acquire(str.length());
+	buffer_set(buf, str.data(), str.length());
+	bool ret = FromSerialized(buf);
+	buffer_release(buf);
 	return ret;
 }
 
@@ -58,64 +79,58 @@ bool DSL_Serializable::FromSerialized(const string& str) {
 bool DSL_Serializable::GetCompressed(DSL_BUFFER * buf, int compression_level) {
 	bool ret = false;
 	if (Serialize(buf, false)) {
-		DSL_BUFFER buf2;
-		buffer_init(&buf2);
 		uLongf dlen = compressBound(buf->len);
-		if ((sizeof(uLongf) == 4 || dlen <= UINT32_MAX)) {
-			buffer_resize(&buf2, dlen);
-			if (compress2(buf2.udata, &dlen, buf->udata, buf->len, compression_level) == Z_OK) {
+		DSL_BUFFER * buf2 = buffer_acquire(dlen);
+		if ((sizeof(uLongf) == 4 || dlen <= UINT32_MAX) && buffer_resize(buf2, dlen)) {
+			if (compress2(buf2->udata, &dlen, buf->udata, buf->len, compression_level) == Z_OK) {
 				uint32_t serlen = buf->len;
 				buffer_clear(buf);
 				if (dsl_serialize_int(buf, &serlen, sizeof(serlen))) {
-					if (buffer_append(buf, buf2.data, dlen)) {
+					if (buffer_append(buf, buf2->data, dlen)) {
 						ret = true;
 					}
 				}
 			}
 		}
-		buffer_free(&buf2);
+		buffer_release(buf2);
 	}
 	return ret;
 }
 
 bool DSL_Serializable::FromCompressed(DSL_BUFFER * buf) {
 	bool ret = false;
-	DSL_BUFFER buf2;
-	buffer_init(&buf2);
 	uint32_t serlen = 0;
 	if (dsl_deserialize_int(buf, &serlen, sizeof(serlen))) {
+		DSL_BUFFER * buf2 = buffer_acquire(serlen);
 		uLongf dlen = serlen;
-		buffer_resize(&buf2, serlen);
 		int n = 0;
-		if ((n = uncompress(buf2.udata, &dlen, buf->udata, buf->len)) == Z_OK && dlen == serlen) {
+		if (buffer_resize(buf2, serlen) && (n = uncompress(buf2->udata, &dlen, buf->udata, buf->len)) == Z_OK && dlen == serlen) {
 			buffer_clear(buf);
-			if (buffer_append(buf, buf2.data, dlen)) {
+			if (buffer_append(buf, buf2->data, dlen)) {
 				if (Serialize(buf, true)) {
 					ret = true;
 				}
 			}
 		}
+		buffer_release(buf2);
 	}
-	buffer_free(&buf2);
 	return ret;
 }
 
 string DSL_Serializable::GetCompressed(int compression_level) {
-	DSL_BUFFER buf;
-	buffer_init(&buf);
+	DSL_BUFFER * buf = buffer_acquire();
 	string ret;
-	if (GetCompressed(&buf, compression_level)) {
-		ret.assign(buf.data, buf.len);
+	if (GetCompressed(buf, compression_level)) {
+		ret.assign(buf->data, buf->len);
 	}
-	buffer_free(&buf);
+	buffer_release(buf);
 	return ret;
 }
 bool DSL_Serializable::FromCompressed(const string& str) {
-	DSL_BUFFER buf;
-	buffer_init(&buf);
-	buffer_set(&buf, str.data(), str.length());
-	bool ret = FromCompressed(&buf);
-	buffer_free(&buf);
+	DSL_BUFFER * buf = buffer_acquire(str.length());
+	buffer_set(buf, str.data(), str.length());
+	bool ret = FromCompressed(buf);
+	buffer_release(buf);
 	return ret;
 }
 
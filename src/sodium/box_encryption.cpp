@@ -75,11 +75,16 @@ bool DS_BoxPrivKey::IsValid() const {
 
 bool DS_BoxPrivKey::Encrypt(const DS_BoxNonce& nonce, DSL_BUFFER * buf) {
 	int64 origlen = buf->len;
-	buffer_resize(buf, buf->len + crypto_secretbox_MACBYTES);
+	if (!buffer_resize(buf, buf->len + crypto_secretbox_MACBYTES)) {
+		return false;
+	}
 	return (crypto_secretbox_easy(buf->udata, buf->udata, origlen, nonce.data, key) == 0);
 }
 
 bool DS_BoxPrivKey::Decrypt(const DS_BoxNonce& nonce, DSL_BUFFER * buf) {
+	if (buf->len < crypto_secretbox_MACBYTES) {
+		return false;
+	}
 	if (crypto_secretbox_open_easy(buf->udata, buf->udata, buf->len, nonce.data, key) == 0) {
 		buffer_resize(buf, buf->len - crypto_secretbox_MACBYTES);
 		return true;
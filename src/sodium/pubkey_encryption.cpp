@@ -80,30 +80,24 @@ bool DS_EncSharedKey::Calculate(DS_EncPrivKey& privkey, DS_EncPubKey& pubkey) {
 	return false;
 }
 
+// libsodium's *_easy functions support in-place operation so we don't need a temporary copy of the data
 bool DS_EncSharedKey::Encrypt(DS_EncNonce& nonce, DSL_BUFFER * buf) {
-		DSL_BUFFER tmp;
-		buffer_init(&tmp);
-		buffer_set(&tmp, buf->data, buf->len);
-		buffer_resize(buf, buf->len + crypto_box_MACBYTES);
-		if (crypto_box_easy_afternm(buf->udata, tmp.udata, tmp.len, nonce.data, data) == 0) {
-			buffer_free(&tmp);
-			return true;
-		}
-		buffer_free(&tmp);
+	int64 origlen = buf->len;
+	if (!buffer_resize(buf, buf->len + crypto_box_MACBYTES)) {
 		return false;
+	}
+	return (crypto_box_easy_afternm(buf->udata, buf->udata, origlen, nonce.data, data) == 0);
 }
 
 bool DS_EncSharedKey::Decrypt(DS_EncNonce& nonce, DSL_BUFFER * buf) {
-		DSL_BUFFER tmp;
-		buffer_init(&tmp);
-		buffer_set(&tmp, buf->data, buf->len);
-		buffer_resize(buf, buf->len - crypto_box_MACBYTES);
-		if (crypto_box_open_easy_afternm(buf->udata, tmp.udata, tmp.len, nonce.data, data) == 0) {
-			buffer_free(&tmp);
-			return true;
-		}
-		buffer_free(&tmp);
+	if (buf->len < crypto_box_MACBYTES) {
 		return false;
+	}
+	if (crypto_box_open_easy_afternm(buf->udata, buf->udata, buf->len, nonce.data, data) == 0) {
+		buffer_resize(buf, buf->len - crypto_box_MACBYTES);
+		return true;
+	}
+	return false;
 }
 
 void DS_EncSharedKey::checkLocking(bool fForce) {
@@ -196,28 +190,21 @@ bool DS_EncPrivKey::IsValid() const {
 }
 
 bool DS_EncPrivKey::Encrypt(const DS_EncPubKey& recpt_key, const DS_EncNonce& nonce, DSL_BUFFER * buf) {
-	DSL_BUFFER tmp;
-	buffer_init(&tmp);
-	buffer_set(&tmp, buf->data, buf->len);
-	buffer_resize(buf, buf->len + crypto_box_MACBYTES);
-	if (crypto_box_easy(buf->udata, tmp.udata, tmp.len, nonce.data, recpt_key.key, key) == 0) {
-		buffer_free(&tmp);
-		return true;
+	int64 origlen = buf->len;
+	if (!buffer_resize(buf, buf->len + crypto_box_MACBYTES)) {
+		return false;
 	}
-	buffer_free(&tmp);
-	return false;
+	return (crypto_box_easy(buf->udata, buf->udata, origlen, nonce.data, recpt_key.key, key) == 0);
 }
 
 bool DS_EncPrivKey::Decrypt(const DS_EncPubKey& sender_key, const DS_EncNonce& nonce, DSL_BUFFER * buf) {
-	DSL_BUFFER tmp;
-	buffer_init(&tmp);
-	buffer_set(&tmp, buf->data, buf->len);
-	buffer_resize(buf, buf->len - crypto_box_MACBYTES);
-	if (crypto_box_open_easy(buf->udata, tmp.udata, tmp.len, nonce.data, sender_key.key, key) == 0) {
-		buffer_free(&tmp);
+	if (buf->len < crypto_box_MACBYTES) {
+		return false;
+	}
+	if (crypto_box_open_easy(buf->udata, buf->udata, buf->len, nonce.data, sender_key.key, key) == 0) {
+		buffer_resize(buf, buf->len - crypto_box_MACBYTES);
 		return true;
 	}
-	buffer_free(&tmp);
 	return false;
 }
 
@@ -112,7 +112,7 @@ int64 DB_SQLite::AffectedRows64() {
 #endif
 
 uint32 DB_SQLite::GetQueryCount() {
-	return query_count;
+	return (uint32)query_count.Get();
 }
 
 string DB_SQLite::GetErrorString() {
@@ -0,0 +1,272 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+#include <drift/dslcore.h>
+#include <drift/thread_pool.h>
+#include <drift/GenLib.h>
+#include <deque>
+#include <assert.h>
+
+struct alignas(64) DSL_ThreadPool_Worker {
+	DSL_ThreadPool * pool;
+	uint32 index;
+	DSL_FastMutex hMutex;
+	deque<DSL_ThreadPool_Task> tasks; // the owner works from the back, thieves take from the front
+};
+
+static thread_local DSL_ThreadPool_Worker * tls_worker = NULL;
+
+DSL_ThreadPool::DSL_ThreadPool(uint32 num_threads, const char * pname) {
+	if (num_threads == 0) {
+		num_threads = thread::hardware_concurrency();
+		if (num_threads == 0) { num_threads = 1; }
+	}
+	name = pname ? pname : "Thread Pool";
+	next_worker = 0;
+	queued = 0;
+	outstanding = 0;
+	shutting_down = false;
+	submitting = 0;
+
+	for (uint32 i = 0; i < num_threads; i++) {
+		DSL_ThreadPool_Worker * w = new DSL_ThreadPool_Worker;
+		w->pool = this;
+		w->index = i;
+		workers.push_back(w);
+	}
+	for (auto * w : workers) {
+		threads.emplace_back(&DSL_ThreadPool::worker_main, this, w);
+#if defined(WIN32)
+		DSL_SetThreadName(GetThreadId(threads.back().native_handle()), name.c_str());
+#else
+		DSL_SetThreadName(threads.back().native_handle(), name.c_str());
+#endif
+	}
+}
+
+DSL_ThreadPool::~DSL_ThreadPool() {
+	// a worker can't join itself, and it would be freeing the DSL_ThreadPool_Worker it's running on
+	assert(!IsWorkerThread());
+	Shutdown();
+	for (auto * w : workers) {
+		delete w;
+	}
+	workers.clear();
+}
+
+DSL_ThreadPool_Worker * DSL_ThreadPool::current_worker() {
+	return (tls_worker != NULL && tls_worker->pool == this) ? tls_worker : NULL;
+}
+
+bool DSL_ThreadPool::IsWorkerThread() {
+	return (current_worker() != NULL);
+}
+
+/* Returns false if the pool is shutting down, otherwise the caller has to queue its task(s) and then decrement submitting */
+bool DSL_ThreadPool::begin_submit() {
+	submitting.fetch_add(1);
+	if (shutting_down.load()) {
+		submitting.fetch_sub(1);
+		return false;
+	}
+	return true;
+}
+
+void DSL_ThreadPool::Submit(DSL_ThreadPool_Task task) {
+	if (!begin_submit()) {
+		// the workers may already be gone, run it here so it isn't lost and WaitIdle() can't hang on it
+		task();
+		return;
+	}
+	DSL_ThreadPool_Worker * w = current_worker();
+	if (w == NULL) {
+		w = workers[next_worker.fetch_add(1, memory_order_relaxed) % workers.size()];
+	}
+	outstanding.fetch_add(1);
+	{
+		AutoFastMutex(w->hMutex);
+		w->tasks.push_back(std::move(task));
+	}
+	queued.fetch_add(1);
+	submitting.fetch_sub(1);
+	work_event.Notify(false);
+}
+
+void DSL_ThreadPool::SubmitBatch(vector<DSL_ThreadPool_Task>& tasks) {
+	if (tasks.size() == 0) { return; }
+	if (!begin_submit()) {
+		for (auto& t : tasks) {
+			t();
+		}
+		tasks.clear();
+		return;
+	}
+	size_t n = tasks.size();
+	outstanding.fetch_add(n);
+	size_t per_worker = (n + workers.size() - 1) / workers.size();
+	size_t ind = 0;
+	uint32 start = next_worker.fetch_add(1, memory_order_relaxed);
+	for (size_t i = 0; ind < n; i++) {
+		DSL_ThreadPool_Worker * w = workers[(start + i) % workers.size()];
+		AutoFastMutex(w->hMutex);
+		for (size_t j = 0; j < per_worker && ind < n; j++) {
+			w->tasks.push_back(std::move(tasks[ind++]));
+		}
+	}
+	tasks.clear();
+	queued.fetch_add(n);
+	submitting.fetch_sub(1);
+	work_event.Notify(true);
+}
+
+bool DSL_ThreadPool::get_task(DSL_ThreadPool_Worker * w, DSL_ThreadPool_Task& task) {
+	if (queued.load(memory_order_relaxed) <= 0) {
+		return false;
+	}
+	if (w != NULL) {
+		AutoFastMutex(w->hMutex);
+		if (w->tasks.size()) {
+			task = std::move(w->tasks.back());
+			w->tasks.pop_back();
+			queued.fetch_sub(1);
+			return true;
+		}
+	}
+
+	// steal, starting at a different victim each time so thieves don't all pile on to worker 0
+	size_t num = workers.size();
+	size_t start = (w != NULL) ? w->index + 1 : next_worker.load(memory_order_relaxed);
+	for (size_t i = 0; i < num; i++) {
+		DSL_ThreadPool_Worker * v = workers[(start + i) % num];
+		if (v == w) { continue; }
+		AutoFastMutex(v->hMutex);
+		if (v->tasks.size()) {
+			task = std::move(v->tasks.front());
+			v->tasks.pop_front();
+			queued.fetch_sub(1);
+			return true;
+		}
+	}
+	return false;
+}
+
+void DSL_ThreadPool::run_task(DSL_ThreadPool_Task& task) {
+	task();
+	task = nullptr;
+	if (outstanding.fetch_sub(1) == 1) {
+		idle_event.Notify();
+	}
+}
+
+bool DSL_ThreadPool::RunPendingTask() {
+	DSL_ThreadPool_Task task;
+	if (get_task(current_worker(), task)) {
+		run_task(task);
+		return true;
+	}
+	return false;
+}
+
+void DSL_ThreadPool::worker_main(DSL_ThreadPool_Worker * w) {
+	tls_worker = w;
+	DSL_ThreadPool_Task task;
+	while (1) {
+		if (get_task(w, task)) {
+			run_task(task);
+			continue;
+		}
+		uint32 key = work_event.PrepareWait();
+		if (queued.load() > 0) {
+			work_event.CancelWait();
+			continue;
+		}
+		/*
+		 * A Submit() that got in before Shutdown() may still be about to queue its task. It bumps queued before it drops submitting and
+		 * notifies after, so only leave once neither is pending, otherwise sleep and let that Notify() wake us back up.
+		 */
+		if (shutting_down.load() && submitting.load() == 0 && queued.load() == 0) {
+			work_event.CancelWait();
+			break;
+		}
+		work_event.Wait(key);
+	}
+	tls_worker = NULL;
+}
+
+bool DSL_ThreadPool::WaitIdle(int timeout) {
+	uint64 end = (timeout > 0) ? GetTickCount64() + timeout : 0;
+	while (outstanding.load() > 0) {
+		if (timeout == 0) { return false; }
+		uint32 key = idle_event.PrepareWait();
+		if (outstanding.load() <= 0) {
+			idle_event.CancelWait();
+			break;
+		}
+		int left = -1;
+		if (timeout > 0) {
+			uint64 now = GetTickCount64();
+			if (now >= end) {
+				idle_event.CancelWait();
+				return false;
+			}
+			left = (int)(end - now);
+		}
+		idle_event.Wait(key, left);
+	}
+	return true;
+}
+
+bool DSL_ThreadPool::Shutdown() {
+	if (IsWorkerThread()) {
+		return false;
+	}
+	if (shutting_down.exchange(true)) {
+		return true;
+	}
+	// anything that got past the shutting_down check in Submit() has to be queued before the workers can decide there's nothing left
+	while (submitting.load() > 0) {
+		this_thread::yield();
+	}
+	work_event.Notify(true);
+	for (auto& t : threads) {
+		if (t.joinable()) {
+			t.join();
+		}
+	}
+	threads.clear();
+	return true;
+}
+
+static DSL_FastMutex default_pool_mutex;
+static DSL_ThreadPool * default_pool = NULL;
+
+DSL_ThreadPool * DSL_CC DSL_GetDefaultThreadPool() {
+	AutoFastMutex(default_pool_mutex);
+	if (default_pool == NULL) {
+		default_pool = new DSL_ThreadPool(0, "DSL Pool");
+	}
+	return default_pool;
+}
+
+void dsl_cleanup_default_thread_pool() {
+	default_pool_mutex.Lock();
+	DSL_ThreadPool * pool = default_pool;
+	default_pool = NULL;
+	default_pool_mutex.Release();
+	// not under the lock, the remaining tasks could still be submitting more work
+	delete pool;
+}
+
+void DSL_CC DSL_StartAsyncTaskOnPool(DSL_AsyncTask * task, DSL_ThreadPool * pool) {
+	if (pool == NULL) {
+		pool = DSL_GetDefaultThreadPool();
+	}
+	pool->Submit([task]() { task->Execute(); });
+}
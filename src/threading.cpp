@@ -21,21 +21,75 @@
 #define DSL_LIST_TYPE set
 #include <set>
 #endif
+#include <condition_variable>
+#include <memory>
 #if defined(WIN32)
 #include <process.h>
+#else
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#if defined(LINUX)
+#include <sys/syscall.h>
+#endif
 #endif
 
-DSL_Mutex  * DSL_Thread_Mutex()
+DSL_RWLock * DSL_Thread_Lock()
 {
-	static DSL_Mutex actualMutex;
-	return &actualMutex;
+	static DSL_RWLock actualLock;
+	return &actualLock;
 }
 typedef DSL_LIST_TYPE<DSL_THREAD_INFO *> DSL_List_Type;
 DSL_List_Type DSL_List;
 uint32 DSL_NoThreads=0;
 
+static void (*dsl_thread_key_destructors[DSL_THREAD_MAX_KEYS])(void * value) = { NULL };
+static atomic<int> dsl_thread_num_keys(0);
+static thread_local DSL_THREAD_INFO * dsl_current_thread = NULL;
+
+int DSL_CC DSL_ThreadKeyCreate(void (*destructor)(void * value)) {
+	int key = dsl_thread_num_keys.load();
+	do {
+		if (key >= DSL_THREAD_MAX_KEYS) {
+			return -1;
+		}
+	} while (!dsl_thread_num_keys.compare_exchange_weak(key, key + 1));
+	dsl_thread_key_destructors[key] = destructor;
+	return key;
+}
+
+void * DSL_CC DSL_GetThreadValue(int key) {
+	if (dsl_current_thread == NULL || key < 0 || key >= DSL_THREAD_MAX_KEYS) {
+		return NULL;
+	}
+	return dsl_current_thread->values[key];
+}
+
+bool DSL_CC DSL_SetThreadValue(int key, void * value) {
+	if (dsl_current_thread == NULL || key < 0 || key >= DSL_THREAD_MAX_KEYS) {
+		return false;
+	}
+	dsl_current_thread->values[key] = value;
+	return true;
+}
+
+DSL_THREAD_INFO * DSL_CC DSL_GetCurrentThreadInfo() {
+	return dsl_current_thread;
+}
+
 void DSL_UnregisterThread(DSL_THREAD_INFO * tt) {
-	AutoMutexPtr(DSL_Thread_Mutex());
+	int num_keys = dsl_thread_num_keys.load();
+	for (int i = 0; i < num_keys && i < DSL_THREAD_MAX_KEYS; i++) {
+		if (tt->values[i] != NULL && dsl_thread_key_destructors[i] != NULL) {
+			dsl_thread_key_destructors[i](tt->values[i]);
+		}
+		tt->values[i] = NULL;
+	}
+	if (dsl_current_thread == tt) {
+		dsl_current_thread = NULL;
+	}
+
+	AutoWriteLockPtr(DSL_Thread_Lock());
 	DSL_List_Type::iterator x = DSL_List.find(tt);
 	if (x != DSL_List.end()) {
 		DSL_List.erase(x);
@@ -94,31 +148,192 @@ DSL_API void DSL_CC DSL_SetThreadName(pthread_t thread_id, const char * szThread
 }
 #endif
 
+int DSL_CC DSL_GetNumaNodeCount() {
+#if defined(WIN32)
+	ULONG highest = 0;
+	if (GetNumaHighestNodeNumber(&highest)) {
+		return highest + 1;
+	}
+#elif defined(LINUX)
+	int ret = 0;
+	char buf[64];
+	while (1) {
+		snprintf(buf, sizeof(buf), "/sys/devices/system/node/node%d", ret);
+		if (access(buf, F_OK) != 0) {
+			break;
+		}
+		ret++;
+	}
+	if (ret > 0) {
+		return ret;
+	}
+#endif
+	return 1;
+}
+
+#if defined(LINUX)
+static bool dsl_get_numa_cpus(int node, cpu_set_t * set) {
+	char buf[1024];
+	snprintf(buf, sizeof(buf), "/sys/devices/system/node/node%d/cpulist", node);
+	FILE * fp = fopen(buf, "rb");
+	if (fp == NULL) {
+		return false;
+	}
+	bool ret = (fgets(buf, sizeof(buf), fp) != NULL);
+	fclose(fp);
+	CPU_ZERO(set);
+	// format is like 0-3,8-11
+	char * p2 = NULL;
+	char * p = strtok_r(buf, ",\r\n", &p2);
+	while (ret && p != NULL) {
+		int first = atoi(p), last = first;
+		char * dash = strchr(p, '-');
+		if (dash != NULL) {
+			last = atoi(dash + 1);
+		}
+		for (int i = first; i <= last && i < CPU_SETSIZE; i++) {
+			CPU_SET(i, set);
+		}
+		p = strtok_r(NULL, ",\r\n", &p2);
+	}
+	return ret;
+}
+#endif
+
+static void dsl_apply_thread_priority(int priority) {
+#if defined(LINUX)
+	static const int nice_values[] = { 19, 19, 10, 0, -5, -10, -10 };
+	struct sched_param sp;
+	memset(&sp, 0, sizeof(sp));
+	if (priority == DSL_THREAD_PRIORITY_IDLE) {
+		pthread_setschedparam(pthread_self(), SCHED_IDLE, &sp);
+	} else if (priority == DSL_THREAD_PRIORITY_REALTIME) {
+		sp.sched_priority = sched_get_priority_min(SCHED_FIFO);
+		pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+	} else if (priority != DSL_THREAD_PRIORITY_NORMAL && priority >= 0 && priority <= DSL_THREAD_PRIORITY_REALTIME) {
+		// on Linux nice values are per-thread
+		setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), nice_values[priority]);
+	}
+#elif !defined(WIN32)
+	if (priority == DSL_THREAD_PRIORITY_REALTIME) {
+		struct sched_param sp;
+		memset(&sp, 0, sizeof(sp));
+		sp.sched_priority = sched_get_priority_min(SCHED_FIFO);
+		pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+	}
+#endif
+}
+
+/* All DSL threads start here so we can set the current thread pointer and apply settings that have to be done from inside the thread */
+static THREADTYPE DSL_ThreadEntry(void * lpData) {
+	DSL_THREAD_INFO * tt = (DSL_THREAD_INFO *)lpData;
+	dsl_current_thread = tt;
+	dsl_apply_thread_priority(tt->priority);
+	return tt->func(tt);
+}
+
 DSL_THREAD_INFO * DSL_CC DSL_StartThread(ThreadProto Thread,void * Parm, const char * desc, int32 id) {
+	DSL_THREAD_OPTIONS opts;
+	opts.desc = desc;
+	opts.id = id;
+	return DSL_StartThreadEx(Thread, Parm, opts);
+}
+
+DSL_THREAD_INFO * DSL_CC DSL_StartThreadEx(ThreadProto Thread, void * Parm, const DSL_THREAD_OPTIONS& opts) {
 	DSL_THREAD_INFO * ret = (DSL_THREAD_INFO *)dsl_malloc(sizeof(DSL_THREAD_INFO));
 	memset(ret, 0, sizeof(DSL_THREAD_INFO));
 
-	DSL_Thread_Mutex()->Lock();
+	DSL_Thread_Lock()->LockWrite();
 	DSL_List.insert(ret);
 	DSL_NoThreads++;
-	DSL_Thread_Mutex()->Release();
+	DSL_Thread_Lock()->ReleaseWrite();
 
+	const char * desc = opts.desc;
 	if (desc) { sstrcpy(ret->desc, desc); }
-	ret->id = id;
+	ret->id = opts.id;
 	ret->parm = Parm;
 	ret->RemoveMe = DSL_UnregisterThread;
+	ret->func = Thread;
+	ret->priority = opts.priority;
 
 #if defined(WIN32)
+	DWORD_PTR mask = 0;
+	for (int cpu : opts.cpus) {
+		if (cpu >= 0 && cpu < (int)(sizeof(mask) * 8)) {
+			mask |= ((DWORD_PTR)1) << cpu;
+		}
+	}
+	if (opts.numa_node >= 0) {
+		ULONGLONG node_mask = 0;
+		if (!GetNumaNodeProcessorMask((UCHAR)opts.numa_node, &node_mask) || node_mask == 0) {
+			DSL_UnregisterThread(ret);
+			return NULL;
+		}
+		mask = (mask != 0) ? (mask & (DWORD_PTR)node_mask) : (DWORD_PTR)node_mask;
+		if (mask == 0) {
+			DSL_UnregisterThread(ret);
+			return NULL;
+		}
+	} else if (opts.cpus.size() && mask == 0) {
+		DSL_UnregisterThread(ret);
+		return NULL;
+	}
+
 	unsigned int ThreadID=0;
-	ret->hThread = (HANDLE)_beginthreadex(NULL, 0, Thread, ret, 0, &ThreadID);
+	ret->hThread = (HANDLE)_beginthreadex(NULL, (unsigned)opts.stack_size, DSL_ThreadEntry, ret, CREATE_SUSPENDED, &ThreadID);
 	if (ret->hThread != 0) {
+		if (mask != 0) {
+			SetThreadAffinityMask(ret->hThread, mask);
+		}
+		static const int win_priorities[] = { THREAD_PRIORITY_IDLE, THREAD_PRIORITY_LOWEST, THREAD_PRIORITY_BELOW_NORMAL, THREAD_PRIORITY_NORMAL, THREAD_PRIORITY_ABOVE_NORMAL, THREAD_PRIORITY_HIGHEST, THREAD_PRIORITY_TIME_CRITICAL };
+		if (opts.priority != DSL_THREAD_PRIORITY_NORMAL && opts.priority >= 0 && opts.priority <= DSL_THREAD_PRIORITY_REALTIME) {
+			SetThreadPriority(ret->hThread, win_priorities[opts.priority]);
+		}
 		DSL_SetThreadName(ThreadID, desc);
+		ResumeThread(ret->hThread);
 	} else {
 		DSL_UnregisterThread(ret);
 		return NULL;
 	}
 #else
-	if (pthread_create(&ret->hThread, NULL, Thread, (void *)ret) == 0) {
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	if (opts.stack_size > 0) {
+		pthread_attr_setstacksize(&attr, (opts.stack_size < (size_t)PTHREAD_STACK_MIN) ? (size_t)PTHREAD_STACK_MIN : opts.stack_size);
+	}
+#if defined(LINUX)
+	if (opts.cpus.size() || opts.numa_node >= 0) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (int cpu : opts.cpus) {
+			if (cpu >= 0 && cpu < CPU_SETSIZE) {
+				CPU_SET(cpu, &set);
+			}
+		}
+		if (opts.numa_node >= 0) {
+			cpu_set_t node_set;
+			if (!dsl_get_numa_cpus(opts.numa_node, &node_set)) {
+				pthread_attr_destroy(&attr);
+				DSL_UnregisterThread(ret);
+				return NULL;
+			}
+			if (opts.cpus.size()) {
+				CPU_AND(&set, &set, &node_set);
+			} else {
+				set = node_set;
+			}
+		}
+		// set in attr rather than after creation so the thread never runs (or touches its stack) anywhere else
+		if (CPU_COUNT(&set) == 0 || pthread_attr_setaffinity_np(&attr, sizeof(set), &set) != 0) {
+			pthread_attr_destroy(&attr);
+			DSL_UnregisterThread(ret);
+			return NULL;
+		}
+	}
+#endif
+	int err = pthread_create(&ret->hThread, &attr, DSL_ThreadEntry, (void *)ret);
+	pthread_attr_destroy(&attr);
+	if (err == 0) {
 		DSL_SetThreadName(ret->hThread, desc);
 		pthread_detach(ret->hThread); // tells OS that it can reclaim used memory after thread exits
 	} else {
@@ -165,7 +380,7 @@ bool DSL_CC DSL_KillThread(DSL_THREAD_INFO * tt) {
 }
 
 void DSL_CC DSL_PrintRunningThreads() {
-	AutoMutexPtr(DSL_Thread_Mutex());
+	AutoReadLockPtr(DSL_Thread_Lock());
 
 	printf("Running threads:");
 	for (DSL_List_Type::iterator x = DSL_List.begin(); x != DSL_List.end(); x++) {
@@ -176,7 +391,7 @@ void DSL_CC DSL_PrintRunningThreads() {
 }
 
 void DSL_CC DSL_PrintRunningThreadsWithID(int id) {
-	AutoMutexPtr(DSL_Thread_Mutex());
+	AutoReadLockPtr(DSL_Thread_Lock());
 
 	printf("Running threads:");
 	for (DSL_List_Type::iterator x = DSL_List.begin(); x != DSL_List.end(); x++) {
@@ -189,13 +404,13 @@ void DSL_CC DSL_PrintRunningThreadsWithID(int id) {
 }
 
 uint32 DSL_CC DSL_NumThreads() {
-	AutoMutexPtr(DSL_Thread_Mutex());
+	AutoReadLockPtr(DSL_Thread_Lock());
 	return DSL_NoThreads;
 }
 
 uint32 DSL_CC DSL_NumThreadsWithID(int id) {
 	uint32 ret = 0;
-	AutoMutexPtr(DSL_Thread_Mutex());
+	AutoReadLockPtr(DSL_Thread_Lock());
 	for (DSL_List_Type::iterator x = DSL_List.begin(); x != DSL_List.end(); x++) {
 		DSL_THREAD_INFO * tScan = *x;
 		if (tScan->id == id) { ret++; }
@@ -203,11 +418,133 @@ uint32 DSL_CC DSL_NumThreadsWithID(int id) {
 	return ret;
 }
 
+struct DSL_AsyncTask_State {
+	mutex hMutex;
+	condition_variable hCond;
+	bool completed = false;
+	vector<pair<DSL_AsyncTask_Callback, DSL_Executor *>> callbacks;
+};
+
+DSL_AsyncTask::DSL_AsyncTask() {
+	state = new DSL_AsyncTask_State;
+}
+
+DSL_AsyncTask::~DSL_AsyncTask() {
+	// Complete() may still be in the middle of unlocking after setting completed
+	state->hMutex.lock();
+	state->hMutex.unlock();
+	delete state;
+}
+
+static void dsl_async_task_callback(DSL_AsyncTask * task, DSL_AsyncTask_Callback& cb, DSL_Executor * executor) {
+	if (executor != NULL) {
+		executor->Execute([task, cb]() { cb(task); });
+	} else {
+		cb(task);
+	}
+}
+
+bool DSL_AsyncTask::Wait(int timeout) {
+	unique_lock<mutex> lock(state->hMutex);
+	if (timeout < 0) {
+		state->hCond.wait(lock, [this] { return state->completed; });
+		return true;
+	}
+	return state->hCond.wait_for(lock, chrono::milliseconds(timeout), [this] { return state->completed; });
+}
+
+void DSL_AsyncTask::OnComplete(DSL_AsyncTask_Callback cb, DSL_Executor * executor) {
+	{
+		lock_guard<mutex> lock(state->hMutex);
+		if (!state->completed) {
+			state->callbacks.push_back({ cb, executor });
+			return;
+		}
+	}
+	dsl_async_task_callback(this, cb, executor);
+}
+
+DSL_AsyncTask * DSL_AsyncTask::Then(DSL_AsyncTask * next, DSL_Executor * executor) {
+	OnComplete([next](DSL_AsyncTask * task) { next->Execute(); }, executor);
+	return next;
+}
+
+void DSL_AsyncTask::Execute() {
+	Run();
+	Complete();
+}
+
+void DSL_AsyncTask::Complete() {
+	vector<pair<DSL_AsyncTask_Callback, DSL_Executor *>> cbs;
+	{
+		lock_guard<mutex> lock(state->hMutex);
+		if (state->completed) {
+			return;
+		}
+		state->completed = true;
+		done = true;
+		cbs.swap(state->callbacks);
+		state->hCond.notify_all();
+	}
+	// the task may be deleted as soon as the lock is released (even by one of these callbacks), so only touch our local copy from here on
+	for (auto& x : cbs) {
+		dsl_async_task_callback(this, x.first, x.second);
+	}
+}
+
+/* Shared by the callbacks of one DSL_WhenAll/DSL_WhenAny call. The WhenTask itself isn't touched after it completes, since its owner may delete it at any time after that. */
+struct DSL_WhenState {
+	DSL_WhenTask * when;
+	atomic<size_t> remaining;
+	atomic<bool> fired;
+};
+
+DSL_WhenTask * DSL_WhenAll(const vector<DSL_AsyncTask *>& tasks) {
+	DSL_WhenTask * ret = new DSL_WhenTask();
+	if (tasks.size() == 0) {
+		ret->Complete();
+		return ret;
+	}
+	auto ws = make_shared<DSL_WhenState>();
+	ws->when = ret;
+	ws->remaining = tasks.size();
+	ws->fired = false;
+	for (auto * t : tasks) {
+		t->OnComplete([ws](DSL_AsyncTask * task) {
+			if (ws->remaining.fetch_sub(1) == 1) {
+				ws->when->Complete();
+			}
+		});
+	}
+	return ret;
+}
+
+DSL_WhenTask * DSL_WhenAny(const vector<DSL_AsyncTask *>& tasks) {
+	DSL_WhenTask * ret = new DSL_WhenTask();
+	if (tasks.size() == 0) {
+		ret->Complete();
+		return ret;
+	}
+	auto ws = make_shared<DSL_WhenState>();
+	ws->when = ret;
+	ws->remaining = tasks.size();
+	ws->fired = false;
+	for (auto * t : tasks) {
+		t->OnComplete([ws](DSL_AsyncTask * task) {
+			bool expected = false;
+			if (ws->fired.compare_exchange_strong(expected, true)) {
+				ws->when->first_done = task;
+				ws->when->Complete();
+			}
+		});
+	}
+	return ret;
+}
+
 DSL_DEFINE_THREAD(AsyncTaskThread) {
 	DSL_THREAD_START
 	DSL_AsyncTask * h = (DSL_AsyncTask *)tt->parm;
-	h->Run();
-	h->done = true;
+	h->Execute();
 	DSL_THREAD_END
 }
 
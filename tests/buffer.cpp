@@ -0,0 +1,203 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2023 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+#include <drift/dsl.h>
+
+#define QUEUE_PRODUCERS 4
+#define QUEUE_ITEMS 100000
+
+DSL_DEFINE_THREAD(QueueProducer) {
+	DSL_THREAD_START
+	DSL_ByteQueue * q = (DSL_ByteQueue *)tt->parm;
+	for (uint32 i = 0; i < QUEUE_ITEMS; i++) {
+		q->Append(&i, sizeof(i), -1);
+	}
+	DSL_THREAD_END
+}
+
+// moves one chain into the other over and over while another thread does the opposite
+DSL_CHAIN_BUFFER swap_chains[2];
+DSL_DEFINE_THREAD(ChainSwapper) {
+	DSL_THREAD_START
+	int dir = (int)(intptr_t)tt->parm;
+	for (int i = 0; i < 20000; i++) {
+		chain_buffer_append_chain(&swap_chains[dir], &swap_chains[1 - dir]);
+	}
+	DSL_THREAD_END
+}
+
+int main(int argc, char * argv[]) {
+	if (!dsl_init()) {
+		printf("dsl_init() failed!\n");
+		return 1;
+	}
+
+	int ret = 0;
+	DSL_BUFFER buf;
+	buffer_init(&buf);
+
+	// stream bytes through the buffer a few at a time like a parser would
+	string expected, got;
+	char tmp[7];
+	for (int i = 0; i < 100000; i++) {
+		for (size_t j = 0; j < sizeof(tmp); j++) {
+			tmp[j] = (char)('a' + ((i + j) % 26));
+		}
+		buffer_append(&buf, tmp, sizeof(tmp));
+		expected.append(tmp, sizeof(tmp));
+		if (buf.len >= 5) {
+			got.append(buf.data, 5);
+			buffer_remove_front(&buf, 5);
+		}
+	}
+	got.append(buf.data, buf.len);
+	if (got == expected) {
+		printf("[buffer] Streaming append/remove_front success!\n");
+	} else {
+		printf("[buffer] Streaming append/remove_front mismatch!\n");
+		ret = 1;
+	}
+
+	buffer_set(&buf, "World", 5);
+	buffer_remove_front(&buf, 2);
+	buffer_prepend(&buf, "Wo", 2);
+	buffer_prepend(&buf, "Hello ", 6);
+	buffer_append(&buf, "!", 1);
+	if (buffer_as_string(&buf) == "Hello World!") {
+		printf("[buffer] Prepend success!\n");
+	} else {
+		printf("[buffer] Prepend mismatch: %s\n", buffer_as_string(&buf).c_str());
+		ret = 1;
+	}
+
+	buffer_free(&buf);
+
+	buffer_init_spill(&buf, 4096);
+	for (int i = 0; i < 65536; i++) {
+		buffer_append_int<int32>(&buf, i);
+	}
+	DSL_FILE * fp = RW_ConvertBuffer(&buf, 0);
+	bool spill_ok = (buf.flags & DSL_BUFFER_FLAG_SPILLED) != 0;
+	for (int i = 0; i < 65536 && spill_ok; i++) {
+		int32 val;
+		spill_ok = (fp->read(&val, sizeof(val), fp) == sizeof(val) && val == i);
+	}
+	fp->close(fp);
+	if (spill_ok) {
+		printf("[buffer] Spill to disk success!\n");
+	} else {
+		printf("[buffer] Spill to disk error!\n");
+		ret = 1;
+	}
+	buffer_free(&buf);
+
+	DSL_BUFFER * pbuf = buffer_acquire(1000);
+	DSL_BUFFER * first = pbuf;
+	buffer_set(pbuf, "pooled", 6);
+	buffer_release(pbuf);
+	pbuf = buffer_acquire(1000);
+	if (pbuf == first && pbuf->len == 0 && pbuf->capacity >= 1000) {
+		printf("[buffer] Pool reuse success!\n");
+	} else {
+		printf("[buffer] Pool reuse error!\n");
+		ret = 1;
+	}
+	buffer_release(pbuf);
+
+	{
+		DSL_INLINE_BUFFER<16> ibuf;
+		buffer_append(&ibuf, "0123456789", 10);
+		bool was_inline = (ibuf.data == ibuf.storage);
+		buffer_append(&ibuf, "0123456789", 10);
+		if (was_inline && ibuf.data != ibuf.storage && buffer_as_string(&ibuf) == "01234567890123456789") {
+			printf("[buffer] Inline buffer success!\n");
+		} else {
+			printf("[buffer] Inline buffer error!\n");
+			ret = 1;
+		}
+	}
+
+	DSL_CHAIN_BUFFER chain;
+	chain_buffer_init(&chain, 16);
+	static const char ext[] = "external ";
+	int released = 0;
+	chain_buffer_append(&chain, "a chain ", 8);
+	chain_buffer_append_ref(&chain, ext, sizeof(ext) - 1, [](void * ptr, int64 len, void * user_ptr) { (*(int *)user_ptr)++; }, &released);
+	chain_buffer_append(&chain, "buffer spanning several segments", 32);
+	chain_buffer_prepend(&chain, "This is ", 8);
+
+	DSL_IOVEC iov[16];
+	int niov = chain_buffer_get_iovec(&chain, iov, 16);
+	string joined;
+	for (int i = 0; i < niov; i++) {
+#if defined(WIN32)
+		joined.append(iov[i].buf, iov[i].len);
+#else
+		joined.append((const char *)iov[i].iov_base, iov[i].iov_len);
+#endif
+	}
+	if (joined == "This is a chain external buffer spanning several segments" && joined == chain_buffer_as_string(&chain)) {
+		printf("[chain_buffer] iovec export success! (%d segments)\n", niov);
+	} else {
+		printf("[chain_buffer] iovec export mismatch: %s\n", joined.c_str());
+		ret = 1;
+	}
+	chain_buffer_remove_front(&chain, 25);
+	if (released == 1 && chain_buffer_as_string(&chain) == "buffer spanning several segments") {
+		printf("[chain_buffer] remove_front/release success!\n");
+	} else {
+		printf("[chain_buffer] remove_front/release error!\n");
+		ret = 1;
+	}
+	chain_buffer_free(&chain);
+
+	for (int i = 0; i < 2; i++) {
+		chain_buffer_init(&swap_chains[i], 16, true);
+		chain_buffer_append(&swap_chains[i], "0123456789abcdefghij", 20);
+	}
+	DSL_StartThread(ChainSwapper, (void *)0, "Chain Swapper", 2);
+	DSL_StartThread(ChainSwapper, (void *)1, "Chain Swapper", 2);
+	while (DSL_NumThreadsWithID(2)) {
+		safe_sleep_ms(10);
+	}
+	if (swap_chains[0].len + swap_chains[1].len == 40 && (chain_buffer_as_string(&swap_chains[0]) + chain_buffer_as_string(&swap_chains[1])).length() == 40) {
+		printf("[chain_buffer] Concurrent append_chain success!\n");
+	} else {
+		printf("[chain_buffer] Concurrent append_chain error!\n");
+		ret = 1;
+	}
+	chain_buffer_free(&swap_chains[0]);
+	chain_buffer_free(&swap_chains[1]);
+
+	// every producer sends 0..QUEUE_ITEMS-1, the consumer checks the total so nothing was lost or torn
+	DSL_ByteQueue queue(4096, true);
+	for (int i = 0; i < QUEUE_PRODUCERS; i++) {
+		DSL_StartThread(QueueProducer, &queue, "Queue Producer", 1);
+	}
+	uint64 sum = 0;
+	for (uint32 i = 0; i < QUEUE_PRODUCERS * QUEUE_ITEMS; i++) {
+		uint32 val;
+		queue.WaitForData(sizeof(val));
+		queue.Read(&val, sizeof(val));
+		sum += val;
+	}
+	while (DSL_NumThreadsWithID(1)) {
+		safe_sleep_ms(10);
+	}
+	if (sum == (uint64)QUEUE_PRODUCERS * QUEUE_ITEMS * (QUEUE_ITEMS - 1) / 2 && queue.Length() == 0) {
+		printf("[byte_queue] MPSC success!\n");
+	} else {
+		printf("[byte_queue] MPSC error! Got sum " U64FMT "\n", sum);
+		ret = 1;
+	}
+
+	dsl_cleanup();
+	return ret;
+}
@@ -9,6 +9,8 @@
 //@AUTOHEADER@END@
 
 #include <drift/dsl.h>
+#include <drift/algo/blake3.h>
+#include <drift/algo/fasthash.h>
 
 int main(int argc, char * argv[]) {
 	if (!dsl_init()) {
@@ -30,13 +32,37 @@ int main(int argc, char * argv[]) {
 
 	map<string, string> hashtests;
 	hashtests["sha512"] = "353c491fbc377105f3eec54ebb495aafe4a32db2975c132981ef5d86e453f401dcd6ef88c2c8d947d56782f99783ea78069a5c5e818ea64ade6bd97b958353bb";
+	hashtests["sha384"] = "93d00be8f8cf925a6ce7049a2cc4915c7dab769430e4b0d51e35f6aa58ac7766d6a181f470c5ecbb16eaa15b7eb90245";
+	hashtests["sha512-256"] = "12b3462c362a4bb4020d3773263f27f9313297d8c7d0401dd29c91db516e885a";
 	hashtests["sha256"] = "d4abc4d6b461a88d41603c634933f513045e2533b544c67f03d5b56a3d6e93c6";
 	hashtests["sha1"] = "426cddde1d3699bfae66c0b3a37ef78fafb21e8f";
 	hashtests["md5"] = "f8aa86a89d24c64f390fcd7a28f0eca8";
+	hashtests["sha3-256"] = "94ca22d6186c9c6e2dfe4d7bb683284e6a4e69f6a3f777eee8ff99accb202232";
+	hashtests["sha3-512"] = "5b8ae0f522099037e5688b42882dae69a9e546d51b188a343bb17d532a65934f38108fbad176ec8e236378fdcf847d2e4ab917117ca48d0b12ecaa983f68904b";
+	hashtests["keccak256"] = "83607814064c12e5bf7738e47933753594eb17be1bd28bd199e0c292e03c3277";
+	hashtests["keccak512"] = "99ad3996a0024b931e293065ac7dd8a6916105ca02087e1bc9215fc6a3cd5875f1335316e157e8bb343a8fe2f151a38f1e86478928eb6d957a128c32e7100c34";
 	hashtests["blake2s256"] = "7551e904b28ee6f4be76d0b7d6d5d7edef312c46dcf07f0a2c9ed25bd9628b61";
 	hashtests["blake2b256"] = "457814f56ef15896dc58495609f747e7836229bc71136e92fe9fbc8c59aa142a";
+	hashtests["blake3"] = "b5c80fac11cdcc50271d9d71e01d8271b33687366752581f8d7df4cbcf912712";
+	hashtests["xxh3-64"] = "43e72b36dd4d0386";
+	hashtests["xxh3-128"] = "d46f96c4b418454448e62b262cfba0df";
+	hashtests["wyhash"] = "24d7c58d5124826c";
+	hashtests["crc32"] = "c7ebe065";
+	hashtests["crc32c"] = "69bb463c";
 	hashtests["blake2b512"] = "636c594c418aba70c1bb4680e7ebf56b5de33048694372afeae9fe1d3fce123b185a2ad68ad8526c72a4c6298deb4bf8fc1a13e295a67a85314fe1d7f107c923";
 
+	// multi-block input, exercises the bulk paths of the accelerated implementations
+	string longstr(1000000, 'a');
+	map<string, string> longtests;
+	longtests["sha512"] = "e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803afa973ebde0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e4eadb217ad8cc09b";
+	longtests["sha256"] = "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0";
+	longtests["sha3-256"] = "5c8875ae474a3634ba4fd55ec85bffd661f32aca75c6d699d0cdcb6c115891c1";
+	longtests["sha1"] = "34aa973cd4c4daa4f61eeb2bdbad27316534016f";
+	longtests["blake3"] = "616f575a1b58d4c9797d4217b9730ae5e6eb319d76edef6549b46f4efe31ff8b";
+	longtests["xxh3-128"] = "a545df8e384a9579b1fd6fae5285c4eb";
+	longtests["crc32"] = "dc25bfbc";
+	longtests["crc32c"] = "436fe240";
+
 	dsl_get_hash_providers(p);
 	printf("Num hash providers: %zu\n", p.size());
 	for (auto e = p.begin(); e != p.end(); e++) {
@@ -63,6 +89,207 @@ int main(int argc, char * argv[]) {
 				printf("[%s]: error initializing hash!\n", x->first.c_str());
 			}
 		}
+		for (auto x = longtests.begin(); x != longtests.end(); x++) {
+			HASH_CTX * ptr = (*e)->hash_init(x->first.c_str());
+			if (ptr != NULL) {
+				// odd sized pieces so some blocks are buffered and some aren't
+				for (size_t off = 0; off < longstr.length(); off += 999) {
+					(*e)->hash_update(ptr, (const uint8_t *)longstr.c_str() + off, std::min<size_t>(999, longstr.length() - off));
+				}
+				size_t hlen = ptr->hashSize;
+				if ((*e)->hash_finish(ptr, (uint8_t *)buf, sizeof(buf))) {
+					bin2hex((const uint8_t *)buf, hlen, buf2, sizeof(buf2));
+					if (stricmp(buf2, x->second.c_str()) == 0) {
+						printf("[%s long]: success!\n", x->first.c_str());
+					} else {
+						printf("[%s long]: error! Got %s, should be %s\n", x->first.c_str(), buf2, x->second.c_str());
+					}
+				} else {
+					printf("[%s long]: error finishing hash!\n", x->first.c_str());
+				}
+			}
+		}
+	}
+
+	// handles from hash_algo_lookup() are cached and give the same results as hash_init()
+	{
+		const HASH_ALGO * algo = hash_algo_lookup("sha256");
+		bool ok = (algo != NULL && algo == hash_algo_lookup("SHA256") && algo->hashSize == 32 && hash_algo_lookup("no-such-hash") == NULL);
+		if (ok) {
+			HASH_CTX * ctx = hash_init_algo(algo);
+			hash_update(ctx, (const uint8_t *)str.c_str(), str.length());
+			ok = hash_finish(ctx, (uint8_t *)buf, sizeof(buf)) && bin2hex((const uint8_t *)buf, 32, buf2, sizeof(buf2)) != NULL && stricmp(buf2, hashtests["sha256"].c_str()) == 0;
+		}
+		printf("[hash_algo_lookup]: %s\n", ok ? "success!" : "error!");
+	}
+
+	// contexts in caller storage that are reset and cloned instead of freed
+	{
+		const HASH_ALGO * algo = hash_algo_lookup("sha256");
+		alignas(DSL_HASH_CTX_ALIGN) uint8 storage[1024], storage2[1024];
+		bool ok = (hash_ctx_size(algo) > 0 && hash_ctx_size(algo) <= sizeof(storage));
+		HASH_CTX * ctx = ok ? hash_ctx_init_inplace(algo, storage, sizeof(storage)) : NULL;
+		for (int i = 0; ctx != NULL && ok && i < 2; i++) {
+			hash_update(ctx, (const uint8_t *)str.c_str(), str.length());
+			ok = hash_finish_reset(ctx, (uint8_t *)buf, sizeof(buf)) && bin2hex((const uint8_t *)buf, 32, buf2, sizeof(buf2)) != NULL && stricmp(buf2, hashtests["sha256"].c_str()) == 0;
+		}
+		if (ctx != NULL && ok) {
+			// a clone of a half-hashed ctx carries on from the same point
+			hash_update(ctx, (const uint8_t *)str.c_str(), 5);
+			HASH_CTX * ctx2 = hash_clone(ctx, storage2, sizeof(storage2));
+			ok = (ctx2 != NULL);
+			if (ok) {
+				hash_update(ctx2, (const uint8_t *)str.c_str() + 5, str.length() - 5);
+				ok = hash_finish(ctx2, (uint8_t *)buf, sizeof(buf)) && bin2hex((const uint8_t *)buf, 32, buf2, sizeof(buf2)) != NULL && stricmp(buf2, hashtests["sha256"].c_str()) == 0;
+			}
+		}
+		if (ctx != NULL) {
+			hash_finish(ctx, (uint8_t *)buf, sizeof(buf));
+		}
+		printf("[hash inplace/reset/clone]: %s\n", (ctx != NULL && ok) ? "success!" : "error!");
+
+		uint8 mac[32], mac2[32];
+		HASH_HMAC_CTX * hctx = hmac_init("sha256", (const uint8 *)"key", 3);
+		hmac_update(hctx, (const uint8_t *)str.c_str(), str.length());
+		hmac_finish(hctx, mac, sizeof(mac));
+		ok = (hmac_ctx_size("sha256") > 0);
+		hctx = ok ? hmac_init_inplace("sha256", (const uint8 *)"key", 3, storage, sizeof(storage)) : NULL;
+		for (int i = 0; hctx != NULL && ok && i < 2; i++) {
+			hmac_update(hctx, (const uint8_t *)str.c_str(), str.length());
+			ok = hmac_finish_reset(hctx, mac2, sizeof(mac2)) && memcmp(mac, mac2, sizeof(mac)) == 0;
+		}
+		if (hctx != NULL) {
+			hmac_finish(hctx, mac2, sizeof(mac2));
+		}
+		printf("[hmac inplace/reset]: %s\n", (hctx != NULL && ok) ? "success!" : "error!");
+	}
+
+	// RFC 6962 shaped tree of 16 64K leaves (the last one short)
+	{
+		bool ok = hashdata_tree("sha256", (const uint8 *)longstr.c_str(), longstr.length(), buf2, sizeof(buf2), false, 65536) && stricmp(buf2, "c3fa26996cd7eb4e09e725be994cff6963821fcc1ac2d6d37f4c7ca2f1ef792a") == 0;
+		printf("[sha256 tree]: %s\n", ok ? "success!" : "error!");
+	}
+
+	// hashfile_ex() and hashfile_tree() with the file mapped, read ahead and read plainly all have to match the in-memory results
+	{
+		const char * fn = "hash_test.tmp";
+		FILE * fp = fopen(fn, "wb");
+		bool ok = (fp != NULL && fwrite(longstr.c_str(), longstr.length(), 1, fp) == 1);
+		if (fp != NULL) { fclose(fp); }
+		const uint32 modes[] = { DSL_HASHFILE_MMAP, DSL_HASHFILE_READAHEAD, 0 };
+		for (auto mode : modes) {
+			ok = ok && hashfile_ex("sha256", fn, buf2, sizeof(buf2), false, mode) && stricmp(buf2, longtests["sha256"].c_str()) == 0;
+			ok = ok && hashfile_tree("sha256", fn, buf2, sizeof(buf2), false, 65536, mode) && stricmp(buf2, "c3fa26996cd7eb4e09e725be994cff6963821fcc1ac2d6d37f4c7ca2f1ef792a") == 0;
+		}
+		remove(fn);
+		printf("[hashfile_ex/hashfile_tree]: %s\n", ok ? "success!" : "error!");
+	}
+
+	// hashfiles() gives the same digests as hashfile() one at a time, and an empty entry plus false for a file that isn't there
+	{
+		const string contents[] = { "", str, longstr };
+		vector<string> files;
+		bool ok = true;
+		for (size_t i = 0; i < sizeof(contents) / sizeof(contents[0]); i++) {
+			files.push_back(mprintf("hash_test%zu.tmp", i));
+			FILE * fp = fopen(files.back().c_str(), "wb");
+			ok = ok && fp != NULL && (contents[i].length() == 0 || fwrite(contents[i].c_str(), contents[i].length(), 1, fp) == 1);
+			if (fp != NULL) { fclose(fp); }
+		}
+		files.push_back("hash_test_missing.tmp");
+		vector<string> out;
+		ok = ok && !hashfiles("sha256", files, out) && out.size() == files.size() && out.back().length() == 0;
+		for (size_t i = 0; ok && i < files.size() - 1; i++) {
+			ok = hashfile("sha256", files[i].c_str(), buf2, sizeof(buf2)) && out[i] == buf2;
+		}
+		for (size_t i = 0; i < files.size() - 1; i++) {
+			remove(files[i].c_str());
+		}
+		printf("[hashfiles]: %s\n", ok ? "success!" : "error!");
+	}
+
+	// prepared HMAC keys give the same MACs as hmac_init()
+	{
+		const char * hmactests[] = { "sha256", "sha512" };
+		for (auto name : hmactests) {
+			uint8 mac[64], mac2[64];
+			HASH_HMAC_CTX * hctx = hmac_init(name, (const uint8 *)"key", 3);
+			hmac_update(hctx, (const uint8_t *)str.c_str(), str.length());
+			hmac_finish(hctx, mac, sizeof(mac));
+			HMAC_KEY * key = hmac_key_create(name, (const uint8 *)"key", 3);
+			bool ok = (key != NULL);
+			for (int i = 0; ok && i < 2; i++) {
+				ok = hmac_key_mac(key, (const uint8_t *)str.c_str(), str.length(), mac2, sizeof(mac2)) && memcmp(mac, mac2, key->hashSize) == 0;
+			}
+			if (ok) {
+				hctx = hmac_init_key(key);
+				hmac_update(hctx, (const uint8_t *)str.c_str(), str.length());
+				ok = hmac_finish(hctx, mac2, sizeof(mac2)) && memcmp(mac, mac2, key->hashSize) == 0;
+			}
+			hmac_key_free(key);
+			printf("[%s hmac_key]: %s\n", name, ok ? "success!" : "error!");
+		}
+	}
+
+	// BLAKE3 keyed mode with extended output (read in one go and from an offset), and key derivation
+	{
+		uint8 key[BLAKE3_KEY_LEN], out[100];
+		for (size_t i = 0; i < sizeof(key); i++) {
+			key[i] = (uint8)i;
+		}
+		blake3_hasher b3;
+		blake3_hasher_init_keyed(&b3, key);
+		blake3_hasher_update(&b3, str.c_str(), str.length());
+		blake3_hasher_finalize(&b3, out, sizeof(out));
+		bool ok = bin2hex(out, sizeof(out), buf2, sizeof(buf2)) != NULL && stricmp(buf2, "e6e12b4f49bb94887bf20a1a340f4e001b6a1ed4123b2df4f7fc522d1339dbb858448ff3cd11e24965e40eccaf251d3d754e7c6cea26bff735a791f0ce6fab1a2d6eda001d67cd047df57ab6ae2eb4e16a444cb4c473a1a849ae578de3cf8a671dfa38be") == 0;
+		uint8 tail[36];
+		blake3_hasher_finalize_seek(&b3, 64, tail, sizeof(tail));
+		ok = ok && memcmp(tail, out + 64, sizeof(tail)) == 0;
+		printf("[blake3 keyed/xof]: %s\n", ok ? "success!" : "error!");
+
+		blake3_hasher_init_derive_key(&b3, "Drift Standard Libraries test");
+		blake3_hasher_update(&b3, str.c_str(), str.length());
+		blake3_hasher_finalize(&b3, out, BLAKE3_OUT_LEN);
+		ok = bin2hex(out, BLAKE3_OUT_LEN, buf2, sizeof(buf2)) != NULL && stricmp(buf2, "ab98b51e9c90375595c205d2459389221f300ab44405a9158560be2ab43ca323") == 0;
+		printf("[blake3 derive_key]: %s\n", ok ? "success!" : "error!");
+	}
+
+	// XXH3 streamed in uneven pieces should match the one-shot functions, and the CRCs should continue from a previous result
+	{
+		xxh3_state xs;
+		xxh3_init(&xs, 1234);
+		for (size_t done = 0, step = 1; done < longstr.length(); step = step * 3 + 1) {
+			size_t n = min(step, longstr.length() - done);
+			xxh3_update(&xs, longstr.c_str() + done, n);
+			done += n;
+		}
+		xxh3_128_hash h = xxh3_128(longstr.c_str(), longstr.length(), 1234), h2 = xxh3_digest128(&xs);
+		bool ok = xxh3_digest64(&xs) == xxh3_64(longstr.c_str(), longstr.length(), 1234) && h.low == h2.low && h.high == h2.high;
+		ok = ok && dsl_crc32c(dsl_crc32c(0, longstr.c_str(), 777), longstr.c_str() + 777, longstr.length() - 777) == 0x436fe240;
+		ok = ok && dsl_crc32(dsl_crc32(0, longstr.c_str(), 777), longstr.c_str() + 777, longstr.length() - 777) == 0xdc25bfbc;
+		printf("[xxh3 stream/crc continue]: %s\n", ok ? "success!" : "error!");
+	}
+
+	// hash_batch() should give the same digests as hashing one at a time
+	{
+		vector<HASH_BATCH_ITEM> items(37);
+		for (size_t i = 0; i < items.size(); i++) {
+			items[i].data = (const uint8 *)longstr.c_str();
+			items[i].length = (i * i * 7) % 1000;
+		}
+		const char * batchtests[] = { "md5", "sha1", "sha256", "sha512", "sha3-256", "keccak256" };
+		for (auto name : batchtests) {
+			uint8 out[37 * 64];
+			bool ok = hash_batch(name, items.data(), items.size(), out, sizeof(out));
+			for (size_t i = 0; ok && i < items.size(); i++) {
+				HASH_CTX * ctx = hash_init(name);
+				size_t hlen = ctx->hashSize;
+				hash_update(ctx, items[i].data, items[i].length);
+				hash_finish(ctx, (uint8_t *)buf, sizeof(buf));
+				ok = (memcmp(buf, out + (i * hlen), hlen) == 0);
+			}
+			printf("[%s batch]: %s\n", name, ok ? "success!" : "error!");
+		}
 	}
 
 	dsl_cleanup();
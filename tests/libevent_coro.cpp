@@ -0,0 +1,131 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2025 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+/*
+ * Loopback test of the C++20 coroutine layer, built as its own C++20 target (see CMakeLists.txt.)
+ * A plain blocking thread plays the server, the client side runs as a coroutine on the event loop.
+ */
+
+#include <drift/dsl.h>
+#include <drift/libevent_coro.h>
+
+#if defined(DSL_IS_CPP20_OR_NEWER)
+
+DSL_Sockets3 * socks = NULL;
+DSL_SOCKET * listener = NULL;
+
+// echoes lines back until it gets "quit", then closes the connection
+DSL_DEFINE_THREAD(EchoServer) {
+	DSL_THREAD_START
+	DSL_SOCKET * s = socks->Accept(listener);
+	if (s != NULL) {
+		char buf[256];
+		while (socks->RecvLine(s, buf, sizeof(buf)) >= 0) {
+			if (!strcmp(buf, "quit")) {
+				break;
+			}
+			string reply = mprintf("echo %s\n", buf);
+			socks->Send(s, reply.c_str(), (int)reply.length());
+		}
+		socks->Close(s);
+	}
+	DSL_THREAD_END
+}
+
+DSL_Event_Task<> CancelLater(DSL_Sockets_Events * ev, DSL_Event_Cancel * cancel, int ms) {
+	co_await DSL_Event_Sleep(ev, ms);
+	cancel->Cancel();
+}
+
+DSL_Event_Task<> Client(DSL_Sockets_Events * ev, int port, string * result) {
+	DSL_Event_Socket sock(ev, socks->Create());
+	DSL_Event_Cancel cancel;
+	string line;
+
+	if (!co_await sock.Connect("127.0.0.1", port, 5000)) {
+		*result = "connect";
+	} else if (co_await sock.Send("hello\n", -1, 5000) != 6) {
+		*result = "send";
+	} else if (co_await sock.RecvLine(line, 4096, 5000) < 0 || line != "echo hello") {
+		*result = "recv_line";
+	} else {
+		// nothing else is coming, so the read has to end by timeout or cancellation
+		int64 start = GetTickCount64();
+		bool slept = co_await DSL_Event_Sleep(ev, 50);
+		int64 elapsed = GetTickCount64() - start;
+		CancelLater(ev, &cancel, 50).Start();
+		int timeout_ret = co_await sock.RecvLine(line, 4096, 50);
+		int cancel_ret = co_await sock.RecvLine(line, 4096, 5000, &cancel);
+		bool cancelled_sleep = co_await DSL_Event_Sleep(ev, 5000, &cancel);
+		if (!slept || elapsed < 40) {
+			*result = "sleep";
+		} else if (timeout_ret != DSL_EVENT_TIMEOUT) {
+			*result = "timeout";
+		} else if (cancel_ret != DSL_EVENT_CANCELLED || cancelled_sleep) {
+			*result = "cancel";
+		} else if (co_await sock.Send("quit\n") != 5 || co_await sock.RecvLine(line, 4096, 5000) != RL3_CLOSED) {
+			*result = "close";
+		} else {
+			*result = "ok";
+		}
+	}
+	sock.Close();
+	ev->LoopBreak();
+}
+
+int main(int argc, char * argv[]) {
+	if (!dsl_init()) {
+		printf("dsl_init() failed!\n");
+		return 1;
+	}
+
+	socks = new DSL_Sockets3();
+	listener = socks->Create();
+	sockaddr_in addr;
+	socklen_t addrlen = sizeof(addr);
+	if (listener == NULL || !socks->BindToAddr(listener, "127.0.0.1", 0) || !socks->Listen(listener) || getsockname(listener->sock, (sockaddr *)&addr, &addrlen) != 0) {
+		printf("[libevent_coro] Error setting up the listening socket!\n");
+		return 1;
+	}
+	DSL_StartThread(EchoServer, NULL);
+
+	string result = "loop timed out";
+	{
+		DSL_Sockets_Events ev(socks);
+		Client(&ev, ntohs(addr.sin_port), &result).Start(&ev);
+		ev.LoopWithTimeout(30000);
+	}
+
+	int ret = 0;
+	if (result == "ok") {
+		printf("[libevent_coro] Connect/Send/RecvLine/Sleep/Cancel success!\n");
+	} else {
+		printf("[libevent_coro] Connect/Send/RecvLine/Sleep/Cancel error! (%s)\n", result.c_str());
+		ret = 1;
+	}
+
+	socks->Close(listener);
+	while (DSL_NumThreads()) {
+		safe_sleep(100, true);
+	}
+	delete socks;
+
+	dsl_cleanup();
+	return ret;
+}
+
+#else
+
+int main(int argc, char * argv[]) {
+	printf("[libevent_coro] Skipped, needs C++20\n");
+	return 0;
+}
+
+#endif
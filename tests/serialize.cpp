@@ -25,6 +25,17 @@ protected:
 	}
 };
 
+class SerializationVectorTest : public DSL_Serializable {
+public:
+	vector<SerializationTest> items;
+
+protected:
+	bool Serialize(DSL_BUFFER * buf, bool deserialize) {
+		serv2p(items, SerializationTest);
+		return true;
+	}
+};
+
 int main(int argc, char * argv[]) {
 	if (!dsl_init()) {
 		printf("dsl_init() failed!\n");
@@ -56,6 +67,18 @@ int main(int argc, char * argv[]) {
 		printf("Error serializing data!\n");
 	}
 
+	// parallel vector round trip, and a count that claims far more entries than the data holds has to be rejected
+	SerializationVectorTest vtest1, vtest2;
+	for (int i = 0; i < 100; i++) {
+		vtest1.items.push_back(test1);
+		vtest1.items.back().test3 = i;
+	}
+	encoded = vtest1.GetSerialized();
+	bool ok = vtest2.FromSerialized(encoded) && vtest2.items.size() == 100 && vtest2.items[99].test3 == 99 && vtest2.items[0].test1 == "Hello";
+	encoded = string("\xFF\xFF\xFF\xFF\x0F", 5) + encoded.substr(1, 16); // a count of 0xFFFFFFFF
+	ok = ok && !vtest2.FromSerialized(encoded);
+	printf("Vector serializer test %s\n", ok ? "success!" : "error!");
+
 	dsl_cleanup();
 	return 0;
 }
@@ -0,0 +1,373 @@
+//@AUTOHEADER@BEGIN@
+/***********************************************************************\
+|                    Drift Standard Libraries v1.01                     |
+|            Copyright 2010-2023 Drift Solutions / Indy Sams            |
+| Docs and more information available at https://www.driftsolutions.dev |
+|          This file released under the 3-clause BSD license,           |
+|            see included DSL.LICENSE.TXT file for details.             |
+\***********************************************************************/
+//@AUTOHEADER@END@
+
+#define DSL_MUTEX_PROFILER
+#include <drift/dsl.h>
+
+#define LOCK_THREADS 4
+#define LOCK_ITERATIONS 200000
+
+DSL_Mutex profiled_mutex;
+DSL_FastMutex fast_mutex;
+DSL_SpinLock spin_lock;
+DSL_RWLock rw_lock;
+uint64 mutex_count = 0, fast_count = 0, spin_count = 0, rw_count = 0;
+bool rw_torn = false;
+atomic<uint64> pool_count(0);
+uint64 rw_pair[2] = { 0, 0 };
+DSL_ShardedCounter sharded_count;
+DSL_Atomic<int64> atomic_min(INT64_MAX), atomic_max(0);
+
+int value_key = -1;
+atomic<int> value_freed(0);
+bool value_ok = false;
+
+DSL_DEFINE_THREAD(ValueThread) {
+	DSL_THREAD_START
+	DSL_SetThreadValue(value_key, new int(42));
+	int * p = (int *)DSL_GetThreadValue(value_key);
+	value_ok = (p != NULL && *p == 42 && DSL_GetCurrentThreadInfo() == tt);
+	DSL_THREAD_END
+}
+
+#define QUEUE_ITEMS 100000
+DSL_Queue<uint64> queue(64);
+atomic<uint64> queue_sum(0), queue_popped(0);
+
+DSL_DEFINE_THREAD(QueueProducer) {
+	DSL_THREAD_START
+	for (uint64 i = 1; i <= QUEUE_ITEMS; i++) {
+		queue.Push(i);
+	}
+	DSL_THREAD_END
+}
+
+DSL_DEFINE_THREAD(QueueConsumer) {
+	DSL_THREAD_START
+	uint64 items[16];
+	size_t n;
+	while ((n = queue.PopBatch(items, 16)) > 0) {
+		for (size_t i = 0; i < n; i++) {
+			queue_sum += items[i];
+		}
+		queue_popped += n;
+	}
+	DSL_THREAD_END
+}
+
+// external threads hammering Submit() while the pool shuts down, every call has to end up running exactly once
+DSL_ThreadPool * shutdown_pool = NULL;
+atomic<int> shutdown_submitted(0), shutdown_ran(0);
+atomic<bool> shutdown_go(false);
+
+DSL_DEFINE_THREAD(ShutdownSubmitter) {
+	DSL_THREAD_START
+	while (!shutdown_go) {
+		safe_sleep_ms(1);
+	}
+	for (int i = 0; i < 20000; i++) {
+		shutdown_submitted++;
+		shutdown_pool->Submit([]() { shutdown_ran++; });
+	}
+	DSL_THREAD_END
+}
+
+class CountTask : public DSL_AsyncTask {
+public:
+	void Run() {
+		pool_count += 1000;
+	}
+};
+
+DSL_DEFINE_THREAD(LockThread) {
+	DSL_THREAD_START
+	for (int i = 0; i < LOCK_ITERATIONS; i++) {
+		sharded_count++;
+		atomic_min.FetchMin(i);
+		atomic_max.FetchMax(i);
+		{
+			AutoMutex(profiled_mutex);
+			mutex_count++;
+		}
+		{
+			AutoFastMutex(fast_mutex);
+			fast_count++;
+		}
+		{
+			AutoSpinLock(spin_lock);
+			spin_count++;
+		}
+		if (i % 8 == 0) {
+			AutoWriteLock(rw_lock);
+			rw_pair[0]++;
+			rw_pair[1]++;
+			rw_count++;
+		} else {
+			AutoReadLock(rw_lock);
+			if (rw_pair[0] != rw_pair[1]) {
+				rw_torn = true;
+			}
+		}
+	}
+	DSL_THREAD_END
+}
+
+int main(int argc, char * argv[]) {
+	if (!dsl_init()) {
+		printf("dsl_init() failed!\n");
+		return 1;
+	}
+
+	int ret = 0;
+	dsl_mutex_profiler_enable(true);
+	for (int i = 0; i < LOCK_THREADS; i++) {
+		DSL_StartThread(LockThread, NULL, "Lock Thread", 1);
+	}
+	while (DSL_NumThreadsWithID(1)) {
+		safe_sleep_ms(10);
+	}
+
+	uint64 expected = (uint64)LOCK_THREADS * LOCK_ITERATIONS;
+	dsl_mutex_profiler_enable(false);
+	uint64 profiled = 0;
+	for (DSL_MUTEX_PROFILE_SITE * site = dsl_mutex_profiler_first_site(); site != NULL; site = site->next) {
+		if (!strcmp(site->file, __FILE__)) {
+			profiled += site->count;
+		}
+	}
+	if (mutex_count == expected && profiled == expected) {
+		printf("[mutex] Contention profiler success!\n");
+		dsl_mutex_profiler_report(stdout, false);
+	} else {
+		printf("[mutex] Contention profiler error! (" U64FMT "/" U64FMT ")\n", mutex_count, profiled);
+		ret = 1;
+	}
+	if (fast_count == expected && spin_count == expected) {
+		printf("[mutex] DSL_FastMutex/DSL_SpinLock success!\n");
+	} else {
+		printf("[mutex] DSL_FastMutex/DSL_SpinLock error! (" U64FMT "/" U64FMT ")\n", fast_count, spin_count);
+		ret = 1;
+	}
+	if (!rw_torn && rw_count == expected / 8 && rw_pair[0] == rw_count) {
+		printf("[mutex] DSL_RWLock success!\n");
+	} else {
+		printf("[mutex] DSL_RWLock error!\n");
+		ret = 1;
+	}
+	if (sharded_count.Get() == (int64)expected && atomic_min == 0 && atomic_max == LOCK_ITERATIONS - 1) {
+		printf("[atomic] DSL_ShardedCounter/DSL_Atomic success!\n");
+	} else {
+		printf("[atomic] DSL_ShardedCounter/DSL_Atomic error! (" I64FMT ")\n", sharded_count.Get());
+		ret = 1;
+	}
+	if (fast_mutex.TryLock() && !fast_mutex.Lock(50)) {
+		printf("[mutex] DSL_FastMutex timeout success!\n");
+	} else {
+		printf("[mutex] DSL_FastMutex timeout error!\n");
+		ret = 1;
+	}
+	fast_mutex.Release();
+
+	value_key = DSL_ThreadKeyCreate([](void * value) { delete (int *)value; value_freed++; });
+	DSL_THREAD_OPTIONS opts;
+	opts.desc = "Value Thread";
+	opts.id = 2;
+	opts.cpus.push_back(0);
+	opts.priority = DSL_THREAD_PRIORITY_BELOW_NORMAL;
+	opts.stack_size = 256 * 1024;
+	if (DSL_StartThreadEx(ValueThread, NULL, opts) == NULL) {
+		printf("[threading] DSL_StartThreadEx error!\n");
+		ret = 1;
+	}
+	while (DSL_NumThreadsWithID(2)) {
+		safe_sleep_ms(10);
+	}
+	if (value_key >= 0 && value_ok && value_freed == 1 && DSL_GetThreadValue(value_key) == NULL) {
+		printf("[threading] DSL_StartThreadEx/thread values success! (NUMA nodes: %d)\n", DSL_GetNumaNodeCount());
+	} else {
+		printf("[threading] DSL_StartThreadEx/thread values error!\n");
+		ret = 1;
+	}
+
+	for (int i = 0; i < 2; i++) {
+		DSL_StartThread(QueueProducer, NULL, "Queue Producer", 3);
+		DSL_StartThread(QueueConsumer, NULL, "Queue Consumer", 4);
+	}
+	while (DSL_NumThreadsWithID(3)) {
+		safe_sleep_ms(10);
+	}
+	queue.Close();
+	while (DSL_NumThreadsWithID(4)) {
+		safe_sleep_ms(10);
+	}
+	uint64 queue_expected = (uint64)QUEUE_ITEMS * (QUEUE_ITEMS + 1); // 2 producers * n(n+1)/2
+	if (queue_popped == 2 * QUEUE_ITEMS && queue_sum == queue_expected && !queue.TryPush(1)) {
+		printf("[queue] DSL_Queue MPMC success!\n");
+	} else {
+		printf("[queue] DSL_Queue MPMC error! (" U64FMT "/" U64FMT ")\n", queue_popped.load(), queue_sum.load());
+		ret = 1;
+	}
+
+	// tasks that submit more tasks end up on the submitting worker's deque and get stolen by the others
+	DSL_ThreadPool pool(4, "Test Pool");
+	for (int i = 0; i < 1000; i++) {
+		pool.Submit([&pool]() {
+			for (int j = 0; j < 10; j++) {
+				pool.Submit([]() { pool_count++; });
+			}
+		});
+	}
+	vector<DSL_ThreadPool_Task> batch;
+	for (int i = 0; i < 10000; i++) {
+		batch.push_back([]() { pool_count++; });
+	}
+	pool.SubmitBatch(batch);
+	CountTask task;
+	DSL_StartAsyncTaskOnPool(&task, &pool);
+	if (pool.WaitIdle(30000) && task.done && pool_count == 21000) {
+		printf("[thread_pool] Submit/SubmitBatch success!\n");
+	} else {
+		printf("[thread_pool] Submit/SubmitBatch error! (" U64FMT ")\n", pool_count.load());
+		ret = 1;
+	}
+
+	vector<uint32> nums(100000);
+	DSL_ParallelFor(0, nums.size(), [&nums](size_t i) { nums[i] = (uint32)((i * 2654435761u) % 1000003); }, 0, &pool);
+	uint64 sum = DSL_ParallelReduce<uint64>(0, nums.size(), 0, [&nums](size_t i) { return (uint64)nums[i]; }, [](uint64 x, uint64 y) { return x + y; }, 0, &pool);
+	uint64 sum2 = 0;
+	for (auto x : nums) { sum2 += x; }
+	vector<uint32> sorted(nums.size());
+	DSL_ParallelTransform(nums.begin(), nums.end(), sorted.begin(), [](uint32 x) { return x; }, 0, &pool);
+	DSL_ParallelSort(sorted.begin(), sorted.end(), &pool);
+	std::sort(nums.begin(), nums.end());
+	bool caught = false;
+	try {
+		DSL_ParallelFor(0, 1000, [](size_t i) { if (i == 500) { throw runtime_error("test"); } }, 10, &pool);
+	} catch (runtime_error&) {
+		caught = true;
+	}
+	if (sum == sum2 && sorted == nums && caught) {
+		printf("[parallel] DSL_ParallelFor/Reduce/Transform/Sort success!\n");
+	} else {
+		printf("[parallel] DSL_ParallelFor/Reduce/Transform/Sort error!\n");
+		ret = 1;
+	}
+
+	// tasks submitted while (or after) a pool shuts down still have to run, and can't leave WaitIdle() waiting on them
+	{
+		atomic<int> late(0);
+		DSL_ThreadPool pool2(2, "Shutdown Pool");
+		for (int i = 0; i < 100; i++) {
+			pool2.Submit([&pool2, &late]() {
+				safe_sleep_ms(1);
+				pool2.Submit([&late]() { late++; });
+			});
+		}
+		pool2.Shutdown();
+		pool2.Submit([&late]() { late++; });
+		vector<DSL_ThreadPool_Task> batch2 = { [&late]() { late++; } };
+		pool2.SubmitBatch(batch2);
+		if (pool2.WaitIdle(5000) && late == 102) {
+			printf("[thread_pool] Submit during/after Shutdown success!\n");
+		} else {
+			printf("[thread_pool] Submit during/after Shutdown error! (%d)\n", late.load());
+			ret = 1;
+		}
+	}
+	{
+		shutdown_pool = new DSL_ThreadPool(4, "Shutdown Pool");
+		atomic<int> refused(0);
+		shutdown_pool->Submit([&refused]() {
+			if (!shutdown_pool->Shutdown()) { refused++; }
+		});
+		shutdown_pool->WaitIdle();
+		for (int i = 0; i < 4; i++) {
+			DSL_StartThread(ShutdownSubmitter, NULL, "Shutdown Submitter", 5);
+		}
+		shutdown_go = true;
+		while (shutdown_submitted < 1000) {
+			safe_sleep_ms(1);
+		}
+		shutdown_pool->Shutdown();
+		while (DSL_NumThreadsWithID(5)) {
+			safe_sleep_ms(10);
+		}
+		bool idle = shutdown_pool->WaitIdle(5000);
+		delete shutdown_pool;
+		shutdown_pool = NULL;
+		if (refused == 1 && idle && shutdown_ran == shutdown_submitted) {
+			printf("[thread_pool] Concurrent Submit during Shutdown success!\n");
+		} else {
+			printf("[thread_pool] Concurrent Submit during Shutdown error! (%d/%d)\n", shutdown_ran.load(), shutdown_submitted.load());
+			ret = 1;
+		}
+	}
+
+	{
+		DSL_Scheduler sched;
+		atomic<int> once(0), every(0), cancelled(0);
+		uint64 start = GetTickCount64();
+		atomic<uint64> once_at(0);
+		sched.ScheduleIn(50, [&]() { once_at = GetTickCount64(); once++; }, &pool);
+		DSL_SCHEDULER_ID id = sched.ScheduleEvery(20, [&]() { every++; }, &pool);
+		DSL_SCHEDULER_ID id2 = sched.ScheduleIn(100, [&]() { cancelled++; });
+		bool cancel_ok = sched.Cancel(id2) && !sched.Cancel(id2);
+		safe_sleep_ms(300);
+		sched.Cancel(id);
+		pool.WaitIdle();
+		int every_count = every;
+		safe_sleep_ms(60);
+		if (cancel_ok && once == 1 && once_at - start >= 50 && cancelled == 0 && every_count >= 5 && every == every_count && sched.NumScheduled() == 0) {
+			printf("[scheduler] ScheduleIn/ScheduleEvery/Cancel success! (%d periodic runs)\n", every_count);
+		} else {
+			printf("[scheduler] ScheduleIn/ScheduleEvery/Cancel error! (%d/%d/%d)\n", once.load(), every_count, cancelled.load());
+			ret = 1;
+		}
+	}
+
+	// a -> b -> c chain plus a group on the pool
+	string order;
+	DSL_FunctionTask a([&order]() { safe_sleep_ms(20); order += "a"; });
+	DSL_FunctionTask b([&order]() { order += "b"; });
+	DSL_FunctionTask c([&order]() { order += "c"; });
+	atomic<int> callbacks(0);
+	a.OnComplete([&callbacks](DSL_AsyncTask * t) { callbacks++; });
+	a.Then(&b, &pool)->Then(&c);
+	vector<DSL_AsyncTask *> group;
+	for (int i = 0; i < 8; i++) {
+		group.push_back(new DSL_FunctionTask([i]() { safe_sleep_ms(5 * i); }));
+	}
+	DSL_WhenTask * all = DSL_WhenAll(group);
+	DSL_WhenTask * any = DSL_WhenAny(group);
+	for (auto * t : group) {
+		DSL_StartAsyncTaskOnPool(t, &pool);
+	}
+	DSL_StartAsyncTask(&a);
+	bool chain_ok = c.Wait(30000) && order == "abc" && callbacks == 1 && a.done;
+	bool group_ok = all->Wait(30000) && any->Wait(0) && any->first_done != NULL;
+	a.OnComplete([&callbacks](DSL_AsyncTask * t) { callbacks++; }); // already done, called right away
+	if (chain_ok && group_ok && callbacks == 2) {
+		printf("[async_task] Then/WhenAll/WhenAny success!\n");
+	} else {
+		printf("[async_task] Then/WhenAll/WhenAny error! (%s)\n", order.c_str());
+		ret = 1;
+	}
+	delete all;
+	delete any;
+	for (auto * t : group) {
+		delete t;
+	}
+	while (DSL_NumThreads()) {
+		safe_sleep_ms(10);
+	}
+
+	dsl_cleanup();
+	return ret;
+}